@@ -15,7 +15,16 @@ const tint_public_cpp_flags = [_][]const u8{
 };
 
 pub fn build(b: *Build) void {
-    _ = build_exe(b, b.standardTargetOptions(.{}), b.standardOptimizeOption(.{}), "");
+    const target = b.standardTargetOptions(.{});
+    const mode = b.standardOptimizeOption(.{});
+    const shdc = lib_shdc(b, target, mode, "");
+    b.installArtifact(shdc);
+    _ = build_exe(b, target, mode, "");
+
+    // compile-throughput benchmark, built with 'zig build bench'
+    const bench_exe = build_bench_exe(b, target, mode, "");
+    const bench_step = b.step("bench", "Build the shdc-bench compile-throughput benchmark");
+    bench_step.dependOn(&b.addInstallArtifact(bench_exe, .{}).step);
 }
 
 pub fn build_exe(
@@ -23,17 +32,98 @@ pub fn build_exe(
     target: Build.ResolvedTarget,
     mode: std.builtin.OptimizeMode,
     comptime prefix_path: []const u8,
+) *Build.Step.Compile {
+    const exe = b.addExecutable(.{
+        .name = "sokol-shdc",
+        .target = target,
+        .optimize = mode,
+    });
+    add_shdc_main(b, exe, target, mode, prefix_path, "main.cc");
+    b.installArtifact(exe);
+    return exe;
+}
+
+fn build_bench_exe(
+    b: *Build,
+    target: Build.ResolvedTarget,
+    mode: std.builtin.OptimizeMode,
+    comptime prefix_path: []const u8,
+) *Build.Step.Compile {
+    const exe = b.addExecutable(.{
+        .name = "shdc-bench",
+        .target = target,
+        .optimize = mode,
+    });
+    add_shdc_main(b, exe, target, mode, prefix_path, "bench/bench.cc");
+    return exe;
+}
+
+const shdc_incl_dirs = [_][]const u8{
+    "src/shdc",
+    "ext/fmt/include",
+    "ext/SPIRV-Cross",
+    "ext/pystring",
+    "ext/getopt/include",
+    "ext/glslang",
+    "ext/glslang/glslang/Public",
+    "ext/glslang/glslang/Include",
+    "ext/glslang/SPIRV",
+    "ext/SPIRV-Tools/include",
+    "ext/tint/include",
+    "ext/tint",
+};
+
+// link libshdc into an executable, with main_src as source file of the main function
+fn add_shdc_main(
+    b: *Build,
+    exe: *Build.Step.Compile,
+    target: Build.ResolvedTarget,
+    mode: std.builtin.OptimizeMode,
+    comptime prefix_path: []const u8,
+    comptime main_src: []const u8,
+) void {
+    const flags = common_cpp_flags ++ spvcross_public_cpp_flags ++ tint_public_cpp_flags;
+    if (exe.rootModuleTarget().abi != .msvc)
+        exe.linkLibCpp()
+    else
+        exe.linkLibC();
+    exe.linkLibrary(lib_shdc(b, target, mode, prefix_path));
+    inline for (shdc_incl_dirs) |incl_dir| {
+        exe.addIncludePath(b.path(prefix_path ++ incl_dir));
+    }
+    exe.addCSourceFile(.{ .file = b.path(prefix_path ++ "src/shdc/" ++ main_src), .flags = &flags });
+}
+
+// the sokol-shdc compile pipeline as static library, for embedding
+// the shader compiler into other applications (see src/shdc/shdc.h)
+pub fn lib_shdc(
+    b: *Build,
+    target: Build.ResolvedTarget,
+    mode: std.builtin.OptimizeMode,
+    comptime prefix_path: []const u8,
 ) *Build.Step.Compile {
     const dir = prefix_path ++ "src/shdc/";
     const sources = [_][]const u8{
         "args.cc",
         "bytecode.cc",
+        "cache.cc",
+        "cache_remote.cc",
+        "compile.cc",
+        "compress.cc",
         "input.cc",
-        "main.cc",
+        "jobs.cc",
+        "minify.cc",
+        "process.cc",
         "reflection.cc",
+        "shdc.cc",
+        "size_report.cc",
+        "source_buffer.cc",
         "spirv.cc",
         "spirvcross.cc",
+        "stats.cc",
+        "timings.cc",
         "generators/bare.cc",
+        "generators/barebin.cc",
         "generators/generate.cc",
         "generators/generator.cc",
         "generators/sokolc.cc",
@@ -45,46 +135,31 @@ pub fn build_exe(
         "generators/sokolzig.cc",
         "generators/yaml.cc",
     };
-    const incl_dirs = [_][]const u8{
-        "src/shdc",
-        "ext/fmt/include",
-        "ext/SPIRV-Cross",
-        "ext/pystring",
-        "ext/getopt/include",
-        "ext/glslang",
-        "ext/glslang/glslang/Public",
-        "ext/glslang/glslang/Include",
-        "ext/glslang/SPIRV",
-        "ext/SPIRV-Tools/include",
-        "ext/tint/include",
-        "ext/tint",
-    };
     const flags = common_cpp_flags ++ spvcross_public_cpp_flags ++ tint_public_cpp_flags;
 
-    const exe = b.addExecutable(.{
-        .name = "sokol-shdc",
+    const lib = b.addStaticLibrary(.{
+        .name = "shdc",
         .target = target,
         .optimize = mode,
     });
-    if (exe.rootModuleTarget().abi != .msvc)
-        exe.linkLibCpp()
+    if (lib.rootModuleTarget().abi != .msvc)
+        lib.linkLibCpp()
     else
-        exe.linkLibC();
-    exe.linkLibrary(lib_fmt(b, target, mode, prefix_path));
-    exe.linkLibrary(lib_getopt(b, target, mode, prefix_path));
-    exe.linkLibrary(lib_pystring(b, target, mode, prefix_path));
-    exe.linkLibrary(lib_spirvcross(b, target, mode, prefix_path));
-    exe.linkLibrary(lib_spirvtools(b, target, mode, prefix_path));
-    exe.linkLibrary(lib_glslang(b, target, mode, prefix_path));
-    exe.linkLibrary(lib_tint(b, target, mode, prefix_path));
-    inline for (incl_dirs) |incl_dir| {
-        exe.addIncludePath(b.path(prefix_path ++ incl_dir));
+        lib.linkLibC();
+    lib.linkLibrary(lib_fmt(b, target, mode, prefix_path));
+    lib.linkLibrary(lib_getopt(b, target, mode, prefix_path));
+    lib.linkLibrary(lib_pystring(b, target, mode, prefix_path));
+    lib.linkLibrary(lib_spirvcross(b, target, mode, prefix_path));
+    lib.linkLibrary(lib_spirvtools(b, target, mode, prefix_path));
+    lib.linkLibrary(lib_glslang(b, target, mode, prefix_path));
+    lib.linkLibrary(lib_tint(b, target, mode, prefix_path));
+    inline for (shdc_incl_dirs) |incl_dir| {
+        lib.addIncludePath(b.path(prefix_path ++ incl_dir));
     }
     inline for (sources) |src| {
-        exe.addCSourceFile(.{ .file = b.path(dir ++ src), .flags = &flags });
+        lib.addCSourceFile(.{ .file = b.path(dir ++ src), .flags = &flags });
     }
-    b.installArtifact(exe);
-    return exe;
+    return lib;
 }
 
 fn lib_getopt(
@@ -3,7 +3,10 @@
 */
 #include "args.h"
 #include "types/slang.h"
+#include "cache_remote.h"
 #include <vector>
+#include <algorithm>
+#include <filesystem>
 #include <stdio.h>
 #include "fmt/format.h"
 #include "getopt/getopt.h"
@@ -12,7 +15,7 @@
 namespace shdc {
 
 enum {
-    OPTION_HELP = 1,
+    OPTION_HELP = 256,  // must not collide with the special getopt return values (e.g. '!')
     OPTION_INPUT,
     OPTION_OUTPUT,
     OPTION_SLANG,
@@ -28,25 +31,103 @@ enum {
     OPTION_NOIFDEF,
     OPTION_REFLECTION,
     OPTION_SAVE_INTERMEDIATE_SPIRV,
+    OPTION_JOBS,
+    OPTION_CACHE_DIR,
+    OPTION_CACHE_URL,
+    OPTION_CACHE_TIMEOUT,
+    OPTION_BATCH,
+    OPTION_WATCH,
+    OPTION_DEPFILE,
+    OPTION_WRITE_IF_CHANGED,
+    OPTION_OPT,
+    OPTION_WGSL_OPT,
+    OPTION_MINIFY,
+    OPTION_COMPRESS,
+    OPTION_EMBED,
+    OPTION_SINGLE_METALLIB,
+    OPTION_METAL_IN_MEMORY,
+    OPTION_METAL_VERSION,
+    OPTION_METAL_MACOS_MIN,
+    OPTION_METAL_IOS_MIN,
+    OPTION_METAL_PRECISE_MATH,
+    OPTION_METAL_OPT,
+    OPTION_HLSL_OPT,
+    OPTION_HLSL_STRIP,
+    OPTION_CONST_DESC,
+    OPTION_SPLIT_BACKENDS,
+    OPTION_ALIGNED_SBUFS,
+    OPTION_YAML_SCHEMA,
+    OPTION_PACK,
+    OPTION_WARN_UNUSED_UNIFORMS,
+    OPTION_WARN_UNIFORM_PADDING,
+    OPTION_WARN_EARLY_FRAGMENT_TESTS,
+    OPTION_MODULE_BIND_SLOTS,
+    OPTION_TIMINGS,
+    OPTION_TRACE_JSON,
+    OPTION_STATS,
+    OPTION_CHECK,
+    OPTION_SIZE_REPORT,
+    OPTION_SIZE_BUDGET,
+    OPTION_PROFILE_BUILD,
+    OPTION_REPRODUCIBLE,
 };
 
 static const getopt_option_t option_list[] = {
     { "help",               'h', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_HELP,         "print this help text", 0},
     { "input",              'i', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_INPUT,        "input source file", "GLSL file" },
-    { "output",             'o', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_OUTPUT,       "output source file", "C header" },
+    { "output",             'o', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_OUTPUT,       "output source file (repeat with --format for several outputs)", "C header" },
     { "slang",              'l', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_SLANG,        "output shader language(s), see above for list", "glsl430:glsl300es..." },
     { "defines",            0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_DEFINES,      "optional preprocessor defines", "define1:define2..." },
     { "module",             'm', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_MODULE,       "optional @module name override" },
     { "reflection",         'r', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_REFLECTION,   "generate runtime reflection functions" },
+    { "warn-unused-uniforms", 0, GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_WARN_UNUSED_UNIFORMS, "warn about uniform block members which are never read by a shader"},
+    { "warn-uniform-padding", 0, GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_WARN_UNIFORM_PADDING, "warn about uniform blocks with avoidable std140 padding, and suggest a better member order"},
+    { "warn-early-fragment-tests", 0, GETOPT_OPTION_TYPE_NO_ARG, 0, OPTION_WARN_EARLY_FRAGMENT_TESTS, "warn about fragment shaders which disable early depth/stencil tests"},
+    { "module-bind-slots", 0,    GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_MODULE_BIND_SLOTS, "assign the same bind slot to same-named resources in all programs of a module"},
     { "bytecode",           'b', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_BYTECODE,     "output bytecode (HLSL and Metal)"},
-    { "format",             'f', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_FORMAT,       "output format (default: sokol)", "[sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_d|sokol_jai|bare|bare_yaml]" },
+    { "single-metallib",    0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_SINGLE_METALLIB, "link all Metal bytecode of a module into a single metallib (with --bytecode)"},
+    { "hlsl-opt",           0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_HLSL_OPT,     "HLSL bytecode optimization level (default: 3)", "[0|1|2|3|skip]" },
+    { "hlsl-strip",         0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_HLSL_STRIP,   "strip reflection and debug data from HLSL bytecode"},
+    { "metal-in-memory",    0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_METAL_IN_MEMORY, "pipe Metal source into the compiler, and keep intermediate files out of --tmpdir"},
+    { "metal-version",      0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_METAL_VERSION, "minimum Metal shading language version (default: 1.1)", "[1.1|1.2|2.0|2.1|2.2|2.3|2.4|3.0]" },
+    { "metal-macos-min",    0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_METAL_MACOS_MIN, "macOS deployment target for Metal bytecode (default: derived from the Metal version)", "[major.minor]" },
+    { "metal-ios-min",      0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_METAL_IOS_MIN, "iOS deployment target for Metal bytecode (default: derived from the Metal version)", "[major.minor]" },
+    { "metal-precise-math", 0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_METAL_PRECISE_MATH, "compile Metal bytecode without -ffast-math"},
+    { "metal-opt",          0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_METAL_OPT,    "Metal bytecode optimization level (default: compiler default)", "[0|1|2|3|s]" },
+    { "profile-build",      0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_PROFILE_BUILD, "emit line directives and debug info for GPU profilers and debuggers"},
+    { "opt",                0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_OPT,          "SPIRV optimization level (default: size)", "[none|size|perf]" },
+    { "wgsl-opt",           0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_WGSL_OPT,     "run a reduced set of SPIRV optimizer passes for WGSL (experimental)"},
+    { "minify",             0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_MINIFY,       "minify embedded shader source code (and omit the source code comments)"},
+    { "compress",           0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_COMPRESS,     "compress embedded shader arrays (sokol and sokol_impl format only)", "[lz4]"},
+    { "embed",              0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_EMBED,        "write shader arrays to binary sidecar files which are embedded at compile time"},
+    { "const-desc",         0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_CONST_DESC,   "generate shader descs as static const tables (sokol and sokol_impl format only)"},
+    { "split-backends",     0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_SPLIT_BACKENDS, "write the shader code of each backend into a separate file (sokol and sokol_impl format only)"},
+    { "aligned-sbufs",      0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_ALIGNED_SBUFS, "generate naturally aligned storage buffer structs with layout checks (sokol, sokol_impl and sokol_zig format only)"},
+    { "format",             'f', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_FORMAT,       "output format of the preceding or following --output (default: sokol)", "[sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_d|sokol_jai|bare|bare_yaml|bare_bin]" },
+    { "pack",               0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_PACK,         "write all shader files of a module into a single pack file (bare and bare_yaml format only)"},
+    { "yaml-schema",        0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_YAML_SCHEMA,  "bare_yaml schema version (default: 1)", "[1|2]"},
     { "errfmt",             'e', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_ERRFMT,       "error message format (default: gcc)", "[gcc|msvc]"},
     { "dump",               'd', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_DUMP,         "dump debugging information to stderr"},
     { "genver",             'g', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_GENVER,       "version-stamp for code-generation", "[int]"},
+    { "depfile",            0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_DEPFILE,      "write a Make/Ninja depfile with all @include dependencies", "[path]"},
+    { "reproducible",       0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_REPRODUCIBLE, "write paths relative to [dir] and omit machine-specific data in generated files", "[dir]"},
+    { "check",              0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_CHECK,        "only check the input for errors (fast, for editor linting), don't write output files"},
+    { "size-report",        0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_SIZE_REPORT,  "write the size of the embedded shader data per program, stage and shader language as JSON file", "[path]"},
+    { "size-budget",        0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_SIZE_BUDGET,  "fail if the embedded shader data of the module exceeds the budget", "[bytes]"},
+    { "stats",              0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_STATS,        "write static shader cost statistics per snippet and shader language as JSON file", "[path]"},
     { "tmpdir",             't', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_TMPDIR,       "directory for temporary files (use output dir if not specified)", "[dir]"},
     { "ifdef",              0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_IFDEF,        "wrap backend-specific generated code in #ifdef/#endif"},
     { "noifdef",            'n', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_NOIFDEF,      "obsolete, superseded by --ifdef"},
     { "save-intermediate-spirv", 0, GETOPT_OPTION_TYPE_NO_ARG,  0, OPTION_SAVE_INTERMEDIATE_SPIRV, "save intermediate SPIRV bytecode (for debug inspection)"},
+    { "batch",              0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_BATCH,        "compile all entries of a batch manifest file (instead of --input)", "[path]"},
+    { "write-if-changed",   0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_WRITE_IF_CHANGED, "don't overwrite output files if their content wouldn't change"},
+    { "watch",              'w', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_WATCH,        "keep running and recompile when a source file changes"},
+    { "jobs",               'j', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_JOBS,         "max number of parallel compile jobs (default: one per CPU core)", "[int]"},
+    { "cache-dir",          0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_CACHE_DIR,    "directory for the persistent compile cache (default: no caching)", "[dir]"},
+    { "cache-url",          0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_CACHE_URL,    "optional remote compile cache behind --cache-dir", "[http://...]"},
+    { "cache-timeout",      0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_CACHE_TIMEOUT, "remote compile cache timeout in seconds (default: 5)", "[int]"},
+    { "timings",            0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_TIMINGS,      "print a summary of the time spent in each compile phase"},
+    { "trace-json",         0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_TRACE_JSON,   "write compile phase timings as Chrome trace (about:tracing) JSON file", "[path]"},
     GETOPT_OPTIONS_END
 };
 
@@ -54,7 +135,8 @@ static void print_help_string(getopt_context_t& ctx) {
     fmt::print(stderr,
         "Shader compiler / code generator for sokol_gfx.h based on GLslang + SPIRV-Cross\n"
         "https://github.com/floooh/sokol-tools\n\n"
-        "Usage: sokol-shdc -i input [-o output] [options]\n\n"
+        "Usage: sokol-shdc -i input [-o output] [options]\n"
+        "       sokol-shdc --batch manifest [options]\n\n"
         "Where [input] is exactly one .glsl file in Vulkan syntax (separate texture and sampler uniforms),\n"
         "and [output] is a C header with embedded shader source code and/or byte code and\n"
         "code-generated uniform-block and shader-description C structs ready for use with sokol_gfx.h\n\n"
@@ -66,10 +148,12 @@ static void print_help_string(getopt_context_t& ctx) {
         "  - glsl300es      OpenGLES3 and WebGL2 (SOKOL_GLES3)\n"
         "  - hlsl4          Direct3D11 with HLSL4 (SOKOL_D3D11)\n"
         "  - hlsl5          Direct3D11 with HLSL5 (SOKOL_D3D11)\n"
+        "  - hlsl6          Direct3D12 with HLSL Shader Model 6 (SOKOL_D3D12)\n"
         "  - metal_macos    Metal on macOS (SOKOL_METAL)\n"
         "  - metal_ios      Metal on iOS devices (SOKOL_METAL)\n"
         "  - metal_sim      Metal on iOS simulator (SOKOL_METAL)\n"
-        "  - wgsl           WebGPU (SOKOL_WGPU)\n\n"
+        "  - wgsl           WebGPU (SOKOL_WGPU)\n"
+        "  - spirv          Vulkan with SPIRV bytecode (SOKOL_VULKAN)\n\n"
         "Output formats (used with -f --format):\n"
         "  - sokol          C header which includes both decl and inlined impl\n"
         "  - sokol_impl     C header with STB-style SOKOL_SHDC_IMPL wrapped impl\n"
@@ -80,7 +164,8 @@ static void print_help_string(getopt_context_t& ctx) {
         "  - sokol_d        D module file\n"
         "  - sokol_jai      Jai module file\n"
         "  - bare           raw output of SPIRV-Cross compiler, in text or binary format\n"
-        "  - bare_yaml      like bare, but with reflection file in YAML format\n\n"
+        "  - bare_yaml      like bare, but with reflection file in YAML format\n"
+        "  - bare_bin       single binary file with reflection info and shader code\n\n"
         "Options:\n\n");
     char buf[4096];
     fmt::print(stderr, "{}", getopt_create_help_string(&ctx, buf, sizeof(buf)));
@@ -127,20 +212,177 @@ static bool parse_slang(Args& args, const char* str) {
     return true;
 }
 
+// pair up the --format and --output options, with a single --output the
+// format is optional (default: sokol)
+static bool pair_outputs(Args& args, const std::vector<std::string>& paths, const std::vector<Format::Enum>& formats) {
+    if ((paths.size() > 1) || (formats.size() > 1)) {
+        if (paths.size() != formats.size()) {
+            fmt::print(stderr, "sokol-shdc: with multiple outputs, each --output needs exactly one --format ({} outputs, {} formats)\n", paths.size(), formats.size());
+            return false;
+        }
+    }
+    if (!paths.empty()) {
+        args.output = paths[0];
+    }
+    if (!formats.empty()) {
+        args.output_format = formats[0];
+    }
+    for (size_t i = 1; i < paths.size(); i++) {
+        Args::Output extra;
+        extra.format = formats[i];
+        extra.path = paths[i];
+        args.extra_outputs.push_back(extra);
+    }
+    return true;
+}
+
+// true if the output format of all outputs is one of the formats
+static bool all_formats_in(const Args& args, const std::vector<Format::Enum>& formats) {
+    if (std::find(formats.begin(), formats.end(), args.output_format) == formats.end()) {
+        return false;
+    }
+    for (const Args::Output& extra: args.extra_outputs) {
+        if (std::find(formats.begin(), formats.end(), extra.format) == formats.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static void validate(Args& args) {
     bool err = false;
-    if (args.input.empty()) {
-        fmt::print(stderr, "sokol-shdc: no input file (--input [path])\n");
+    if (!args.batch.empty()) {
+        // input, output and shader languages are defined in the batch manifest
+        if (!args.input.empty()) {
+            fmt::print(stderr, "sokol-shdc: --batch and --input can't be used together\n");
+            err = true;
+        }
+        if (args.watch) {
+            fmt::print(stderr, "sokol-shdc: --batch and --watch can't be used together\n");
+            err = true;
+        }
+    } else {
+        if (args.input.empty()) {
+            fmt::print(stderr, "sokol-shdc: no input file (--input [path])\n");
+            err = true;
+        }
+        if (args.output.empty() && !args.check) {
+            fmt::print(stderr, "sokol-shdc: no output file (--output [path])\n");
+            err = true;
+        }
+        if (args.slang == 0) {
+            if (args.check) {
+                // --check only needs one representative target language
+                args.slang = Slang::bit(Slang::GLSL430);
+            } else {
+                fmt::print(stderr, "sokol-shdc: no shader languages (--slang ...)\n");
+                err = true;
+            }
+        }
+    }
+    if (!args.cache_url.empty()) {
+        if (args.cache_dir.empty()) {
+            fmt::print(stderr, "sokol-shdc: --cache-url requires a local cache directory (--cache-dir [path])\n");
+            err = true;
+        }
+        if (!CacheRemote::is_valid_url(args.cache_url)) {
+            fmt::print(stderr, "sokol-shdc: unsupported cache URL '{}', must start with http:// or https://\n", args.cache_url);
+            err = true;
+        }
+    }
+    const std::vector<Format::Enum> sokol_c_formats = { Format::SOKOL, Format::SOKOL_IMPL };
+    if ((args.compression != Compression::NONE) && !all_formats_in(args, sokol_c_formats)) {
+        fmt::print(stderr, "sokol-shdc: --compress is only supported for the sokol and sokol_impl output formats\n");
+        err = true;
+    }
+    if (args.profile_build) {
+        if (args.hlsl_strip) {
+            fmt::print(stderr, "sokol-shdc: --profile-build can't be combined with --hlsl-strip\n");
+            err = true;
+        }
+        if (args.minify) {
+            fmt::print(stderr, "sokol-shdc: --profile-build can't be combined with --minify\n");
+            err = true;
+        }
+    }
+    if (!args.reproducible_root.empty()) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(args.reproducible_root, ec)) {
+            fmt::print(stderr, "sokol-shdc: --reproducible root '{}' is not a directory\n", args.reproducible_root);
+            err = true;
+        }
+    }
+    if (args.const_desc) {
+        const std::vector<Format::Enum> const_desc_formats = {
+            Format::SOKOL, Format::SOKOL_IMPL, Format::SOKOL_ZIG, Format::SOKOL_RUST,
+            Format::SOKOL_D, Format::SOKOL_ODIN, Format::SOKOL_NIM, Format::SOKOL_JAI
+        };
+        if (!all_formats_in(args, const_desc_formats)) {
+            fmt::print(stderr, "sokol-shdc: --const-desc is only supported for the sokol, sokol_impl, sokol_zig, sokol_rust, sokol_d, sokol_odin, sokol_nim and sokol_jai output formats\n");
+            err = true;
+        }
+        if (args.compression != Compression::NONE) {
+            fmt::print(stderr, "sokol-shdc: --const-desc can't be combined with --compress (compressed arrays are inflated at runtime)\n");
+            err = true;
+        }
+    }
+    if (args.pack && !all_formats_in(args, { Format::BARE, Format::BARE_YAML })) {
+        fmt::print(stderr, "sokol-shdc: --pack is only supported for the bare and bare_yaml output formats\n");
+        err = true;
+    }
+    if ((args.yaml_schema != 1) && !all_formats_in(args, { Format::BARE_YAML })) {
+        fmt::print(stderr, "sokol-shdc: --yaml-schema is only supported for the bare_yaml output format\n");
+        err = true;
+    }
+    if (args.embed && !all_formats_in(args, { Format::SOKOL, Format::SOKOL_IMPL, Format::SOKOL_ZIG, Format::SOKOL_RUST, Format::SOKOL_D })) {
+        fmt::print(stderr, "sokol-shdc: --embed is only supported for the sokol, sokol_impl, sokol_zig, sokol_rust and sokol_d output formats\n");
         err = true;
     }
-    if (args.output.empty()) {
-        fmt::print(stderr, "sokol-shdc: no output file (--output [path])\n");
+    if (args.split_backends && !all_formats_in(args, { Format::SOKOL, Format::SOKOL_IMPL })) {
+        fmt::print(stderr, "sokol-shdc: --split-backends is only supported for the sokol and sokol_impl output formats\n");
         err = true;
     }
-    if (args.slang == 0) {
-        fmt::print(stderr, "sokol-shdc: no shader languages (--slang ...)\n");
+    if (args.aligned_sbufs && !all_formats_in(args, { Format::SOKOL, Format::SOKOL_IMPL, Format::SOKOL_ZIG })) {
+        fmt::print(stderr, "sokol-shdc: --aligned-sbufs is only supported for the sokol, sokol_impl and sokol_zig output formats\n");
         err = true;
     }
+    if (!args.metal_macos_min.empty()) {
+        const int val = MslVersion::os_version_value(args.metal_macos_min);
+        if (val < 0) {
+            fmt::print(stderr, "sokol-shdc: invalid macOS deployment target '{}', must be 'major.minor'\n", args.metal_macos_min);
+            err = true;
+        } else if (val < MslVersion::os_version_value(MslVersion::macos_min(args.metal_version))) {
+            fmt::print(stderr, "sokol-shdc: macOS deployment target {} is too low for Metal {} (needs at least {})\n",
+                args.metal_macos_min, MslVersion::to_str(args.metal_version), MslVersion::macos_min(args.metal_version));
+            err = true;
+        }
+    }
+    if (!args.metal_ios_min.empty()) {
+        const int val = MslVersion::os_version_value(args.metal_ios_min);
+        if (val < 0) {
+            fmt::print(stderr, "sokol-shdc: invalid iOS deployment target '{}', must be 'major.minor'\n", args.metal_ios_min);
+            err = true;
+        } else if (val < MslVersion::os_version_value(MslVersion::ios_min(args.metal_version))) {
+            fmt::print(stderr, "sokol-shdc: iOS deployment target {} is too low for Metal {} (needs at least {})\n",
+                args.metal_ios_min, MslVersion::to_str(args.metal_version), MslVersion::ios_min(args.metal_version));
+            err = true;
+        }
+    }
+    for (size_t i = 0; i < args.extra_outputs.size(); i++) {
+        const std::string& path = args.extra_outputs[i].path;
+        bool duplicate = (path == args.output);
+        for (size_t j = 0; j < i; j++) {
+            duplicate |= (path == args.extra_outputs[j].path);
+        }
+        if (duplicate) {
+            fmt::print(stderr, "sokol-shdc: output file '{}' is used more than once\n", path);
+            err = true;
+        }
+    }
+    if (args.watch) {
+        // only touch output files which actually changed, to keep hot-reloading cheap
+        args.write_if_changed = true;
+    }
     if (args.tmpdir.empty()) {
         std::string tail;
         pystring::os::path::split(args.tmpdir, tail, args.output);
@@ -161,6 +403,129 @@ static void validate(Args& args) {
     }
 }
 
+// options which only affect how (not what) sokol-shdc compiles, or which
+// refer to machine-specific locations, are dropped from the --reproducible cmdline
+static bool is_machine_specific_option(int value) {
+    switch (value) {
+        case OPTION_TMPDIR:
+        case OPTION_JOBS:
+        case OPTION_CACHE_DIR:
+        case OPTION_CACHE_URL:
+        case OPTION_CACHE_TIMEOUT:
+        case OPTION_TIMINGS:
+        case OPTION_TRACE_JSON:
+        case OPTION_DUMP:
+        case OPTION_WATCH:
+        case OPTION_WRITE_IF_CHANGED:
+        case OPTION_DEPFILE:
+        case OPTION_STATS:
+        case OPTION_SIZE_REPORT:
+        case OPTION_SIZE_BUDGET:
+        case OPTION_REPRODUCIBLE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// find the option for a cmdline token ('--name', '--name=value', '-x' or '-xvalue')
+static const getopt_option_t* find_option(const std::string& token, std::string& out_value, bool& out_has_value) {
+    out_has_value = false;
+    out_value.clear();
+    if (pystring::startswith(token, "--")) {
+        const size_t eq = token.find('=');
+        const std::string name = token.substr(2, (eq == std::string::npos) ? std::string::npos : eq - 2);
+        for (const getopt_option_t* opt = option_list; opt->name; opt++) {
+            if (name == opt->name) {
+                if (eq != std::string::npos) {
+                    out_value = token.substr(eq + 1);
+                    out_has_value = true;
+                }
+                return opt;
+            }
+        }
+    } else if ((token.size() >= 2) && (token[0] == '-')) {
+        for (const getopt_option_t* opt = option_list; opt->name; opt++) {
+            if ((opt->name_short != 0) && (token[1] == opt->name_short)) {
+                if (token.size() > 2) {
+                    out_value = token.substr(2);
+                    out_has_value = true;
+                }
+                return opt;
+            }
+        }
+    }
+    return nullptr;
+}
+
+std::string Args::split_backend_path(const std::string& output, Slang::Enum slang) {
+    std::string root, ext;
+    pystring::os::path::splitext(root, ext, output);
+    return fmt::format("{}.{}{}", root, Slang::to_str(slang), ext);
+}
+
+OptLevel::Enum Args::spirv_opt_level(Slang::Enum slang) const {
+    // the WGSL pass list isn't validated against Tint yet, so it's opt-in
+    if (Slang::is_wgsl(slang) && !wgsl_opt) {
+        return OptLevel::NONE;
+    }
+    return opt_level;
+}
+
+std::string Args::reproducible_path(const std::string& path) const {
+    if (reproducible_root.empty() || path.empty()) {
+        return path;
+    }
+    std::error_code ec;
+    const std::filesystem::path abs_path = std::filesystem::absolute(path, ec).lexically_normal();
+    const std::filesystem::path abs_root = std::filesystem::absolute(reproducible_root, ec).lexically_normal();
+    if (ec) {
+        return path;
+    }
+    const std::filesystem::path rel_path = abs_path.lexically_relative(abs_root);
+    if (rel_path.empty()) {
+        return path;
+    }
+    return rel_path.generic_string();
+}
+
+// build the cmdline for the generated file header with paths relative
+// to the --reproducible root and without machine-specific options
+static std::string reproducible_cmdline(const Args& args, int argc, const char** argv) {
+    std::string res = "sokol-shdc";
+    for (int i = 1; i < argc; i++) {
+        std::string value;
+        bool has_value = false;
+        const getopt_option_t* opt = find_option(argv[i], value, has_value);
+        if (!opt) {
+            res.append(" ");
+            res.append(argv[i]);
+            continue;
+        }
+        const bool takes_value = opt->type == GETOPT_OPTION_TYPE_REQUIRED;
+        if (takes_value && !has_value && ((i + 1) < argc)) {
+            value = argv[++i];
+        }
+        if (is_machine_specific_option(opt->value)) {
+            continue;
+        }
+        res.append(fmt::format(" --{}", opt->name));
+        if (takes_value) {
+            switch (opt->value) {
+                case OPTION_INPUT:
+                case OPTION_OUTPUT:
+                case OPTION_BATCH:
+                    value = args.reproducible_path(value);
+                    break;
+                default:
+                    break;
+            }
+            res.append(fmt::format("={}", value));
+        }
+    }
+    return res;
+}
+
 Args Args::parse(int argc, const char** argv) {
     Args args;
 
@@ -171,6 +536,9 @@ Args Args::parse(int argc, const char** argv) {
         args.cmdline.append(argv[i]);
     }
 
+    // the n-th --format applies to the n-th --output
+    std::vector<std::string> output_paths;
+    std::vector<Format::Enum> output_formats;
     getopt_context_t ctx;
     if (getopt_create_context(&ctx, argc, argv, option_list) < 0) {
         fmt::print(stderr, "error in getopt_create_context()\n");
@@ -193,12 +561,69 @@ Args Args::parse(int argc, const char** argv) {
                 case OPTION_INPUT:
                     args.input = ctx.current_opt_arg;
                     break;
+                case OPTION_BATCH:
+                    args.batch = ctx.current_opt_arg;
+                    break;
+                case OPTION_WATCH:
+                    args.watch = true;
+                    break;
+                case OPTION_WRITE_IF_CHANGED:
+                    args.write_if_changed = true;
+                    break;
                 case OPTION_OUTPUT:
-                    args.output = ctx.current_opt_arg;
+                    output_paths.push_back(ctx.current_opt_arg);
                     break;
                 case OPTION_TMPDIR:
                     args.tmpdir = ctx.current_opt_arg;
                     break;
+                case OPTION_DEPFILE:
+                    args.depfile = ctx.current_opt_arg;
+                    break;
+                case OPTION_STATS:
+                    args.stats = ctx.current_opt_arg;
+                    break;
+                case OPTION_CHECK:
+                    args.check = true;
+                    break;
+                case OPTION_SIZE_REPORT:
+                    args.size_report = ctx.current_opt_arg;
+                    break;
+                case OPTION_SIZE_BUDGET:
+                    args.size_budget = atoll(ctx.current_opt_arg);
+                    if (args.size_budget < 1) {
+                        fmt::print(stderr, "sokol-shdc: invalid size budget {}, must be >= 1 bytes\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
+                case OPTION_PROFILE_BUILD:
+                    args.profile_build = true;
+                    break;
+                case OPTION_REPRODUCIBLE:
+                    args.reproducible_root = ctx.current_opt_arg;
+                    break;
+                case OPTION_TIMINGS:
+                    args.timings = true;
+                    break;
+                case OPTION_TRACE_JSON:
+                    args.trace_json = ctx.current_opt_arg;
+                    break;
+                case OPTION_CACHE_DIR:
+                    args.cache_dir = ctx.current_opt_arg;
+                    break;
+                case OPTION_CACHE_URL:
+                    args.cache_url = ctx.current_opt_arg;
+                    break;
+                case OPTION_CACHE_TIMEOUT:
+                    args.cache_timeout = atoi(ctx.current_opt_arg);
+                    if (args.cache_timeout < 1) {
+                        fmt::print(stderr, "sokol-shdc: invalid cache timeout {}, must be >= 1\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
                 case OPTION_BYTECODE:
                     args.byte_code = true;
                     break;
@@ -212,8 +637,8 @@ Args Args::parse(int argc, const char** argv) {
                     args.reflection = true;
                     break;
                 case OPTION_FORMAT:
-                    args.output_format = Format::from_str(ctx.current_opt_arg);
-                    if (args.output_format == Format::INVALID) {
+                    output_formats.push_back(Format::from_str(ctx.current_opt_arg));
+                    if (output_formats.back() == Format::INVALID) {
                         fmt::print(stderr, "sokol-shdc: unknown output format {}, must be [sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_jai|bare|base_yaml]\n", ctx.current_opt_arg);
                         args.valid = false;
                         args.exit_code = 10;
@@ -244,9 +669,127 @@ Args Args::parse(int argc, const char** argv) {
                         return args;
                     }
                     break;
+                case OPTION_OPT:
+                    args.opt_level = OptLevel::from_str(ctx.current_opt_arg);
+                    if (args.opt_level == OptLevel::INVALID) {
+                        fmt::print(stderr, "sokol-shdc: unknown optimization level {}, must be 'none', 'size' or 'perf'\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
+                case OPTION_WGSL_OPT:
+                    args.wgsl_opt = true;
+                    break;
+                case OPTION_MINIFY:
+                    args.minify = true;
+                    break;
+                case OPTION_HLSL_OPT:
+                    if (0 == strcmp("skip", ctx.current_opt_arg)) {
+                        args.hlsl_opt_level = -1;
+                    } else if ((strlen(ctx.current_opt_arg) == 1) && (ctx.current_opt_arg[0] >= '0') && (ctx.current_opt_arg[0] <= '3')) {
+                        args.hlsl_opt_level = ctx.current_opt_arg[0] - '0';
+                    } else {
+                        fmt::print(stderr, "sokol-shdc: invalid HLSL optimization level {}, must be 0, 1, 2, 3 or 'skip'\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
+                case OPTION_HLSL_STRIP:
+                    args.hlsl_strip = true;
+                    break;
+                case OPTION_METAL_IN_MEMORY:
+                    args.metal_in_memory = true;
+                    break;
+                case OPTION_METAL_VERSION:
+                    args.metal_version = MslVersion::from_str(ctx.current_opt_arg);
+                    if (args.metal_version == MslVersion::INVALID) {
+                        fmt::print(stderr, "sokol-shdc: invalid Metal version {}, must be 1.1, 1.2, 2.0, 2.1, 2.2, 2.3, 2.4 or 3.0\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
+                case OPTION_METAL_MACOS_MIN:
+                    args.metal_macos_min = ctx.current_opt_arg;
+                    break;
+                case OPTION_METAL_IOS_MIN:
+                    args.metal_ios_min = ctx.current_opt_arg;
+                    break;
+                case OPTION_METAL_PRECISE_MATH:
+                    args.metal_precise_math = true;
+                    break;
+                case OPTION_METAL_OPT:
+                    if ((strlen(ctx.current_opt_arg) == 1) && (strchr("0123s", ctx.current_opt_arg[0]))) {
+                        args.metal_opt = ctx.current_opt_arg;
+                    } else {
+                        fmt::print(stderr, "sokol-shdc: invalid Metal optimization level {}, must be 0, 1, 2, 3 or s\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
+                case OPTION_SINGLE_METALLIB:
+                    args.single_metallib = true;
+                    break;
+                case OPTION_EMBED:
+                    args.embed = true;
+                    break;
+                case OPTION_CONST_DESC:
+                    args.const_desc = true;
+                    break;
+                case OPTION_SPLIT_BACKENDS:
+                    args.split_backends = true;
+                    break;
+                case OPTION_ALIGNED_SBUFS:
+                    args.aligned_sbufs = true;
+                    break;
+                case OPTION_COMPRESS:
+                    args.compression = Compression::from_str(ctx.current_opt_arg);
+                    if ((args.compression == Compression::INVALID) || (args.compression == Compression::NONE)) {
+                        fmt::print(stderr, "sokol-shdc: unknown compression method {}, must be 'lz4'\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
                 case OPTION_GENVER:
                     args.gen_version = atoi(ctx.current_opt_arg);
                     break;
+                case OPTION_WARN_UNIFORM_PADDING:
+                    args.warn_uniform_padding = true;
+                    break;
+                case OPTION_WARN_EARLY_FRAGMENT_TESTS:
+                    args.warn_early_fragment_tests = true;
+                    break;
+                case OPTION_MODULE_BIND_SLOTS:
+                    args.module_bind_slots = true;
+                    break;
+                case OPTION_WARN_UNUSED_UNIFORMS:
+                    args.warn_unused_uniforms = true;
+                    break;
+                case OPTION_PACK:
+                    args.pack = true;
+                    break;
+                case OPTION_YAML_SCHEMA:
+                    args.yaml_schema = atoi(ctx.current_opt_arg);
+                    if ((args.yaml_schema < 1) || (args.yaml_schema > 2)) {
+                        fmt::print(stderr, "sokol-shdc: invalid YAML schema version {}, must be 1 or 2\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
+                case OPTION_JOBS:
+                    args.jobs = atoi(ctx.current_opt_arg);
+                    if (args.jobs < 1) {
+                        fmt::print(stderr, "sokol-shdc: invalid number of jobs {}, must be >= 1\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
                 case OPTION_IFDEF:
                     args.ifdef = true;
                     break;
@@ -264,25 +807,159 @@ Args Args::parse(int argc, const char** argv) {
             }
         }
     }
+    if (!pair_outputs(args, output_paths, output_formats)) {
+        args.valid = false;
+        args.exit_code = 10;
+        return args;
+    }
+    if (!args.reproducible_root.empty()) {
+        args.cmdline = reproducible_cmdline(args, argc, argv);
+    }
     validate(args);
     return args;
 }
 
+/* split a batch manifest line into cmdline args, with "..." quoting */
+static std::vector<std::string> split_cmdline(const std::string& line) {
+    std::vector<std::string> tokens;
+    std::string token;
+    bool in_token = false;
+    bool in_quotes = false;
+    for (char c: line) {
+        if (c == '"') {
+            in_quotes = !in_quotes;
+            in_token = true;
+        } else if (!in_quotes && ((c == ' ') || (c == '\t'))) {
+            if (in_token) {
+                tokens.push_back(token);
+                token.clear();
+                in_token = false;
+            }
+        } else {
+            token += c;
+            in_token = true;
+        }
+    }
+    if (in_token) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+/*
+    A batch manifest is a text file with one entry per line, each entry
+    consists of the cmdline args for one input file, for instance:
+
+    # comment
+    -i shaders/a.glsl -o shaders/a.glsl.h -l glsl430:hlsl5:metal_macos
+    -i shaders/b.glsl -o shaders/b.glsl.h -l glsl430:hlsl5:metal_macos -f sokol_impl
+
+    Process-wide options (--jobs, --timings, --trace-json and the --cache-*
+    options) are taken from the main cmdline and are ignored in batch entries.
+*/
+bool Args::parse_batch(const Args& args, std::vector<Args>& out_batch) {
+    FILE* fp = fopen(args.batch.c_str(), "rb");
+    if (!fp) {
+        fmt::print(stderr, "sokol-shdc: failed to open batch manifest '{}'\n", args.batch);
+        return false;
+    }
+    std::string content;
+    char buf[4096];
+    size_t num_bytes;
+    while ((num_bytes = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        content.append(buf, num_bytes);
+    }
+    fclose(fp);
+
+    std::vector<std::string> lines;
+    pystring::splitlines(content, lines);
+    for (int line_index = 0; line_index < (int)lines.size(); line_index++) {
+        const std::string line = pystring::strip(lines[line_index]);
+        if (line.empty() || pystring::startswith(line, "#")) {
+            continue;
+        }
+        const std::vector<std::string> tokens = split_cmdline(line);
+        std::vector<const char*> argv = { "sokol-shdc" };
+        for (const std::string& token: tokens) {
+            argv.push_back(token.c_str());
+        }
+        Args entry = Args::parse((int)argv.size(), argv.data());
+        if (!entry.valid || !entry.batch.empty()) {
+            fmt::print(stderr, "sokol-shdc: invalid entry in batch manifest {}:{}\n", args.batch, line_index + 1);
+            return false;
+        }
+        if (entry.reproducible_root.empty() && !args.reproducible_root.empty()) {
+            entry.reproducible_root = args.reproducible_root;
+            entry.cmdline = reproducible_cmdline(entry, (int)argv.size(), argv.data());
+        }
+        entry.jobs = args.jobs;
+        entry.cache_dir = args.cache_dir;
+        entry.cache_url = args.cache_url;
+        entry.cache_timeout = args.cache_timeout;
+        entry.timings = args.timings;
+        entry.trace_json = args.trace_json;
+        out_batch.push_back(std::move(entry));
+    }
+    return true;
+}
+
 void Args::dump_debug() const {
     fmt::print(stderr, "Args:\n");
     fmt::print(stderr, "  valid: {}\n", valid);
     fmt::print(stderr, "  exit_code: {}\n", exit_code);
     fmt::print(stderr, "  input: '{}'\n", input);
+    fmt::print(stderr, "  batch: '{}'\n", batch);
     fmt::print(stderr, "  output: '{}'\n", output);
     fmt::print(stderr, "  tmpdir: '{}'\n", tmpdir);
+    fmt::print(stderr, "  depfile: '{}'\n", depfile);
+    fmt::print(stderr, "  reproducible_root: '{}'\n", reproducible_root);
+    fmt::print(stderr, "  stats: '{}'\n", stats);
+    fmt::print(stderr, "  size_report: '{}'\n", size_report);
+    fmt::print(stderr, "  size_budget: {}\n", size_budget);
+    fmt::print(stderr, "  cache_dir: '{}'\n", cache_dir);
+    fmt::print(stderr, "  cache_url: '{}'\n", cache_url);
+    fmt::print(stderr, "  cache_timeout: {}\n", cache_timeout);
+    fmt::print(stderr, "  timings: {}\n", timings);
+    fmt::print(stderr, "  trace_json: '{}'\n", trace_json);
     fmt::print(stderr, "  slang: '{}'\n", Slang::bits_to_str(slang, ":"));
     fmt::print(stderr, "  byte_code: {}\n", byte_code);
+    fmt::print(stderr, "  opt_level: {}\n", OptLevel::to_str(opt_level));
+    fmt::print(stderr, "  wgsl_opt: {}\n", wgsl_opt);
+    fmt::print(stderr, "  single_metallib: {}\n", single_metallib);
+    fmt::print(stderr, "  metal_in_memory: {}\n", metal_in_memory);
+    fmt::print(stderr, "  metal_version: {}\n", MslVersion::to_str(metal_version));
+    fmt::print(stderr, "  metal_macos_min: '{}'\n", metal_macos_min);
+    fmt::print(stderr, "  metal_ios_min: '{}'\n", metal_ios_min);
+    fmt::print(stderr, "  metal_precise_math: {}\n", metal_precise_math);
+    fmt::print(stderr, "  metal_opt: '{}'\n", metal_opt);
+    fmt::print(stderr, "  hlsl_opt_level: {}\n", hlsl_opt_level);
+    fmt::print(stderr, "  hlsl_strip: {}\n", hlsl_strip);
+    fmt::print(stderr, "  minify: {}\n", minify);
+    fmt::print(stderr, "  compression: {}\n", Compression::to_str(compression));
+    fmt::print(stderr, "  embed: {}\n", embed);
+    fmt::print(stderr, "  const_desc: {}\n", const_desc);
+    fmt::print(stderr, "  split_backends: {}\n", split_backends);
+    fmt::print(stderr, "  aligned_sbufs: {}\n", aligned_sbufs);
+    fmt::print(stderr, "  profile_build: {}\n", profile_build);
     fmt::print(stderr, "  module: '{}'\n", module);
     fmt::print(stderr, "  defines: '{}'\n", pystring::join(":", defines));
     fmt::print(stderr, "  output_format: '{}'\n", Format::to_str(output_format));
+    for (const Output& extra: extra_outputs) {
+        fmt::print(stderr, "  extra_output: '{}' ({})\n", extra.path, Format::to_str(extra.format));
+    }
     fmt::print(stderr, "  debug_dump: {}\n", debug_dump);
+    fmt::print(stderr, "  check: {}\n", check);
+    fmt::print(stderr, "  watch: {}\n", watch);
+    fmt::print(stderr, "  write_if_changed: {}\n", write_if_changed);
     fmt::print(stderr, "  ifdef: {}\n", ifdef);
     fmt::print(stderr, "  gen_version: {}\n", gen_version);
+    fmt::print(stderr, "  pack: {}\n", pack);
+    fmt::print(stderr, "  warn_unused_uniforms: {}\n", warn_unused_uniforms);
+    fmt::print(stderr, "  warn_uniform_padding: {}\n", warn_uniform_padding);
+    fmt::print(stderr, "  warn_early_fragment_tests: {}\n", warn_early_fragment_tests);
+    fmt::print(stderr, "  module_bind_slots: {}\n", module_bind_slots);
+    fmt::print(stderr, "  yaml_schema: {}\n", yaml_schema);
+    fmt::print(stderr, "  jobs: {}\n", jobs);
     fmt::print(stderr, "  error_format: {}\n", ErrMsg::format_to_str(error_format));
     fmt::print(stderr, "\n");
 }
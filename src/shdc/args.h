@@ -4,30 +4,88 @@
 #include <vector>
 #include "types/errmsg.h"
 #include "types/format.h"
+#include "types/opt_level.h"
+#include "types/msl_version.h"
+#include "types/compression.h"
+#include "types/io_hooks.h"
+#include "types/slang.h"
 
 namespace shdc {
 
 // result of command-line-args parsing
 struct Args {
+    // an additional output format and file, generated from the same compile results
+    struct Output {
+        Format::Enum format = Format::INVALID;
+        std::string path;
+    };
     bool valid = false;
     std::string cmdline;
     int exit_code = 10;
     std::string input;                  // input file path
+    std::string batch;                  // optional batch manifest file path (instead of input)
     std::string output;                 // output file path
     std::string tmpdir;                 // directory for temporary files
+    std::string depfile;                // optional path of a Make/Ninja depfile to write
+    std::string reproducible_root;      // optional root dir for paths written into generated files (--reproducible)
+    std::string stats;                  // optional path of a JSON file with static shader cost statistics
+    std::string size_report;            // optional path of a JSON file with the embedded shader data sizes
+    int64_t size_budget = 0;            // optional max size of the embedded shader data in bytes (0: no budget)
+    std::string cache_dir;              // optional directory for the persistent compile cache
+    std::string cache_url;              // optional remote compile cache URL
+    int cache_timeout = 5;              // remote compile cache timeout in seconds
+    bool timings = false;               // print a summary of the time spent in each compile phase
+    std::string trace_json;             // optional path of a Chrome trace JSON file with compile phase timings
     std::string module;                 // optional @module name override
     std::vector<std::string> defines;   // additional preprocessor defines
     uint32_t slang = 0;                 // combined Slang bits
     bool byte_code = false;             // output byte code (for HLSL and MetalSL)
+    OptLevel::Enum opt_level = OptLevel::SIZE;  // SPIRV optimization level
+    bool wgsl_opt = false;              // run the (experimental) Tint-compatible SPIRV optimizer passes for WGSL
+    bool minify = false;                // minify embedded shader source code
+    Compression::Enum compression = Compression::NONE;  // compression of embedded shader arrays
+    int hlsl_opt_level = 3;             // D3DCompile optimization level (0..3), -1 to skip optimization
+    bool hlsl_strip = false;            // strip reflection and debug data from HLSL bytecode
+    bool metal_in_memory = false;       // pipe Metal source via stdin, and use a private temp dir
+    bool single_metallib = false;       // link all Metal shaders of a module into one metallib
+    MslVersion::Enum metal_version = MslVersion::MSL_1_1;   // minimum Metal shading language version
+    std::string metal_macos_min;        // optional macOS deployment target (default: derived from the Metal version)
+    std::string metal_ios_min;          // optional iOS deployment target (default: derived from the Metal version)
+    bool metal_precise_math = false;    // compile Metal bytecode without -ffast-math
+    std::string metal_opt;              // optional Metal compiler optimization level (0, 1, 2, 3 or s)
+    bool embed = false;                 // write shader arrays to sidecar files, embedded at compile time
     bool reflection = false;            // if true, generate runtime reflection functions
+    bool warn_unused_uniforms = false;  // warn about uniform block members which are never read by a shader
+    bool warn_uniform_padding = false;  // warn about uniform blocks with avoidable std140 padding
+    bool warn_early_fragment_tests = false; // warn about fragment shaders which disable early depth/stencil tests
+    bool module_bind_slots = false;     // same bind slot for same-named resources across all programs of a module
+    bool const_desc = false;            // generate shader descs as static const tables (sokol and sokol_impl format only)
+    bool split_backends = false;        // write the shader arrays and desc functions into one file per backend (sokol and sokol_impl format only)
+    bool aligned_sbufs = false;         // naturally aligned std430 storage buffer structs with layout asserts (sokol, sokol_impl and sokol_zig format only)
     Format::Enum output_format = Format::SOKOL; // output format
+    std::vector<Output> extra_outputs;  // additional --format/--output pairs after the first
     bool debug_dump = false;            // print debug-dump info
+    bool check = false;                 // only validate the input, don't write any output files
+    bool watch = false;                 // recompile whenever a source file changes
+    bool write_if_changed = false;      // don't overwrite output files with identical content
     bool ifdef = false;                 // wrap backend specific shaders into #ifdefs (SOKOL_D3D11 etc...)
     bool save_intermediate_spirv = false;   // save intermediate SPIRV bytecode (glslangvalidator output)
+    bool profile_build = false;         // line directives and debug info for GPU profilers
     int gen_version = 1;                // generator-version stamp
+    bool pack = false;                  // bare and bare_yaml: write all shader files of a module into a single pack file
+    int yaml_schema = 1;                // bare_yaml schema version (2: reflection only once per program)
+    int jobs = 0;                       // max number of parallel compile jobs (0: one per hardware thread)
     ErrMsg::Format error_format = ErrMsg::GCC;  // format for error messages
+    IoHooks io;                         // optional in-memory file access (libshdc only)
 
     static Args parse(int argc, const char** argv);
+    static bool parse_batch(const Args& args, std::vector<Args>& out_batch);
+    // the SPIRV optimization level for a target language (WGSL skips the optimizer without --wgsl-opt)
+    OptLevel::Enum spirv_opt_level(Slang::Enum slang) const;
+    // a path as written into generated files, relative to the --reproducible root if provided
+    std::string reproducible_path(const std::string& path) const;
+    // the per-backend file of an output file with --split-backends (e.g. 'shd.glsl430.h' for 'shd.h')
+    static std::string split_backend_path(const std::string& output, Slang::Enum slang);
     void dump_debug() const;
 };
 
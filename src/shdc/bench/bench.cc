@@ -0,0 +1,387 @@
+/*
+    shdc-bench: compile-throughput benchmark over the test shader corpus
+*/
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "fmt/format.h"
+#include "getopt/getopt.h"
+#include "pystring.h"
+#include "spirv.h"
+#include "args.h"
+#include "input.h"
+#include "compile.h"
+#include "jobs.h"
+#include "cache.h"
+#include "timings.h"
+#include "types/format.h"
+
+using namespace shdc;
+
+enum {
+    OPTION_HELP = 256,
+    OPTION_DIR,
+    OPTION_OUT_DIR,
+    OPTION_ITERATIONS,
+    OPTION_SLANG,
+    OPTION_FORMAT,
+    OPTION_BYTECODE,
+    OPTION_JOBS,
+    OPTION_JSON,
+};
+
+static const getopt_option_t option_list[] = {
+    { "help",       'h', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_HELP,         "print this help text", 0},
+    { "dir",        0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_DIR,          "test directory, compiles [dir]/*.glsl and [dir]/sapp/*.glsl (default: test)", "[dir]" },
+    { "out-dir",    0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_OUT_DIR,      "directory for generated files (default: system temp dir)", "[dir]" },
+    { "iterations", 'n', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_ITERATIONS,   "number of timed iterations over the corpus (default: 3)", "[int]" },
+    { "slang",      'l', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_SLANG,        "shader languages (default: all which can be combined)", "glsl430:glsl300es..." },
+    { "format",     'f', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_FORMAT,       "output formats (default: all)", "sokol:sokol_zig..." },
+    { "bytecode",   'b', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_BYTECODE,     "also compile bytecode (HLSL and Metal)" },
+    { "jobs",       'j', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_JOBS,         "number of parallel compile jobs (default: number of CPU cores)", "[int]" },
+    { "json",       0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_JSON,         "write the results as JSON file for comparison across commits", "[path]" },
+    GETOPT_OPTIONS_END
+};
+
+// hlsl4/hlsl5 and glsl410/glsl430 are mutually exclusive, so the benchmark
+// uses the newer of each by default
+static const char* default_slangs = "glsl430:glsl300es:hlsl5:hlsl6:metal_macos:metal_ios:metal_sim:wgsl:spirv";
+
+struct BenchArgs {
+    bool valid = false;
+    int exit_code = 10;
+    std::string dir = "test";
+    std::string out_dir;
+    int iterations = 3;
+    std::string slang = default_slangs;
+    std::vector<std::string> formats;
+    bool byte_code = false;
+    int jobs = 0;
+    std::string json;
+};
+
+// one compile of an input file to one output format
+struct BenchItem {
+    std::string input;
+    Format::Enum format = Format::INVALID;
+    Args args;
+    int num_snippets = 0;
+};
+
+struct BenchResult {
+    int num_files = 0;
+    int num_compiles = 0;
+    int num_snippets = 0;
+    double seconds = 0.0;
+    int64_t peak_rss_kb = 0;
+    std::vector<Timings::PhaseTotal> phases;
+};
+
+static void print_help_string(getopt_context_t& ctx) {
+    fmt::print(stderr,
+        "Compile-throughput benchmark for sokol-shdc\n\n"
+        "Usage: shdc-bench [options]\n\n"
+        "Compiles all shaders of the test corpus in-process to all shader languages and output formats,\n"
+        "once to warm up and drop inputs which don't compile, and then repeatedly for measurement.\n\n"
+        "Options:\n\n");
+    char buf[4096];
+    fmt::print(stderr, "{}", getopt_create_help_string(&ctx, buf, sizeof(buf)));
+}
+
+static BenchArgs parse_args(int argc, const char** argv) {
+    BenchArgs args;
+    std::string formats;
+    getopt_context_t ctx;
+    if (getopt_create_context(&ctx, argc, argv, option_list) < 0) {
+        fmt::print(stderr, "error in getopt_create_context()\n");
+        return args;
+    }
+    int opt = 0;
+    while ((opt = getopt_next(&ctx)) != -1) {
+        switch (opt) {
+            case '+':
+                fmt::print(stderr, "shdc-bench: got argument without flag: {}\n", ctx.current_opt_arg);
+                return args;
+            case '?':
+                fmt::print(stderr, "shdc-bench: unknown flag {}\n", ctx.current_opt_arg);
+                return args;
+            case '!':
+                fmt::print(stderr, "shdc-bench: invalid use of flag {}\n", ctx.current_opt_arg);
+                return args;
+            case OPTION_DIR:
+                args.dir = ctx.current_opt_arg;
+                break;
+            case OPTION_OUT_DIR:
+                args.out_dir = ctx.current_opt_arg;
+                break;
+            case OPTION_ITERATIONS:
+                args.iterations = atoi(ctx.current_opt_arg);
+                if (args.iterations < 1) {
+                    fmt::print(stderr, "shdc-bench: invalid number of iterations '{}'\n", ctx.current_opt_arg);
+                    return args;
+                }
+                break;
+            case OPTION_SLANG:
+                args.slang = ctx.current_opt_arg;
+                break;
+            case OPTION_FORMAT:
+                formats = ctx.current_opt_arg;
+                break;
+            case OPTION_BYTECODE:
+                args.byte_code = true;
+                break;
+            case OPTION_JOBS:
+                args.jobs = atoi(ctx.current_opt_arg);
+                break;
+            case OPTION_JSON:
+                args.json = ctx.current_opt_arg;
+                break;
+            case OPTION_HELP:
+                print_help_string(ctx);
+                args.exit_code = 0;
+                return args;
+            default:
+                break;
+        }
+    }
+    if (formats.empty()) {
+        for (int i = 0; i < Format::NUM; i++) {
+            args.formats.push_back(Format::to_str((Format::Enum)i));
+        }
+    } else {
+        pystring::split(formats, args.formats, ":");
+        for (const std::string& format: args.formats) {
+            if (Format::from_str(format) == Format::INVALID) {
+                fmt::print(stderr, "shdc-bench: unknown output format '{}'\n", format);
+                return args;
+            }
+        }
+    }
+    if (args.out_dir.empty()) {
+        std::error_code ec;
+        args.out_dir = (std::filesystem::temp_directory_path(ec) / "shdc-bench").string();
+        if (ec) {
+            fmt::print(stderr, "shdc-bench: no temp directory, please provide --out-dir\n");
+            return args;
+        }
+    }
+    args.valid = true;
+    return args;
+}
+
+// all .glsl files in a directory, sorted for a reproducible compile order
+static std::vector<std::string> find_glsl_files(const std::string& dir) {
+    std::vector<std::string> res;
+    std::error_code ec;
+    for (const auto& entry: std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.is_regular_file() && (entry.path().extension() == ".glsl")) {
+            res.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+// peak resident set size of the process in KBytes
+static int64_t peak_rss_kb() {
+    #if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+            return (int64_t)(pmc.PeakWorkingSetSize / 1024);
+        }
+        return 0;
+    #else
+        struct rusage usage;
+        if (0 != getrusage(RUSAGE_SELF, &usage)) {
+            return 0;
+        }
+        #if defined(__APPLE__)
+            // macOS reports bytes instead of KBytes
+            return (int64_t)usage.ru_maxrss / 1024;
+        #else
+            return (int64_t)usage.ru_maxrss;
+        #endif
+    #endif
+}
+
+// build the compile args for each input file and output format, this parses the
+// same command line as sokol-shdc so that the benchmark runs the exact same code
+static bool build_items(const BenchArgs& bench_args, std::vector<BenchItem>& items) {
+    std::vector<std::string> inputs = find_glsl_files(bench_args.dir);
+    const std::vector<std::string> sapp_inputs = find_glsl_files(bench_args.dir + "/sapp");
+    inputs.insert(inputs.end(), sapp_inputs.begin(), sapp_inputs.end());
+    if (inputs.empty()) {
+        fmt::print(stderr, "shdc-bench: no .glsl files found in '{}'\n", bench_args.dir);
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(bench_args.out_dir, ec);
+    if (ec) {
+        fmt::print(stderr, "shdc-bench: failed to create output directory '{}'\n", bench_args.out_dir);
+        return false;
+    }
+    for (const std::string& input: inputs) {
+        // the test and sapp directories have files with the same name
+        std::string out_name = pystring::replace(input.substr(bench_args.dir.length() + 1), "/", "_");
+        for (const std::string& format: bench_args.formats) {
+            const std::string output = fmt::format("{}/{}.{}", bench_args.out_dir, out_name, format);
+            std::vector<const char*> argv = {
+                "sokol-shdc",
+                "-i", input.c_str(),
+                "-o", output.c_str(),
+                "-l", bench_args.slang.c_str(),
+                "-f", format.c_str(),
+            };
+            if (bench_args.byte_code) {
+                argv.push_back("-b");
+            }
+            BenchItem item;
+            item.input = input;
+            item.format = Format::from_str(format);
+            item.args = Args::parse((int)argv.size(), argv.data());
+            if (!item.args.valid) {
+                return false;
+            }
+            items.push_back(std::move(item));
+        }
+    }
+    return true;
+}
+
+// compile all items once, drop inputs which fail to compile for any output format
+// (e.g. error-provoking test shaders, or features not supported by a shader language)
+static void warmup(std::vector<BenchItem>& items) {
+    std::vector<std::string> failed;
+    for (BenchItem& item: items) {
+        if (std::find(failed.begin(), failed.end(), item.input) != failed.end()) {
+            continue;
+        }
+        if (0 != Compile::input(item.args)) {
+            fmt::print(stderr, "shdc-bench: skipping '{}' (failed to compile to '{}')\n", item.input, Format::to_str(item.format));
+            failed.push_back(item.input);
+            continue;
+        }
+        const Input inp = Input::load_and_parse(item.args.input, item.args.module);
+        for (const Snippet& snippet: inp.snippets) {
+            item.num_snippets += Snippet::is_shader(snippet.type) ? 1 : 0;
+        }
+    }
+    items.erase(std::remove_if(items.begin(), items.end(), [&](const BenchItem& item) {
+        return std::find(failed.begin(), failed.end(), item.input) != failed.end();
+    }), items.end());
+}
+
+static BenchResult run(const BenchArgs& bench_args, const std::vector<BenchItem>& items) {
+    BenchResult res;
+    std::vector<std::string> files;
+    for (const BenchItem& item: items) {
+        if (std::find(files.begin(), files.end(), item.input) == files.end()) {
+            files.push_back(item.input);
+        }
+    }
+    Timings::clear();
+    const auto start = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < bench_args.iterations; iteration++) {
+        for (const BenchItem& item: items) {
+            Compile::input(item.args);
+            res.num_compiles++;
+            res.num_snippets += item.num_snippets;
+        }
+        res.num_files += (int)files.size();
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    res.peak_rss_kb = peak_rss_kb();
+    res.phases = Timings::phase_totals();
+    return res;
+}
+
+static void print_result(const BenchArgs& bench_args, const BenchResult& res) {
+    fmt::print(stderr, "shdc-bench: {} iterations, {} compiles, {} slangs, {} formats, {} jobs\n",
+        bench_args.iterations, res.num_compiles, bench_args.slang, bench_args.formats.size(), Jobs::num_jobs());
+    fmt::print(stderr, "  total:       {:>10.3f} s\n", res.seconds);
+    fmt::print(stderr, "  files/sec:   {:>10.2f}\n", res.num_files / res.seconds);
+    fmt::print(stderr, "  snippets/sec:{:>10.2f}\n", res.num_snippets / res.seconds);
+    fmt::print(stderr, "  peak RSS:    {:>10.2f} MB\n", res.peak_rss_kb / 1024.0);
+    fmt::print(stderr, "  {:<20} {:>8} {:>11} {:>7}\n", "phase", "count", "total ms", "%");
+    for (const Timings::PhaseTotal& phase: res.phases) {
+        fmt::print(stderr, "  {:<20} {:>8} {:>11.2f} {:>6.1f}%\n",
+            phase.name,
+            phase.count,
+            phase.total_us / 1000.0,
+            (100.0 * phase.total_us) / (res.seconds * 1000000.0));
+    }
+}
+
+static bool write_json(const BenchArgs& bench_args, const BenchResult& res) {
+    std::string out = "{\n";
+    out += fmt::format("  \"iterations\": {},\n", bench_args.iterations);
+    out += fmt::format("  \"jobs\": {},\n", Jobs::num_jobs());
+    out += fmt::format("  \"slangs\": \"{}\",\n", bench_args.slang);
+    out += fmt::format("  \"formats\": \"{}\",\n", pystring::join(":", bench_args.formats));
+    out += fmt::format("  \"bytecode\": {},\n", bench_args.byte_code ? "true" : "false");
+    out += fmt::format("  \"files\": {},\n", res.num_files);
+    out += fmt::format("  \"compiles\": {},\n", res.num_compiles);
+    out += fmt::format("  \"snippets\": {},\n", res.num_snippets);
+    out += fmt::format("  \"seconds\": {:.6f},\n", res.seconds);
+    out += fmt::format("  \"files_per_sec\": {:.3f},\n", res.num_files / res.seconds);
+    out += fmt::format("  \"snippets_per_sec\": {:.3f},\n", res.num_snippets / res.seconds);
+    out += fmt::format("  \"peak_rss_kb\": {},\n", res.peak_rss_kb);
+    out += "  \"phases\": [\n";
+    for (size_t i = 0; i < res.phases.size(); i++) {
+        const Timings::PhaseTotal& phase = res.phases[i];
+        out += fmt::format("    {{ \"name\": \"{}\", \"count\": {}, \"total_us\": {} }}{}\n",
+            phase.name, phase.count, phase.total_us, (i + 1 < res.phases.size()) ? "," : "");
+    }
+    out += "  ]\n}\n";
+    FILE* fp = fopen(bench_args.json.c_str(), "w");
+    if (!fp) {
+        fmt::print(stderr, "shdc-bench: failed to open '{}' for writing\n", bench_args.json);
+        return false;
+    }
+    fwrite(out.c_str(), out.length(), 1, fp);
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, const char** argv) {
+    const BenchArgs bench_args = parse_args(argc, argv);
+    if (!bench_args.valid) {
+        return bench_args.exit_code;
+    }
+    Spirv::initialize_spirv_tools();
+    Jobs::setup(bench_args.jobs);
+    Cache::setup("", "", 0, Args().gen_version);
+    Timings::setup(true);
+
+    int exit_code = 10;
+    std::vector<BenchItem> items;
+    if (build_items(bench_args, items)) {
+        warmup(items);
+        if (items.empty()) {
+            fmt::print(stderr, "shdc-bench: no input file compiled successfully\n");
+        } else {
+            const BenchResult res = run(bench_args, items);
+            print_result(bench_args, res);
+            exit_code = 0;
+            if (!bench_args.json.empty() && !write_json(bench_args, res)) {
+                exit_code = 10;
+            }
+        }
+    }
+
+    Timings::discard();
+    Cache::discard();
+    Jobs::discard();
+    Spirv::finalize_spirv_tools();
+    return exit_code;
+}
@@ -1,21 +1,42 @@
 /*
-    Compile HLSL / Metal source code to bytecode, HLSL only works
-    when running on Windows, Metal only works when running on macOS.
+    Compile HLSL / Metal source code to bytecode, Metal only works
+    when running on macOS.
 
-    Uses d3dcompiler.dll for HLSL, and for Metal, invokes the Metal
-    compiler toolchain command line tools.
+    On Windows, uses d3dcompiler.dll for HLSL4/5 and dxcompiler.dll for
+    HLSL6, on Linux and macOS, invokes the vkd3d-compiler (HLSL4/5) and
+    dxc (HLSL6) command line tools if they can be found in the PATH.
+    For Metal, invokes the Metal compiler toolchain command line tools.
 
     On Metal, bytecode compilation only happens for the macOS and iOS
     targets, but not for running in the simulator, in this case,
     shaders are compiled at runtime from source code.
 */
 #include "bytecode.h"
+#include "cache.h"
+#include "timings.h"
+#include "jobs.h"
+#include "process.h"
+#include "types/option.h"
 #include "fmt/format.h"
 #include "pystring.h"
-#include <stdio.h> // popen etc...
+#include "spirv-tools/libspirv.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#if !defined(_WIN32)
+#include <mutex>
+#include <unistd.h>
+#include <dirent.h>
+#include <ctype.h>
+#include <stdlib.h>
+#endif
 #if defined(_WIN32)
+#include <mutex>
 #include <d3dcompiler.h>
 #include <d3dcommon.h>
+#include <d3d11shader.h>
+#include <dxcapi.h>
 #endif
 
 namespace shdc {
@@ -29,8 +50,77 @@ const BytecodeBlob* Bytecode::find_blob_by_snippet_index(int snippet_index) cons
     return nullptr;
 }
 
-// MacOS/Metal specific stuff...
-#if defined(__APPLE__)
+// convert errors from DXC format to ErrMsg objects (DXC is used on all host platforms)
+static void dxc_parse_errors(const std::string& output, const Input& inp, std::vector<ErrMsg>& out_errors) {
+    /*
+        format for errors/warnings is:
+
+        PATH:LINE:COL: [warning|error]: MESSAGE
+
+        ...followed by the offending source line and a caret line, which
+        are skipped, just like 'note:' lines
+    */
+    std::vector<std::string> lines;
+    pystring::splitlines(output, lines);
+    static const std::string error_tag = ": error: ";
+    static const std::string warning_tag = ": warning: ";
+    for (const std::string& line: lines) {
+        size_t pos;
+        if ((pos = line.find(error_tag)) != std::string::npos) {
+            out_errors.push_back(ErrMsg::error(inp.base_path, 0, line.substr(pos + error_tag.length())));
+        } else if ((pos = line.find(warning_tag)) != std::string::npos) {
+            out_errors.push_back(ErrMsg::warning(inp.base_path, 0, line.substr(pos + warning_tag.length())));
+        }
+    }
+}
+
+// HLSL shader profile prefix for a snippet type, combined with a shader model (e.g. "5_0")
+static std::string hlsl_profile(const Snippet& snippet, const char* shader_model) {
+    const char* prefix = "ps";
+    if (snippet.type == Snippet::VS) {
+        prefix = "vs";
+    } else if (snippet.type == Snippet::CS) {
+        prefix = "cs";
+    }
+    return fmt::format("{}_{}", prefix, shader_model);
+}
+
+// DXC command line args shared by dxcompiler.dll and the dxc command line tool,
+// without input and output file
+static std::vector<std::string> dxc_args(const Args& args, const SpirvcrossSource& src, const Snippet& snippet) {
+    std::vector<std::string> res = {
+        "-E", src.stage_refl->entry_point,
+        "-T", hlsl_profile(snippet, "6_0"),
+        "-Zpc",     // pack matrices column-major
+    };
+    // native 16-bit types need shader model 6.2
+    if (src.stage_refl->uses_16bit_types) {
+        res[3] = hlsl_profile(snippet, "6_2");
+        res.push_back("-enable-16bit-types");
+    }
+    // --hlsl-opt
+    switch (args.hlsl_opt_level) {
+        case 0:  res.push_back("-O0"); break;
+        case 1:  res.push_back("-O1"); break;
+        case 2:  res.push_back("-O2"); break;
+        case 3:  res.push_back("-O3"); break;
+        default: res.push_back("-Od"); break;
+    }
+    // --profile-build: embed debug info for PIX
+    if (args.profile_build) {
+        res.push_back("-Zi");
+        res.push_back("-Qembed_debug");
+    }
+    // optionally move debug- and reflection-data out of the DXIL container
+    if (args.hlsl_strip) {
+        res.push_back("-Qstrip_debug");
+        res.push_back("-Qstrip_reflect");
+    }
+    return res;
+}
+
+// POSIX helpers to run command line tools (Metal toolchain, and HLSL compilers on Linux and macOS)
+#if !defined(_WIN32)
 
 // write source code to file
 static bool write_source(const std::string& source_code, const std::string path) {
@@ -65,6 +155,59 @@ static bool read_binary(const std::string& path, std::vector<uint8_t>& out_blob)
     }
 }
 
+// the file name prefix for intermediate files, the hash of the full input path
+// keeps parallel --batch jobs for inputs with the same basename apart
+static std::string tmp_base_path(const std::string& tmp_dir, const Input& inp, Slang::Enum slang) {
+    std::string base_dir;
+    std::string base_filename;
+    pystring::os::path::split(base_dir, base_filename, inp.base_path);
+    const uint32_t path_hash = (uint32_t)std::hash<std::string>()(inp.base_path);
+    return fmt::format("{}{}_{:08x}_{}_", tmp_dir, base_filename, path_hash, Slang::to_str(slang));
+}
+
+#endif
+
+// the Metal compiler flags for one shader source, the Metal language version is
+// derived the same way as for the SPIRV-Cross MSL output (see Spirvcross::translate()),
+// and the deployment target is at least the minimum OS version of the Metal version
+// (also used for the bytecode cache keys on all host platforms)
+static std::vector<std::string> mtl_cc_flags(const Args& args, const Input& inp, const SpirvcrossSource& src, Slang::Enum slang) {
+    const uint32_t opt_mask = inp.snippets[src.snippet_index].options[slang];
+    const MslVersion::Enum version = MslVersion::for_shader(args.metal_version, !src.stage_refl->spec_constants.empty(), 0 != (opt_mask & Option::ARGUMENT_BUFFERS));
+    std::vector<std::string> flags;
+    const bool precise_math = args.metal_precise_math || (0 != (opt_mask & Option::PRECISE_MATH));
+    flags.push_back(precise_math ? "-fno-fast-math" : "-ffast-math");
+    if (!args.metal_opt.empty()) {
+        flags.push_back(fmt::format("-O{}", args.metal_opt));
+    }
+    const bool is_macos = (slang == Slang::METAL_MACOS);
+    const std::string& user_min = is_macos ? args.metal_macos_min : args.metal_ios_min;
+    std::string os_min = is_macos ? MslVersion::macos_min(version) : MslVersion::ios_min(version);
+    if (!user_min.empty() && (MslVersion::os_version_value(user_min) > MslVersion::os_version_value(os_min))) {
+        os_min = user_min;
+    }
+    flags.push_back(fmt::format("{}{}", is_macos ? "-mmacosx-version-min=" : "-miphoneos-version-min=", os_min));
+    // Metal 3.0 has a common version for all platforms, and macOS uses 'macos' instead of 'osx' since Metal 2.3
+    const char* std_platform;
+    if (version >= MslVersion::MSL_3_0) {
+        std_platform = "";
+    } else if (is_macos) {
+        std_platform = (version >= MslVersion::MSL_2_3) ? "macos-" : "osx-";
+    } else {
+        std_platform = "ios-";
+    }
+    flags.push_back(fmt::format("-std={}metal{}", std_platform, MslVersion::to_str(version)));
+    // --profile-build: line tables and the embedded source for the Xcode GPU debugger
+    if (args.profile_build) {
+        flags.push_back("-gline-tables-only");
+        flags.push_back("-frecord-sources");
+    }
+    return flags;
+}
+
+// MacOS/Metal specific stuff...
+#if defined(__APPLE__)
+
 // convert errors from metal compiler format to ErrMsg objects
 static void mtl_parse_errors(const std::string& output, const Input& inp, int snippet_index, std::vector<ErrMsg>& out_errors) {
     /*
@@ -119,98 +262,389 @@ static void mtl_parse_errors(const std::string& output, const Input& inp, int sn
     }
 }
 
-// run a command line program via xcrun, capture its output and exit code
-static int xcrun(const std::string& cmdline, std::string& output, Slang::Enum slang) {
-    std::string cmd = "xcrun ";
-    if (slang == Slang::METAL_MACOS) {
-        cmd += "--sdk macosx ";
-    } else {
-        cmd += "--sdk iphoneos ";
+
+// the Metal toolchain paths for one SDK, resolved once via xcrun
+struct MtlTools {
+    bool valid = false;
+    std::string metal;
+    std::string metallib;
+    std::string sdk_path;
+};
+
+static std::string xcrun_query(const char* sdk, const char* query, const char* tool) {
+    std::vector<std::string> args = { "/usr/bin/xcrun", "--sdk", sdk, query };
+    if (tool) {
+        args.push_back(tool);
     }
-    cmd += cmdline;
-    cmd += " 2>&1";
+    std::string output;
+    if (0 != Process::run(args, output)) {
+        return std::string();
+    }
+    return pystring::strip(output);
+}
 
-    int exit_code = 10;
-    FILE* p = popen(cmd.c_str(), "r");
-    if (p) {
-        char buf[1024];
-        buf[0] = 0;
-        while (fgets(buf, sizeof(buf), p)) {
-            output += buf;
-        }
-        exit_code = pclose(p);
+static const MtlTools& mtl_tools(Slang::Enum slang) {
+    static std::mutex mutex;
+    static MtlTools tools[2];
+    static bool resolved[2] = { false, false };
+    const int index = (slang == Slang::METAL_MACOS) ? 0 : 1;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!resolved[index]) {
+        resolved[index] = true;
+        const char* sdk = (index == 0) ? "macosx" : "iphoneos";
+        MtlTools& t = tools[index];
+        t.metal = xcrun_query(sdk, "--find", "metal");
+        t.metallib = xcrun_query(sdk, "--find", "metallib");
+        t.sdk_path = xcrun_query(sdk, "--show-sdk-path", nullptr);
+        t.valid = !t.metal.empty() && !t.metallib.empty() && !t.sdk_path.empty();
     }
-    return exit_code;
+    return tools[index];
 }
 
-// run the metal compiler pass
-static bool mtl_cc(const std::string& src_path, const std::string& out_dia, const std::string& out_air, Slang::Enum slang, std::string& output) {
-    std::string cmdline;
-    cmdline =  "metal -arch air64 -emit-llvm -ffast-math -c -serialize-diagnostics ";
-    cmdline += out_dia;
-    cmdline += " -o ";
-    cmdline += out_air;
-    if (slang == Slang::METAL_MACOS) {
-        cmdline += " -mmacosx-version-min=10.11 -std=osx-metal1.1 ";
+// run the metal compiler pass, if source is provided, it is piped through stdin,
+// and src_path is only used for diagnostics, also no .dia file is written
+static bool mtl_cc(const std::string& src_path, const std::string& out_dia, const std::string& out_air, Slang::Enum slang, const std::vector<std::string>& flags, std::string& output, const std::string* source = nullptr) {
+    const MtlTools& tools = mtl_tools(slang);
+    if (!tools.valid) {
+        output += "error: failed to locate the Metal compiler toolchain via xcrun\n";
+        return false;
+    }
+    std::vector<std::string> args = {
+        tools.metal, "-isysroot", tools.sdk_path,
+        "-arch", "air64", "-emit-llvm", "-c",
+        "-o", out_air,
+    };
+    if (!source) {
+        args.push_back("-serialize-diagnostics");
+        args.push_back(out_dia);
+    }
+    args.insert(args.end(), flags.begin(), flags.end());
+    if (source) {
+        args.push_back("-x");
+        args.push_back("metal");
+        args.push_back("-");
     } else {
-        cmdline += " -miphoneos-version-min=9.0 -std=ios-metal1.1 ";
+        args.push_back(src_path);
     }
-    cmdline += src_path;
-    return 0 == xcrun(cmdline, output, slang);
+    return 0 == Process::run(args, output, source);
 }
 
 // run the metal linker pass
-static bool mtl_link(const std::string& lib_path, const std::string& bin_path, Slang::Enum slang) {
+static bool mtl_link(const std::vector<std::string>& air_paths, const std::string& bin_path, Slang::Enum slang) {
+    const MtlTools& tools = mtl_tools(slang);
+    if (!tools.valid) {
+        return false;
+    }
+    std::vector<std::string> args = { tools.metallib, "-o", bin_path };
+    args.insert(args.end(), air_paths.begin(), air_paths.end());
     std::string dummy_output;
-    std::string cmdline = fmt::format("metallib -o {} {}", bin_path, lib_path);
-    return 0 == xcrun(cmdline, dummy_output, slang);
+    return 0 == Process::run(args, dummy_output);
 }
 
-static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
-    Bytecode bytecode;
-    std::string base_dir;
-    std::string base_filename;
-    pystring::os::path::split(base_dir, base_filename, inp.base_path);
-    std::string base_path = fmt::format("{}{}_{}_", args.tmpdir, base_filename, Slang::to_str(slang));
-    std::string src_path, dia_path, air_path, lib_path, bin_path;
+// with --metal-in-memory, intermediate files go into a private directory
+// below $TMPDIR, which is removed with all its content when done
+struct MtlPrivateDir {
+    std::string path;
+    bool create() {
+        const char* tmp = getenv("TMPDIR");
+        std::string tmpl = (tmp && tmp[0]) ? tmp : "/tmp";
+        if (!pystring::endswith(tmpl, "/")) {
+            tmpl += "/";
+        }
+        tmpl += "sokol-shdc-XXXXXX";
+        std::vector<char> buf(tmpl.begin(), tmpl.end());
+        buf.push_back(0);
+        if (!mkdtemp(buf.data())) {
+            return false;
+        }
+        path = fmt::format("{}/", buf.data());
+        return true;
+    }
+    ~MtlPrivateDir() {
+        if (path.empty()) {
+            return;
+        }
+        DIR* dir = opendir(path.c_str());
+        if (dir) {
+            struct dirent* ent;
+            while ((ent = readdir(dir)) != nullptr) {
+                if ((0 != strcmp(ent->d_name, ".")) && (0 != strcmp(ent->d_name, ".."))) {
+                    unlink(fmt::format("{}{}", path, ent->d_name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+        rmdir(path.c_str());
+    }
+};
 
-    // for each vertex/fragment shader source generated by SPIRV-Cross:
-    for (const SpirvcrossSource& src: spirvcross.sources) {
-        std::string output;
-        const Snippet& snippet = inp.snippets[src.snippet_index];
-        src_path = fmt::format("{}{}.metal", base_path, snippet.name);
-        dia_path = fmt::format("{}{}.dia", base_path, snippet.name);
-        air_path = fmt::format("{}{}.air", base_path, snippet.name);
-        bin_path = fmt::format("{}{}.metallib", base_path, snippet.name);
+// compile a single Metal source into an .air file, returns false on error
+static bool mtl_compile_air(const Args& args, const Input& inp, const SpirvcrossSource& src, const std::string& base_path, Slang::Enum slang, bool use_stdin, std::vector<ErrMsg>& out_errors) {
+    std::string output;
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    const std::string src_path = fmt::format("{}{}.metal", base_path, snippet.name);
+    const std::string dia_path = fmt::format("{}{}.dia", base_path, snippet.name);
+    const std::string air_path = fmt::format("{}{}.air", base_path, snippet.name);
+    Timings::Scope scope("mtl_compile", snippet.name, Slang::to_str(slang));
+    const std::vector<std::string> flags = mtl_cc_flags(args, inp, src, slang);
+    bool ok;
+    if (use_stdin) {
+        ok = mtl_cc(src_path, dia_path, air_path, slang, flags, output, &src.source_code);
+    } else {
         // write metal source code to temp file
         if (!write_source(src.source_code, src_path)) {
-            bytecode.errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to write intermediate file '{}'!", src_path)));
-            break;
+            out_errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to write intermediate file '{}'!", src_path)));
+            return false;
+        }
+        ok = mtl_cc(src_path, dia_path, air_path, slang, flags, output);
+    }
+    // if no hard error happened there may still have been warnings
+    if (!output.empty()) {
+        mtl_parse_errors(output, inp, src.snippet_index, out_errors);
+    }
+    return ok;
+}
+
+// link one or more .air files into a metallib, and load the result
+static bool mtl_link_and_load(const Input& inp, const std::vector<std::string>& air_paths, const std::string& bin_path, Slang::Enum slang, std::vector<uint8_t>& out_data, std::vector<ErrMsg>& out_errors) {
+    Timings::Scope scope("mtl_link", bin_path, Slang::to_str(slang));
+    if (!mtl_link(air_paths, bin_path, slang)) {
+        out_errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to link '{}'!", bin_path)));
+        return false;
+    }
+    if (!read_binary(bin_path, out_data)) {
+        out_errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to read '{}'!", bin_path)));
+        return false;
+    }
+    return true;
+}
+
+// each vertex/fragment shader source generated by SPIRV-Cross is compiled as a
+// separate job (limited by --jobs), all temp files have per-snippet names, with
+// --single-metallib, all .air files are linked into the same metallib, and each
+// bytecode blob contains that same metallib (so that only one copy is written
+// to the generated code)
+static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+    MtlPrivateDir private_dir;
+    std::string tmp_dir = args.tmpdir;
+    if (args.metal_in_memory) {
+        if (!private_dir.create()) {
+            Bytecode bytecode;
+            bytecode.errors.push_back(ErrMsg::error(inp.base_path, 0, "failed to create private temp directory for Metal compilation!"));
+            return bytecode;
         }
-        // compiler, link, load generated bytecode
-        if (!mtl_cc(src_path, dia_path, air_path, slang, output)) {
-            mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
-            break;
+        tmp_dir = private_dir.path;
+    }
+    const std::string base_path = tmp_base_path(tmp_dir, inp, slang);
+
+    const int num_sources = (int)spirvcross.sources.size();
+    std::vector<BytecodeBlob> blobs(num_sources);
+    std::vector<std::vector<ErrMsg>> errors(num_sources);
+    std::vector<char> ok(num_sources, 0);
+    Jobs::run(num_sources, [&](int i) {
+        const SpirvcrossSource& src = spirvcross.sources[i];
+        if (!mtl_compile_air(args, inp, src, base_path, slang, args.metal_in_memory, errors[i])) {
+            return;
         }
-        if (!mtl_link(air_path, bin_path, slang)) {
-            mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
-            break;
+        if (!args.single_metallib) {
+            const Snippet& snippet = inp.snippets[src.snippet_index];
+            const std::string air_path = fmt::format("{}{}.air", base_path, snippet.name);
+            const std::string bin_path = fmt::format("{}{}.metallib", base_path, snippet.name);
+            if (!mtl_link_and_load(inp, { air_path }, bin_path, slang, blobs[i].data, errors[i])) {
+                return;
+            }
+        }
+        blobs[i].valid = true;
+        blobs[i].snippet_index = src.snippet_index;
+        ok[i] = 1;
+    });
+
+    // gather results in source order, and stop at the first failed source
+    Bytecode bytecode;
+    for (int i = 0; i < num_sources; i++) {
+        bytecode.errors.insert(bytecode.errors.end(), errors[i].begin(), errors[i].end());
+        if (!ok[i]) {
+            return bytecode;
+        }
+        bytecode.blobs.push_back(std::move(blobs[i]));
+    }
+    if (args.single_metallib && (num_sources > 0)) {
+        std::vector<std::string> air_paths;
+        for (const SpirvcrossSource& src: spirvcross.sources) {
+            air_paths.push_back(fmt::format("{}{}.air", base_path, inp.snippets[src.snippet_index].name));
         }
         std::vector<uint8_t> data;
-        if (!read_binary(bin_path, data)) {
-            mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
-            break;
+        if (!mtl_link_and_load(inp, air_paths, fmt::format("{}module.metallib", base_path), slang, data, bytecode.errors)) {
+            bytecode.blobs.clear();
+            return bytecode;
         }
-        // if hard error happened there may still have been warnings
-        if (!output.empty()) {
-            mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
+        for (BytecodeBlob& blob: bytecode.blobs) {
+            blob.data = data;
         }
+    }
+    return bytecode;
+}
+#endif
 
-        BytecodeBlob blob;
-        blob.valid = true;
-        blob.snippet_index = src.snippet_index;
-        blob.data = std::move(data);
-        bytecode.blobs.push_back(std::move(blob));
+// Linux/macOS: HLSL bytecode via command line tools found in PATH, vkd3d-compiler
+// for HLSL4/5 (DXBC), and the cross-platform dxc for HLSL6 (DXIL)
+#if !defined(_WIN32)
+
+// the HLSL command line tools, resolved once, empty if not found
+struct HlslTools {
+    std::string vkd3d_compiler;
+    std::string dxc;
+    // the '--version' output of the tools, goes into the bytecode cache key
+    std::string vkd3d_compiler_version;
+    std::string dxc_version;
+};
+
+static std::string find_in_path(const char* name) {
+    const char* path_env = getenv("PATH");
+    std::vector<std::string> dirs;
+    pystring::split(path_env ? path_env : "", dirs, ":");
+    for (const std::string& dir: dirs) {
+        const std::string path = fmt::format("{}/{}", dir.empty() ? "." : dir, name);
+        if (0 == access(path.c_str(), X_OK)) {
+            return path;
+        }
+    }
+    return std::string();
+}
+
+static std::string tool_version(const std::string& path) {
+    std::string output;
+    if (path.empty() || (0 != Process::run({ path, "--version" }, output))) {
+        return std::string();
+    }
+    return pystring::strip(output);
+}
+
+static const HlslTools& hlsl_tools() {
+    static std::mutex mutex;
+    static HlslTools tools;
+    static bool resolved = false;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!resolved) {
+        resolved = true;
+        tools.vkd3d_compiler = find_in_path("vkd3d-compiler");
+        tools.dxc = find_in_path("dxc");
+        tools.vkd3d_compiler_version = tool_version(tools.vkd3d_compiler);
+        tools.dxc_version = tool_version(tools.dxc);
+    }
+    return tools;
+}
+
+// the command line tool used for a HLSL target language, or an empty string
+static const std::string& hlsl_tool(Slang::Enum slang) {
+    const HlslTools& tools = hlsl_tools();
+    return (slang == Slang::HLSL6) ? tools.dxc : tools.vkd3d_compiler;
+}
+
+// identifies the HLSL compiler and its version for the bytecode cache key
+static std::string hlsl_tool_id(Slang::Enum slang) {
+    const HlslTools& tools = hlsl_tools();
+    if (slang == Slang::HLSL6) {
+        return fmt::format("dxc {}", tools.dxc_version);
+    } else {
+        return fmt::format("vkd3d-compiler {}", tools.vkd3d_compiler_version);
+    }
+}
+
+// convert errors from vkd3d-compiler format to ErrMsg objects
+static void vkd3d_parse_errors(const std::string& output, const Input& inp, std::vector<ErrMsg>& out_errors) {
+    /*
+        format for errors/warnings is:
+
+        PATH:LINE:COL: [E|W]NNNN: MESSAGE
+    */
+    std::vector<std::string> lines;
+    pystring::splitlines(output, lines);
+    for (const std::string& line: lines) {
+        bool found = false;
+        size_t pos = 0;
+        while (!found && ((pos = line.find(": ", pos)) != std::string::npos)) {
+            pos += 2;
+            if (((pos + 1) < line.size()) && ((line[pos] == 'E') || (line[pos] == 'W')) && isdigit((unsigned char)line[pos + 1])) {
+                const size_t msg_pos = line.find(": ", pos);
+                if (msg_pos != std::string::npos) {
+                    const std::string msg = line.substr(msg_pos + 2);
+                    if (line[pos] == 'E') {
+                        out_errors.push_back(ErrMsg::error(inp.base_path, 0, msg));
+                    } else {
+                        out_errors.push_back(ErrMsg::warning(inp.base_path, 0, msg));
+                    }
+                    found = true;
+                }
+            }
+        }
+    }
+}
+
+// compile a single HLSL source through a temp file, may be called from parallel jobs
+static void hlsl_tool_compile_source(const Args& args, const Input& inp, const SpirvcrossSource& src, const std::string& base_path, Slang::Enum slang, BytecodeBlob& out_blob, std::vector<ErrMsg>& out_errors) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    const std::string src_path = fmt::format("{}{}.hlsl", base_path, snippet.name);
+    const std::string bin_path = fmt::format("{}{}.{}", base_path, snippet.name, (slang == Slang::HLSL6) ? "dxil" : "dxbc");
+    Timings::Scope scope("hlsl_compile", snippet.name, Slang::to_str(slang));
+    if (!write_source(src.source_code, src_path)) {
+        out_errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to write intermediate file '{}'!", src_path)));
+        return;
+    }
+    std::vector<std::string> tool_args = { hlsl_tool(slang) };
+    if (slang == Slang::HLSL6) {
+        const std::vector<std::string> common_args = dxc_args(args, src, snippet);
+        tool_args.insert(tool_args.end(), common_args.begin(), common_args.end());
+        tool_args.insert(tool_args.end(), { "-Fo", bin_path, src_path });
+    } else {
+        // NOTE: vkd3d-shader has no optimization levels and doesn't emit debug info,
+        // so --hlsl-opt and --hlsl-strip don't apply
+        const std::string profile = hlsl_profile(snippet, (slang == Slang::HLSL4) ? "4_0" : "5_0");
+        tool_args.insert(tool_args.end(), {
+            "-x", "hlsl", "-b", "dxbc-tpf",
+            fmt::format("--profile={}", profile),
+            fmt::format("--entry={}", src.stage_refl->entry_point),
+            "--matrix-storage-order=column",
+            "-o", bin_path, src_path,
+        });
+    }
+    std::string output;
+    const int exit_code = Process::run(tool_args, output);
+    if (slang == Slang::HLSL6) {
+        dxc_parse_errors(output, inp, out_errors);
+    } else {
+        vkd3d_parse_errors(output, inp, out_errors);
+    }
+    if (exit_code != 0) {
+        // make sure that a failed compilation is never silent
+        if (std::none_of(out_errors.begin(), out_errors.end(), [](const ErrMsg& err) { return err.type == ErrMsg::ERROR; })) {
+            out_errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("'{}' failed to compile snippet '{}': {}", tool_args[0], snippet.name, pystring::strip(output))));
+        }
+        return;
+    }
+    if (!read_binary(bin_path, out_blob.data) || out_blob.data.empty()) {
+        out_errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to read '{}'!", bin_path)));
+        return;
+    }
+    out_blob.valid = true;
+    out_blob.snippet_index = src.snippet_index;
+}
+
+static Bytecode hlsl_tool_compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+    const std::string base_path = tmp_base_path(args.tmpdir, inp, slang);
+    const int num_sources = (int)spirvcross.sources.size();
+    std::vector<BytecodeBlob> blobs(num_sources);
+    std::vector<std::vector<ErrMsg>> errors(num_sources);
+    Jobs::run(num_sources, [&](int i) {
+        hlsl_tool_compile_source(args, inp, spirvcross.sources[i], base_path, slang, blobs[i], errors[i]);
+    });
+    // gather results in source order
+    Bytecode bytecode;
+    for (int i = 0; i < num_sources; i++) {
+        bytecode.errors.insert(bytecode.errors.end(), errors[i].begin(), errors[i].end());
+        if (blobs[i].valid) {
+            bytecode.blobs.push_back(std::move(blobs[i]));
+        }
     }
     return bytecode;
 }
@@ -220,17 +654,43 @@ static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross
 #if defined(_WIN32)
 static HINSTANCE d3dcompiler_dll = 0;
 static pD3DCompile d3dcompile_func = 0;
+typedef HRESULT (WINAPI *pD3DStripShader)(LPCVOID pShaderBytecode, SIZE_T BytecodeLength, UINT uStripFlags, ID3DBlob** ppStrippedBlob);
+static pD3DStripShader d3dstripshader_func = 0;
+typedef HRESULT (WINAPI *pD3DReflect)(LPCVOID pSrcData, SIZE_T SrcDataSize, REFIID pInterface, void** ppReflector);
+static pD3DReflect d3dreflect_func = 0;
+static std::mutex d3dcompiler_mutex;
 
+// NOTE: may be called from parallel compile jobs
 static bool load_d3dcompiler_dll(void) {
+    std::lock_guard<std::mutex> lock(d3dcompiler_mutex);
     if (0 == d3dcompiler_dll) {
         d3dcompiler_dll = LoadLibraryA("d3dcompiler_47.dll");
         if (0 != d3dcompiler_dll) {
             d3dcompile_func = (pD3DCompile) GetProcAddress(d3dcompiler_dll, "D3DCompile");
+            d3dstripshader_func = (pD3DStripShader) GetProcAddress(d3dcompiler_dll, "D3DStripShader");
+            d3dreflect_func = (pD3DReflect) GetProcAddress(d3dcompiler_dll, "D3DReflect");
         }
     }
     return 0 != d3dcompile_func;
 }
 
+// DXC is only used for the HLSL6 target (Shader Model 6.x => DXIL)
+static HMODULE dxcompiler_dll = 0;
+static DxcCreateInstanceProc dxc_create_instance_func = 0;
+static std::mutex dxcompiler_mutex;
+
+// NOTE: may be called from parallel compile jobs
+static bool load_dxcompiler_dll(void) {
+    std::lock_guard<std::mutex> lock(dxcompiler_mutex);
+    if (0 == dxcompiler_dll) {
+        dxcompiler_dll = LoadLibraryA("dxcompiler.dll");
+        if (0 != dxcompiler_dll) {
+            dxc_create_instance_func = (DxcCreateInstanceProc) GetProcAddress(dxcompiler_dll, "DxcCreateInstance");
+        }
+    }
+    return 0 != dxc_create_instance_func;
+}
+
 static void d3d_parse_errors(const std::string& output, const Input& inp, int snippet_index, std::vector<ErrMsg>& out_errors) {
     /*
         format for errors/warnings is:
@@ -278,82 +738,400 @@ static void d3d_parse_errors(const std::string& output, const Input& inp, int sn
     }
 }
 
-static Bytecode d3d_compile(const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
-    Bytecode bytecode;
-    if (!load_d3dcompiler_dll()) {
-        bytecode.errors.push_back(ErrMsg::warning(inp.base_path, 0, fmt::format("failed to load d3dcompiler_47.dll!")));
-        return bytecode;
+// D3DCompile() flags for --hlsl-opt
+static UINT d3d_compile_flags(const Args& args) {
+    UINT flags = D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR;
+    switch (args.hlsl_opt_level) {
+        case 0:  flags |= D3DCOMPILE_OPTIMIZATION_LEVEL0; break;
+        case 1:  flags |= D3DCOMPILE_OPTIMIZATION_LEVEL1; break;
+        case 2:  flags |= D3DCOMPILE_OPTIMIZATION_LEVEL2; break;
+        case 3:  flags |= D3DCOMPILE_OPTIMIZATION_LEVEL3; break;
+        default: flags |= D3DCOMPILE_SKIP_OPTIMIZATION; break;
     }
-    for (const SpirvcrossSource& src: spirvcross.sources) {
-        const Snippet& snippet = inp.snippets[src.snippet_index];
-        ID3DBlob* output = NULL;
-        ID3DBlob* errors = NULL;
-        const char* compile_target = nullptr;
-        if (slang == Slang::HLSL4) {
-            if (snippet.type == Snippet::VS) {
-                compile_target = "vs_4_0";
-            } else {
-                compile_target = "ps_4_0";
-            }
-        } else {
-            if (snippet.type == Snippet::VS) {
-                compile_target = "vs_5_0";
-            } else {
-                compile_target = "ps_5_0";
+    // --profile-build: embed debug info for PIX
+    if (args.profile_build) {
+        flags |= D3DCOMPILE_DEBUG;
+    }
+    return flags;
+}
+
+// compile a single HLSL source, may be called from parallel jobs (D3DCompile is thread-safe)
+static void d3d_compile_source(const Args& args, const Input& inp, const SpirvcrossSource& src, Slang::Enum slang, BytecodeBlob& out_blob, std::vector<ErrMsg>& out_errors) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    Timings::Scope scope("d3d_compile", snippet.name, Slang::to_str(slang));
+    ID3DBlob* output = NULL;
+    ID3DBlob* errors = NULL;
+    const std::string compile_target = hlsl_profile(snippet, (slang == Slang::HLSL4) ? "4_0" : "5_0");
+    d3dcompile_func(
+        src.source_code.c_str(),        // pSrcData
+        src.source_code.length(),       // SrcDataSize
+        NULL,                           // pSourceName
+        NULL,                           // pDefines
+        NULL,                           // pInclude
+        src.stage_refl->entry_point.c_str(), // entryPoint
+        compile_target.c_str(),         // pTarget
+        d3d_compile_flags(args),        // Flags1
+        0,                              // Flags2
+        &output,                        // ppCode
+        &errors);                       // ppErrorMsgs
+    if (errors) {
+        std::string err_str((const char*)errors->GetBufferPointer());
+        d3d_parse_errors(err_str, inp, src.snippet_index, out_errors);
+    }
+    // optional shader statistics for --stats, must happen before stripping the reflection data
+    if (output && !args.stats.empty() && d3dreflect_func) {
+        ID3D11ShaderReflection* refl = NULL;
+        if (SUCCEEDED(d3dreflect_func(output->GetBufferPointer(), output->GetBufferSize(), __uuidof(ID3D11ShaderReflection), (void**)&refl)) && refl) {
+            D3D11_SHADER_DESC desc;
+            if (SUCCEEDED(refl->GetDesc(&desc))) {
+                out_blob.has_d3d_stats = true;
+                out_blob.d3d_instruction_count = (int)desc.InstructionCount;
+                out_blob.d3d_temp_register_count = (int)desc.TempRegisterCount;
+                out_blob.d3d_alu_instruction_count = (int)(desc.FloatInstructionCount + desc.IntInstructionCount + desc.UintInstructionCount);
+                out_blob.d3d_texture_instruction_count = (int)(desc.TextureNormalInstructions +
+                                                               desc.TextureLoadInstructions +
+                                                               desc.TextureCompInstructions +
+                                                               desc.TextureBiasInstructions +
+                                                               desc.TextureGradientInstructions);
             }
+            refl->Release();
         }
-        d3dcompile_func(
-            src.source_code.c_str(),        // pSrcData
-            src.source_code.length(),       // SrcDataSize
-            NULL,                           // pSourceName
-            NULL,                           // pDefines
-            NULL,                           // pInclude
-            src.stage_refl.entry_point.c_str(), // entryPoint
-            compile_target,                 // pTarget
-            D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR | D3DCOMPILE_OPTIMIZATION_LEVEL3, // Flags1
-            0,                              // Flags2
-            &output,                        // ppCode
-            &errors);                       // ppErrorMsgs
-        if (errors) {
-            std::string err_str((const char*)errors->GetBufferPointer());
-            d3d_parse_errors(err_str, inp, src.snippet_index, bytecode.errors);
-        }
-        if (output && (output->GetBufferSize() > 0)) {
-            std::vector<uint8_t> data(output->GetBufferSize());
-            memcpy(data.data(), output->GetBufferPointer(), output->GetBufferSize());
-            BytecodeBlob blob;
-            blob.valid = true;
-            blob.snippet_index = src.snippet_index;
-            blob.data = std::move(data);
-            bytecode.blobs.push_back(std::move(blob));
+    }
+    // optionally strip reflection-, debug- and other data which isn't needed at runtime
+    if (output && args.hlsl_strip && d3dstripshader_func) {
+        ID3DBlob* stripped = NULL;
+        const UINT strip_flags = D3DCOMPILER_STRIP_REFLECTION_DATA |
+                                 D3DCOMPILER_STRIP_DEBUG_INFO |
+                                 D3DCOMPILER_STRIP_TEST_BLOBS |
+                                 D3DCOMPILER_STRIP_PRIVATE_DATA |
+                                 D3DCOMPILER_STRIP_ROOT_SIGNATURE;
+        if (SUCCEEDED(d3dstripshader_func(output->GetBufferPointer(), output->GetBufferSize(), strip_flags, &stripped)) && stripped) {
+            output->Release();
+            output = stripped;
         }
-        if (errors) {
+    }
+    if (output && (output->GetBufferSize() > 0)) {
+        out_blob.data.resize(output->GetBufferSize());
+        memcpy(out_blob.data.data(), output->GetBufferPointer(), output->GetBufferSize());
+        out_blob.valid = true;
+        out_blob.snippet_index = src.snippet_index;
+    }
+    if (errors) {
+        errors->Release();
+    }
+    if (output) {
+        output->Release();
+    }
+}
+
+// compile a single HLSL6 source to DXIL, may be called from parallel jobs (each job uses its own compiler instance)
+static void dxc_compile_source(const Args& args, const Input& inp, const SpirvcrossSource& src, BytecodeBlob& out_blob, std::vector<ErrMsg>& out_errors) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    Timings::Scope scope("dxc_compile", snippet.name, Slang::to_str(Slang::HLSL6));
+    IDxcCompiler3* compiler = NULL;
+    if (FAILED(dxc_create_instance_func(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler)))) {
+        out_errors.push_back(ErrMsg::error(inp.base_path, 0, "failed to create DXC compiler instance!"));
+        return;
+    }
+    // the DXC args are plain ASCII, so widening char by char is fine
+    std::vector<std::wstring> wide_args;
+    for (const std::string& arg: dxc_args(args, src, snippet)) {
+        wide_args.push_back(std::wstring(arg.begin(), arg.end()));
+    }
+    std::vector<LPCWSTR> arg_ptrs;
+    for (const std::wstring& arg: wide_args) {
+        arg_ptrs.push_back(arg.c_str());
+    }
+    DxcBuffer source;
+    source.Ptr = src.source_code.c_str();
+    source.Size = src.source_code.length();
+    source.Encoding = DXC_CP_UTF8;
+    IDxcResult* result = NULL;
+    HRESULT status = E_FAIL;
+    if (SUCCEEDED(compiler->Compile(&source, arg_ptrs.data(), (UINT32)arg_ptrs.size(), NULL, IID_PPV_ARGS(&result))) && result) {
+        result->GetStatus(&status);
+        IDxcBlobUtf8* errors = NULL;
+        if (SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), NULL)) && errors) {
+            if (errors->GetStringLength() > 0) {
+                dxc_parse_errors(std::string(errors->GetStringPointer(), errors->GetStringLength()), inp, out_errors);
+            }
             errors->Release();
         }
-        if (output) {
+        IDxcBlob* output = NULL;
+        if (SUCCEEDED(status) && SUCCEEDED(result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&output), NULL)) && output) {
+            if (output->GetBufferSize() > 0) {
+                out_blob.data.resize(output->GetBufferSize());
+                memcpy(out_blob.data.data(), output->GetBufferPointer(), output->GetBufferSize());
+                out_blob.valid = true;
+                out_blob.snippet_index = src.snippet_index;
+            }
             output->Release();
         }
+        result->Release();
+    }
+    // make sure that a failed compilation is never silent
+    if (FAILED(status) && std::none_of(out_errors.begin(), out_errors.end(), [](const ErrMsg& err) { return err.type == ErrMsg::ERROR; })) {
+        out_errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("DXC failed to compile snippet '{}'", snippet.name)));
+    }
+    compiler->Release();
+}
+
+static Bytecode d3d_compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+    Bytecode bytecode;
+    if (slang == Slang::HLSL6) {
+        if (!load_dxcompiler_dll()) {
+            bytecode.errors.push_back(ErrMsg::warning(inp.base_path, 0, "failed to load dxcompiler.dll!"));
+            return bytecode;
+        }
+    } else {
+        if (!load_d3dcompiler_dll()) {
+            bytecode.errors.push_back(ErrMsg::warning(inp.base_path, 0, fmt::format("failed to load d3dcompiler_47.dll!")));
+            return bytecode;
+        }
+        if (args.hlsl_strip && !d3dstripshader_func) {
+            bytecode.errors.push_back(ErrMsg::warning(inp.base_path, 0, "D3DStripShader not found in d3dcompiler_47.dll, bytecode is not stripped!"));
+        }
+    }
+    const int num_sources = (int)spirvcross.sources.size();
+    std::vector<BytecodeBlob> blobs(num_sources);
+    std::vector<std::vector<ErrMsg>> errors(num_sources);
+    Jobs::run(num_sources, [&](int i) {
+        if (slang == Slang::HLSL6) {
+            dxc_compile_source(args, inp, spirvcross.sources[i], blobs[i], errors[i]);
+        } else {
+            d3d_compile_source(args, inp, spirvcross.sources[i], slang, blobs[i], errors[i]);
+        }
+    });
+    // gather results in source order
+    for (int i = 0; i < num_sources; i++) {
+        bytecode.errors.insert(bytecode.errors.end(), errors[i].begin(), errors[i].end());
+        if (blobs[i].valid) {
+            bytecode.blobs.push_back(std::move(blobs[i]));
+        }
     }
     return bytecode;
 }
 #endif
 
-Bytecode Bytecode::compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
-    Bytecode bytecode;
+static Cache::Key bytecode_cache_key(const Args& args, const Input& inp, const SpirvcrossSource& src, Slang::Enum slang) {
+    Cache::Key key("bytecode");
+    key.add((int)slang).add((int)inp.snippets[src.snippet_index].type).add(src.stage_refl->entry_point).add(src.source_code);
+    if (Slang::is_hlsl(slang)) {
+        #if defined(_WIN32)
+        key.add((slang == Slang::HLSL6) ? "dxcompiler.dll" : "d3dcompiler_47.dll");
+        #else
+        key.add(hlsl_tool_id(slang));
+        #endif
+        key.add(args.hlsl_opt_level).add(args.hlsl_strip ? 1 : 0).add(args.profile_build ? 1 : 0);
+    }
+    if (Slang::is_msl(slang)) {
+        key.add(pystring::join(" ", mtl_cc_flags(args, inp, src, slang)));
+    }
+    return key;
+}
+
+// cached bytecode items have a trailer with the optional D3D statistics (for --stats)
+static const int num_cached_stats = 5;
+
+static void cache_put_blob(const Cache::Key& key, const BytecodeBlob& blob) {
+    const int32_t stats[num_cached_stats] = {
+        blob.has_d3d_stats ? 1 : 0,
+        blob.d3d_instruction_count,
+        blob.d3d_temp_register_count,
+        blob.d3d_alu_instruction_count,
+        blob.d3d_texture_instruction_count,
+    };
+    std::vector<uint8_t> item = blob.data;
+    item.insert(item.end(), (const uint8_t*)stats, (const uint8_t*)stats + sizeof(stats));
+    Cache::put(key, item);
+}
+
+static bool cache_get_blob(const Cache::Key& key, BytecodeBlob& blob) {
+    int32_t stats[num_cached_stats];
+    if (!Cache::get(key, blob.data) || (blob.data.size() < sizeof(stats))) {
+        blob.data.clear();
+        return false;
+    }
+    const size_t data_size = blob.data.size() - sizeof(stats);
+    memcpy(stats, blob.data.data() + data_size, sizeof(stats));
+    blob.data.resize(data_size);
+    blob.has_d3d_stats = (0 != stats[0]);
+    blob.d3d_instruction_count = stats[1];
+    blob.d3d_temp_register_count = stats[2];
+    blob.d3d_alu_instruction_count = stats[3];
+    blob.d3d_texture_instruction_count = stats[4];
+    return true;
+}
+
+// true if bytecode for a target language can be compiled on this host platform
+static bool host_supports_bytecode(Slang::Enum slang) {
     #if defined(__APPLE__)
     // NOTE: for the iOS simulator case, don't compile bytecode but use source code
+    if ((slang == Slang::METAL_MACOS) || (slang == Slang::METAL_IOS)) {
+        return true;
+    }
+    #endif
+    #if defined(_WIN32)
+    if (Slang::is_hlsl(slang)) {
+        return true;
+    }
+    #else
+    // on Linux and macOS only if the command line tool has been found
+    if (Slang::is_hlsl(slang) && !hlsl_tool(slang).empty()) {
+        return true;
+    }
+    #endif
+    return false;
+}
+
+static Bytecode compile_uncached(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+    Bytecode bytecode;
+    #if defined(__APPLE__)
     if ((slang == Slang::METAL_MACOS) || (slang == Slang::METAL_IOS)) {
         bytecode = mtl_compile(args, inp, spirvcross, slang);
     }
     #endif
     #if defined(_WIN32)
-    if ((slang == Slang::HLSL4) || (slang == Slang::HLSL5)) {
-        bytecode = d3d_compile(inp, spirvcross, slang);
+    if (Slang::is_hlsl(slang)) {
+        bytecode = d3d_compile(args, inp, spirvcross, slang);
+    }
+    #else
+    if (Slang::is_hlsl(slang) && host_supports_bytecode(slang)) {
+        bytecode = hlsl_tool_compile(args, inp, spirvcross, slang);
     }
     #endif
     return bytecode;
 }
 
+// with --single-metallib, the metallib depends on all sources, and is cached as a whole
+static Cache::Key metallib_cache_key(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+    Cache::Key key("metallib");
+    key.add((int)slang);
+    for (const SpirvcrossSource& src: spirvcross.sources) {
+        key.add((int)inp.snippets[src.snippet_index].type).add(src.stage_refl->entry_point_by_slang(slang)).add(src.source_code);
+        key.add(pystring::join(" ", mtl_cc_flags(args, inp, src, slang)));
+    }
+    return key;
+}
+
+static Bytecode compile_single_metallib(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+    const Cache::Key key = metallib_cache_key(args, inp, spirvcross, slang);
+    std::vector<uint8_t> data;
+    if (Cache::get(key, data)) {
+        Bytecode bytecode;
+        for (const SpirvcrossSource& src: spirvcross.sources) {
+            BytecodeBlob blob;
+            blob.valid = true;
+            blob.snippet_index = src.snippet_index;
+            blob.data = data;
+            bytecode.blobs.push_back(std::move(blob));
+        }
+        return bytecode;
+    }
+    if (!host_supports_bytecode(slang)) {
+        return Bytecode();
+    }
+    Bytecode bytecode = compile_uncached(args, inp, spirvcross, slang);
+    if (bytecode.errors.empty() && !bytecode.blobs.empty()) {
+        Cache::put(key, bytecode.blobs[0].data);
+    }
+    return bytecode;
+}
+
+// On hosts which can't compile bytecode for a target language, bytecode
+// built on other hosts can still be picked up from a shared cache, but
+// only if all sources have a cache hit (otherwise the output would be
+// a mix of bytecode and source code).
+static Bytecode lookup_foreign(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+    Bytecode bytecode;
+    for (const SpirvcrossSource& src: spirvcross.sources) {
+        BytecodeBlob blob;
+        if (!cache_get_blob(bytecode_cache_key(args, inp, src, slang), blob)) {
+            return Bytecode();
+        }
+        blob.valid = true;
+        blob.snippet_index = src.snippet_index;
+        bytecode.blobs.push_back(std::move(blob));
+    }
+    return bytecode;
+}
+
+// the SPIRV target is 'compiled' on all host platforms by assembling the
+// SPIRV disassembly which was produced by Spirvcross::translate()
+static Bytecode spirv_assemble(const Input& inp, const Spirvcross& spirvcross) {
+    Bytecode bytecode;
+    for (const SpirvcrossSource& src: spirvcross.sources) {
+        Timings::Scope scope("spirv_assemble", inp.snippets[src.snippet_index].name, Slang::to_str(Slang::SPIRV));
+        std::string msg;
+        spvtools::SpirvTools spirv_tools(SPV_ENV_UNIVERSAL_1_0);
+        spirv_tools.SetMessageConsumer([&msg](spv_message_level_t, const char*, const spv_position_t&, const char* message) {
+            msg = message;
+        });
+        std::vector<uint32_t> words;
+        if (!spirv_tools.Assemble(src.source_code, &words, spvtools::SpirvTools::kDefaultAssembleOption)) {
+            bytecode.errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to assemble SPIRV for snippet '{}': {}", inp.snippets[src.snippet_index].name, msg)));
+            return bytecode;
+        }
+        BytecodeBlob blob;
+        blob.valid = true;
+        blob.snippet_index = src.snippet_index;
+        blob.data.resize(words.size() * sizeof(uint32_t));
+        memcpy(blob.data.data(), words.data(), blob.data.size());
+        bytecode.blobs.push_back(std::move(blob));
+    }
+    return bytecode;
+}
+
+Bytecode Bytecode::compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+    if (Slang::is_spirv(slang)) {
+        return spirv_assemble(inp, spirvcross);
+    }
+    if (args.single_metallib && ((slang == Slang::METAL_MACOS) || (slang == Slang::METAL_IOS))) {
+        return compile_single_metallib(args, inp, spirvcross, slang);
+    }
+    if (!Cache::enabled()) {
+        return compile_uncached(args, inp, spirvcross, slang);
+    }
+    if (!host_supports_bytecode(slang)) {
+        // only HLSL and Metal (except simulator) have bytecode
+        if (Slang::is_hlsl(slang) || (slang == Slang::METAL_MACOS) || (slang == Slang::METAL_IOS)) {
+            return lookup_foreign(args, inp, spirvcross, slang);
+        }
+        return Bytecode();
+    }
+    // lookup cached bytecode blobs, and only compile the sources without cache hit
+    std::vector<BytecodeBlob> cached_blobs;
+    Spirvcross uncached;
+    for (const SpirvcrossSource& src: spirvcross.sources) {
+        BytecodeBlob blob;
+        if (cache_get_blob(bytecode_cache_key(args, inp, src, slang), blob)) {
+            blob.valid = true;
+            blob.snippet_index = src.snippet_index;
+            cached_blobs.push_back(std::move(blob));
+        } else {
+            uncached.sources.push_back(src);
+        }
+    }
+    Bytecode bytecode;
+    if (!uncached.sources.empty()) {
+        bytecode = compile_uncached(args, inp, uncached, slang);
+        // only cache results without warnings, so that warnings are reported every time
+        if (bytecode.errors.empty()) {
+            for (const BytecodeBlob& blob: bytecode.blobs) {
+                cache_put_blob(bytecode_cache_key(args, inp, *uncached.find_source_by_snippet_index(blob.snippet_index), slang), blob);
+            }
+        }
+    }
+    // merge cached and compiled blobs back into source (== snippet) order
+    for (BytecodeBlob& blob: cached_blobs) {
+        bytecode.blobs.push_back(std::move(blob));
+    }
+    std::stable_sort(bytecode.blobs.begin(), bytecode.blobs.end(), [](const BytecodeBlob& b0, const BytecodeBlob& b1) {
+        return b0.snippet_index < b1.snippet_index;
+    });
+    return bytecode;
+}
+
 void Bytecode::dump_debug() const {
     fmt::print(stderr, "Bytecode::dump_debug(): FIXME!\n");
 }
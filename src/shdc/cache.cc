@@ -0,0 +1,284 @@
+/*
+    persistent content-addressed compile cache
+
+    Each cache item is a single file in the cache directory, with the file
+    name being the hash of the cache key. The cache key must contain everything
+    which influences the result of a compile step. Items are written to a temporary
+    file first and then renamed, so that concurrent sokol-shdc processes
+    sharing the same cache directory never see partially written items.
+
+    Optionally, a remote cache (--cache-url) is used as second tier, see
+    cache_remote.cc for details.
+*/
+#include "cache.h"
+#include "cache_remote.h"
+#include <stdio.h>
+#include <string.h>
+#include <random>
+#include <mutex>
+#include <map>
+#include <list>
+#include "fmt/format.h"
+#include "pystring.h"
+#include "ShaderLang.h"
+
+namespace shdc {
+
+// bump this when the output of any compile step changes for the same input, and
+// the versions in the key prefix don't change (e.g. after updating SPIRV-Tools,
+// SPIRV-Cross or Tint, which don't have a version number)
+static const char* cache_version = "sokol-shdc-cache-2";
+
+// the start of all cache keys, with the cache version, the generator version
+// (--genver) and the glslang version
+static std::string key_prefix;
+static std::string cache_dir;
+static std::unique_ptr<CacheRemote> remote;
+static bool memory_tier_enabled = false;
+static std::mutex memory_tier_mutex;
+// the memory tier is an LRU cache, the least recently used items are evicted
+// when the size of all items would exceed the size limit
+static const size_t memory_tier_max_bytes = 256 * 1024 * 1024;
+struct MemoryItem {
+    std::vector<uint8_t> data;
+    std::list<std::string>::iterator lru_pos;
+};
+static std::map<std::string, MemoryItem> memory_tier;
+static std::list<std::string> memory_tier_lru;  // most recently used key first
+static size_t memory_tier_bytes = 0;
+
+// 64-bit FNV-1a hash
+static uint64_t fnv1a(const void* ptr, size_t num_bytes, uint64_t hash) {
+    const uint8_t* bytes = (const uint8_t*) ptr;
+    for (size_t i = 0; i < num_bytes; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+Cache::Key::Key(const char* kind) {
+    str = key_prefix;
+    str += kind;
+    str += '\n';
+}
+
+Cache::Key& Cache::Key::add(const std::string& val) {
+    // prefix with length so that concatenated values can't collide
+    str += fmt::format("{}:", val.length());
+    str += val;
+    str += '\n';
+    return *this;
+}
+
+Cache::Key& Cache::Key::add(int val) {
+    str += fmt::format("{}\n", val);
+    return *this;
+}
+
+Cache::Key& Cache::Key::add(const std::vector<uint32_t>& val) {
+    str += fmt::format("{}:", val.size());
+    str.append((const char*)val.data(), val.size() * sizeof(uint32_t));
+    str += '\n';
+    return *this;
+}
+
+std::string Cache::Key::hash() const {
+    // two differently seeded hashes to reduce the chance of collisions
+    const uint64_t h0 = fnv1a(str.data(), str.length(), 0xCBF29CE484222325ULL);
+    const uint64_t h1 = fnv1a(str.data(), str.length(), 0x84222325CBF29CE4ULL);
+    return fmt::format("{:016x}{:016x}", h0, h1);
+}
+
+void Cache::setup(const std::string& dir, const std::string& remote_url, int remote_timeout_sec, int gen_version) {
+    const glslang::Version glslang_version = glslang::GetVersion();
+    key_prefix = fmt::format("{}\ngenver {}\nglslang {}.{}.{}{}\n", cache_version, gen_version,
+        glslang_version.major, glslang_version.minor, glslang_version.patch, glslang_version.flavor);
+    cache_dir = dir;
+    if (!cache_dir.empty() && !pystring::endswith(cache_dir, "/")) {
+        cache_dir += "/";
+    }
+    remote.reset();
+    if (!cache_dir.empty() && !remote_url.empty()) {
+        remote = CacheRemote::create(remote_url, remote_timeout_sec);
+    }
+}
+
+void Cache::discard() {
+    remote.reset();
+    cache_dir.clear();
+    memory_tier_enabled = false;
+    memory_tier.clear();
+    memory_tier_lru.clear();
+    memory_tier_bytes = 0;
+}
+
+void Cache::enable_memory_tier() {
+    memory_tier_enabled = true;
+}
+
+bool Cache::enabled() {
+    return memory_tier_enabled || !cache_dir.empty();
+}
+
+// the memory tier is keyed by the full key string, no collision check needed
+static bool memory_get(const Cache::Key& key, std::vector<uint8_t>& out_data) {
+    if (memory_tier_enabled) {
+        std::lock_guard<std::mutex> lock(memory_tier_mutex);
+        auto it = memory_tier.find(key.str);
+        if (it != memory_tier.end()) {
+            memory_tier_lru.splice(memory_tier_lru.begin(), memory_tier_lru, it->second.lru_pos);
+            out_data = it->second.data;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void memory_put(const Cache::Key& key, const std::vector<uint8_t>& data) {
+    if (!memory_tier_enabled || (data.size() > memory_tier_max_bytes)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(memory_tier_mutex);
+    auto it = memory_tier.find(key.str);
+    if (it != memory_tier.end()) {
+        memory_tier_bytes -= it->second.data.size();
+        memory_tier_lru.erase(it->second.lru_pos);
+        memory_tier.erase(it);
+    }
+    while (!memory_tier_lru.empty() && ((memory_tier_bytes + data.size()) > memory_tier_max_bytes)) {
+        auto lru_it = memory_tier.find(memory_tier_lru.back());
+        memory_tier_bytes -= lru_it->second.data.size();
+        memory_tier.erase(lru_it);
+        memory_tier_lru.pop_back();
+    }
+    memory_tier_lru.push_front(key.str);
+    memory_tier[key.str] = { data, memory_tier_lru.begin() };
+    memory_tier_bytes += data.size();
+}
+
+// NOTE: the temp file name must be unique across threads and processes
+static std::string tmp_path(const std::string& path) {
+    std::random_device rnd;
+    return fmt::format("{}.{:08x}{:08x}.tmp", path, rnd(), rnd());
+}
+
+// read a cache item file, each item starts with the full key, which is
+// compared to guard against hash collisions (and corrupted remote items)
+static bool read_item(const std::string& path, const Cache::Key& key, std::vector<uint8_t>& out_data) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        return false;
+    }
+    bool ok = false;
+    uint64_t sizes[2] = { };
+    if (fread(sizes, sizeof(sizes), 1, fp) == 1) {
+        if (sizes[0] == key.str.length()) {
+            std::string stored_key(sizes[0], 0);
+            if ((sizes[0] == 0) || (fread(&stored_key[0], sizes[0], 1, fp) == 1)) {
+                if (stored_key == key.str) {
+                    out_data.resize(sizes[1]);
+                    ok = (sizes[1] == 0) || (fread(out_data.data(), sizes[1], 1, fp) == 1);
+                }
+            }
+        }
+    }
+    fclose(fp);
+    if (!ok) {
+        out_data.clear();
+    }
+    return ok;
+}
+
+// write a cache item file via a temporary file
+static bool write_item(const std::string& path, const Cache::Key& key, const std::vector<uint8_t>& data) {
+    const std::string tmp = tmp_path(path);
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if (!fp) {
+        return false;
+    }
+    const uint64_t sizes[2] = { key.str.length(), data.size() };
+    bool ok = fwrite(sizes, sizeof(sizes), 1, fp) == 1;
+    ok = ok && fwrite(key.str.data(), 1, key.str.length(), fp) == key.str.length();
+    ok = ok && fwrite(data.data(), 1, data.size(), fp) == data.size();
+    ok = (0 == fclose(fp)) && ok;
+    if (ok) {
+        // this may fail on Windows if the item already exists, which is fine
+        ok = (0 == rename(tmp.c_str(), path.c_str()));
+    }
+    if (!ok) {
+        remove(tmp.c_str());
+    }
+    return ok;
+}
+
+bool Cache::get(const Key& key, std::vector<uint8_t>& out_data) {
+    if (memory_get(key, out_data)) {
+        return true;
+    }
+    if (cache_dir.empty()) {
+        return false;
+    }
+    const std::string hash = key.hash();
+    const std::string path = cache_dir + hash;
+    bool ok = read_item(path, key, out_data);
+    if (!ok && remote) {
+        // on local cache miss, try the remote cache and keep a local copy on success
+        const std::string tmp = tmp_path(path);
+        ok = remote->fetch(hash, tmp) && read_item(tmp, key, out_data);
+        if (!(ok && (0 == rename(tmp.c_str(), path.c_str())))) {
+            remove(tmp.c_str());
+        }
+    }
+    if (ok) {
+        memory_put(key, out_data);
+    }
+    return ok;
+}
+
+void Cache::put(const Key& key, const std::vector<uint8_t>& data) {
+    memory_put(key, data);
+    if (cache_dir.empty()) {
+        return;
+    }
+    // failing to write the cache isn't an error
+    const std::string hash = key.hash();
+    const std::string path = cache_dir + hash;
+    if (write_item(path, key, data) && remote) {
+        remote->store(hash, path);
+    }
+}
+
+bool Cache::get(const Key& key, std::vector<uint32_t>& out_words) {
+    std::vector<uint8_t> data;
+    if (!get(key, data) || (data.size() % sizeof(uint32_t)) != 0) {
+        return false;
+    }
+    out_words.resize(data.size() / sizeof(uint32_t));
+    memcpy(out_words.data(), data.data(), data.size());
+    return true;
+}
+
+void Cache::put(const Key& key, const std::vector<uint32_t>& words) {
+    if (enabled()) {
+        const uint8_t* ptr = (const uint8_t*) words.data();
+        put(key, std::vector<uint8_t>(ptr, ptr + words.size() * sizeof(uint32_t)));
+    }
+}
+
+bool Cache::get(const Key& key, std::string& out_str) {
+    std::vector<uint8_t> data;
+    if (!get(key, data)) {
+        return false;
+    }
+    out_str.assign(data.begin(), data.end());
+    return true;
+}
+
+void Cache::put(const Key& key, const std::string& str) {
+    if (enabled()) {
+        put(key, std::vector<uint8_t>(str.begin(), str.end()));
+    }
+}
+
+} // namespace shdc
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace shdc {
+
+// optional persistent, content-addressed compile cache (--cache-dir),
+// all functions are thread-safe and may be called from parallel jobs
+struct Cache {
+    // helper to build a cache key from all inputs of a compile step
+    struct Key {
+        std::string str;
+        Key(const char* kind);
+        Key& add(const std::string& val);
+        Key& add(int val);
+        Key& add(const std::vector<uint32_t>& val);
+        std::string hash() const;
+    };
+
+    // enable the cache, an empty dir keeps the cache disabled, the optional
+    // remote cache is used as second tier behind the local cache directory, the
+    // generator version (--genver) goes into all cache keys
+    static void setup(const std::string& cache_dir, const std::string& remote_url, int remote_timeout_sec, int gen_version);
+    static void discard();
+    // additionally keep cache items in memory (size-limited, least recently
+    // used items are evicted first), for the --watch mode
+    static void enable_memory_tier();
+    static bool enabled();
+    // lookup or store a cache item, lookup returns false on cache miss
+    static bool get(const Key& key, std::vector<uint8_t>& out_data);
+    static void put(const Key& key, const std::vector<uint8_t>& data);
+    // convenience wrappers for SPIRV bytecode and text
+    static bool get(const Key& key, std::vector<uint32_t>& out_words);
+    static void put(const Key& key, const std::vector<uint32_t>& words);
+    static bool get(const Key& key, std::string& out_str);
+    static void put(const Key& key, const std::string& str);
+};
+
+} // namespace shdc
@@ -0,0 +1,90 @@
+/*
+    remote compile cache backends
+
+    The HTTP backend expects a content-addressed store which answers
+    GET [url]/[hash] with the cache item (or an HTTP error for unknown
+    items), and stores cache items via PUT [url]/[hash]. Requests go
+    through the curl command line tool (spawned directly with an argument
+    list, like the Metal toolchain) to avoid a network library dependency.
+*/
+#include "cache_remote.h"
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+#include "fmt/format.h"
+#include "pystring.h"
+#include "process.h"
+
+namespace shdc {
+
+// curl exit codes which mean that the remote cache isn't reachable
+static const int curl_err_resolve_proxy = 5;
+static const int curl_err_resolve_host = 6;
+static const int curl_err_connect = 7;
+static const int curl_err_timeout = 28;
+
+struct HttpCacheRemote: CacheRemote {
+    std::string url;
+    int timeout_sec = 5;
+    std::atomic<bool> disabled{false};
+
+    virtual bool fetch(const std::string& hash, const std::string& dst_path);
+    virtual void store(const std::string& hash, const std::string& src_path);
+    bool curl(const std::vector<std::string>& args);
+};
+
+// run curl with common options, return true on success, the URL and paths
+// are passed as separate arguments and never go through a shell
+bool HttpCacheRemote::curl(const std::vector<std::string>& args) {
+    if (disabled) {
+        return false;
+    }
+    std::vector<std::string> curl_args = {
+        "curl", "--silent", "--fail",
+        "--connect-timeout", fmt::format("{}", timeout_sec),
+        "--max-time", fmt::format("{}", timeout_sec),
+    };
+    curl_args.insert(curl_args.end(), args.begin(), args.end());
+    std::string output;
+    const int exit_code = Process::run(curl_args, output);
+    if ((exit_code == curl_err_resolve_proxy) ||
+        (exit_code == curl_err_resolve_host) ||
+        (exit_code == curl_err_connect) ||
+        (exit_code == curl_err_timeout))
+    {
+        // don't pay the timeout again for every other cache item
+        if (!disabled.exchange(true)) {
+            fmt::print(stderr, "sokol-shdc: remote cache '{}' not reachable (curl exit code {}), falling back to local compilation\n", url, exit_code);
+        }
+    }
+    return 0 == exit_code;
+}
+
+bool HttpCacheRemote::fetch(const std::string& hash, const std::string& dst_path) {
+    return curl({ "--output", dst_path, fmt::format("{}/{}", url, hash) });
+}
+
+void HttpCacheRemote::store(const std::string& hash, const std::string& src_path) {
+    #if defined(_WIN32)
+    const char* null_dev = "NUL";
+    #else
+    const char* null_dev = "/dev/null";
+    #endif
+    curl({ "--upload-file", src_path, "--output", null_dev, fmt::format("{}/{}", url, hash) });
+}
+
+bool CacheRemote::is_valid_url(const std::string& url) {
+    return pystring::startswith(url, "http://") || pystring::startswith(url, "https://");
+}
+
+std::unique_ptr<CacheRemote> CacheRemote::create(const std::string& url, int timeout_sec) {
+    if (!is_valid_url(url)) {
+        return nullptr;
+    }
+    auto remote = std::make_unique<HttpCacheRemote>();
+    remote->url = pystring::endswith(url, "/") ? url.substr(0, url.length() - 1) : url;
+    remote->timeout_sec = timeout_sec;
+    return remote;
+}
+
+} // namespace shdc
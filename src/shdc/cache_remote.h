@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <memory>
+
+namespace shdc {
+
+// interface for remote compile cache backends, the local cache directory is
+// always the first tier, remote backends are only asked on local cache misses,
+// implementations must be thread-safe
+struct CacheRemote {
+    virtual ~CacheRemote() { };
+    // download a cache item into a local file, return false on cache miss or error
+    virtual bool fetch(const std::string& hash, const std::string& dst_path) = 0;
+    // upload a local cache item file, failing to upload is not an error
+    virtual void store(const std::string& hash, const std::string& src_path) = 0;
+
+    // create a remote backend for a cache URL, return nullptr for unsupported URLs
+    static std::unique_ptr<CacheRemote> create(const std::string& url, int timeout_sec);
+    static bool is_valid_url(const std::string& url);
+};
+
+} // namespace shdc
@@ -0,0 +1,386 @@
+/*
+    the complete compile pipeline for a single input file
+*/
+#include "compile.h"
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <set>
+#include <stdio.h>
+#include "fmt/format.h"
+#include "spirv.h"
+#include "input.h"
+#include "spirvcross.h"
+#include "bytecode.h"
+#include "reflection.h"
+#include "jobs.h"
+#include "timings.h"
+#include "minify.h"
+#include "stats.h"
+#include "size_report.h"
+#include "generators/generate.h"
+
+namespace shdc {
+
+using namespace refl;
+using namespace gen;
+
+static bool has_errors(const std::vector<ErrMsg>& errors) {
+    for (const ErrMsg& err: errors) {
+        if (err.type == ErrMsg::ERROR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// print an error or warning, or pass it to the args.io.message hook
+static void report(const Args& args, const ErrMsg& err) {
+    if (args.io.message) {
+        args.io.message(err);
+    } else {
+        err.print(args.error_format);
+    }
+}
+
+// print errors and warnings, return true if there was at least one error
+static bool print_errors(const Args& args, const std::vector<ErrMsg>& errors) {
+    for (const ErrMsg& err: errors) {
+        report(args, err);
+    }
+    return has_errors(errors);
+}
+
+// escape a path for a Make/Ninja depfile
+static std::string depfile_escape(const std::string& path) {
+    std::string res;
+    for (char c: path) {
+        if ((c == ' ') || (c == '#')) {
+            res += '\\';
+        } else if (c == '$') {
+            res += '$';
+        }
+        res += c;
+    }
+    return res;
+}
+
+// write a gcc-style depfile with all output files as targets, and the input file
+// and all @include files as prerequisites
+static ErrMsg write_depfile(const Args& args, const Input& inp) {
+    std::vector<std::string> outputs = { args.output };
+    for (const Args::Output& extra: args.extra_outputs) {
+        outputs.push_back(extra.path);
+    }
+    std::string content;
+    for (const std::string& output: outputs) {
+        content += fmt::format("{}{}", content.empty() ? "" : " ", depfile_escape(output));
+        if (args.split_backends) {
+            for (int i = 0; i < Slang::Num; i++) {
+                const Slang::Enum slang = Slang::from_index(i);
+                if (args.slang & Slang::bit(slang)) {
+                    content += fmt::format(" {}", depfile_escape(Args::split_backend_path(output, slang)));
+                }
+            }
+        }
+    }
+    content += ":";
+    // a file which is included several times has several filenames entries
+    std::set<std::string> deps;
+    for (const std::string& filename: inp.filenames) {
+        if (deps.insert(filename).second) {
+            content += fmt::format(" \\\n  {}", depfile_escape(filename));
+        }
+    }
+    content += "\n";
+    FILE* fp = fopen(args.depfile.c_str(), "w");
+    if (!fp) {
+        return ErrMsg::error(args.depfile, 0, fmt::format("failed to open depfile '{}' for writing", args.depfile));
+    }
+    fwrite(content.c_str(), content.length(), 1, fp);
+    fclose(fp);
+    return ErrMsg();
+}
+
+// --check: compile to SPIRV for one representative target language with the
+// optimizer off, and only run the resource restriction and linking validation,
+// this skips cross-translation, bytecode compilation and code generation
+static int check_input(const Args& args, const Input& inp) {
+    const Slang::Enum slang = Slang::first_valid(args.slang);
+    Args check_args = args;
+    check_args.slang = Slang::bit(slang);
+    Timings::Scope spirv_scope("check", args.input, Slang::to_str(slang));
+    const Spirv spirv = Spirv::compile_glsl(inp, slang, args.defines, OptLevel::NONE, false);
+    if (print_errors(args, spirv.errors)) {
+        return 10;
+    }
+    BindSlots bind_slots;
+    if (args.module_bind_slots) {
+        ErrMsg err;
+        bind_slots = Spirvcross::assign_module_bind_slots(inp, spirv, err);
+        if (err.valid()) {
+            report(args, err);
+            return 10;
+        }
+    }
+    // the reflection info of the analysis pass is enough for the linking checks
+    std::array<Spirvcross,Slang::Num> spirvcross;
+    for (const SpirvcrossAnalysis& analysis: Spirvcross::analyze(inp, spirv, bind_slots, false)) {
+        const ErrMsg& err = analysis.error.valid() ? analysis.error : analysis.refl_error;
+        if (err.valid()) {
+            report(args, err);
+            return 10;
+        }
+        SpirvcrossSource src;
+        src.valid = true;
+        src.snippet_index = analysis.snippet_index;
+        src.stage_refl = analysis.stage_refl;
+        spirvcross[slang].sources.push_back(std::move(src));
+    }
+    const Reflection refl = Reflection::build(check_args, inp, spirvcross);
+    if (refl.error.valid()) {
+        report(args, refl.error);
+        return 10;
+    }
+    print_errors(args, refl.warnings);
+    return 0;
+}
+
+int Compile::input(const Args& args, std::vector<std::string>* out_filenames) {
+
+    // load the source and parse tagged blocks
+    Timings::Scope input_scope("input", args.input);
+    const Input inp = Input::load_and_parse(args.input, args.module, args.io);
+    input_scope.end();
+    if (out_filenames) {
+        *out_filenames = inp.filenames;
+    }
+    if (args.debug_dump) {
+        inp.dump_debug(args.error_format);
+    }
+    if (inp.out_error.valid()) {
+        report(args, inp.out_error);
+        return 10;
+    }
+    if (args.check) {
+        return check_input(args, inp);
+    }
+
+    // compile source snippets to SPIRV blobs (multiple compilations is necessary
+    // because of conditional compilation by target language), target languages
+    // of the same family (e.g. all Metal flavours) see the same preprocessed source
+    // and share the same SPIRV compile result
+    std::vector<Slang::Enum> slangs;
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (args.slang & Slang::bit(slang)) {
+            slangs.push_back(slang);
+        }
+    }
+    std::vector<std::string> spirv_keys;
+    std::vector<Slang::Enum> spirv_slangs;  // first target language for each unique key
+    std::array<int,Slang::Num> spirv_index;
+    spirv_index.fill(-1);
+    for (Slang::Enum slang: slangs) {
+        const std::string key = Spirv::source_key(slang, args.defines, args.spirv_opt_level(slang));
+        auto it = std::find(spirv_keys.begin(), spirv_keys.end(), key);
+        spirv_index[slang] = (int)std::distance(spirv_keys.begin(), it);
+        if (it == spirv_keys.end()) {
+            spirv_keys.push_back(key);
+            spirv_slangs.push_back(slang);
+        }
+    }
+    std::vector<Spirv> spirv(spirv_keys.size());
+    Jobs::run((int)spirv.size(), [&](int i) {
+        spirv[i] = Spirv::compile_glsl(inp, spirv_slangs[i], args.defines, args.spirv_opt_level(spirv_slangs[i]), args.profile_build);
+    });
+    for (int i = 0; i < (int)spirv.size(); i++) {
+        if (args.debug_dump) {
+            spirv[i].dump_debug(inp, args.error_format);
+        }
+        if (print_errors(args, spirv[i].errors)) {
+            return 10;
+        }
+    }
+    // prune varyings which aren't read by the linked fragment shaders
+    Jobs::run((int)spirv.size(), [&](int i) {
+        Timings::Scope link_scope("link", "", Slang::to_str(spirv_slangs[i]));
+        spirv[i].link_programs(inp, spirv_slangs[i], args.spirv_opt_level(spirv_slangs[i]));
+    });
+    if (args.save_intermediate_spirv) {
+        for (Slang::Enum slang: slangs) {
+            if (!spirv[spirv_index[slang]].write_to_file(args, inp, slang)) {
+                return 10;
+            }
+        }
+    }
+
+    // with --module-bind-slots, resources are assigned bind slots by name across all
+    // programs, the resource names may differ between SPIRV compile results (e.g. via
+    // target language specific #ifdefs), so each result gets its own bind slot table
+    std::vector<BindSlots> bind_slots(spirv.size());
+    if (args.module_bind_slots) {
+        for (int i = 0; i < (int)spirv.size(); i++) {
+            ErrMsg err;
+            bind_slots[i] = Spirvcross::assign_module_bind_slots(inp, spirv[i], err);
+            if (err.valid()) {
+                report(args, err);
+                return 10;
+            }
+        }
+    }
+
+    // resource validation and reflection only depend on the SPIRV blobs, and are
+    // shared by all target languages which use the same SPIRV compile result
+    std::vector<std::vector<SpirvcrossAnalysis>> analysis(spirv.size());
+    Jobs::run((int)spirv.size(), [&](int i) {
+        analysis[i] = Spirvcross::analyze(inp, spirv[i], bind_slots[i], args.single_metallib);
+    });
+
+    // cross-translate SPIRV to shader dialects, and compile shader-byte code
+    // if requested (HLSL / Metal), each target language runs as one
+    // independent parallel job, the results are checked in fixed order
+    // once all jobs have finished
+    //
+    // to keep the peak memory usage down (which matters in batch mode), each
+    // SPIRV compile result and its analysis is released by the last target
+    // language job which has translated it, unless --stats needs it afterwards
+    std::array<Spirvcross,Slang::Num> spirvcross;
+    std::array<Bytecode, Slang::Num> bytecode;
+    const bool keep_spirv = !args.stats.empty();
+    std::vector<int> spirv_users(spirv.size(), 0);
+    for (Slang::Enum slang: slangs) {
+        spirv_users[spirv_index[slang]]++;
+    }
+    std::mutex spirv_users_mutex;
+    Jobs::run((int)slangs.size(), [&](int job_index) {
+        const Slang::Enum slang = slangs[job_index];
+        const int si = spirv_index[slang];
+        spirvcross[slang] = Spirvcross::translate(args, inp, spirv[si], analysis[si], slang, bind_slots[si]);
+        if (!keep_spirv) {
+            std::lock_guard<std::mutex> lock(spirv_users_mutex);
+            if (0 == --spirv_users[si]) {
+                spirv[si] = Spirv();
+                analysis[si] = std::vector<SpirvcrossAnalysis>();
+            }
+        }
+        if (spirvcross[slang].error.valid()) {
+            return;
+        }
+        // SPIRV is only useful as bytecode, and is always "compiled"
+        if (args.byte_code || Slang::is_spirv(slang)) {
+            bytecode[slang] = Bytecode::compile(args, inp, spirvcross[slang], slang);
+        }
+        // minify embedded source code after bytecode compilation, so that
+        // compiler error messages still refer to the readable source
+        if (args.minify && !Slang::is_spirv(slang)) {
+            Timings::Scope minify_scope("minify", args.input, Slang::to_str(slang));
+            for (SpirvcrossSource& src: spirvcross[slang].sources) {
+                if (src.valid) {
+                    src.source_code = Minify::source(src.source_code, *src.stage_refl);
+                }
+            }
+        }
+    });
+
+    // check SPIRV cross-translation results
+    for (Slang::Enum slang: slangs) {
+        if (args.debug_dump) {
+            spirvcross[slang].dump_debug(args.error_format, slang);
+        }
+        if (spirvcross[slang].error.valid()) {
+            report(args, spirvcross[slang].error);
+            return 10;
+        }
+    }
+
+    // check shader-byte code results
+    for (Slang::Enum slang: slangs) {
+        if (args.byte_code || Slang::is_spirv(slang)) {
+            if (args.debug_dump) {
+                bytecode[slang].dump_debug();
+            }
+            if (print_errors(args, bytecode[slang].errors)) {
+                return 10;
+            }
+        }
+    }
+
+    // build merged Reflection info
+    Timings::Scope reflection_scope("reflection", args.input);
+    const Reflection refl = Reflection::build(args, inp, spirvcross);
+    reflection_scope.end();
+    if (refl.error.valid()) {
+        report(args, refl.error);
+        return 10;
+    }
+    print_errors(args, refl.warnings);
+    if (args.debug_dump) {
+        refl.dump_debug(args.error_format);
+    }
+
+    // generate output files, all --format/--output pairs share the same compile
+    // results, each generator sees its own output format and path in Args
+    std::vector<Args> gen_args(1 + args.extra_outputs.size(), args);
+    for (size_t i = 0; i < args.extra_outputs.size(); i++) {
+        gen_args[1 + i].output_format = args.extra_outputs[i].format;
+        gen_args[1 + i].output = args.extra_outputs[i].path;
+    }
+    std::vector<ErrMsg> gen_errors(gen_args.size());
+    Jobs::run((int)gen_args.size(), [&](int i) {
+        Timings::Scope generate_scope("generate", gen_args[i].output);
+        const GenInput gen_input(gen_args[i], inp, spirvcross, bytecode, refl);
+        gen_errors[i] = generate(gen_args[i].output_format, gen_input);
+    });
+    for (const ErrMsg& gen_error: gen_errors) {
+        if (gen_error.valid()) {
+            report(args, gen_error);
+            return 10;
+        }
+    }
+
+    // optionally write static shader statistics
+    if (!args.stats.empty()) {
+        std::array<const Spirv*, Slang::Num> slang_spirv;
+        slang_spirv.fill(nullptr);
+        for (Slang::Enum slang: slangs) {
+            slang_spirv[slang] = &spirv[spirv_index[slang]];
+        }
+        ErrMsg stats_error = Stats::write_json(args, inp, slang_spirv, spirvcross, bytecode);
+        if (stats_error.valid()) {
+            report(args, stats_error);
+            return 10;
+        }
+    }
+
+    // optionally write the embedded shader data size report, and check the size budget
+    if (!args.size_report.empty() || (args.size_budget > 0)) {
+        const SizeReport size_report = SizeReport::build(args, inp, spirvcross, bytecode);
+        if (!args.size_report.empty()) {
+            ErrMsg size_report_error = size_report.write_json(args, inp);
+            if (size_report_error.valid()) {
+                report(args, size_report_error);
+                return 10;
+            }
+        }
+        ErrMsg budget_error = size_report.check_budget(args, inp);
+        if (budget_error.valid()) {
+            report(args, budget_error);
+            return 10;
+        }
+    }
+
+    // optionally write depfile for the build system
+    if (!args.depfile.empty()) {
+        ErrMsg dep_error = write_depfile(args, inp);
+        if (dep_error.valid()) {
+            report(args, dep_error);
+            return 10;
+        }
+    }
+
+    // success
+    return 0;
+}
+
+} // namespace shdc
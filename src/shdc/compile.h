@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "args.h"
+
+namespace shdc {
+
+// the complete compile pipeline for a single input file, shared by
+// sokol-shdc and the shdc-bench benchmark
+struct Compile {
+    // returns the process exit code, optionally returns the paths
+    // of all loaded source files (also on error)
+    static int input(const Args& args, std::vector<std::string>* out_filenames = nullptr);
+};
+
+} // namespace shdc
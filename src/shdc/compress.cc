@@ -0,0 +1,88 @@
+/*
+    A simple greedy LZ4 block compressor, the generated code contains the
+    matching decompressor (see SokolCGenerator::gen_lz4_decompress_func()).
+*/
+#include "compress.h"
+#include <string.h>
+
+namespace shdc {
+
+static const int LZ4_HASH_BITS = 12;
+static const size_t LZ4_MIN_MATCH = 4;
+static const size_t LZ4_MAX_OFFSET = 65535;
+// LZ4 block format end conditions: the last match must start at least
+// 12 bytes before the end, and the last 5 bytes are always literals
+static const size_t LZ4_MF_LIMIT = 12;
+static const size_t LZ4_LAST_LITERALS = 5;
+
+static uint32_t read_u32(const uint8_t* ptr) {
+    uint32_t val;
+    memcpy(&val, ptr, sizeof(val));
+    return val;
+}
+
+static uint32_t hash_u32(uint32_t val) {
+    return (val * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// write the extra bytes of a literal- or match-length >= 15
+static void write_length(std::vector<uint8_t>& out, size_t len) {
+    len -= 15;
+    while (len >= 255) {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back((uint8_t)len);
+}
+
+static void write_sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t num_literals, size_t offset, size_t match_len) {
+    const bool has_match = match_len > 0;
+    const size_t ml = has_match ? (match_len - LZ4_MIN_MATCH) : 0;
+    const uint8_t token = (uint8_t)(((num_literals < 15) ? num_literals : 15) << 4) | (uint8_t)((ml < 15) ? ml : 15);
+    out.push_back(token);
+    if (num_literals >= 15) {
+        write_length(out, num_literals);
+    }
+    out.insert(out.end(), literals, literals + num_literals);
+    if (has_match) {
+        out.push_back((uint8_t)(offset & 0xFF));
+        out.push_back((uint8_t)((offset >> 8) & 0xFF));
+        if (ml >= 15) {
+            write_length(out, ml);
+        }
+    }
+}
+
+std::vector<uint8_t> Compress::lz4(const uint8_t* data, size_t num_bytes) {
+    std::vector<uint8_t> out;
+    out.reserve(num_bytes / 2 + 16);
+    std::vector<int64_t> table(1 << LZ4_HASH_BITS, -1);
+    size_t anchor = 0;
+    size_t pos = 0;
+    if (num_bytes > LZ4_MF_LIMIT) {
+        const size_t match_start_limit = num_bytes - LZ4_MF_LIMIT;
+        const size_t match_end_limit = num_bytes - LZ4_LAST_LITERALS;
+        while (pos <= match_start_limit) {
+            const uint32_t val = read_u32(data + pos);
+            const uint32_t h = hash_u32(val);
+            const int64_t cand = table[h];
+            table[h] = (int64_t)pos;
+            if ((cand >= 0) && ((pos - (size_t)cand) <= LZ4_MAX_OFFSET) && (read_u32(data + cand) == val)) {
+                size_t match_len = LZ4_MIN_MATCH;
+                while (((pos + match_len) < match_end_limit) && (data[cand + match_len] == data[pos + match_len])) {
+                    match_len++;
+                }
+                write_sequence(out, data + anchor, pos - anchor, pos - (size_t)cand, match_len);
+                pos += match_len;
+                anchor = pos;
+            } else {
+                pos++;
+            }
+        }
+    }
+    // the last sequence only has literals
+    write_sequence(out, data + anchor, num_bytes - anchor, 0, 0);
+    return out;
+}
+
+} // namespace shdc
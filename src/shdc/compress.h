@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace shdc {
+
+// compression of embedded shader arrays (--compress)
+struct Compress {
+    // compress into an LZ4 block (no frame header, and no size prefix)
+    static std::vector<uint8_t> lz4(const uint8_t* data, size_t num_bytes);
+};
+
+} // namespace shdc
@@ -2,6 +2,7 @@
     Generate bare output in text or binary format
 */
 #include "bare.h"
+#include "binwriter.h"
 #include "fmt/format.h"
 #include "pystring.h"
 #include <stdio.h>
@@ -10,11 +11,12 @@ namespace shdc::gen {
 
 using namespace refl;
 
-static ErrMsg write_file(const std::string& file_path, const SpirvcrossSource* src, const BytecodeBlob* blob) {
-    FILE* f = fopen(file_path.c_str(), "wb");
-    if (f == nullptr) {
-        return ErrMsg::error(file_path, 0, fmt::format("failed to open output file '{}'", file_path));
-    }
+static const uint32_t pack_magic = 0x4B504853;   // 'SHPK'
+static const uint32_t pack_version = 1;
+static const size_t pack_header_words = 7;
+static const size_t pack_entry_words = 7;
+
+static ErrMsg write_file(const GenInput& gen, const std::string& file_path, const SpirvcrossSource* src, const BytecodeBlob* blob) {
     const void* write_data;
     size_t write_count;
     if (blob) {
@@ -25,12 +27,9 @@ static ErrMsg write_file(const std::string& file_path, const SpirvcrossSource* s
         write_data = src->source_code.data();
         write_count = src->source_code.length();
     }
-    size_t written = fwrite(write_data, 1, write_count, f);
-    if (written != write_count) {
-        fclose(f);
+    if (!Generator::write_output_file(gen, file_path, write_data, write_count, true)) {
         return ErrMsg::error(file_path, 0, fmt::format("failed to write output file '{}'", file_path));
     }
-    fclose(f);
     return ErrMsg();
 }
 
@@ -41,6 +40,9 @@ ErrMsg BareGenerator::generate(const GenInput& gen) {
     if (err.valid()) {
         return err;
     }
+    if (gen.args.pack) {
+        return write_pack(gen);
+    }
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (gen.args.slang & Slang::bit(slang)) {
@@ -48,11 +50,14 @@ ErrMsg BareGenerator::generate(const GenInput& gen) {
             const Bytecode& bytecode = gen.bytecode[slang];
             for (const ProgramReflection& prog: gen.refl.progs) {
                 for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                    if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                        continue;
+                    }
                     const StageReflection& refl = prog.stages[stage_index];
                     const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(refl.snippet_index);
                     const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(refl.snippet_index);
                     const std::string file_path = shader_file_path(gen, prog.name, refl.stage_name, slang, blob != nullptr);
-                    err = write_file(file_path, src, blob);
+                    err = write_file(gen, file_path, src, blob);
                     if (err.valid()) {
                         return err;
                     }
@@ -63,10 +68,72 @@ ErrMsg BareGenerator::generate(const GenInput& gen) {
     return ErrMsg();
 }
 
+// with --pack, all shader files of a module go into a single file with
+// an entry table, see the 'bare' section in docs/sokol-shdc.md
+ErrMsg BareGenerator::write_pack(const GenInput& gen) {
+    struct Entry {
+        const ProgramReflection* prog = nullptr;
+        const StageReflection* refl = nullptr;
+        Slang::Enum slang = Slang::Num;
+        const SpirvcrossSource* src = nullptr;
+        const BytecodeBlob* blob = nullptr;
+    };
+    std::vector<Entry> entries;
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            for (const ProgramReflection& prog: gen.refl.progs) {
+                for (const StageReflection& refl: prog.stages) {
+                    if (refl.stage == ShaderStage::Invalid) {
+                        continue;
+                    }
+                    Entry entry;
+                    entry.prog = &prog;
+                    entry.refl = &refl;
+                    entry.slang = slang;
+                    entry.src = gen.spirvcross[slang].find_source_by_snippet_index(refl.snippet_index);
+                    entry.blob = gen.bytecode[slang].find_blob_by_snippet_index(refl.snippet_index);
+                    entries.push_back(entry);
+                }
+            }
+        }
+    }
+    BinWriter w;
+    const uint32_t header = w.alloc(pack_header_words);
+    bin_write_records(w, header, 5, entries, pack_entry_words, [&](uint32_t rec, const Entry& entry) {
+        w.put(rec, 0, w.str(entry.prog->name));
+        w.put(rec, 1, w.str(Slang::to_str(entry.slang)));
+        w.put(rec, 2, (uint32_t)entry.refl->stage);
+        w.put(rec, 3, entry.blob ? 1 : 0);
+        if (entry.blob) {
+            w.put(rec, 4, w.payload(entry.blob->data.data(), entry.blob->data.size()));
+            w.put(rec, 5, (uint32_t)entry.blob->data.size());
+        } else {
+            assert(entry.src);
+            w.put(rec, 4, w.payload(entry.src->source_code.data(), entry.src->source_code.length()));
+            w.put(rec, 5, (uint32_t)entry.src->source_code.length());
+        }
+        w.put(rec, 6, w.str(gen.args.reproducible_path(shader_file_path(gen, entry.prog->name, entry.refl->stage_name, entry.slang, entry.blob != nullptr))));
+    });
+    w.finish(header, pack_magic, pack_version);
+    const std::string file_path = pack_file_path(gen);
+    if (!write_output_file(gen, file_path, w.data.data(), w.data.size(), true)) {
+        return ErrMsg::error(file_path, 0, fmt::format("failed to write output file '{}'", file_path));
+    }
+    return ErrMsg();
+}
+
+std::string BareGenerator::pack_file_path(const GenInput& gen) {
+    return fmt::format("{}_{}shaders.pack", gen.args.output, mod_prefix);
+}
+
 static const char* slang_file_extension(Slang::Enum c, bool binary) {
     if (Slang::is_glsl(c)) {
         return ".glsl";
     }
+    if (c == Slang::HLSL6) {
+        return binary ? ".dxil" : ".hlsl";
+    }
     if (Slang::is_hlsl(c)) {
         return binary ? ".fxc" : ".hlsl";
     }
@@ -76,6 +143,9 @@ static const char* slang_file_extension(Slang::Enum c, bool binary) {
     if (Slang::is_msl(c)) {
         return ".wgsl";
     }
+    if (Slang::is_spirv(c)) {
+        return binary ? ".spv" : ".spvasm";
+    }
     return "";
 }
 
@@ -9,8 +9,10 @@ public:
 protected:
     std::string mod_prefix;
     std::string shader_file_path(const GenInput& gen, const std::string& prog_name, const std::string& stage_name, Slang::Enum slang, bool is_blob);
+    std::string pack_file_path(const GenInput& gen);
 private:
     ErrMsg gen_shader_sources_and_blobs(const GenInput& gen, Slang::Enum slang);
+    ErrMsg write_pack(const GenInput& gen);
 };
 
 } // namespace
@@ -0,0 +1,155 @@
+/*
+    Generate a single binary file with reflection info and shader code,
+    see the 'bare_bin' section in docs/sokol-shdc.md for the file layout
+*/
+#include "barebin.h"
+#include "binwriter.h"
+#include "fmt/format.h"
+
+namespace shdc::gen {
+
+using namespace refl;
+
+static const uint32_t bin_magic = 0x43444853;    // 'SHDC'
+static const uint32_t bin_version = 5;
+static const size_t bin_header_words = 7;
+static const size_t bin_slang_words = 3;
+static const size_t bin_stage_words = 22;
+static const size_t bin_program_stages_word = 7;
+static const size_t bin_program_words = bin_program_stages_word + ShaderStage::Num * bin_stage_words;
+static const size_t bin_attr_words = 5;
+static const size_t bin_uniform_block_words = 7;
+static const size_t bin_uniform_words = 4;
+static const size_t bin_storage_buffer_words = 7;
+static const size_t bin_image_words = 5;
+static const size_t bin_sampler_words = 3;
+static const size_t bin_image_sampler_words = 6;
+
+static void write_attrs(BinWriter& w, uint32_t parent, size_t word_index, const std::array<StageAttr, StageAttr::Num>& attrs) {
+    std::vector<StageAttr> used_attrs;
+    for (const StageAttr& attr: attrs) {
+        if (attr.slot >= 0) {
+            used_attrs.push_back(attr);
+        }
+    }
+    bin_write_records(w, parent, word_index, used_attrs, bin_attr_words, [&](uint32_t rec, const StageAttr& attr) {
+        w.put(rec, 0, (uint32_t)attr.slot);
+        w.put(rec, 1, w.str(attr.name));
+        w.put(rec, 2, w.str(attr.sem_name));
+        w.put(rec, 3, (uint32_t)attr.sem_index);
+        w.put(rec, 4, (uint32_t)attr.type_info.type);
+    });
+}
+
+static void write_stage(BinWriter& w, uint32_t rec, const StageReflection& refl, const SpirvcrossSource* src, const BytecodeBlob* blob, Slang::Enum slang) {
+    w.put(rec, 0, w.str(refl.entry_point_by_slang(slang)));
+    w.put(rec, 1, blob ? 1 : 0);
+    if (blob) {
+        w.put(rec, 2, w.payload(blob->data.data(), blob->data.size()));
+        w.put(rec, 3, (uint32_t)blob->data.size());
+    } else {
+        w.put(rec, 2, w.payload(src->source_code.data(), src->source_code.length()));
+        w.put(rec, 3, (uint32_t)src->source_code.length());
+    }
+    write_attrs(w, rec, 4, refl.inputs);
+    write_attrs(w, rec, 6, refl.outputs);
+    const Bindings& bindings = refl.bindings;
+    bin_write_records(w, rec, 8, bindings.uniform_blocks, bin_uniform_block_words, [&](uint32_t ub_rec, const UniformBlock& ub) {
+        w.put(ub_rec, 0, (uint32_t)ub.slot);
+        w.put(ub_rec, 1, (uint32_t)((ub.struct_info.size + 15) & ~15));
+        w.put(ub_rec, 2, w.str(ub.struct_info.name));
+        w.put(ub_rec, 3, w.str(ub.inst_name));
+        w.put(ub_rec, 4, ub.flattened ? 1 : 0);
+        bin_write_records(w, ub_rec, 5, ub.struct_info.struct_items, bin_uniform_words, [&](uint32_t u_rec, const Type& u) {
+            w.put(u_rec, 0, w.str(u.name));
+            w.put(u_rec, 1, (uint32_t)u.type);
+            w.put(u_rec, 2, (uint32_t)u.array_count);
+            w.put(u_rec, 3, (uint32_t)u.offset);
+        });
+    });
+    bin_write_records(w, rec, 10, bindings.storage_buffers, bin_storage_buffer_words, [&](uint32_t sbuf_rec, const StorageBuffer& sbuf) {
+        w.put(sbuf_rec, 0, (uint32_t)sbuf.slot);
+        w.put(sbuf_rec, 1, (uint32_t)sbuf.struct_info.size);
+        w.put(sbuf_rec, 2, (uint32_t)sbuf.struct_info.align);
+        w.put(sbuf_rec, 3, w.str(sbuf.struct_info.name));
+        w.put(sbuf_rec, 4, w.str(sbuf.inst_name));
+        w.put(sbuf_rec, 5, sbuf.readonly ? 1 : 0);
+        w.put(sbuf_rec, 6, w.str(sbuf.struct_info.struct_items[0].struct_typename));
+    });
+    bin_write_records(w, rec, 12, bindings.images, bin_image_words, [&](uint32_t img_rec, const Image& img) {
+        w.put(img_rec, 0, (uint32_t)img.slot);
+        w.put(img_rec, 1, w.str(img.name));
+        w.put(img_rec, 2, (uint32_t)img.type);
+        w.put(img_rec, 3, (uint32_t)img.sample_type);
+        w.put(img_rec, 4, img.multisampled ? 1 : 0);
+    });
+    bin_write_records(w, rec, 14, bindings.samplers, bin_sampler_words, [&](uint32_t smp_rec, const Sampler& smp) {
+        w.put(smp_rec, 0, (uint32_t)smp.slot);
+        w.put(smp_rec, 1, w.str(smp.name));
+        w.put(smp_rec, 2, (uint32_t)smp.type);
+    });
+    bin_write_records(w, rec, 16, bindings.image_samplers, bin_image_sampler_words, [&](uint32_t img_smp_rec, const ImageSampler& img_smp) {
+        w.put(img_smp_rec, 0, (uint32_t)img_smp.slot);
+        w.put(img_smp_rec, 1, w.str(img_smp.name));
+        w.put(img_smp_rec, 2, w.str(img_smp.image_name));
+        w.put(img_smp_rec, 3, w.str(img_smp.sampler_name));
+        w.put(img_smp_rec, 4, (uint32_t)bindings.find_image_by_name(img_smp.image_name)->slot);
+        w.put(img_smp_rec, 5, (uint32_t)bindings.find_sampler_by_name(img_smp.sampler_name)->slot);
+    });
+    for (int i = 0; i < 3; i++) {
+        w.put(rec, 18 + i, (uint32_t)refl.workgroup_size[i]);
+    }
+    w.put(rec, 21, (refl.discards ? 1 : 0) | (refl.writes_frag_depth ? 2 : 0) | (refl.early_fragment_tests ? 8 : 0));
+}
+
+// completely override the generate function, everything goes into a single output file
+ErrMsg BareBinGenerator::generate(const GenInput& gen) {
+    ErrMsg err = check_errors(gen);
+    if (err.valid()) {
+        return err;
+    }
+    std::vector<Slang::Enum> slangs;
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            slangs.push_back(slang);
+        }
+    }
+    BinWriter w;
+    const uint32_t header = w.alloc(bin_header_words);
+    bin_write_records(w, header, 5, slangs, bin_slang_words, [&](uint32_t slang_rec, Slang::Enum slang) {
+        const Spirvcross& spirvcross = gen.spirvcross[slang];
+        const Bytecode& bytecode = gen.bytecode[slang];
+        w.put(slang_rec, 0, w.str(Slang::to_str(slang)));
+        bin_write_records(w, slang_rec, 1, gen.refl.progs, bin_program_words, [&](uint32_t prog_rec, const ProgramReflection& prog) {
+            w.put(prog_rec, 0, w.str(prog.name));
+            const uint64_t hash = program_hash(gen, prog, slang);
+            w.put(prog_rec, 1, (uint32_t)hash);
+            w.put(prog_rec, 2, (uint32_t)(hash >> 32));
+            for (int i = 0; i < LayoutClass::Num; i++) {
+                const uint64_t cls = prog.layout_classes[i];
+                w.put(prog_rec, 3 + i * 2, (uint32_t)cls);
+                w.put(prog_rec, 4 + i * 2, (uint32_t)(cls >> 32));
+            }
+            // stages which don't exist in a program are left zero-initialized
+            for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                    continue;
+                }
+                const StageReflection& refl = prog.stages[stage_index];
+                const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(refl.snippet_index);
+                const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(refl.snippet_index);
+                write_stage(w, (uint32_t)(prog_rec + (bin_program_stages_word + stage_index * bin_stage_words) * 4), refl, src, blob, slang);
+            }
+        });
+    });
+    w.finish(header, bin_magic, bin_version);
+
+    const std::string& file_path = gen.args.output;
+    if (!write_output_file(gen, file_path, w.data.data(), w.data.size(), true)) {
+        return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", file_path));
+    }
+    return ErrMsg();
+}
+
+} // namespace
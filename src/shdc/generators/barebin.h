@@ -0,0 +1,11 @@
+#pragma once
+#include "bare.h"
+
+namespace shdc::gen {
+
+class BareBinGenerator: public BareGenerator {
+public:
+    virtual ErrMsg generate(const GenInput& gen);
+};
+
+} // namespace
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+namespace shdc::gen {
+
+// a writer for the binary bare_bin and --pack output files, all records are
+// sequences of little-endian 32-bit words which are allocated first and patched
+// afterwards, references are byte offsets from the start of the file (or from
+// the start of the string table for strings)
+//
+// both file types start with the same 5-word header prefix:
+//  magic, version, file_size, strings_offset, strings_size
+struct BinWriter {
+    static const size_t payload_align = 16;
+    std::vector<uint8_t> data;
+    std::string strings;
+    std::map<std::string, uint32_t> string_offsets;
+
+    BinWriter() {
+        strings.push_back(0);   // string offset 0 is the empty string
+        string_offsets[""] = 0;
+    }
+    uint32_t alloc(size_t num_words) {
+        const uint32_t offset = (uint32_t)data.size();
+        data.resize(data.size() + num_words * 4, 0);
+        return offset;
+    }
+    void put(uint32_t offset, size_t word_index, uint32_t val) {
+        uint8_t* ptr = &data[offset + word_index * 4];
+        ptr[0] = (uint8_t)(val);
+        ptr[1] = (uint8_t)(val >> 8);
+        ptr[2] = (uint8_t)(val >> 16);
+        ptr[3] = (uint8_t)(val >> 24);
+    }
+    uint32_t str(const std::string& s) {
+        auto it = string_offsets.find(s);
+        if (it != string_offsets.end()) {
+            return it->second;
+        }
+        const uint32_t offset = (uint32_t)strings.size();
+        strings.append(s);
+        strings.push_back(0);
+        string_offsets[s] = offset;
+        return offset;
+    }
+    // shader code is 16-byte aligned with a terminating zero (not included in the size)
+    uint32_t payload(const void* ptr, size_t num_bytes) {
+        data.resize((data.size() + payload_align - 1) & ~(payload_align - 1), 0);
+        const uint32_t offset = (uint32_t)data.size();
+        data.insert(data.end(), (const uint8_t*)ptr, (const uint8_t*)ptr + num_bytes);
+        data.push_back(0);
+        data.resize((data.size() + 3) & ~3, 0);
+        return offset;
+    }
+    // write the header prefix, and append the string table to the end of the file
+    void finish(uint32_t header, uint32_t magic, uint32_t version) {
+        const uint32_t strings_offset = (uint32_t)data.size();
+        data.insert(data.end(), strings.begin(), strings.end());
+        data.resize((data.size() + 3) & ~3, 0);
+        put(header, 0, magic);
+        put(header, 1, version);
+        put(header, 2, (uint32_t)data.size());
+        put(header, 3, strings_offset);
+        put(header, 4, (uint32_t)strings.size());
+    }
+};
+
+// write an array of records, and patch count and offset into the parent record
+template<typename T, typename F> void bin_write_records(BinWriter& w, uint32_t parent, size_t word_index, const std::vector<T>& items, size_t record_words, F write_record) {
+    const uint32_t offset = w.alloc(items.size() * record_words);
+    w.put(parent, word_index, (uint32_t)items.size());
+    w.put(parent, word_index + 1, items.empty() ? 0 : offset);
+    for (size_t i = 0; i < items.size(); i++) {
+        write_record((uint32_t)(offset + i * record_words * 4), items[i]);
+    }
+}
+
+} // namespace
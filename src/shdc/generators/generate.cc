@@ -4,6 +4,7 @@
 #include "generate.h"
 #include "types/format.h"
 #include "bare.h"
+#include "barebin.h"
 #include "sokolc.h"
 #include "sokolnim.h"
 #include "sokolodin.h"
@@ -22,6 +23,8 @@ std::unique_ptr<Generator> make_generator(Format::Enum format) {
             return std::make_unique<BareGenerator>();
         case Format::BARE_YAML:
             return std::make_unique<YamlGenerator>();
+        case Format::BARE_BIN:
+            return std::make_unique<BareBinGenerator>();
         case Format::SOKOL_ZIG:
             return std::make_unique<SokolZigGenerator>();
         case Format::SOKOL_NIM:
@@ -3,6 +3,15 @@
 */
 #include "generator.h"
 #include "pystring.h"
+#include "types/option.h"
+#include "types/msl_argument_buffer.h"
+#include "types/reflection/program_hasher.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
 
 using namespace shdc::refl;
 
@@ -19,6 +28,8 @@ ErrMsg Generator::generate(const GenInput& gen) {
     gen_prerequisites(gen);
     gen_vertex_attr_consts(gen);
     gen_bind_slot_consts(gen);
+    gen_program_hash_consts(gen);
+    gen_layout_class_consts(gen);
     gen_uniform_block_decls(gen);
     gen_storage_buffer_decls(gen);
     gen_stb_impl_start(gen);
@@ -33,22 +44,134 @@ ErrMsg Generator::generate(const GenInput& gen) {
     return err;
 }
 
+// target languages which may share shader arrays, must not cross the
+// boundaries of the backend-specific #ifdefs of the C generator
+int Generator::shared_array_group(Slang::Enum slang) {
+    switch (slang) {
+        case Slang::GLSL410:
+        case Slang::GLSL430:
+            return 0;
+        case Slang::GLSL300ES:
+            return 1;
+        case Slang::HLSL4:
+        case Slang::HLSL5:
+            return 2;
+        case Slang::METAL_MACOS:
+        case Slang::METAL_IOS:
+        case Slang::METAL_SIM:
+            return 3;
+        default:
+            return 4 + (int)slang;
+    }
+}
+
+// find identical shader payloads (e.g. the MSL source is often identical for all Metal
+// flavours, and @permutation variants may compile to identical shaders), the first
+// occurrence in slang and snippet order owns the shader array
+void Generator::find_shared_arrays(const GenInput& gen) {
+    struct Key {
+        int group;
+        bool is_bytecode;
+        std::string_view payload;
+        bool operator==(const Key& other) const {
+            return (group == other.group) && (is_bytecode == other.is_bytecode) && (payload == other.payload);
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<std::string_view>()(key.payload) ^ (size_t)(key.group * 2 + (key.is_bytecode ? 1 : 0));
+        }
+    };
+    std::unordered_map<Key, SharedArray, KeyHash> owners;
+    for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
+        const Slang::Enum slang = Slang::from_index(slang_idx);
+        shared_arrays[slang].clear();
+        if (0 == (gen.args.slang & Slang::bit(slang))) {
+            continue;
+        }
+        shared_arrays[slang].resize(gen.inp.snippets.size());
+        for (int snippet_index = 0; snippet_index < (int)gen.inp.snippets.size(); snippet_index++) {
+            SharedArray self;
+            self.slang = slang;
+            self.snippet_index = snippet_index;
+            shared_arrays[slang][snippet_index] = self;
+            const SpirvcrossSource* src = gen.spirvcross[slang].find_source_by_snippet_index(snippet_index);
+            if (!src) {
+                continue;
+            }
+            Key key;
+            key.group = shared_array_group(slang);
+            const BytecodeBlob* blob = gen.bytecode[slang].find_blob_by_snippet_index(snippet_index);
+            if (blob) {
+                key.is_bytecode = true;
+                key.payload = std::string_view((const char*)blob->data.data(), blob->data.size());
+            } else {
+                key.is_bytecode = false;
+                key.payload = src->source_code;
+            }
+            auto res = owners.insert({ key, self });
+            shared_arrays[slang][snippet_index] = res.first->second;
+        }
+    }
+}
+
+Generator::SharedArray Generator::shared_array(Slang::Enum slang, int snippet_index) const {
+    if (snippet_index < (int)shared_arrays[slang].size()) {
+        return shared_arrays[slang][snippet_index];
+    }
+    SharedArray self;
+    self.slang = slang;
+    self.snippet_index = snippet_index;
+    return self;
+}
+
+// true if the shader array of a (slang, snippet) is owned by another (slang, snippet)
+bool Generator::is_shared_array(Slang::Enum slang, int snippet_index) const {
+    const SharedArray shared = shared_array(slang, snippet_index);
+    return (shared.slang != slang) || (shared.snippet_index != snippet_index);
+}
+
 Generator::ShaderStageArrayInfo Generator::shader_stage_array_info(const GenInput& gen, const ProgramReflection& prog, ShaderStage::Enum stage, Slang::Enum slang) {
     ShaderStageArrayInfo info;
-    const BytecodeBlob* bytecode_blob = gen.bytecode[slang].find_blob_by_snippet_index(prog.stage(stage).snippet_index);
+    const SharedArray shared = shared_array(slang, prog.stage(stage).snippet_index);
+    const std::string& snippet_name = gen.inp.snippets[shared.snippet_index].name;
+    const BytecodeBlob* bytecode_blob = gen.bytecode[shared.slang].find_blob_by_snippet_index(shared.snippet_index);
     if (bytecode_blob) {
         info.has_bytecode = true;
         info.bytecode_array_size = bytecode_blob->data.size();
     }
-    info.bytecode_array_name = shader_bytecode_array_name(prog.stage(stage).snippet_name, slang);
-    info.source_array_name = shader_source_array_name(prog.stage(stage).snippet_name, slang);
+    info.bytecode_array_name = shader_bytecode_array_name(snippet_name, shared.slang);
+    info.source_array_name = shader_source_array_name(snippet_name, shared.slang);
     return info;
 }
 
-// default behaviour of begin is to clear the generated content string, and check for error in GenInput
+// estimate the size of the generated output, dominated by the shader arrays
+// (5 bytes per array item plus the commented-out source code)
+static size_t estimate_content_size(const GenInput& gen) {
+    size_t num_bytes = 64 * 1024;
+    for (int i = 0; i < Slang::Num; i++) {
+        const Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            for (const SpirvcrossSource& src: gen.spirvcross[slang].sources) {
+                num_bytes += src.source_code.size() * 7;
+            }
+            for (const BytecodeBlob& blob: gen.bytecode[slang].blobs) {
+                num_bytes += blob.data.size() * 5;
+            }
+        }
+    }
+    return num_bytes;
+}
+
+// default behaviour of begin is to clear the generated content buffer, and check for error in GenInput
 ErrMsg Generator::begin(const GenInput& gen) {
     content.clear();
-    return check_errors(gen);
+    content.reserve(estimate_content_size(gen));
+    ErrMsg err = check_errors(gen);
+    if (!err.valid()) {
+        find_shared_arrays(gen);
+    }
+    return err;
 }
 
 // for anything written at the top of the file
@@ -77,8 +200,12 @@ void Generator::gen_header(const GenInput& gen) {
     for (const ProgramReflection& prog: gen.refl.progs) {
         cbl_open("Shader program: '{}':\n", prog.name);
         cbl("Get shader desc: {}", get_shader_desc_help(prog.name));
-        gen_vertex_shader_info(gen, prog);
-        gen_fragment_shader_info(gen, prog);
+        if (prog.is_compute()) {
+            gen_compute_shader_info(gen, prog);
+        } else {
+            gen_vertex_shader_info(gen, prog);
+            gen_fragment_shader_info(gen, prog);
+        }
         cbl_close();
     }
     cbl_end();
@@ -99,12 +226,43 @@ void Generator::gen_vertex_shader_info(const GenInput& gen, const ProgramReflect
     }
     cbl_close();
     gen_bindings_info(gen, prog.vs().bindings);
+    gen_spec_constants_info(gen, prog.vs());
+    gen_msl_argument_buffer_info(gen, prog.vs());
+    gen_glsl_uniform_buffers_info(gen, prog.vs());
     cbl_close();
 }
 
 void Generator::gen_fragment_shader_info(const GenInput& gen, const ProgramReflection& prog) {
     cbl_open("Fragment shader: {}\n", prog.fs_name());
+    if (prog.fs().early_fragment_tests) {
+        // only some target languages honor @early_fragment_tests
+        std::vector<std::string> forced_slangs;
+        for (int i = 0; i < Slang::Num; i++) {
+            const Slang::Enum slang = Slang::from_index(i);
+            if ((gen.args.slang & Slang::bit(slang)) && Slang::has_early_fragment_tests(slang)) {
+                forced_slangs.push_back(Slang::to_str(slang));
+            }
+        }
+        if (!forced_slangs.empty()) {
+            cbl("Early fragment tests: forced ({})\n", pystring::join(", ", forced_slangs));
+        }
+    } else if (prog.fs().disables_early_fragment_tests()) {
+        cbl("Early fragment tests: disabled ({})\n", prog.fs().early_fragment_tests_hazards());
+    }
     gen_bindings_info(gen, prog.fs().bindings);
+    gen_spec_constants_info(gen, prog.fs());
+    gen_msl_argument_buffer_info(gen, prog.fs());
+    gen_glsl_uniform_buffers_info(gen, prog.fs());
+    cbl_close();
+}
+
+void Generator::gen_compute_shader_info(const GenInput& gen, const ProgramReflection& prog) {
+    cbl_open("Compute shader: {}\n", prog.cs_name());
+    cbl("Workgroup size: {} x {} x {}\n", prog.cs().workgroup_size[0], prog.cs().workgroup_size[1], prog.cs().workgroup_size[2]);
+    gen_bindings_info(gen, prog.cs().bindings);
+    gen_spec_constants_info(gen, prog.cs());
+    gen_msl_argument_buffer_info(gen, prog.cs());
+    gen_glsl_uniform_buffers_info(gen, prog.cs());
     cbl_close();
 }
 
@@ -143,6 +301,83 @@ void Generator::gen_bindings_info(const GenInput& gen, const Bindings& bindings)
     }
 }
 
+void Generator::gen_spec_constants_info(const GenInput& gen, const StageReflection& refl) {
+    for (const SpecConstant& spec: refl.spec_constants) {
+        cbl_open("Specialization constant '{}':\n", spec.name);
+        cbl("Type: {}\n", Type::type_to_glsl(spec.type));
+        cbl("Default value: {}\n", spec.default_value);
+        cbl("Constant id: {} => {}\n", spec_constant_name(spec), spec.id);
+        cbl_close();
+    }
+}
+
+std::vector<std::string> Generator::unique_backends(const GenInput& gen) {
+    std::vector<std::string> res;
+    for (int i = 0; i < Slang::Num; i++) {
+        const Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            const std::string be = backend(slang);
+            if (std::find(res.begin(), res.end(), be) == res.end()) {
+                res.push_back(be);
+            }
+        }
+    }
+    return res;
+}
+
+bool Generator::uses_msl_argument_buffer(const GenInput& gen, const StageReflection& refl, Slang::Enum slang) {
+    return Slang::is_msl(slang) && (0 != (gen.inp.snippets[refl.snippet_index].options[slang] & Option::ARGUMENT_BUFFERS));
+}
+
+// only written when the stage uses a Metal argument buffer on any of the Metal
+// targets, @msl_options are the same for all Metal targets
+void Generator::gen_msl_argument_buffer_info(const GenInput& gen, const StageReflection& refl) {
+    bool uses_arg_buf = false;
+    for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
+        const Slang::Enum slang = Slang::from_index(slang_idx);
+        if (gen.args.slang & Slang::bit(slang)) {
+            uses_arg_buf |= uses_msl_argument_buffer(gen, refl, slang);
+        }
+    }
+    if (!uses_arg_buf) {
+        return;
+    }
+    cbl_open("Metal argument buffer: [[buffer({})]]\n", MslArgumentBuffer::buffer_index(ShaderStage::is_vs(refl.stage)));
+    for (const StorageBuffer& sbuf: refl.bindings.storage_buffers) {
+        cbl("Storage buffer '{}' => [[id({})]]\n", sbuf.struct_info.name, MslArgumentBuffer::storage_buffer_id(sbuf.slot));
+    }
+    for (const Image& img: refl.bindings.images) {
+        cbl("Image '{}' => [[id({})]]\n", img.name, MslArgumentBuffer::image_id(img.slot));
+    }
+    for (const Sampler& smp: refl.bindings.samplers) {
+        cbl("Sampler '{}' => [[id({})]]\n", smp.name, MslArgumentBuffer::sampler_id(smp.slot));
+    }
+    cbl_close();
+}
+
+bool Generator::uses_glsl_uniform_buffers(const GenInput& gen, const StageReflection& refl, Slang::Enum slang) {
+    return Slang::is_glsl(slang) && (0 != (gen.inp.snippets[refl.snippet_index].options[slang] & Option::UNIFORM_BUFFERS));
+}
+
+// only written when the stage uses native uniform buffers on any of the GLSL targets
+void Generator::gen_glsl_uniform_buffers_info(const GenInput& gen, const StageReflection& refl) {
+    bool uses_ubos = false;
+    for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
+        const Slang::Enum slang = Slang::from_index(slang_idx);
+        if (gen.args.slang & Slang::bit(slang)) {
+            uses_ubos |= uses_glsl_uniform_buffers(gen, refl, slang);
+        }
+    }
+    if (!uses_ubos || refl.bindings.uniform_blocks.empty()) {
+        return;
+    }
+    cbl_open("GL uniform buffers (glsl410, glsl430):\n");
+    for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
+        cbl("Uniform block '{}' => binding {}\n", ub.struct_info.name, UniformBlock::glsl_binding(ShaderStage::is_fs(refl.stage), ub.slot));
+    }
+    cbl_close();
+}
+
 void Generator::gen_vertex_attr_consts(const GenInput& gen) {
     for (const StageAttr& attr: gen.refl.unique_vs_inputs) {
         if (attr.slot >= 0) {
@@ -164,6 +399,32 @@ void Generator::gen_bind_slot_consts(const GenInput& gen) {
     for (const Sampler& smp: gen.refl.bindings.samplers) {
         l("{}\n", sampler_bind_slot_definition(smp));
     }
+    for (const SpecConstant& spec: gen.refl.spec_constants) {
+        l("{}\n", spec_constant_definition(spec));
+    }
+}
+
+void Generator::gen_program_hash_consts(const GenInput& gen) {
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        for (int i = 0; i < Slang::Num; i++) {
+            const Slang::Enum slang = Slang::from_index(i);
+            if (gen.args.slang & Slang::bit(slang)) {
+                l("{}\n", program_hash_definition(prog, slang, program_hash(gen, prog, slang)));
+            }
+        }
+    }
+}
+
+void Generator::gen_layout_class_consts(const GenInput& gen) {
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        for (int i = 0; i < LayoutClass::Num; i++) {
+            const LayoutClass::Enum cls = LayoutClass::from_index(i);
+            if ((cls == LayoutClass::VertexLayout) && prog.is_compute()) {
+                continue;
+            }
+            l("{}\n", layout_class_definition(prog, cls));
+        }
+    }
 }
 
 void Generator::gen_uniform_block_decls(const GenInput& gen) {
@@ -186,58 +447,94 @@ void Generator::gen_shader_arrays(const GenInput& gen) {
             const Bytecode& bytecode = gen.bytecode[slang];
             for (int snippet_index = 0; snippet_index < (int)gen.inp.snippets.size(); snippet_index++) {
                 const Snippet& snippet = gen.inp.snippets[snippet_index];
-                if ((snippet.type != Snippet::VS) && (snippet.type != Snippet::FS)) {
+                if (!Snippet::is_shader(snippet.type)) {
+                    continue;
+                }
+                if (is_shared_array(slang, snippet_index)) {
+                    // identical payload has already been written
                     continue;
                 }
                 const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(snippet_index);
                 assert(src);
                 const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(snippet_index);
-                std::vector<std::string> lines;
-                pystring::splitlines(src->source_code, lines);
-                // first write the source code in a comment block
-                cbl_start();
-                for (const std::string& line: lines) {
-                    cbl("{}\n", replace_C_comment_tokens(line));
+                // first write the source code in a comment block (skipped when minifying)
+                if (!gen.args.minify) {
+                    std::vector<std::string> lines;
+                    pystring::splitlines(src->source_code, lines);
+                    cbl_start();
+                    for (const std::string& line: lines) {
+                        cbl("{}\n", replace_C_comment_tokens(line));
+                    }
+                    cbl_end();
                 }
-                cbl_end();
                 if (blob) {
                     const std::string array_name = shader_bytecode_array_name(snippet.name, slang);
-                    gen_shader_array_start(gen, array_name, blob->data.size(), slang);
-                    const size_t len = blob->data.size();
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        l("{:#04x},", blob->data[i]);
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
+                    gen_shader_array(gen, array_name, blob->data.data(), blob->data.size(), slang);
                 } else {
                     // if no bytecode exists, write the source code, but also a byte array with a trailing 0
                     const std::string array_name = shader_source_array_name(snippet.name, slang);
                     const size_t len = src->source_code.length() + 1;
-                    gen_shader_array_start(gen, array_name, len, slang);
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        l("{:#04x},", (int)src->source_code[i]);
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
+                    gen_shader_array(gen, array_name, (const uint8_t*)src->source_code.c_str(), len, slang);
                 }
             }
         }
     }
 }
 
+void Generator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* data, size_t num_bytes, Slang::Enum slang) {
+    if (gen.args.embed) {
+        // write the array content into a sidecar file next to the output file
+        const std::string path = fmt::format("{}_{}.bin", gen.args.output, array_name);
+        if (!write_output_file(gen, path, data, num_bytes, true)) {
+            if (!embed_error.valid()) {
+                embed_error = ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to write embedded file '{}'", path));
+            }
+            return;
+        }
+        gen_shader_array_embed(gen, array_name, pystring::os::path::basename(path), num_bytes, slang);
+        return;
+    }
+    gen_shader_array_start(gen, array_name, num_bytes, slang);
+    gen_hex_bytes(data, num_bytes);
+    gen_shader_array_end(gen);
+}
+
+// this is called for every byte of shader code, so avoid going through fmt::format()
+void Generator::gen_hex_bytes(const uint8_t* data, size_t num_bytes, const char* first_suffix) {
+    static const char* hex_digits = "0123456789abcdef";
+    static const char* line_prefix = "    ";
+    const size_t suffix_len = strlen(first_suffix);
+    content.reserve(content.size() + (num_bytes / 16 + 1) * (indentation.size() + 4 + 1) + num_bytes * 5 + suffix_len);
+    for (size_t i = 0; i < num_bytes; i++) {
+        if ((i & 15) == 0) {
+            content.append(indentation.data(), indentation.data() + indentation.size());
+            content.append(line_prefix, line_prefix + 4);
+        }
+        const char item[5] = { '0', 'x', hex_digits[data[i] >> 4], hex_digits[data[i] & 15], ',' };
+        if ((0 == i) && (suffix_len > 0)) {
+            content.append(item, item + 4);
+            content.append(first_suffix, first_suffix + suffix_len);
+            content.push_back(',');
+        } else {
+            content.append(item, item + 5);
+        }
+        if ((i & 15) == 15) {
+            content.push_back('\n');
+        }
+    }
+}
+
 void Generator::gen_shader_desc_funcs(const GenInput& gen) {
     for (const auto& prog: gen.refl.progs) {
         gen_shader_desc_func(gen, prog);
+        if (prog.has_vertex_layout()) {
+            gen_vertex_layout_func(gen, prog);
+        }
+    }
+    for (const auto& item: gen.inp.programs) {
+        if (!item.second.features.empty()) {
+            gen_shader_desc_variant_func(gen, item.second);
+        }
     }
 }
 
@@ -254,24 +551,90 @@ void Generator::gen_reflection_funcs(const GenInput& gen) {
     }
 }
 
+// check if an existing file has the same content (read in the same mode as it would be written)
+static bool file_content_equals(const std::string& path, const void* data, size_t num_bytes, bool binary) {
+    if (binary) {
+        // quick size check first
+        struct stat st;
+        if ((0 != stat(path.c_str(), &st)) || ((size_t)st.st_size != num_bytes)) {
+            return false;
+        }
+    }
+    FILE* f = fopen(path.c_str(), binary ? "rb" : "r");
+    if (!f) {
+        return false;
+    }
+    const uint8_t* ptr = (const uint8_t*) data;
+    uint8_t buf[64 * 1024];
+    size_t pos = 0;
+    bool equal = true;
+    while (equal) {
+        const size_t num_read = fread(buf, 1, sizeof(buf), f);
+        if (num_read == 0) {
+            break;
+        }
+        if (((pos + num_read) > num_bytes) || (0 != memcmp(buf, ptr + pos, num_read))) {
+            equal = false;
+        }
+        pos += num_read;
+    }
+    fclose(f);
+    return equal && (pos == num_bytes);
+}
+
+bool Generator::write_output_file(const GenInput& gen, const std::string& path, const void* data, size_t num_bytes, bool binary) {
+    if (gen.args.io.write) {
+        return gen.args.io.write(path, data, num_bytes, binary);
+    }
+    if (gen.args.write_if_changed && file_content_equals(path, data, num_bytes, binary)) {
+        return true;
+    }
+    FILE* f = fopen(path.c_str(), binary ? "wb" : "w");
+    if (!f) {
+        return false;
+    }
+    const size_t written = fwrite(data, 1, num_bytes, f);
+    fclose(f);
+    return written == num_bytes;
+}
+
 // default behaviour of end() is to write the output file
 ErrMsg Generator::end(const GenInput& gen) {
-    FILE* f = fopen(gen.args.output.c_str(), "w");
-    if (!f) {
+    if (embed_error.valid()) {
+        return embed_error;
+    }
+    if (!write_output_file(gen, gen.args.output, content.data(), content.size(), false)) {
         return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", gen.args.output));
     }
-    fwrite(content.c_str(), content.length(), 1, f);
-    fclose(f);
     return ErrMsg();
 }
 
-// check that each input shader has a vs and fs source
+// check that each input shader has a vs and fs source (or cs source for compute programs)
 ErrMsg Generator::check_errors(const GenInput& gen) {
+    if (!Format::has_compute(gen.args.output_format)) {
+        for (const auto& item: gen.inp.programs) {
+            const Program& prog = item.second;
+            if (prog.is_compute()) {
+                return gen.inp.error(gen.inp.snippets[gen.inp.snippet_map.at(prog.cs_name)].lines[0],
+                    fmt::format("compute program '{}' is not supported by output format {} (compute programs need bare, bare_yaml or bare_bin)",
+                    prog.name, Format::to_str(gen.args.output_format)));
+            }
+        }
+    }
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (gen.args.slang & Slang::bit(slang)) {
             for (const auto& item: gen.inp.programs) {
                 const Program& prog = item.second;
+                if (prog.is_compute()) {
+                    int cs_snippet_index = gen.inp.snippet_map.at(prog.cs_name);
+                    if (gen.spirvcross[i].find_source_by_snippet_index(cs_snippet_index) == nullptr) {
+                        return gen.inp.error(gen.inp.snippets[cs_snippet_index].lines[0],
+                            fmt::format("no generated '{}' source for compute shader '{}' in program '{}'",
+                            Slang::to_str(slang), prog.cs_name, prog.name));
+                    }
+                    continue;
+                }
                 int vs_snippet_index = gen.inp.snippet_map.at(prog.vs_name);
                 int fs_snippet_index = gen.inp.snippet_map.at(prog.fs_name);
                 const SpirvcrossSource* vs_src = gen.spirvcross[i].find_source_by_snippet_index(vs_snippet_index);
@@ -293,6 +656,79 @@ ErrMsg Generator::check_errors(const GenInput& gen) {
     return ErrMsg();
 }
 
+uint64_t Generator::program_hash(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang) {
+    ProgramHasher hasher;
+    hasher.add(std::string(Slang::to_str(slang)));
+    for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+        if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+            hasher.add(0);
+            continue;
+        }
+        hasher.add(1);
+        const StageReflection& refl = prog.stages[stage_index];
+        // the shader code is bytecode if available, otherwise the source code
+        const BytecodeBlob* blob = gen.bytecode[slang].find_blob_by_snippet_index(refl.snippet_index);
+        const SpirvcrossSource* src = gen.spirvcross[slang].find_source_by_snippet_index(refl.snippet_index);
+        if (blob) {
+            hasher.add((int)blob->data.size());
+            hasher.add(blob->data.data(), blob->data.size());
+        } else if (src) {
+            hasher.add(src->source_code);
+        }
+        hasher.add(refl.entry_point_by_slang(slang));
+        for (const StageAttr& attr: refl.inputs) {
+            hasher.add(attr);
+        }
+        for (const StageAttr& attr: refl.outputs) {
+            hasher.add(attr);
+        }
+        // the image-sampler pairs of the target language specific reflection may differ
+        hasher.add(refl.bindings);
+        if (src) {
+            hasher.add(src->stage_refl->bindings);
+        }
+        for (int size: refl.workgroup_size) {
+            hasher.add(size);
+        }
+        hasher.add((int)refl.spec_constants.size());
+        for (const SpecConstant& spec: refl.spec_constants) {
+            hasher.add(spec.id);
+            hasher.add(spec.name);
+            hasher.add((int)spec.type);
+            hasher.add(spec.default_value);
+        }
+    }
+    return hasher.hash;
+}
+
+// NOTE: the generated code must compute the exact same hash at runtime
+uint32_t Generator::name_hash(const std::string& name) {
+    uint32_t hash = 0x811C9DC5;
+    for (char c: name) {
+        hash ^= (uint8_t)c;
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+// group names by hash, cases are in order of first appearance
+std::vector<Generator::NameHashCase> Generator::name_hash_cases(const std::vector<std::string>& names) {
+    std::vector<NameHashCase> cases;
+    for (int i = 0; i < (int)names.size(); i++) {
+        const uint32_t hash = name_hash(names[i]);
+        auto it = std::find_if(cases.begin(), cases.end(), [hash](const NameHashCase& c) { return c.hash == hash; });
+        if (it == cases.end()) {
+            NameHashCase c;
+            c.hash = hash;
+            c.items.push_back(i);
+            cases.push_back(std::move(c));
+        } else {
+            it->items.push_back(i);
+        }
+    }
+    return cases;
+}
+
 int Generator::roundup(int val, int round_to) {
     return (val + (round_to - 1)) & ~(round_to - 1);
 }
@@ -1,5 +1,9 @@
 #pragma once
 #include <string>
+#include <array>
+#include <vector>
+#include <ctype.h>
+#include "fmt/format.h"
 #include "pystring.h"
 #include "types/gen_input.h"
 
@@ -11,6 +15,21 @@ public:
     virtual ~Generator() {};
     virtual ErrMsg generate(const GenInput& gen);
 
+    // write an output file, skips writing if the file content wouldn't change and --write-if-changed is set,
+    // output goes to the args.io.write hook instead if set
+    static bool write_output_file(const GenInput& gen, const std::string& path, const void* data, size_t num_bytes, bool binary);
+    // stable 64-bit content hash of a program's shader code and reflection info for one
+    // target language, so that runtime hot-reloading can skip unchanged programs
+    static uint64_t program_hash(const GenInput& gen, const refl::ProgramReflection& prog, Slang::Enum slang);
+    // true if the stage binds its images, samplers and storage buffers through
+    // a Metal argument buffer (@msl_options argument_buffers)
+    static bool uses_msl_argument_buffer(const GenInput& gen, const refl::StageReflection& refl, Slang::Enum slang);
+    // true if the stage keeps its uniform blocks as native GL uniform buffers (@glsl_options uniform_buffers),
+    // the uniform block members are then not described as individual uniforms
+    static bool uses_glsl_uniform_buffers(const GenInput& gen, const refl::StageReflection& refl, Slang::Enum slang);
+    // target languages in the same group may share identical shader arrays
+    static int shared_array_group(Slang::Enum slang);
+
 protected:
     // called directly by generate() in this order
     virtual ErrMsg begin(const GenInput& gen);
@@ -19,6 +38,8 @@ protected:
     virtual void gen_prerequisites(const GenInput& gen);
     virtual void gen_vertex_attr_consts(const GenInput& gen);
     virtual void gen_bind_slot_consts(const GenInput& gen);
+    virtual void gen_program_hash_consts(const GenInput& gen);
+    virtual void gen_layout_class_consts(const GenInput& gen);
     virtual void gen_uniform_block_decls(const GenInput& gen);
     virtual void gen_storage_buffer_decls(const GenInput& gen);
     virtual void gen_stb_impl_start(const GenInput& gen) { };
@@ -32,7 +53,11 @@ protected:
     // called by gen_header()
     virtual void gen_vertex_shader_info(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_fragment_shader_info(const GenInput& gen, const refl::ProgramReflection& prog);
+    virtual void gen_compute_shader_info(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_bindings_info(const GenInput& gen, const refl::Bindings& bindings);
+    virtual void gen_spec_constants_info(const GenInput& gen, const refl::StageReflection& refl);
+    virtual void gen_msl_argument_buffer_info(const GenInput& gen, const refl::StageReflection& refl);
+    virtual void gen_glsl_uniform_buffers_info(const GenInput& gen, const refl::StageReflection& refl);
 
     // called by gen_uniform_block_decls()
     virtual void gen_uniform_block_decl(const GenInput& gen, const refl::UniformBlock& ub) { assert(false && "implement me"); };
@@ -41,11 +66,18 @@ protected:
     virtual void gen_storage_buffer_decl(const GenInput& gen, const refl::StorageBuffer& sbuf) { assert(false && "implement me"); };
 
     // called by gen_shader_arrays()
+    virtual void gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* data, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) { assert(false && "implement me"); };
     virtual void gen_shader_array_end(const GenInput& gen) { assert(false && "implement me"); };
+    // called by gen_shader_array() with --embed, file_name is relative to the output file's directory
+    virtual void gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) { assert(false && "implement me"); };
 
     // called by gen_shader_desc_funcs()
     virtual void gen_shader_desc_func(const GenInput& gen, const refl::ProgramReflection& prog) { assert(false && "implement me"); };
+    // optional, called by gen_shader_desc_funcs() for programs with @permutation
+    virtual void gen_shader_desc_variant_func(const GenInput& gen, const Program& prog) { };
+    // optional, called by gen_shader_desc_funcs() for programs with @vertex_format tags
+    virtual void gen_vertex_layout_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
 
     // optional, called by gen_reflection_funcs()
     virtual void gen_attr_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
@@ -81,12 +113,18 @@ protected:
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp) { assert(false && "implement me"); return ""; };
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub) { assert(false && "implement me"); return ""; };
     virtual std::string storage_buffer_bind_slot_name(const refl::StorageBuffer& sbuf) { assert(false && "implement me"); return ""; };
+    virtual std::string spec_constant_name(const refl::SpecConstant& spec) { assert(false && "implement me"); return ""; };
+    virtual std::string program_hash_name(const refl::ProgramReflection& prog, Slang::Enum slang) { assert(false && "implement me"); return ""; };
+    virtual std::string layout_class_name(const refl::ProgramReflection& prog, refl::LayoutClass::Enum cls) { assert(false && "implement me"); return ""; };
 
     virtual std::string vertex_attr_definition(const refl::StageAttr& attr) { assert(false && "implement me"); return ""; };
     virtual std::string image_bind_slot_definition(const refl::Image& img) { assert(false && "implement me"); return ""; };
     virtual std::string sampler_bind_slot_definition(const refl::Sampler& smp) { assert(false && "implement me"); return ""; };
     virtual std::string uniform_block_bind_slot_definition(const refl::UniformBlock& ub) { assert(false && "implement me"); return ""; };
     virtual std::string storage_buffer_bind_slot_definition(const refl::StorageBuffer& sbuf) { assert(false && "implement me"); return ""; };
+    virtual std::string spec_constant_definition(const refl::SpecConstant& spec) { assert(false && "implement me"); return ""; };
+    virtual std::string program_hash_definition(const refl::ProgramReflection& prog, Slang::Enum slang, uint64_t hash) { assert(false && "implement me"); return ""; };
+    virtual std::string layout_class_definition(const refl::ProgramReflection& prog, refl::LayoutClass::Enum cls) { assert(false && "implement me"); return ""; };
 
     struct ShaderStageArrayInfo {
     public:
@@ -97,14 +135,23 @@ protected:
     };
     ShaderStageArrayInfo shader_stage_array_info(const GenInput& gen, const refl::ProgramReflection& prog, refl::ShaderStage::Enum stage, Slang::Enum slang);
 
-    // line output
+    // identical shader sources and bytecode are only written once, each (slang, snippet)
+    // refers to the (slang, snippet) whose shader array is actually used
+    struct SharedArray {
+        Slang::Enum slang = Slang::Num;
+        int snippet_index = -1;
+    };
+    void find_shared_arrays(const GenInput& gen);
+    SharedArray shared_array(Slang::Enum slang, int snippet_index) const;
+    bool is_shared_array(Slang::Enum slang, int snippet_index) const;
+
+    // line output, formats directly into the content buffer
     template<typename... T> void l(fmt::format_string<T...> fmt, T&&... args) {
-        const std::string str = fmt::format("{}{}", indentation, fmt::format(fmt, args...));
-        content.append(str);
+        content.append(indentation.data(), indentation.data() + indentation.size());
+        fmt::format_to(fmt::appender(content), fmt, args...);
     }
     template<typename... T> void l_append(fmt::format_string<T...> fmt, T&&... args) {
-        const std::string str = fmt::format(fmt, args...);
-        content.append(str);
+        fmt::format_to(fmt::appender(content), fmt, args...);
     }
     template<typename... T> void l_open(fmt::format_string<T...> fmt, T&&... args) {
         l(fmt, args...);
@@ -122,9 +169,13 @@ protected:
         l_open("{}\n", comment_block_start());
     }
     template<typename... T> void cbl(fmt::format_string<T...> fmt, T&&... args) {
-        std::string str = pystring::rstrip(fmt::format("{}{}{}", comment_block_line_prefix(), indentation, fmt::format(fmt, args...)));
-        str += "\n";
-        content.append(str);
+        const size_t start = content.size();
+        const std::string prefix = comment_block_line_prefix();
+        content.append(prefix.data(), prefix.data() + prefix.size());
+        content.append(indentation.data(), indentation.data() + indentation.size());
+        fmt::format_to(fmt::appender(content), fmt, args...);
+        rstrip_content(start);
+        content.push_back('\n');
     }
     template<typename... T> void cbl_open(fmt::format_string<T...> fmt, T&&... args) {
         cbl(fmt, args...);
@@ -141,6 +192,23 @@ protected:
         l_close("{}\n", comment_block_end());
     }
 
+    // bulk output of shader array bytes as '0x00,' items, 16 per line, an optional
+    // suffix is appended to the first item (e.g. a type suffix like 'u8)
+    void gen_hex_bytes(const uint8_t* data, size_t num_bytes, const char* first_suffix = "");
+
+    // runtime reflection lookups by name switch over a precomputed 32-bit FNV-1a hash
+    // of the name and verify the match with a single string compare, names with
+    // colliding hashes end up in the same case
+    struct NameHashCase {
+        uint32_t hash = 0;
+        std::vector<int> items;     // indices into the names array
+    };
+    static uint32_t name_hash(const std::string& name);
+    static std::vector<NameHashCase> name_hash_cases(const std::vector<std::string>& names);
+
+    // the backend names of all enabled target languages, without duplicates
+    std::vector<std::string> unique_backends(const GenInput& gen);
+
     // utility methods
     static ErrMsg check_errors(const GenInput& gen);
     static int roundup(int val, int round_to);
@@ -149,11 +217,21 @@ protected:
     static std::string to_pascal_case(const std::string& str);
     static std::string to_ada_case(const std::string& str);
 
-    std::string content;
+    fmt::memory_buffer content;
+    ErrMsg embed_error;
+    std::array<std::vector<SharedArray>, Slang::Num> shared_arrays;
     int tab_width = 4;
     std::string indentation;
 
 private:
+    // remove trailing whitespace from the content buffer, but not before start
+    void rstrip_content(size_t start) {
+        size_t size = content.size();
+        while ((size > start) && isspace((unsigned char)content[size - 1])) {
+            size--;
+        }
+        content.resize(size);
+    }
     void indent() { for (int i = 0; i < tab_width; i++) { indentation.push_back(' '); } };
     void dedent() { for (int i = 0; i < tab_width; i++) { if (indentation.length() > 0) { indentation.pop_back(); } } };
 
@@ -4,7 +4,9 @@
 #include "sokolc.h"
 #include "fmt/format.h"
 #include "pystring.h"
+#include "compress.h"
 #include <stdio.h>
+#include <set>
 
 namespace shdc::gen {
 
@@ -20,17 +22,74 @@ static const char* sokol_define(Slang::Enum slang) {
         case Slang::HLSL4:
         case Slang::HLSL5:
             return "SOKOL_D3D11";
+        case Slang::HLSL6:
+            return "SOKOL_D3D12";
         case Slang::METAL_MACOS:
         case Slang::METAL_IOS:
         case Slang::METAL_SIM:
             return "SOKOL_METAL";
         case Slang::WGSL:
             return "SOKOL_WGPU";
+        case Slang::SPIRV:
+            return "SOKOL_VULKAN";
         default:
             return "<INVALID>";
     }
 }
 
+// with --split-backends, the regular output file only contains the backend-independent
+// parts, and the shader arrays and shader desc functions of each backend are
+// written to a separate file which includes the regular output file
+ErrMsg SokolCGenerator::generate(const GenInput& gen) {
+    ErrMsg err = Generator::generate(gen);
+    if (err.valid() || !gen.args.split_backends) {
+        return err;
+    }
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            err = gen_backend_file(gen, slang);
+            if (err.valid()) {
+                return err;
+            }
+        }
+    }
+    return ErrMsg();
+}
+
+// the generator code is run on a copy of the args with only one target language,
+// this also keeps shader arrays from being shared across backend files
+ErrMsg SokolCGenerator::gen_backend_file(const GenInput& gen, Slang::Enum slang) {
+    Args slang_args = gen.args;
+    slang_args.slang = Slang::bit(slang);
+    const GenInput slang_gen(slang_args, gen.inp, gen.spirvcross, gen.bytecode, gen.refl);
+    content.clear();
+    find_shared_arrays(slang_gen);
+    const std::string common_header = pystring::os::path::basename(gen.args.output);
+    l("#pragma once\n");
+    l("/* {} shader code for {} (machine generated, don't edit!) */\n", Slang::to_str(slang), common_header);
+    l("#include \"{}\"\n", common_header);
+    gen_stb_impl_start(slang_gen);
+    Generator::gen_shader_arrays(slang_gen);
+    for (const auto& prog: gen.refl.progs) {
+        gen_shader_desc_func(slang_gen, prog);
+    }
+    for (const auto& item: gen.inp.programs) {
+        if (!item.second.features.empty()) {
+            gen_shader_desc_variant_func(slang_gen, item.second);
+        }
+    }
+    gen_stb_impl_end(slang_gen);
+    if (embed_error.valid()) {
+        return embed_error;
+    }
+    const std::string path = Args::split_backend_path(gen.args.output, slang);
+    if (!write_output_file(gen, path, content.data(), content.size(), false)) {
+        return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", path));
+    }
+    return ErrMsg();
+}
+
 ErrMsg SokolCGenerator::begin(const GenInput& gen) {
     if (!gen.inp.module.empty()) {
         mod_prefix = fmt::format("{}_", gen.inp.module);
@@ -63,9 +122,19 @@ void SokolCGenerator::gen_prerequisites(const GenInput& gen) {
     l("#define SOKOL_SHDC_ALIGN(a) __attribute__((aligned(a)))\n");
     l("#endif\n");
     l("#endif\n");
+    if (gen.args.aligned_sbufs) {
+        l("#if !defined(SOKOL_SHDC_STATIC_ASSERT)\n");
+        l("#if defined(__cplusplus)\n");
+        l("#define SOKOL_SHDC_STATIC_ASSERT(c,m) static_assert(c,m)\n");
+        l("#else\n");
+        l("#define SOKOL_SHDC_STATIC_ASSERT(c,m) _Static_assert(c,m)\n");
+        l("#endif\n");
+        l("#endif\n");
+    }
     if (gen.args.output_format == Format::SOKOL_IMPL) {
         for (const auto& item: gen.inp.programs) {
             const Program& prog = item.second;
+            // with --split-backends, implemented in the backend files
             l("const sg_shader_desc* {}{}_shader_desc(sg_backend backend);\n", mod_prefix, prog.name);
             if (gen.args.reflection) {
                 l("int {}{}_attr_slot(const char* attr_name);\n", mod_prefix, prog.name);
@@ -77,6 +146,28 @@ void SokolCGenerator::gen_prerequisites(const GenInput& gen) {
                 l("int {}{}_uniform_offset(sg_shader_stage stage, const char* ub_name, const char* u_name);\n", mod_prefix, prog.name);
                 l("sg_shader_uniform_desc {}{}_uniform_desc(sg_shader_stage stage, const char* ub_name, const char* u_name);\n", mod_prefix, prog.name);
             }
+            if (!prog.features.empty()) {
+                l("const sg_shader_desc* {}{}_shader_desc_variant(sg_backend backend, uint32_t mask);\n", mod_prefix, prog.name);
+            }
+            if (!prog.is_compute() && !gen.inp.snippets[gen.inp.snippet_map.at(prog.vs_name)].vertex_format_tags.empty()) {
+                l("sg_vertex_layout_state {}{}_vertex_layout(void);\n", mod_prefix, prog.name);
+            }
+        }
+    }
+    if (gen.args.embed) {
+        gen_embed_macros(gen);
+    }
+    if (gen.args.compression == Compression::LZ4) {
+        gen_lz4_decompress_func(gen);
+    }
+    if (gen.args.reflection) {
+        gen_name_hash_func(gen);
+    }
+    // @permutation feature bits for the shader_desc_variant() functions
+    for (const auto& item: gen.inp.programs) {
+        const Program& prog = item.second;
+        for (int i = 0; i < (int)prog.features.size(); i++) {
+            l("#define VARIANT_{}{}_{} ({})\n", mod_prefix, prog.name, prog.features[i], 1 << i);
         }
     }
 }
@@ -106,6 +197,10 @@ void SokolCGenerator::gen_uniform_block_decl(const GenInput &gen, const UniformB
                     case Type::Float2:  l("float {}[2];\n", uniform.name); break;
                     case Type::Float3:  l("float {}[3];\n", uniform.name); break;
                     case Type::Float4:  l("float {}[4];\n", uniform.name); break;
+                    case Type::Half:    l("uint16_t {};\n", uniform.name); break;
+                    case Type::Half2:   l("uint16_t {}[2];\n", uniform.name); break;
+                    case Type::Half3:   l("uint16_t {}[3];\n", uniform.name); break;
+                    case Type::Half4:   l("uint16_t {}[4];\n", uniform.name); break;
                     case Type::Int:     l("int {};\n", uniform.name); break;
                     case Type::Int2:    l("int {}[2];\n", uniform.name); break;
                     case Type::Int3:    l("int {}[3];\n", uniform.name); break;
@@ -183,6 +278,10 @@ void SokolCGenerator::gen_struct_interior_decl_std430(const GenInput& gen, const
                     case Type::Float2:  l("float {}[2];\n", item.name); break;
                     case Type::Float3:  l("float {}[3];\n", item.name); break;
                     case Type::Float4:  l("float {}[4];\n", item.name); break;
+                    case Type::Half:    l("uint16_t {};\n", item.name); break;
+                    case Type::Half2:   l("uint16_t {}[2];\n", item.name); break;
+                    case Type::Half3:   l("uint16_t {}[3];\n", item.name); break;
+                    case Type::Half4:   l("uint16_t {}[4];\n", item.name); break;
                     case Type::Mat2x1:  l("float {}[2];\n", item.name); break;
                     case Type::Mat2x2:  l("float {}[4];\n", item.name); break;
                     case Type::Mat2x3:  l("float {}[6];\n", item.name); break;
@@ -216,6 +315,10 @@ void SokolCGenerator::gen_struct_interior_decl_std430(const GenInput& gen, const
                     case Type::Float2:  l("float {}[{}][2];\n", item.name, item.array_count); break;
                     case Type::Float3:  l("float {}[{}][3];\n", item.name, item.array_count); break;
                     case Type::Float4:  l("float {}[{}][4];\n", item.name, item.array_count); break;
+                    case Type::Half:    l("uint16_t {}[{}];\n", item.name, item.array_count); break;
+                    case Type::Half2:   l("uint16_t {}[{}][2];\n", item.name, item.array_count); break;
+                    case Type::Half3:   l("uint16_t {}[{}][3];\n", item.name, item.array_count); break;
+                    case Type::Half4:   l("uint16_t {}[{}][4];\n", item.name, item.array_count); break;
                     case Type::Mat2x1:  l("float {}[{}][2];\n", item.name, item.array_count); break;
                     case Type::Mat2x2:  l("float {}[{}][4];\n", item.name, item.array_count); break;
                     case Type::Mat2x3:  l("float {}[{}][6];\n", item.name, item.array_count); break;
@@ -239,9 +342,105 @@ void SokolCGenerator::gen_struct_interior_decl_std430(const GenInput& gen, const
     }
 }
 
+// component type of a std430 struct item in aligned storage buffer structs
+static const char* std430_scalar_ctype(Type::Enum type) {
+    switch (type) {
+        // NOTE: bool => int is not a bug!
+        case Type::Bool: case Type::Bool2: case Type::Bool3: case Type::Bool4:
+        case Type::Int: case Type::Int2: case Type::Int3: case Type::Int4:
+            return "int32_t";
+        case Type::UInt: case Type::UInt2: case Type::UInt3: case Type::UInt4:
+            return "uint32_t";
+        case Type::Half: case Type::Half2: case Type::Half3: case Type::Half4:
+            return "uint16_t";
+        default:
+            return "float";
+    }
+}
+
+static int std430_scalar_size(Type::Enum type) {
+    switch (type) {
+        case Type::Half: case Type::Half2: case Type::Half3: case Type::Half4:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+// with --aligned-sbufs: items are placed at their natural std430 alignment instead
+// of byte-packing, vector and matrix items are written as arrays of their components
+// which cover the reflected size (or array stride), and get an explicit alignment
+// when the std430 alignment is bigger than the component size
+void SokolCGenerator::gen_struct_interior_decl_std430_aligned(const GenInput& gen, const Type& struc, int pad_to_size) {
+    assert(struc.type == Type::Struct);
+    assert(pad_to_size > 0);
+
+    int cur_offset = 0;
+    for (const Type& item: struc.struct_items) {
+        int next_offset = item.offset;
+        if (next_offset > cur_offset) {
+            l("uint8_t _pad_{}[{}];\n", cur_offset, next_offset - cur_offset);
+            cur_offset = next_offset;
+        }
+        const std::string array_suffix = (item.array_count > 0) ? fmt::format("[{}]", item.array_count) : "";
+        // NOTE: unbounded arrays are written as regular items
+        const int elem_size = (item.array_count > 0) ? item.array_stride : item.size;
+        if (item.type == Type::Struct) {
+            // recurse into nested struct, padded to the multiple of its alignment
+            l_open("struct {{\n");
+            gen_struct_interior_decl_std430_aligned(gen, item, roundup(elem_size, item.align));
+            l_close("}} {}{};\n", item.name, array_suffix);
+            cur_offset += (item.array_count > 0) ? (item.array_count * item.array_stride) : roundup(item.size, item.align);
+            continue;
+        }
+        const int scalar_size = std430_scalar_size(item.type);
+        const std::string align_prefix = (item.align > scalar_size) ? fmt::format("SOKOL_SHDC_ALIGN({}) ", item.align) : "";
+        if (gen.inp.ctype_map.count(item.type_as_glsl()) > 0) {
+            // user-mapped typename, the size is checked by the layout asserts
+            l("{}{} {}{};\n", align_prefix, gen.inp.ctype_map.at(item.type_as_glsl()), item.name, array_suffix);
+        } else {
+            const int num_components = elem_size / scalar_size;
+            if (num_components == 1) {
+                l("{}{} {}{};\n", align_prefix, std430_scalar_ctype(item.type), item.name, array_suffix);
+            } else {
+                l("{}{} {}{}[{}];\n", align_prefix, std430_scalar_ctype(item.type), item.name, array_suffix, num_components);
+            }
+        }
+        cur_offset += item.size;
+    }
+    if (cur_offset < pad_to_size) {
+        l("uint8_t _pad_{}[{}];\n", cur_offset, pad_to_size - cur_offset);
+    }
+}
+
+// check the host struct layout against the reflected std430 layout
+void SokolCGenerator::gen_struct_layout_asserts(const std::string& type_name, const Type& struc, const std::string& path, int base_offset) {
+    for (const Type& item: struc.struct_items) {
+        const std::string item_path = path + item.name;
+        const int offset = base_offset + item.offset;
+        l("SOKOL_SHDC_STATIC_ASSERT(offsetof({}, {}) == {}, \"{}.{} offset mismatch\");\n", type_name, item_path, offset, type_name, item_path);
+        if (item.array_count > 0) {
+            l("SOKOL_SHDC_STATIC_ASSERT(sizeof((({}*)0)->{}[0]) == {}, \"{}.{} array stride mismatch\");\n",
+                type_name, item_path, item.array_stride, type_name, item_path);
+        }
+        if (item.type == Type::Struct) {
+            gen_struct_layout_asserts(type_name, item, item_path + ((item.array_count > 0) ? "[0]." : "."), offset);
+        }
+    }
+}
+
 void SokolCGenerator::gen_storage_buffer_decl(const GenInput& gen, const StorageBuffer& sbuf) {
-    l("#pragma pack(push,1)\n");
     const auto& item = sbuf.struct_info.struct_items[0];
+    if (gen.args.aligned_sbufs) {
+        const std::string name = struct_name(item.struct_typename);
+        l_open("SOKOL_SHDC_ALIGN({}) typedef struct {} {{\n", sbuf.struct_info.align, name);
+        gen_struct_interior_decl_std430_aligned(gen, item, sbuf.struct_info.size);
+        l_close("}} {};\n", name);
+        l("SOKOL_SHDC_STATIC_ASSERT(sizeof({}) == {}, \"{} size mismatch\");\n", name, sbuf.struct_info.size, name);
+        gen_struct_layout_asserts(name, item, "", 0);
+        return;
+    }
+    l("#pragma pack(push,1)\n");
     l_open("SOKOL_SHDC_ALIGN({}) typedef struct {} {{\n", sbuf.struct_info.align, struct_name(item.struct_typename));
     gen_struct_interior_decl_std430(gen, item, sbuf.struct_info.size);
     l_close("}} {};\n", struct_name(item.struct_typename));
@@ -257,127 +456,239 @@ void SokolCGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramRef
                 l("#if defined({})\n", sokol_define(slang));
             }
             l_open("if (backend == {}) {{\n", backend(slang));
+            if (gen.args.const_desc) {
+                // C++ doesn't allow nested and array designators, so C++ falls back
+                // to filling the desc on first call
+                l("#if !defined(__cplusplus)\n");
+                l_open("static const sg_shader_desc desc = {{\n");
+                gen_shader_desc_items(gen, prog, slang, true);
+                l_close("}};\n");
+                l("#else\n");
+            }
             l("static sg_shader_desc desc;\n");
             l("static bool valid;\n");
             l_open("if (!valid) {{\n");
             l("valid = true;\n");
-            for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
-                const StageAttr& attr = prog.vs().inputs[attr_index];
-                if (attr.slot >= 0) {
-                    if (Slang::is_glsl(slang)) {
-                        l("desc.attrs[{}].name = \"{}\";\n", attr_index, attr.name);
-                    } else if (Slang::is_hlsl(slang)) {
-                        l("desc.attrs[{}].sem_name = \"{}\";\n", attr_index, attr.sem_name);
-                        l("desc.attrs[{}].sem_index = {};\n", attr_index, attr.sem_index);
-                    }
-                }
+            gen_shader_desc_items(gen, prog, slang, false);
+            l_close("}}\n");
+            if (gen.args.const_desc) {
+                l("#endif\n");
             }
-            for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
-                const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
-                const StageReflection& refl = prog.stages[stage_index];
-                const std::string dsn = fmt::format("desc.{}", pystring::lower(refl.stage_name));
-                if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = {};\n", dsn, info.bytecode_array_name);
-                    l("{}.bytecode.size = {};\n", dsn, info.bytecode_array_size);
-                } else {
-                    l("{}.source = (const char*){};\n", dsn, info.source_array_name);
-                    const char* d3d11_tgt = nullptr;
-                    if (slang == Slang::HLSL4) {
-                        d3d11_tgt = (0 == stage_index) ? "vs_4_0" : "ps_4_0";
-                    } else if (slang == Slang::HLSL5) {
-                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : "ps_5_0";
-                    }
-                    if (d3d11_tgt) {
-                        l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
-                    }
-                }
-                l("{}.entry = \"{}\";\n", dsn, refl.entry_point_by_slang(slang));
-                for (int ub_index = 0; ub_index < UniformBlock::Num; ub_index++) {
-                    const UniformBlock* ub = refl.bindings.find_uniform_block_by_slot(ub_index);
-                    if (ub) {
-                        const std::string ubn = fmt::format("{}.uniform_blocks[{}]", dsn, ub_index);
-                        l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
-                        l("{}.layout = SG_UNIFORMLAYOUT_STD140;\n", ubn);
-                        if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
-                            if (ub->flattened) {
-                                l("{}.uniforms[0].name = \"{}\";\n", ubn, ub->struct_info.name);
-                                // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
-                                l("{}.uniforms[0].type = {};\n", ubn, flattened_uniform_type(ub->struct_info.struct_items[0].type));
-                                l("{}.uniforms[0].array_count = {};\n", ubn, roundup(ub->struct_info.size, 16) / 16);
-                            } else {
-                                for (int u_index = 0; u_index < (int)ub->struct_info.struct_items.size(); u_index++) {
-                                    const Type& u = ub->struct_info.struct_items[u_index];
-                                    const std::string un = fmt::format("{}.uniforms[{}]", ubn, u_index);
-                                    l("{}.name = \"{}.{}\";\n", un, ub->inst_name, u.name);
-                                    l("{}.type = {};\n", un, uniform_type(u.type));
-                                    l("{}.array_count = {};\n", un, u.array_count);
-                                }
-                            }
+            l("return &desc;\n");
+            l_close("}}\n");
+            if (gen.args.ifdef) {
+                l("#endif /* {} */\n", sokol_define(slang));
+            }
+        }
+    }
+    l("return 0;\n");
+    l_close("}}\n");
+}
+
+// the shader desc fields of one backend, either as assignments, or with
+// init_list as a C99 designated initializer (e.g. '.vs.entry = "main",')
+void SokolCGenerator::gen_shader_desc_items(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang, bool init_list) {
+    const char* dp = init_list ? "" : "desc";
+    const char* de = init_list ? "," : ";";
+    for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
+        const StageAttr& attr = prog.vs().inputs[attr_index];
+        if (attr.slot >= 0) {
+            if (Slang::is_glsl(slang)) {
+                l("{}.attrs[{}].name = \"{}\"{}\n", dp, attr_index, attr.name, de);
+            } else if (Slang::is_hlsl(slang)) {
+                l("{}.attrs[{}].sem_name = \"{}\"{}\n", dp, attr_index, attr.sem_name, de);
+                l("{}.attrs[{}].sem_index = {}{}\n", dp, attr_index, attr.sem_index, de);
+            }
+        }
+    }
+    for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+        if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+            continue;
+        }
+        const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
+        const StageReflection& refl = prog.stages[stage_index];
+        const std::string dsn = fmt::format("{}.{}", dp, pystring::lower(refl.stage_name));
+        if (info.has_bytecode) {
+            l("{}.bytecode.ptr = {}{}\n", dsn, shader_array_ref(gen, info.bytecode_array_name), de);
+            l("{}.bytecode.size = {}{}\n", dsn, info.bytecode_array_size, de);
+        } else {
+            l("{}.source = (const char*){}{}\n", dsn, shader_array_ref(gen, info.source_array_name), de);
+            const char* d3d11_tgt = nullptr;
+            if (slang == Slang::HLSL4) {
+                d3d11_tgt = (0 == stage_index) ? "vs_4_0" : "ps_4_0";
+            } else if (slang == Slang::HLSL5) {
+                d3d11_tgt = (0 == stage_index) ? "vs_5_0" : (1 == stage_index) ? "ps_5_0" : "cs_5_0";
+            }
+            if (d3d11_tgt) {
+                l("{}.d3d11_target = \"{}\"{}\n", dsn, d3d11_tgt, de);
+            }
+        }
+        l("{}.entry = \"{}\"{}\n", dsn, refl.entry_point_by_slang(slang), de);
+        if (Slang::is_msl(slang) && ShaderStage::is_cs(refl.stage)) {
+            l("{}.mtl_threads_per_threadgroup.x = {}{}\n", dp, refl.workgroup_size[0], de);
+            l("{}.mtl_threads_per_threadgroup.y = {}{}\n", dp, refl.workgroup_size[1], de);
+            l("{}.mtl_threads_per_threadgroup.z = {}{}\n", dp, refl.workgroup_size[2], de);
+        }
+        for (int ub_index = 0; ub_index < UniformBlock::Num; ub_index++) {
+            const UniformBlock* ub = refl.bindings.find_uniform_block_by_slot(ub_index);
+            if (ub) {
+                const std::string ubn = fmt::format("{}.uniform_blocks[{}]", dsn, ub_index);
+                l("{}.size = {}{}\n", ubn, roundup(ub->struct_info.size, 16), de);
+                l("{}.layout = SG_UNIFORMLAYOUT_STD140{}\n", ubn, de);
+                if (Slang::is_glsl(slang) && !uses_glsl_uniform_buffers(gen, refl, slang) && (ub->struct_info.struct_items.size() > 0)) {
+                    if (ub->flattened) {
+                        l("{}.uniforms[0].name = \"{}\"{}\n", ubn, ub->struct_info.name, de);
+                        // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
+                        l("{}.uniforms[0].type = {}{}\n", ubn, flattened_uniform_type(ub->struct_info.struct_items[0].type), de);
+                        l("{}.uniforms[0].array_count = {}{}\n", ubn, roundup(ub->struct_info.size, 16) / 16, de);
+                    } else {
+                        for (int u_index = 0; u_index < (int)ub->struct_info.struct_items.size(); u_index++) {
+                            const Type& u = ub->struct_info.struct_items[u_index];
+                            const std::string un = fmt::format("{}.uniforms[{}]", ubn, u_index);
+                            l("{}.name = \"{}.{}\"{}\n", un, ub->inst_name, u.name, de);
+                            l("{}.type = {}{}\n", un, uniform_type(u.type), de);
+                            l("{}.array_count = {}{}\n", un, u.array_count, de);
                         }
                     }
                 }
-                for (int sbuf_index = 0; sbuf_index < StorageBuffer::Num; sbuf_index++) {
-                    const StorageBuffer* sbuf = refl.bindings.find_storage_buffer_by_slot(sbuf_index);
-                    if (sbuf) {
-                        const std::string& sbn = fmt::format("{}.storage_buffers[{}]", dsn, sbuf_index);
-                        l("{}.used = true;\n", sbn);
-                        l("{}.readonly = {};\n", sbn, sbuf->readonly);
-                    }
-                }
-                for (int img_index = 0; img_index < Image::Num; img_index++) {
-                    const Image* img = refl.bindings.find_image_by_slot(img_index);
-                    if (img) {
-                        const std::string in = fmt::format("{}.images[{}]", dsn, img_index);
-                        l("{}.used = true;\n", in);
-                        l("{}.multisampled = {};\n", in, img->multisampled ? "true" : "false");
-                        l("{}.image_type = {};\n", in, image_type(img->type));
-                        l("{}.sample_type = {};\n", in, image_sample_type(img->sample_type));
-                    }
-                }
-                for (int smp_index = 0; smp_index < Sampler::Num; smp_index++) {
-                    const Sampler* smp = refl.bindings.find_sampler_by_slot(smp_index);
-                    if (smp) {
-                        const std::string sn = fmt::format("{}.samplers[{}]", dsn, smp_index);
-                        l("{}.used = true;\n", sn);
-                        l("{}.sampler_type = {};\n", sn, sampler_type(smp->type));
-                    }
-                }
-                for (int img_smp_index = 0; img_smp_index < ImageSampler::Num; img_smp_index++) {
-                    const ImageSampler* img_smp = refl.bindings.find_image_sampler_by_slot(img_smp_index);
-                    if (img_smp) {
-                        const std::string isn = fmt::format("{}.image_sampler_pairs[{}]", dsn, img_smp_index);
-                        l("{}.used = true;\n", isn);
-                        l("{}.image_slot = {};\n", isn, refl.bindings.find_image_by_name(img_smp->image_name)->slot);
-                        l("{}.sampler_slot = {};\n", isn, refl.bindings.find_sampler_by_name(img_smp->sampler_name)->slot);
-                        if (Slang::is_glsl(slang)) {
-                            l("{}.glsl_name = \"{}\";\n", isn, img_smp->name);
-                        }
-                    }
+            }
+        }
+        for (int sbuf_index = 0; sbuf_index < StorageBuffer::Num; sbuf_index++) {
+            const StorageBuffer* sbuf = refl.bindings.find_storage_buffer_by_slot(sbuf_index);
+            if (sbuf) {
+                const std::string& sbn = fmt::format("{}.storage_buffers[{}]", dsn, sbuf_index);
+                l("{}.used = true{}\n", sbn, de);
+                l("{}.readonly = {}{}\n", sbn, sbuf->readonly, de);
+            }
+        }
+        for (int img_index = 0; img_index < Image::Num; img_index++) {
+            const Image* img = refl.bindings.find_image_by_slot(img_index);
+            if (img) {
+                const std::string in = fmt::format("{}.images[{}]", dsn, img_index);
+                l("{}.used = true{}\n", in, de);
+                l("{}.multisampled = {}{}\n", in, img->multisampled ? "true" : "false", de);
+                l("{}.image_type = {}{}\n", in, image_type(img->type), de);
+                l("{}.sample_type = {}{}\n", in, image_sample_type(img->sample_type), de);
+            }
+        }
+        for (int smp_index = 0; smp_index < Sampler::Num; smp_index++) {
+            const Sampler* smp = refl.bindings.find_sampler_by_slot(smp_index);
+            if (smp) {
+                const std::string sn = fmt::format("{}.samplers[{}]", dsn, smp_index);
+                l("{}.used = true{}\n", sn, de);
+                l("{}.sampler_type = {}{}\n", sn, sampler_type(smp->type), de);
+            }
+        }
+        for (int img_smp_index = 0; img_smp_index < ImageSampler::Num; img_smp_index++) {
+            const ImageSampler* img_smp = refl.bindings.find_image_sampler_by_slot(img_smp_index);
+            if (img_smp) {
+                const std::string isn = fmt::format("{}.image_sampler_pairs[{}]", dsn, img_smp_index);
+                l("{}.used = true{}\n", isn, de);
+                l("{}.image_slot = {}{}\n", isn, refl.bindings.find_image_by_name(img_smp->image_name)->slot, de);
+                l("{}.sampler_slot = {}{}\n", isn, refl.bindings.find_sampler_by_name(img_smp->sampler_name)->slot, de);
+                if (Slang::is_glsl(slang)) {
+                    l("{}.glsl_name = \"{}\"{}\n", isn, img_smp->name, de);
                 }
             }
-            l("desc.label = \"{}{}_shader\";\n", mod_prefix, prog.name);
-            l_close("}}\n");
-            l("return &desc;\n");
+        }
+    }
+    l("{}.label = \"{}{}_shader\"{}\n", dp, mod_prefix, prog.name, de);
+}
+
+void SokolCGenerator::gen_shader_arrays(const GenInput& gen) {
+    // with --split-backends, the shader arrays are written to the backend files
+    if (!gen.args.split_backends) {
+        Generator::gen_shader_arrays(gen);
+    }
+}
+
+void SokolCGenerator::gen_shader_desc_funcs(const GenInput& gen) {
+    if (!gen.args.split_backends) {
+        Generator::gen_shader_desc_funcs(gen);
+        return;
+    }
+    // the shader desc functions (and the variant functions which call them) are
+    // written to the backend files, only the vertex layout functions are shared
+    for (const auto& prog: gen.refl.progs) {
+        if (prog.has_vertex_layout()) {
+            gen_vertex_layout_func(gen, prog);
+        }
+    }
+}
+
+void SokolCGenerator::gen_shader_desc_variant_func(const GenInput& gen, const Program& prog) {
+    l_open("{}const sg_shader_desc* {}{}_shader_desc_variant(sg_backend backend, uint32_t mask) {{\n", func_prefix, mod_prefix, prog.name);
+    l_open("static const sg_shader_desc* (*funcs[{}])(sg_backend) = {{\n", prog.variants.size());
+    for (const std::string& variant: prog.variants) {
+        l("{}{}_shader_desc,\n", mod_prefix, variant);
+    }
+    l_close("}};\n");
+    l("return (mask < {}) ? funcs[mask](backend) : 0;\n", prog.variants.size());
+    l_close("}}\n");
+}
+
+// a switch over the runtime-hashed name with one verifying strcmp() per name,
+// gen_match() is called with the names index to generate the code for a match
+void SokolCGenerator::gen_name_switch(const std::string& var_name, const std::vector<std::string>& names, const std::function<void(int)>& gen_match) {
+    if (names.empty()) {
+        return;
+    }
+    l_open("switch (_sokol_shdc_hash({})) {{\n", var_name);
+    for (const NameHashCase& c: name_hash_cases(names)) {
+        l_open("case 0x{:08X}u:\n", c.hash);
+        for (int item: c.items) {
+            l_open("if (0 == strcmp({}, \"{}\")) {{\n", var_name, names[item]);
+            gen_match(item);
             l_close("}}\n");
-            if (gen.args.ifdef) {
-                l("#endif /* {} */\n", sokol_define(slang));
+        }
+        l("break;\n");
+        l_close();
+    }
+    l("default: break;\n");
+    l_close("}}\n");
+}
+
+// vertex attributes without @vertex_format tag use the format matching their
+// type, strides and offsets are left to sokol-gfx (tightly packed)
+void SokolCGenerator::gen_vertex_layout_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("{}sg_vertex_layout_state {}{}_vertex_layout(void) {{\n", func_prefix, mod_prefix, prog.name);
+    l("#if defined(__cplusplus)\n");
+    l("sg_vertex_layout_state layout = {{}};\n");
+    l("#else\n");
+    l("sg_vertex_layout_state layout = {{0}};\n");
+    l("#endif\n");
+    std::set<int> instanced_buffers;
+    for (const StageAttr& attr: prog.vs().inputs) {
+        if (attr.slot >= 0) {
+            const VertexFormat::Enum vfmt = (attr.format != VertexFormat::INVALID) ? attr.format : VertexFormat::from_type(attr.type_info.type);
+            l("layout.attrs[{}].format = SG_VERTEXFORMAT_{};\n", vertex_attr_name(attr), pystring::upper(VertexFormat::to_str(vfmt)));
+            if (attr.buffer_index != 0) {
+                l("layout.attrs[{}].buffer_index = {};\n", vertex_attr_name(attr), attr.buffer_index);
+            }
+            if (attr.per_instance) {
+                instanced_buffers.insert(attr.buffer_index);
             }
         }
     }
-    l("return 0;\n");
+    for (int buffer_index: instanced_buffers) {
+        l("layout.buffers[{}].step_func = SG_VERTEXSTEP_PER_INSTANCE;\n", buffer_index);
+    }
+    l("return layout;\n");
     l_close("}}\n");
 }
 
 void SokolCGenerator::gen_attr_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_attr_slot(const char* attr_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)attr_name;\n");
+    std::vector<std::string> names;
+    std::vector<int> slots;
     for (const StageAttr& attr: prog.vs().inputs) {
         if (attr.slot >= 0) {
-            l_open("if (0 == strcmp(attr_name, \"{}\")) {{\n", attr.name);
-            l("return {};\n", attr.slot);
-            l_close("}}\n");
+            names.push_back(attr.name);
+            slots.push_back(attr.slot);
         }
     }
+    gen_name_switch("attr_name", names, [&](int i) { l("return {};\n", slots[i]); });
     l("return -1;\n");
     l_close("}}\n");
 }
@@ -388,13 +699,15 @@ void SokolCGenerator::gen_image_slot_refl_func(const GenInput& gen, const Progra
     for (const StageReflection& refl: prog.stages) {
         if (!refl.bindings.images.empty()) {
             l_open("if (SG_SHADERSTAGE_{} == stage) {{\n", pystring::upper(refl.stage_name));
+            std::vector<std::string> names;
+            std::vector<int> slots;
             for (const Image& img: refl.bindings.images) {
                 if (img.slot >= 0) {
-                    l_open("if (0 == strcmp(img_name, \"{}\")) {{\n", img.name);
-                    l("return {};\n", img.slot);
-                    l_close("}}\n");
+                    names.push_back(img.name);
+                    slots.push_back(img.slot);
                 }
             }
+            gen_name_switch("img_name", names, [&](int i) { l("return {};\n", slots[i]); });
             l_close("}}\n");
         }
     }
@@ -408,13 +721,15 @@ void SokolCGenerator::gen_sampler_slot_refl_func(const GenInput& gen, const Prog
     for (const StageReflection& refl: prog.stages) {
         if (!refl.bindings.samplers.empty()) {
             l_open("if (SG_SHADERSTAGE_{} == stage) {{\n", pystring::upper(refl.stage_name));
+            std::vector<std::string> names;
+            std::vector<int> slots;
             for (const Sampler& smp: refl.bindings.samplers) {
                 if (smp.slot >= 0) {
-                    l_open("if (0 == strcmp(smp_name, \"{}\")) {{\n", smp.name);
-                    l("return {};\n", smp.slot);
-                    l_close("}}\n");
+                    names.push_back(smp.name);
+                    slots.push_back(smp.slot);
                 }
             }
+            gen_name_switch("smp_name", names, [&](int i) { l("return {};\n", slots[i]); });
             l_close("}}\n");
         }
     }
@@ -422,19 +737,36 @@ void SokolCGenerator::gen_sampler_slot_refl_func(const GenInput& gen, const Prog
     l_close("}}\n");
 }
 
+// the uniform blocks with a valid bind slot, and their struct names
+static std::vector<const UniformBlock*> valid_uniform_blocks(const StageReflection& refl, std::vector<std::string>& out_names) {
+    std::vector<const UniformBlock*> res;
+    out_names.clear();
+    for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
+        if (ub.slot >= 0) {
+            res.push_back(&ub);
+            out_names.push_back(ub.struct_info.name);
+        }
+    }
+    return res;
+}
+
+static std::vector<std::string> uniform_names(const UniformBlock& ub) {
+    std::vector<std::string> res;
+    for (const Type& u: ub.struct_info.struct_items) {
+        res.push_back(u.name);
+    }
+    return res;
+}
+
 void SokolCGenerator::gen_uniform_block_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_uniformblock_slot(sg_shader_stage stage, const char* ub_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)stage; (void)ub_name;\n");
     for (const StageReflection& refl: prog.stages) {
         if (!refl.bindings.uniform_blocks.empty()) {
             l_open("if (SG_SHADERSTAGE_{} == stage) {{\n", pystring::upper(refl.stage_name));
-            for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
-                if (ub.slot >= 0) {
-                    l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.struct_info.name);
-                    l("return {};\n", ub.slot);
-                    l_close("}}\n");
-                }
-            }
+            std::vector<std::string> names;
+            const std::vector<const UniformBlock*> ubs = valid_uniform_blocks(refl, names);
+            gen_name_switch("ub_name", names, [&](int i) { l("return {};\n", ubs[i]->slot); });
             l_close("}}\n");
         }
     }
@@ -448,13 +780,9 @@ void SokolCGenerator::gen_uniform_block_size_refl_func(const GenInput& gen, cons
     for (const StageReflection& refl: prog.stages) {
         if (!refl.bindings.uniform_blocks.empty()) {
             l_open("if (SG_SHADERSTAGE_{} == stage) {{\n", pystring::upper(refl.stage_name));
-            for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
-                if (ub.slot >= 0) {
-                    l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.struct_info.name);
-                    l("return sizeof({});\n", struct_name(ub.struct_info.name));
-                    l_close("}}\n");
-                }
-            }
+            std::vector<std::string> names;
+            const std::vector<const UniformBlock*> ubs = valid_uniform_blocks(refl, names);
+            gen_name_switch("ub_name", names, [&](int i) { l("return sizeof({});\n", struct_name(ubs[i]->struct_info.name)); });
             l_close("}}\n");
         }
     }
@@ -468,13 +796,15 @@ void SokolCGenerator::gen_storage_buffer_slot_refl_func(const GenInput& gen, con
     for (const StageReflection& refl: prog.stages) {
         if (!refl.bindings.storage_buffers.empty()) {
             l_open("if (SG_SHADERSTAGE_{} == stage) {{\n", pystring::upper(refl.stage_name));
+            std::vector<std::string> names;
+            std::vector<int> slots;
             for (const StorageBuffer& sbuf: refl.bindings.storage_buffers) {
                 if (sbuf.slot >= 0) {
-                    l_open("if (0 == strcmp(sbuf_name, \"{}\")) {{\n", sbuf.struct_info.name);
-                    l("return {};\n", sbuf.slot);
-                    l_close("}}\n");
+                    names.push_back(sbuf.struct_info.name);
+                    slots.push_back(sbuf.slot);
                 }
             }
+            gen_name_switch("sbuf_name", names, [&](int i) { l("return {};\n", slots[i]); });
             l_close("}}\n");
         }
     }
@@ -488,17 +818,14 @@ void SokolCGenerator::gen_uniform_offset_refl_func(const GenInput& gen, const Pr
     for (const StageReflection& refl: prog.stages) {
         if (!refl.bindings.uniform_blocks.empty()) {
             l_open("if (SG_SHADERSTAGE_{} == stage) {{\n", pystring::upper(refl.stage_name));
-            for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
-                if (ub.slot >= 0) {
-                    l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.struct_info.name);
-                    for (const Type& u: ub.struct_info.struct_items) {
-                        l_open("if (0 == strcmp(u_name, \"{}\")) {{\n", u.name);
-                        l("return {};\n", u.offset);
-                        l_close("}}\n");
-                    }
-                    l_close("}}\n");
-                }
-            }
+            std::vector<std::string> names;
+            const std::vector<const UniformBlock*> ubs = valid_uniform_blocks(refl, names);
+            gen_name_switch("ub_name", names, [&](int i) {
+                const UniformBlock& ub = *ubs[i];
+                gen_name_switch("u_name", uniform_names(ub), [&](int u_index) {
+                    l("return {};\n", ub.struct_info.struct_items[u_index].offset);
+                });
+            });
             l_close("}}\n");
         }
     }
@@ -517,20 +844,18 @@ void SokolCGenerator::gen_uniform_desc_refl_func(const GenInput& gen, const Prog
     for (const StageReflection& refl: prog.stages) {
         if (!refl.bindings.uniform_blocks.empty()) {
             l_open("if (SG_SHADERSTAGE_{} == stage) {{\n", pystring::upper(refl.stage_name));
-            for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
-                if (ub.slot >= 0) {
-                    l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.struct_info.name);
-                    for (const Type& u: ub.struct_info.struct_items) {
-                        l_open("if (0 == strcmp(u_name, \"{}\")) {{\n", u.name);
-                        l("desc.name = \"{}\";\n", u.name);
-                        l("desc.type = {};\n", uniform_type(u.type));
-                        l("desc.array_count = {};\n", u.array_count);
-                        l("return desc;\n");
-                        l_close("}}\n");
-                    }
-                    l_close("}}\n");
-                }
-            }
+            std::vector<std::string> names;
+            const std::vector<const UniformBlock*> ubs = valid_uniform_blocks(refl, names);
+            gen_name_switch("ub_name", names, [&](int i) {
+                const UniformBlock& ub = *ubs[i];
+                gen_name_switch("u_name", uniform_names(ub), [&](int u_index) {
+                    const Type& u = ub.struct_info.struct_items[u_index];
+                    l("desc.name = \"{}\";\n", u.name);
+                    l("desc.type = {};\n", uniform_type(u.type));
+                    l("desc.array_count = {};\n", u.array_count);
+                    l("return desc;\n");
+                });
+            });
             l_close("}}\n");
         }
     }
@@ -538,6 +863,145 @@ void SokolCGenerator::gen_uniform_desc_refl_func(const GenInput& gen, const Prog
     l_close("}}\n");
 }
 
+// with --compress, shader arrays are stored compressed, and are inflated on first use
+// by a function next to the array, this means only the active backend's shaders are
+// ever decompressed (shader desc functions are also only initialized on first use)
+void SokolCGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* data, size_t num_bytes, Slang::Enum slang) {
+    if (gen.args.compression == Compression::NONE) {
+        Generator::gen_shader_array(gen, array_name, data, num_bytes, slang);
+        return;
+    }
+    const std::vector<uint8_t> packed = Compress::lz4(data, num_bytes);
+    const std::string packed_name = fmt::format("{}_{}", array_name, Compression::to_str(gen.args.compression));
+    Generator::gen_shader_array(gen, packed_name, packed.data(), packed.size(), slang);
+    if (gen.args.ifdef) {
+        l("#if defined({})\n", sokol_define(slang));
+    }
+    l_open("static inline const uint8_t* {}_inflate(void) {{\n", array_name);
+    l("static uint8_t buf[{}];\n", num_bytes);
+    l("static bool inflated;\n");
+    l_open("if (!inflated) {{\n");
+    l("inflated = true;\n");
+    l("SOKOL_SHDC_DECOMPRESS(buf, {}, {}, {});\n", num_bytes, packed_name, packed.size());
+    l_close("}}\n");
+    l("return buf;\n");
+    l_close("}}\n");
+    if (gen.args.ifdef) {
+        l("#endif\n");
+    }
+}
+
+// with --embed, use C23 #embed if supported by the compiler, otherwise fall
+// back to an .incbin assembler stub (GCC and Clang only)
+void SokolCGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    if (gen.args.ifdef) {
+        l("#if defined({})\n", sokol_define(slang));
+    }
+    l("#if defined(SOKOL_SHDC_HAS_EMBED)\n");
+    l("static const uint8_t {}[{}] = {{\n", array_name, num_bytes);
+    l("#embed \"{}\"\n", file_name);
+    l("}};\n");
+    l("#else\n");
+    // the weak .incbin symbol gets a prefix which is unique for the output file, so
+    // that the same array name in two different headers doesn't end up as the same
+    // symbol (the same header included in several compilation units still is)
+    const std::string sym = fmt::format("sokol_shdc_{:08x}_{}", name_hash(gen.args.reproducible_path(gen.args.output)), array_name);
+    l("SOKOL_SHDC_INCBIN({}, \"{}\");\n", sym, file_name);
+    l("extern const uint8_t {}[{}] __asm__(\"{}\");\n", array_name, num_bytes, sym);
+    l("#endif\n");
+    if (gen.args.ifdef) {
+        l("#endif\n");
+    }
+}
+
+// .incbin resolves paths relative to the compiler's working directory, so
+// the directory of the embedded files can be provided in SOKOL_SHDC_EMBED_DIR,
+// the symbols are weak because the header may be included in several
+// compilation units, the C declaration refers to the symbol via an asm label
+// (so no leading underscore on Apple platforms)
+void SokolCGenerator::gen_embed_macros(const GenInput& gen) {
+    l("#if !defined(SOKOL_SHDC_HAS_EMBED) && defined(__has_embed)\n");
+    l("#define SOKOL_SHDC_HAS_EMBED (1)\n");
+    l("#endif\n");
+    l("#if !defined(SOKOL_SHDC_HAS_EMBED) && !defined(SOKOL_SHDC_INCBIN)\n");
+    l("#if !defined(SOKOL_SHDC_EMBED_DIR)\n");
+    l("#define SOKOL_SHDC_EMBED_DIR \"\"\n");
+    l("#endif\n");
+    l("#if defined(__APPLE__)\n");
+    l("#define SOKOL_SHDC_INCBIN(sym, file) __asm__(\".const_data\\n.globl \" #sym \"\\n.weak_definition \" #sym \"\\n.p2align 4\\n\" #sym \":\\n.incbin \\\"\" SOKOL_SHDC_EMBED_DIR file \"\\\"\\n.text\\n\")\n");
+    l("#elif defined(__GNUC__)\n");
+    l("#define SOKOL_SHDC_INCBIN(sym, file) __asm__(\".pushsection .rodata\\n.weak \" #sym \"\\n.balign 16\\n\" #sym \":\\n.incbin \\\"\" SOKOL_SHDC_EMBED_DIR file \"\\\"\\n.popsection\\n\")\n");
+    l("#else\n");
+    l("#error \"sokol-shdc --embed requires a compiler with #embed support, or an .incbin fallback in SOKOL_SHDC_INCBIN(sym, file)\"\n");
+    l("#endif\n");
+    l("#endif\n");
+}
+
+// the C expression which evaluates to the (uncompressed) content of a shader array
+std::string SokolCGenerator::shader_array_ref(const GenInput& gen, const std::string& array_name) {
+    if (gen.args.compression == Compression::NONE) {
+        return array_name;
+    } else {
+        return fmt::format("{}_inflate()", array_name);
+    }
+}
+
+// the FNV-1a string hash used by the reflection functions, must match Generator::name_hash()
+void SokolCGenerator::gen_name_hash_func(const GenInput& gen) {
+    l("#if !defined(SOKOL_SHDC_HASH_INCLUDED)\n");
+    l("#define SOKOL_SHDC_HASH_INCLUDED\n");
+    l_open("static inline uint32_t _sokol_shdc_hash(const char* str) {{\n");
+    l("uint32_t hash = 0x811C9DC5u;\n");
+    l_open("while (*str) {{\n");
+    l("hash ^= (uint8_t)*str++;\n");
+    l("hash *= 0x01000193u;\n");
+    l_close("}}\n");
+    l("return hash;\n");
+    l_close("}}\n");
+    l("#endif\n");
+}
+
+// the default decompressor for --compress=lz4, may be replaced by defining
+// SOKOL_SHDC_DECOMPRESS(dst, dst_size, src, src_size) before including the header
+void SokolCGenerator::gen_lz4_decompress_func(const GenInput& gen) {
+    l("#if !defined(SOKOL_SHDC_DECOMPRESS)\n");
+    l("#define SOKOL_SHDC_DECOMPRESS(dst, dst_size, src, src_size) _sokol_shdc_lz4_decompress(dst, dst_size, src, src_size)\n");
+    l("#endif\n");
+    l("#if !defined(SOKOL_SHDC_LZ4_DECOMPRESS_INCLUDED)\n");
+    l("#define SOKOL_SHDC_LZ4_DECOMPRESS_INCLUDED\n");
+    l_open("static inline void _sokol_shdc_lz4_decompress(uint8_t* dst, size_t dst_size, const uint8_t* src, size_t src_size) {{\n");
+    l("const uint8_t* src_end = src + src_size;\n");
+    l("const uint8_t* dst_end = dst + dst_size;\n");
+    l_open("while ((src < src_end) && (dst < dst_end)) {{\n");
+    l("const uint8_t token = *src++;\n");
+    l("size_t len = token >> 4;\n");
+    l_open("if (len == 15) {{\n");
+    l("uint8_t b;\n");
+    l("do {{ b = *src++; len += b; }} while (b == 255);\n");
+    l_close("}}\n");
+    l_open("while (len-- > 0) {{\n");
+    l("*dst++ = *src++;\n");
+    l_close("}}\n");
+    l_open("if (src >= src_end) {{\n");
+    l("break;\n");
+    l_close("}}\n");
+    l("const size_t offset = (size_t)src[0] | ((size_t)src[1] << 8);\n");
+    l("src += 2;\n");
+    l("len = token & 15;\n");
+    l_open("if (len == 15) {{\n");
+    l("uint8_t b;\n");
+    l("do {{ b = *src++; len += b; }} while (b == 255);\n");
+    l_close("}}\n");
+    l("len += 4;\n");
+    l("const uint8_t* match = dst - offset;\n");
+    l_open("while (len-- > 0) {{\n");
+    l("*dst++ = *match++;\n");
+    l_close("}}\n");
+    l_close("}}\n");
+    l_close("}}\n");
+    l("#endif\n");
+}
+
 void SokolCGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
     if (gen.args.ifdef) {
         l("#if defined({})\n", sokol_define(slang));
@@ -603,6 +1067,12 @@ std::string SokolCGenerator::uniform_type(Type::Enum e) {
         case Type::Int3:   return "SG_UNIFORMTYPE_INT3";
         case Type::Int4:   return "SG_UNIFORMTYPE_INT4";
         case Type::Mat4x4: return "SG_UNIFORMTYPE_MAT4";
+        // there are no 16-bit uniform types, uniform blocks with 16-bit
+        // types are only supported on backends without uniform flattening
+        case Type::Half:
+        case Type::Half2:
+        case Type::Half3:
+        case Type::Half4:  return "SG_UNIFORMTYPE_INVALID";
         default: return "INVALID";
     }
 }
@@ -665,6 +1135,8 @@ std::string SokolCGenerator::backend(Slang::Enum e) {
         case Slang::HLSL4:
         case Slang::HLSL5:
             return "SG_BACKEND_D3D11";
+        case Slang::HLSL6:
+            return "SG_BACKEND_D3D12";
         case Slang::METAL_MACOS:
             return "SG_BACKEND_METAL_MACOS";
         case Slang::METAL_IOS:
@@ -673,6 +1145,8 @@ std::string SokolCGenerator::backend(Slang::Enum e) {
             return "SG_BACKEND_METAL_SIMULATOR";
         case Slang::WGSL:
             return "SG_BACKEND_WGPU";
+        case Slang::SPIRV:
+            return "SG_BACKEND_VULKAN";
         default:
             return "<INVALID>";
     }
@@ -702,6 +1176,18 @@ std::string SokolCGenerator::storage_buffer_bind_slot_name(const StorageBuffer&
     return fmt::format("SLOT_{}{}", mod_prefix, sbuf.struct_info.name);
 }
 
+std::string SokolCGenerator::spec_constant_name(const SpecConstant& spec) {
+    return fmt::format("SPEC_{}{}", mod_prefix, spec.name);
+}
+
+std::string SokolCGenerator::program_hash_name(const ProgramReflection& prog, Slang::Enum slang) {
+    return fmt::format("HASH_{}{}_{}", mod_prefix, prog.name, Slang::to_str(slang));
+}
+
+std::string SokolCGenerator::layout_class_name(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("{}_CLASS_{}{}", LayoutClass::to_str(cls), mod_prefix, prog.name);
+}
+
 std::string SokolCGenerator::vertex_attr_definition(const StageAttr& attr) {
     return fmt::format("#define {} ({})", vertex_attr_name(attr), attr.slot);
 }
@@ -722,4 +1208,16 @@ std::string SokolCGenerator::storage_buffer_bind_slot_definition(const StorageBu
     return fmt::format("#define {} ({})", storage_buffer_bind_slot_name(sbuf), sbuf.slot);
 }
 
+std::string SokolCGenerator::spec_constant_definition(const SpecConstant& spec) {
+    return fmt::format("#define {} ({})", spec_constant_name(spec), spec.id);
+}
+
+std::string SokolCGenerator::program_hash_definition(const ProgramReflection& prog, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("#define {} (0x{:016X}ull)", program_hash_name(prog, slang), hash);
+}
+
+std::string SokolCGenerator::layout_class_definition(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("#define {} (0x{:016X}ull)", layout_class_name(prog, cls), prog.layout_classes[cls]);
+}
+
 } // namespace
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include "generator.h"
 
 namespace shdc::gen {
@@ -6,6 +7,8 @@ namespace shdc::gen {
 class SokolCGenerator: public Generator {
     std::string mod_prefix;
     std::string func_prefix;
+public:
+    virtual ErrMsg generate(const GenInput& gen);
 protected:
     virtual ErrMsg begin(const GenInput& gen);
     virtual void gen_prolog(const GenInput& gen);
@@ -13,11 +16,17 @@ protected:
     virtual void gen_prerequisites(const GenInput& gen);
     virtual void gen_uniform_block_decl(const GenInput& gen, const refl::UniformBlock& ub);
     virtual void gen_storage_buffer_decl(const GenInput& gen, const refl::StorageBuffer& sbuf);
+    virtual void gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* data, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_array_end(const GenInput& gen);
+    virtual void gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang);
     virtual void gen_stb_impl_start(const GenInput& gen);
     virtual void gen_stb_impl_end(const GenInput& gen);
+    virtual void gen_shader_arrays(const GenInput& gen);
+    virtual void gen_shader_desc_funcs(const GenInput& gen);
     virtual void gen_shader_desc_func(const GenInput& gen, const refl::ProgramReflection& prog);
+    virtual void gen_vertex_layout_func(const GenInput& gen, const refl::ProgramReflection& prog);
+    virtual void gen_shader_desc_variant_func(const GenInput& gen, const Program& prog);
     virtual void gen_attr_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_image_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_sampler_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& progm);
@@ -45,13 +54,28 @@ protected:
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_name(const refl::StorageBuffer& sbuf);
+    virtual std::string spec_constant_name(const refl::SpecConstant& spec);
+    virtual std::string program_hash_name(const refl::ProgramReflection& prog, Slang::Enum slang);
+    virtual std::string layout_class_name(const refl::ProgramReflection& prog, refl::LayoutClass::Enum cls);
     virtual std::string vertex_attr_definition(const refl::StageAttr& attr);
     virtual std::string image_bind_slot_definition(const refl::Image& img);
     virtual std::string sampler_bind_slot_definition(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_definition(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_definition(const refl::StorageBuffer& sbuf);
+    virtual std::string spec_constant_definition(const refl::SpecConstant& spec);
+    virtual std::string program_hash_definition(const refl::ProgramReflection& prog, Slang::Enum slang, uint64_t hash);
+    virtual std::string layout_class_definition(const refl::ProgramReflection& prog, refl::LayoutClass::Enum cls);
 private:
+    ErrMsg gen_backend_file(const GenInput& gen, Slang::Enum slang);
+    void gen_shader_desc_items(const GenInput& gen, const refl::ProgramReflection& prog, Slang::Enum slang, bool init_list);
+    void gen_lz4_decompress_func(const GenInput& gen);
+    void gen_name_hash_func(const GenInput& gen);
+    void gen_name_switch(const std::string& var_name, const std::vector<std::string>& names, const std::function<void(int)>& gen_match);
+    void gen_embed_macros(const GenInput& gen);
+    std::string shader_array_ref(const GenInput& gen, const std::string& array_name);
     virtual void gen_struct_interior_decl_std430(const GenInput& gen, const refl::Type& struc, int pad_to_size);
+    void gen_struct_interior_decl_std430_aligned(const GenInput& gen, const refl::Type& struc, int pad_to_size);
+    void gen_struct_layout_asserts(const std::string& type_name, const refl::Type& struc, const std::string& path, int base_offset);
 };
 
 } // namespace
@@ -54,6 +54,10 @@ void SokolDGenerator::gen_uniform_block_decl(const GenInput& gen, const UniformB
                     case Type::Float2:  l("align({}) float[2] {} = 0;\n", align, uniform.name); break;
                     case Type::Float3:  l("align({}) float[3] {} = 0;\n", align, uniform.name); break;
                     case Type::Float4:  l("align({}) float[4] {} = 0;\n", align, uniform.name); break;
+                    case Type::Half:    l("align({}) ushort {} = 0;\n", align, uniform.name); break;
+                    case Type::Half2:   l("align({}) ushort[2] {} = 0;\n", align, uniform.name); break;
+                    case Type::Half3:   l("align({}) ushort[3] {} = 0;\n", align, uniform.name); break;
+                    case Type::Half4:   l("align({}) ushort[4] {} = 0;\n", align, uniform.name); break;
                     case Type::Int:     l("align({}) int {} = 0;\n", align, uniform.name); break;
                     case Type::Int2:    l("align({}) int[2] {} = 0;\n", align, uniform.name); break;
                     case Type::Int3:    l("align({}) int[3] {} = 0;\n", align, uniform.name); break;
@@ -131,6 +135,10 @@ void SokolDGenerator::gen_struct_interior_decl_std430(const GenInput& gen, const
                     case Type::Float2:  l("align({}) float[2] {} = 0;\n",  align, item.name); break;
                     case Type::Float3:  l("align({}) float[3] {} = 0;\n",  align, item.name); break;
                     case Type::Float4:  l("align({}) float[4] {} = 0;\n",  align, item.name); break;
+                    case Type::Half:    l("align({}) ushort {} = 0;\n",     align, item.name); break;
+                    case Type::Half2:   l("align({}) ushort[2] {} = 0;\n",  align, item.name); break;
+                    case Type::Half3:   l("align({}) ushort[3] {} = 0;\n",  align, item.name); break;
+                    case Type::Half4:   l("align({}) ushort[4] {} = 0;\n",  align, item.name); break;
                     case Type::Mat2x1:  l("align({}) float[2] {} = 0;\n",  align, item.name); break;
                     case Type::Mat2x2:  l("align({}) float[4] {} = 0;\n",  align, item.name); break;
                     case Type::Mat2x3:  l("align({}) float[6] {} = 0;\n",  align, item.name); break;
@@ -164,6 +172,10 @@ void SokolDGenerator::gen_struct_interior_decl_std430(const GenInput& gen, const
                     case Type::Float2:  l("align({}) float[2][{}] {} = 0;\n",  align, item.array_count, item.name); break;
                     case Type::Float3:  l("align({}) float[3][{}] {} = 0;\n",  align, item.array_count, item.name); break;
                     case Type::Float4:  l("align({}) float[4][{}] {} = 0;\n",  align, item.array_count, item.name); break;
+                    case Type::Half:    l("align({}) ushort[{}] {} = 0;\n",     align, item.array_count, item.name); break;
+                    case Type::Half2:   l("align({}) ushort[2][{}] {} = 0;\n",  align, item.array_count, item.name); break;
+                    case Type::Half3:   l("align({}) ushort[3][{}] {} = 0;\n",  align, item.array_count, item.name); break;
+                    case Type::Half4:   l("align({}) ushort[4][{}] {} = 0;\n",  align, item.array_count, item.name); break;
                     case Type::Mat2x1:  l("align({}) float[2][{}] {} = 0;\n",  align, item.array_count, item.name); break;
                     case Type::Mat2x2:  l("align({}) float[4][{}] {} = 0;\n",  align, item.array_count, item.name); break;
                     case Type::Mat2x3:  l("align({}) float[6][{}] {} = 0;\n",  align, item.array_count, item.name); break;
@@ -202,8 +214,19 @@ void SokolDGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n];\n");
 }
 
+// NOTE: import() needs the output directory in the string import paths (-J)
+void SokolDGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("__gshared char[{}] {} = import(\"{}\");\n", num_bytes, array_name, file_name);
+}
+
 void SokolDGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("sg.ShaderDesc {}ShaderDesc(sg.Backend backend) @trusted @nogc nothrow {{\n", prog.name);
+    // with --const-desc, the shader desc is built once per backend by a private
+    // init function and cached (see gen_const_shader_desc_func())
+    if (gen.args.const_desc) {
+        l_open("private sg.ShaderDesc {}ShaderDescInit(sg.Backend backend) @trusted @nogc nothrow {{\n", prog.name);
+    } else {
+        l_open("sg.ShaderDesc {}ShaderDesc(sg.Backend backend) @trusted @nogc nothrow {{\n", prog.name);
+    }
     l("sg.ShaderDesc desc;\n");
     l("desc.label = \"{}_shader\";\n", prog.name);
     l_open("switch (backend) {{\n");
@@ -223,6 +246,9 @@ void SokolDGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramRef
                 }
             }
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                    continue;
+                }
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 const StageReflection& refl = prog.stages[stage_index];
                 const std::string dsn = fmt::format("desc.{}", pystring::lower(refl.stage_name));
@@ -235,20 +261,25 @@ void SokolDGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramRef
                     if (slang == Slang::HLSL4) {
                         d3d11_tgt = (0 == stage_index) ? "vs_4_0" : "ps_4_0";
                     } else if (slang == Slang::HLSL5) {
-                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : "ps_5_0";
+                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : (1 == stage_index) ? "ps_5_0" : "cs_5_0";
                     }
                     if (d3d11_tgt) {
                         l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
                     }
                 }
                 l("{}.entry = \"{}\";\n", dsn, refl.entry_point_by_slang(slang));
+                if (Slang::is_msl(slang) && ShaderStage::is_cs(refl.stage)) {
+                    l("desc.mtl_threads_per_threadgroup.x = {};\n", refl.workgroup_size[0]);
+                    l("desc.mtl_threads_per_threadgroup.y = {};\n", refl.workgroup_size[1]);
+                    l("desc.mtl_threads_per_threadgroup.z = {};\n", refl.workgroup_size[2]);
+                }
                 for (int ub_index = 0; ub_index < UniformBlock::Num; ub_index++) {
                     const UniformBlock* ub = refl.bindings.find_uniform_block_by_slot(ub_index);
                     if (ub) {
                         const std::string ubn = fmt::format("{}.uniform_blocks[{}]", dsn, ub_index);
                         l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
                         l("{}.layout = sg.UniformLayout.Std140;\n", ubn);
-                        if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
+                        if (Slang::is_glsl(slang) && !uses_glsl_uniform_buffers(gen, refl, slang) && (ub->struct_info.struct_items.size() > 0)) {
                             if (ub->flattened) {
                                 l("{}.uniforms[0].name = \"{}\";\n", ubn, ub->struct_info.name);
                                 // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
@@ -313,6 +344,23 @@ void SokolDGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramRef
     l_close("}}\n"); // close switch statement
     l("return desc;\n");
     l_close("}}\n"); // close function
+    if (gen.args.const_desc) {
+        gen_const_shader_desc_func(gen, prog);
+    }
+}
+
+// the desc contains pointers to the __gshared shader arrays, which rules out
+// CTFE, instead it's built on the first call and then returned from the cache
+void SokolDGenerator::gen_const_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("sg.ShaderDesc {}ShaderDesc(sg.Backend backend) @trusted @nogc nothrow {{\n", prog.name);
+    l("__gshared sg.ShaderDesc[sg.Backend.max + 1] descs;\n");
+    l("__gshared bool[sg.Backend.max + 1] valid;\n");
+    l_open("if (!valid[backend]) {{\n");
+    l("descs[backend] = {}ShaderDescInit(backend);\n", prog.name);
+    l("valid[backend] = true;\n");
+    l_close("}}\n");
+    l("return descs[backend];\n");
+    l_close("}}\n");
 }
 
 std::string SokolDGenerator::lang_name() {
@@ -416,6 +464,8 @@ std::string SokolDGenerator::backend(Slang::Enum e) {
         case Slang::HLSL4:
         case Slang::HLSL5:
             return "sg.Backend.D3d11";
+        case Slang::HLSL6:
+            return "sg.Backend.D3d12";
         case Slang::METAL_MACOS:
             return "sg.Backend.Metal_macos";
         case Slang::METAL_IOS:
@@ -424,6 +474,8 @@ std::string SokolDGenerator::backend(Slang::Enum e) {
             return "sg.Backend.Metal_simulator";
         case Slang::WGSL:
             return "sg.Backend.Wgpu";
+        case Slang::SPIRV:
+            return "sg.Backend.Vulkan";
         default:
             return "INVALID";
     }
@@ -457,6 +509,18 @@ std::string SokolDGenerator::storage_buffer_bind_slot_name(const StorageBuffer&
     return slot_name(sbuf.struct_info.name);
 }
 
+std::string SokolDGenerator::spec_constant_name(const SpecConstant& spec) {
+    return pystring::upper(fmt::format("SPEC_{}", spec.name));
+}
+
+std::string SokolDGenerator::program_hash_name(const ProgramReflection& prog, Slang::Enum slang) {
+    return pystring::upper(fmt::format("HASH_{}_{}", prog.name, Slang::to_str(slang)));
+}
+
+std::string SokolDGenerator::layout_class_name(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return pystring::upper(fmt::format("{}_CLASS_{}", LayoutClass::to_str(cls), prog.name));
+}
+
 static std::string const_def(const std::string& name, int slot) {
     return fmt::format("enum {} = {};", name, slot);
 }
@@ -481,4 +545,16 @@ std::string SokolDGenerator::storage_buffer_bind_slot_definition(const StorageBu
     return const_def(storage_buffer_bind_slot_name(sbuf), sbuf.slot);
 }
 
+std::string SokolDGenerator::spec_constant_definition(const SpecConstant& spec) {
+    return const_def(spec_constant_name(spec), spec.id);
+}
+
+std::string SokolDGenerator::program_hash_definition(const ProgramReflection& prog, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("enum ulong {} = 0x{:016X}UL;", program_hash_name(prog, slang), hash);
+}
+
+std::string SokolDGenerator::layout_class_definition(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("enum ulong {} = 0x{:016X}UL;", layout_class_name(prog, cls), prog.layout_classes[cls]);
+}
+
 } // namespace
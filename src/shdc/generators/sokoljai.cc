@@ -49,6 +49,10 @@ void SokolJaiGenerator::gen_uniform_block_decl(const GenInput& gen, const Unifor
                     case Type::Float2:  l("{}: [2]float;\n", uniform.name); break;
                     case Type::Float3:  l("{}: [3]float;\n", uniform.name); break;
                     case Type::Float4:  l("{}: [4]float;\n", uniform.name); break;
+                    case Type::Half:    l("{}: u16;\n", uniform.name); break;
+                    case Type::Half2:   l("{}: [2]u16;\n", uniform.name); break;
+                    case Type::Half3:   l("{}: [3]u16;\n", uniform.name); break;
+                    case Type::Half4:   l("{}: [4]u16;\n", uniform.name); break;
                     case Type::Int:     l("{}: s32;\n", uniform.name); break;
                     case Type::Int2:    l("{}: [2]s32;\n", uniform.name); break;
                     case Type::Int3:    l("{}: [3]s32;\n", uniform.name); break;
@@ -123,6 +127,10 @@ void SokolJaiGenerator::gen_struct_interior_decl_std430(const GenInput& gen, con
                     case Type::Float2:  l("{}: [2]float;\n", item.name); break;
                     case Type::Float3:  l("{}: [3]float;\n", item.name); break;
                     case Type::Float4:  l("{}: [4]float;\n", item.name); break;
+                    case Type::Half:    l("{}: u16;\n", item.name); break;
+                    case Type::Half2:   l("{}: [2]u16;\n", item.name); break;
+                    case Type::Half3:   l("{}: [3]u16;\n", item.name); break;
+                    case Type::Half4:   l("{}: [4]u16;\n", item.name); break;
                     case Type::Mat2x1:  l("{}: [2]float;\n", item.name); break;
                     case Type::Mat2x2:  l("{}: [4]float;\n", item.name); break;
                     case Type::Mat2x3:  l("{}: [6]float;\n", item.name); break;
@@ -156,6 +164,10 @@ void SokolJaiGenerator::gen_struct_interior_decl_std430(const GenInput& gen, con
                     case Type::Float2:  l("{}: [{}][2]float;\n", item.name, item.array_count); break;
                     case Type::Float3:  l("{}: [{}][3]float;\n", item.name, item.array_count); break;
                     case Type::Float4:  l("{}: [{}][4]float;\n", item.name, item.array_count); break;
+                    case Type::Half:    l("{}: [{}]u16;\n", item.name, item.array_count); break;
+                    case Type::Half2:   l("{}: [{}][2]u16;\n", item.name, item.array_count); break;
+                    case Type::Half3:   l("{}: [{}][3]u16;\n", item.name, item.array_count); break;
+                    case Type::Half4:   l("{}: [{}][4]u16;\n", item.name, item.array_count); break;
                     case Type::Mat2x1:  l("{}: [{}][2]float;\n", item.name, item.array_count); break;
                     case Type::Mat2x2:  l("{}: [{}][4]float;\n", item.name, item.array_count); break;
                     case Type::Mat2x3:  l("{}: [{}][6]float;\n", item.name, item.array_count); break;
@@ -187,7 +199,13 @@ void SokolJaiGenerator::gen_storage_buffer_decl(const GenInput& gen, const Stora
 }
 
 void SokolJaiGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("{}_shader_desc :: (backend: sg_backend) -> sg_shader_desc {{\n", prog.name);
+    // with --const-desc, the shader desc is built once per backend by an init
+    // function and cached (see gen_const_shader_desc_func())
+    if (gen.args.const_desc) {
+        l_open("{}_shader_desc_init :: (backend: sg_backend) -> sg_shader_desc {{\n", prog.name);
+    } else {
+        l_open("{}_shader_desc :: (backend: sg_backend) -> sg_shader_desc {{\n", prog.name);
+    }
     l("desc: sg_shader_desc;\n");
     l("desc.label = \"{}_shader\";\n", prog.name);
     l("if backend == {{\n");
@@ -207,6 +225,9 @@ void SokolJaiGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                 }
             }
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                    continue;
+                }
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 const StageReflection& refl = prog.stages[stage_index];
                 const std::string dsn = fmt::format("desc.{}", pystring::lower(refl.stage_name));
@@ -219,20 +240,25 @@ void SokolJaiGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     if (slang == Slang::HLSL4) {
                         d3d11_tgt = (0 == stage_index) ? "vs_4_0" : "ps_4_0";
                     } else if (slang == Slang::HLSL5) {
-                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : "ps_5_0";
+                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : (1 == stage_index) ? "ps_5_0" : "cs_5_0";
                     }
                     if (d3d11_tgt) {
                         l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
                     }
                 }
                 l("{}.entry = \"{}\";\n", dsn, refl.entry_point_by_slang(slang));
+                if (Slang::is_msl(slang) && ShaderStage::is_cs(refl.stage)) {
+                    l("desc.mtl_threads_per_threadgroup.x = {};\n", refl.workgroup_size[0]);
+                    l("desc.mtl_threads_per_threadgroup.y = {};\n", refl.workgroup_size[1]);
+                    l("desc.mtl_threads_per_threadgroup.z = {};\n", refl.workgroup_size[2]);
+                }
                 for (int ub_index = 0; ub_index < UniformBlock::Num; ub_index++) {
                     const UniformBlock* ub = refl.bindings.find_uniform_block_by_slot(ub_index);
                     if (ub) {
                         const std::string ubn = fmt::format("{}.uniform_blocks[{}]", dsn, ub_index);
                         l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
                         l("{}.layout = .STD140;\n", ubn);
-                        if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
+                        if (Slang::is_glsl(slang) && !uses_glsl_uniform_buffers(gen, refl, slang) && (ub->struct_info.struct_items.size() > 0)) {
                             if (ub->flattened) {
                                 l("{}.uniforms[0].name = \"{}\";\n", ubn, ub->struct_info.name);
                                 // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
@@ -295,6 +321,31 @@ void SokolJaiGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
     l("}}\n"); // close switch statement
     l("return desc;\n");
     l_close("}}\n"); // close function
+    if (gen.args.const_desc) {
+        gen_const_shader_desc_func(gen, prog);
+    }
+}
+
+// the desc contains pointers to the shader arrays, so instead of #run it is
+// built on the first call and then returned from a cache with one item per backend
+void SokolJaiGenerator::gen_const_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
+    const std::vector<std::string> backends = unique_backends(gen);
+    l("{}_shader_desc_cache: [{}] sg_shader_desc;\n", prog.name, backends.size());
+    l("{}_shader_desc_valid: [{}] bool;\n", prog.name, backends.size());
+    l_open("{}_shader_desc :: (backend: sg_backend) -> sg_shader_desc {{\n", prog.name);
+    l("index := -1;\n");
+    l("if backend == {{\n");
+    for (int i = 0; i < (int)backends.size(); i++) {
+        l("case {}; index = {};\n", backends[i], i);
+    }
+    l("}}\n");
+    l("if index < 0 return .{{}};\n");
+    l_open("if !{}_shader_desc_valid[index] {{\n", prog.name);
+    l("{}_shader_desc_cache[index] = {}_shader_desc_init(backend);\n", prog.name, prog.name);
+    l("{}_shader_desc_valid[index] = true;\n", prog.name);
+    l_close("}}\n");
+    l("return {}_shader_desc_cache[index];\n", prog.name);
+    l_close("}}\n");
 }
 
 void SokolJaiGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -406,6 +457,8 @@ std::string SokolJaiGenerator::backend(Slang::Enum e) {
         case Slang::HLSL4:
         case Slang::HLSL5:
             return ".D3D11";
+        case Slang::HLSL6:
+            return ".D3D12";
         case Slang::METAL_MACOS:
             return ".METAL_MACOS";
         case Slang::METAL_IOS:
@@ -414,6 +467,8 @@ std::string SokolJaiGenerator::backend(Slang::Enum e) {
             return ".METAL_SIMULATOR";
         case Slang::WGSL:
             return ".WGPU";
+        case Slang::SPIRV:
+            return ".VULKAN";
         default:
             return "INVALID";
     }
@@ -443,6 +498,18 @@ std::string SokolJaiGenerator::storage_buffer_bind_slot_name(const StorageBuffer
     return fmt::format("SLOT_{}", sbuf.struct_info.name);
 }
 
+std::string SokolJaiGenerator::spec_constant_name(const SpecConstant& spec) {
+    return fmt::format("SPEC_{}", spec.name);
+}
+
+std::string SokolJaiGenerator::program_hash_name(const ProgramReflection& prog, Slang::Enum slang) {
+    return fmt::format("HASH_{}_{}", prog.name, Slang::to_str(slang));
+}
+
+std::string SokolJaiGenerator::layout_class_name(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("{}_CLASS_{}", LayoutClass::to_str(cls), prog.name);
+}
+
 std::string SokolJaiGenerator::vertex_attr_definition(const StageAttr& attr) {
     return fmt::format("{} :: {};", vertex_attr_name(attr), attr.slot);
 }
@@ -463,4 +530,16 @@ std::string SokolJaiGenerator::storage_buffer_bind_slot_definition(const Storage
     return fmt::format("{} :: {};", storage_buffer_bind_slot_name(sbuf), sbuf.slot);
 }
 
+std::string SokolJaiGenerator::spec_constant_definition(const SpecConstant& spec) {
+    return fmt::format("{} :: {};", spec_constant_name(spec), spec.id);
+}
+
+std::string SokolJaiGenerator::program_hash_definition(const ProgramReflection& prog, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("{} : u64 : 0x{:016X};", program_hash_name(prog, slang), hash);
+}
+
+std::string SokolJaiGenerator::layout_class_definition(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("{} : u64 : 0x{:016X};", layout_class_name(prog, cls), prog.layout_classes[cls]);
+}
+
 } // namespace
@@ -20,56 +20,37 @@ void SokolNimGenerator::gen_shader_arrays(const GenInput& gen) {
             const Bytecode& bytecode = gen.bytecode[slang];
             for (int snippet_index = 0; snippet_index < (int)gen.inp.snippets.size(); snippet_index++) {
                 const Snippet& snippet = gen.inp.snippets[snippet_index];
-                if ((snippet.type != Snippet::VS) && (snippet.type != Snippet::FS)) {
+                if (!Snippet::is_shader(snippet.type)) {
+                    continue;
+                }
+                if (is_shared_array(slang, snippet_index)) {
+                    // identical payload has already been written
                     continue;
                 }
                 const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(snippet_index);
                 assert(src);
                 const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(snippet_index);
-                std::vector<std::string> lines;
-                pystring::splitlines(src->source_code, lines);
-                // first write the source code in a comment block
-                cbl_start();
-                for (const std::string& line: lines) {
-                    cbl("{}\n", replace_C_comment_tokens(line));
+                // first write the source code in a comment block (skipped when minifying)
+                if (!gen.args.minify) {
+                    std::vector<std::string> lines;
+                    pystring::splitlines(src->source_code, lines);
+                    cbl_start();
+                    for (const std::string& line: lines) {
+                        cbl("{}\n", replace_C_comment_tokens(line));
+                    }
+                    cbl_end();
                 }
-                cbl_end();
                 if (blob) {
                     const std::string array_name = shader_bytecode_array_name(snippet.name, slang);
                     gen_shader_array_start(gen, array_name, blob->data.size(), slang);
-                    const size_t len = blob->data.size();
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        if (0 == i) {
-                            l("{:#04x}'u8,", blob->data[i]);
-                        } else {
-                            l("{:#04x},", blob->data[i]);
-                        }
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
+                    gen_hex_bytes(blob->data.data(), blob->data.size(), "'u8");
                     gen_shader_array_end(gen);
                 } else {
                     // if no bytecode exists, write the source code, but also a byte array with a trailing 0
                     const std::string array_name = shader_source_array_name(snippet.name, slang);
                     const size_t len = src->source_code.length() + 1;
                     gen_shader_array_start(gen, array_name, len, slang);
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        if (0 == i) {
-                            l("{:#04x}'u8,", (int)src->source_code[i]);
-                        } else {
-                            l("{:#04x},", (int)src->source_code[i]);
-                        }
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
+                    gen_hex_bytes((const uint8_t*)src->source_code.c_str(), len, "'u8");
                     gen_shader_array_end(gen);
                 }
             }
@@ -117,6 +98,10 @@ void SokolNimGenerator::gen_uniform_block_decl(const GenInput& gen, const Unifor
                     case Type::Float2:  l("{}*{}: array[2, float32]\n", uniform.name, align); break;
                     case Type::Float3:  l("{}*{}: array[3, float32]\n", uniform.name, align); break;
                     case Type::Float4:  l("{}*{}: array[4, float32]\n", uniform.name, align); break;
+                    case Type::Half:    l("{}*{}: uint16\n", uniform.name, align); break;
+                    case Type::Half2:   l("{}*{}: array[2, uint16]\n", uniform.name, align); break;
+                    case Type::Half3:   l("{}*{}: array[3, uint16]\n", uniform.name, align); break;
+                    case Type::Half4:   l("{}*{}: array[4, uint16]\n", uniform.name, align); break;
                     case Type::Int:     l("{}*{}: int32\n", uniform.name, align); break;
                     case Type::Int2:    l("{}*{}: array[2, int32]\n", uniform.name, align); break;
                     case Type::Int3:    l("{}*{}: array[3, int32]\n", uniform.name, align); break;
@@ -193,6 +178,10 @@ void SokolNimGenerator::gen_struct_interior_decl_std430(const GenInput& gen, con
                     case Type::Float2:  l("{}*{}: array[2, float32]\n",  item.name, align); break;
                     case Type::Float3:  l("{}*{}: array[3, float32]\n",  item.name, align); break;
                     case Type::Float4:  l("{}*{}: array[4, float32]\n",  item.name, align); break;
+                    case Type::Half:    l("{}*{}: uint16\n",            item.name, align); break;
+                    case Type::Half2:   l("{}*{}: array[2, uint16]\n",  item.name, align); break;
+                    case Type::Half3:   l("{}*{}: array[3, uint16]\n",  item.name, align); break;
+                    case Type::Half4:   l("{}*{}: array[4, uint16]\n",  item.name, align); break;
                     case Type::Mat2x1:  l("{}*{}: array[2, float32]\n",  item.name, align); break;
                     case Type::Mat2x2:  l("{}*{}: array[4, float32]\n",  item.name, align); break;
                     case Type::Mat2x3:  l("{}*{}: array[6, float32]\n",  item.name, align); break;
@@ -226,6 +215,10 @@ void SokolNimGenerator::gen_struct_interior_decl_std430(const GenInput& gen, con
                     case Type::Float2:  l("{}*{}: array[{}, array[2, float32]]\n",  item.name, align, item.array_count); break;
                     case Type::Float3:  l("{}*{}: array[{}, array[3, float32]]\n",  item.name, align, item.array_count); break;
                     case Type::Float4:  l("{}*{}: array[{}, array[4, float32]]\n",  item.name, align, item.array_count); break;
+                    case Type::Half:    l("{}*{}: array[{}, uint16]\n",            item.name, align, item.array_count); break;
+                    case Type::Half2:   l("{}*{}: array[{}, array[2, uint16]]\n",  item.name, align, item.array_count); break;
+                    case Type::Half3:   l("{}*{}: array[{}, array[3, uint16]]\n",  item.name, align, item.array_count); break;
+                    case Type::Half4:   l("{}*{}: array[{}, array[4, uint16]]\n",  item.name, align, item.array_count); break;
                     case Type::Mat2x1:  l("{}*{}: array[{}, array[2, float32]]\n",  item.name, align, item.array_count); break;
                     case Type::Mat2x2:  l("{}*{}: array[{}, array[4, float32]]\n",  item.name, align, item.array_count); break;
                     case Type::Mat2x3:  l("{}*{}: array[{}, array[6, float32]]\n",  item.name, align, item.array_count); break;
@@ -271,7 +264,13 @@ void SokolNimGenerator::gen_storage_buffer_decl(const GenInput& gen, const Stora
 }
 
 void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("proc {}ShaderDesc*(backend: sg.Backend): sg.ShaderDesc =\n", to_camel_case(prog.name));
+    // with --const-desc, the shader descs for all backends are built once by a
+    // private init proc at module initialization (see gen_const_shader_desc_func())
+    if (gen.args.const_desc) {
+        l_open("proc {}ShaderDescInit(backend: sg.Backend): sg.ShaderDesc =\n", to_camel_case(prog.name));
+    } else {
+        l_open("proc {}ShaderDesc*(backend: sg.Backend): sg.ShaderDesc =\n", to_camel_case(prog.name));
+    }
     l("result.label = \"{}_shader\"\n", prog.name);
     l_open("case backend:\n");
     for (int i = 0; i < Slang::Num; i++) {
@@ -290,6 +289,9 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                 }
             }
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                    continue;
+                }
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 const StageReflection& refl = prog.stages[stage_index];
                 const std::string dsn = fmt::format("result.{}", pystring::lower(refl.stage_name));
@@ -302,20 +304,25 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     if (slang == Slang::HLSL4) {
                         d3d11_tgt = (0 == stage_index) ? "vs_4_0" : "ps_4_0";
                     } else if (slang == Slang::HLSL5) {
-                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : "ps_5_0";
+                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : (1 == stage_index) ? "ps_5_0" : "cs_5_0";
                     }
                     if (d3d11_tgt) {
                         l("{}.d3d11Target = \"{}\"\n", dsn, d3d11_tgt);
                     }
                 }
                 l("{}.entry = \"{}\"\n", dsn, refl.entry_point_by_slang(slang));
+                if (Slang::is_msl(slang) && ShaderStage::is_cs(refl.stage)) {
+                    l("result.mtlThreadsPerThreadgroup.x = {}\n", refl.workgroup_size[0]);
+                    l("result.mtlThreadsPerThreadgroup.y = {}\n", refl.workgroup_size[1]);
+                    l("result.mtlThreadsPerThreadgroup.z = {}\n", refl.workgroup_size[2]);
+                }
                 for (int ub_index = 0; ub_index < UniformBlock::Num; ub_index++) {
                     const UniformBlock* ub = refl.bindings.find_uniform_block_by_slot(ub_index);
                     if (ub) {
                         const std::string ubn = fmt::format("{}.uniformBlocks[{}]", dsn, ub_index);
                         l("{}.size = {}\n", ubn, roundup(ub->struct_info.size, 16));
                         l("{}.layout = uniformLayoutStd140\n", ubn);
-                        if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
+                        if (Slang::is_glsl(slang) && !uses_glsl_uniform_buffers(gen, refl, slang) && (ub->struct_info.struct_items.size() > 0)) {
                             if (ub->flattened) {
                                 l("{}.uniforms[0].name = \"{}\"\n", ubn, ub->struct_info.name);
                                 // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
@@ -378,6 +385,25 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
     l("else: discard\n");
     l_close();
     l_close();
+    if (gen.args.const_desc) {
+        gen_const_shader_desc_func(gen, prog);
+    }
+}
+
+// Nim constants can't contain pointers, so the descs are an immutable
+// module-level value which is computed once at module initialization
+void SokolNimGenerator::gen_const_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
+    const std::string name = to_camel_case(prog.name);
+    l_open("let {}ShaderDescs = block:\n", name);
+    l("var descs: array[sg.Backend, sg.ShaderDesc]\n");
+    l_open("for backend in sg.Backend:\n");
+    l("descs[backend] = {}ShaderDescInit(backend)\n", name);
+    l_close();
+    l("descs\n");
+    l_close();
+    l_open("proc {}ShaderDesc*(backend: sg.Backend): sg.ShaderDesc =\n", name);
+    l("result = {}ShaderDescs[backend]\n", name);
+    l_close();
 }
 
 void SokolNimGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -489,6 +515,8 @@ std::string SokolNimGenerator::backend(Slang::Enum e) {
         case Slang::HLSL4:
         case Slang::HLSL5:
             return "backendD3d11";
+        case Slang::HLSL6:
+            return "backendD3d12";
         case Slang::METAL_MACOS:
             return "backendMetalMacos";
         case Slang::METAL_IOS:
@@ -497,6 +525,8 @@ std::string SokolNimGenerator::backend(Slang::Enum e) {
             return "backendMetalSimulator";
         case Slang::WGSL:
             return "backendWgpu";
+        case Slang::SPIRV:
+            return "backendVulkan";
         default:
             return "<INVALID>";
     }
@@ -526,6 +556,18 @@ std::string SokolNimGenerator::storage_buffer_bind_slot_name(const StorageBuffer
     return to_camel_case(fmt::format("SLOT_{}", sbuf.struct_info.name));
 }
 
+std::string SokolNimGenerator::spec_constant_name(const SpecConstant& spec) {
+    return to_camel_case(fmt::format("SPEC_{}", spec.name));
+}
+
+std::string SokolNimGenerator::program_hash_name(const ProgramReflection& prog, Slang::Enum slang) {
+    return to_camel_case(fmt::format("HASH_{}_{}", prog.name, Slang::to_str(slang)));
+}
+
+std::string SokolNimGenerator::layout_class_name(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return to_camel_case(fmt::format("{}_CLASS_{}", LayoutClass::to_str(cls), prog.name));
+}
+
 std::string SokolNimGenerator::vertex_attr_definition(const StageAttr& attr) {
     return fmt::format("const {}* = {}", vertex_attr_name(attr), attr.slot);
 }
@@ -546,4 +588,16 @@ std::string SokolNimGenerator::storage_buffer_bind_slot_definition(const Storage
     return fmt::format("const {}* = {}", storage_buffer_bind_slot_name(sbuf), sbuf.slot);
 }
 
+std::string SokolNimGenerator::spec_constant_definition(const SpecConstant& spec) {
+    return fmt::format("const {}* = {}", spec_constant_name(spec), spec.id);
+}
+
+std::string SokolNimGenerator::program_hash_definition(const ProgramReflection& prog, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("const {}* = 0x{:016X}'u64", program_hash_name(prog, slang), hash);
+}
+
+std::string SokolNimGenerator::layout_class_definition(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("const {}* = 0x{:016X}'u64", layout_class_name(prog, cls), prog.layout_classes[cls]);
+}
+
 } // namespace
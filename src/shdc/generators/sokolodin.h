@@ -13,6 +13,7 @@ protected:
     virtual void gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_array_end(const GenInput& gen);
     virtual void gen_shader_desc_func(const GenInput& gen, const refl::ProgramReflection& prog);
+    void gen_const_shader_desc_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual std::string lang_name();
     virtual std::string comment_block_start();
     virtual std::string comment_block_line_prefix();
@@ -32,11 +33,17 @@ protected:
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_name(const refl::StorageBuffer& sbuf);
+    virtual std::string spec_constant_name(const refl::SpecConstant& spec);
+    virtual std::string program_hash_name(const refl::ProgramReflection& prog, Slang::Enum slang);
+    virtual std::string layout_class_name(const refl::ProgramReflection& prog, refl::LayoutClass::Enum cls);
     virtual std::string vertex_attr_definition(const refl::StageAttr& attr);
     virtual std::string image_bind_slot_definition(const refl::Image& img);
     virtual std::string sampler_bind_slot_definition(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_definition(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_definition(const refl::StorageBuffer& sbuf);
+    virtual std::string spec_constant_definition(const refl::SpecConstant& spec);
+    virtual std::string program_hash_definition(const refl::ProgramReflection& prog, Slang::Enum slang, uint64_t hash);
+    virtual std::string layout_class_definition(const refl::ProgramReflection& prog, refl::LayoutClass::Enum cls);
 private:
     virtual void gen_struct_interior_decl_std430(const GenInput& gen, const refl::Type& struc, int pad_to_size);
 };
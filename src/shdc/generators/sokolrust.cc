@@ -51,6 +51,10 @@ void SokolRustGenerator::gen_uniform_block_decl(const GenInput& gen, const Unifo
                     case Type::Float2:  l("pub {}: [f32; 2],\n", uniform.name); break;
                     case Type::Float3:  l("pub {}: [f32; 3],\n", uniform.name); break;
                     case Type::Float4:  l("pub {}: [f32; 4],\n", uniform.name); break;
+                    case Type::Half:    l("pub {}: u16,\n", uniform.name); break;
+                    case Type::Half2:   l("pub {}: [u16; 2],\n", uniform.name); break;
+                    case Type::Half3:   l("pub {}: [u16; 3],\n", uniform.name); break;
+                    case Type::Half4:   l("pub {}: [u16; 4],\n", uniform.name); break;
                     case Type::Int:     l("pub {}: i32,\n", uniform.name); break;
                     case Type::Int2:    l("pub {}: [i32; 2],\n", uniform.name); break;
                     case Type::Int3:    l("pub {}: [i32; 3],\n", uniform.name); break;
@@ -124,6 +128,10 @@ void SokolRustGenerator::gen_struct_interior_decl_std430(const GenInput& gen, co
                     case Type::Float2:  l("pub {}: [f32; 2],\n", item.name); break;
                     case Type::Float3:  l("pub {}: [f32; 3],\n", item.name); break;
                     case Type::Float4:  l("pub {}: [f32; 4],\n", item.name); break;
+                    case Type::Half:    l("pub {}: u16,\n", item.name); break;
+                    case Type::Half2:   l("pub {}: [u16; 2],\n", item.name); break;
+                    case Type::Half3:   l("pub {}: [u16; 3],\n", item.name); break;
+                    case Type::Half4:   l("pub {}: [u16; 4],\n", item.name); break;
                     case Type::Mat2x1:  l("pub {}: [f32; 2],\n", item.name); break;
                     case Type::Mat2x2:  l("pub {}: [f32; 4],\n", item.name); break;
                     case Type::Mat2x3:  l("pub {}: [f32; 6],\n", item.name); break;
@@ -157,6 +165,10 @@ void SokolRustGenerator::gen_struct_interior_decl_std430(const GenInput& gen, co
                     case Type::Float2:  l("pub {}: [[f32; 2]; {}],\n", item.name, item.array_count); break;
                     case Type::Float3:  l("pub {}: [[f32; 3]; {}],\n", item.name, item.array_count); break;
                     case Type::Float4:  l("pub {}: [[f32; 4]; {}],\n", item.name, item.array_count); break;
+                    case Type::Half:    l("pub {}: [u16; {}],\n", item.name, item.array_count); break;
+                    case Type::Half2:   l("pub {}: [[u16; 2]; {}],\n", item.name, item.array_count); break;
+                    case Type::Half3:   l("pub {}: [[u16; 3]; {}],\n", item.name, item.array_count); break;
+                    case Type::Half4:   l("pub {}: [[u16; 4]; {}],\n", item.name, item.array_count); break;
                     case Type::Mat2x1:  l("pub {}: [[f32; 2]; {}],\n", item.name, item.array_count); break;
                     case Type::Mat2x2:  l("pub {}: [[f32; 4]; {}],\n", item.name, item.array_count); break;
                     case Type::Mat2x3:  l("pub {}: [[f32; 6]; {}],\n", item.name, item.array_count); break;
@@ -203,7 +215,13 @@ void SokolRustGenerator::gen_storage_buffer_decl(const GenInput& gen, const Stor
 }
 
 void SokolRustGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("pub fn {}_shader_desc(backend: sg::Backend) -> sg::ShaderDesc {{\n", prog.name);
+    // with --const-desc, the shader desc is built by a private const fn which
+    // is evaluated at compile time for each backend (see gen_const_shader_desc_func())
+    if (gen.args.const_desc) {
+        l_open("const fn {}_shader_desc_init(backend: sg::Backend) -> sg::ShaderDesc {{\n", prog.name);
+    } else {
+        l_open("pub fn {}_shader_desc(backend: sg::Backend) -> sg::ShaderDesc {{\n", prog.name);
+    }
     l("let mut desc = sg::ShaderDesc::new();\n");
     l("desc.label = c\"{}_shader\".as_ptr();\n", prog.name);
     l_open("match backend {{\n");
@@ -223,6 +241,9 @@ void SokolRustGenerator::gen_shader_desc_func(const GenInput& gen, const Program
                 }
             }
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                    continue;
+                }
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 const StageReflection& refl = prog.stages[stage_index];
                 const std::string dsn = fmt::format("desc.{}", pystring::lower(refl.stage_name));
@@ -235,20 +256,25 @@ void SokolRustGenerator::gen_shader_desc_func(const GenInput& gen, const Program
                     if (slang == Slang::HLSL4) {
                         d3d11_tgt = (0 == stage_index) ? "vs_4_0" : "ps_4_0";
                     } else if (slang == Slang::HLSL5) {
-                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : "ps_5_0";
+                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : (1 == stage_index) ? "ps_5_0" : "cs_5_0";
                     }
                     if (d3d11_tgt) {
                         l("{}.d3d11_target = c\"{}\".as_ptr();\n", dsn, d3d11_tgt);
                     }
                 }
                 l("{}.entry = c\"{}\".as_ptr();\n", dsn, refl.entry_point_by_slang(slang));
+                if (Slang::is_msl(slang) && ShaderStage::is_cs(refl.stage)) {
+                    l("desc.mtl_threads_per_threadgroup.x = {};\n", refl.workgroup_size[0]);
+                    l("desc.mtl_threads_per_threadgroup.y = {};\n", refl.workgroup_size[1]);
+                    l("desc.mtl_threads_per_threadgroup.z = {};\n", refl.workgroup_size[2]);
+                }
                 for (int ub_index = 0; ub_index < UniformBlock::Num; ub_index++) {
                     const UniformBlock* ub = refl.bindings.find_uniform_block_by_slot(ub_index);
                     if (ub) {
                         const std::string ubn = fmt::format("{}.uniform_blocks[{}]", dsn, ub_index);
                         l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
                         l("{}.layout = sg::UniformLayout::Std140;\n", ubn);
-                        if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
+                        if (Slang::is_glsl(slang) && !uses_glsl_uniform_buffers(gen, refl, slang) && (ub->struct_info.struct_items.size() > 0)) {
                             if (ub->flattened) {
                                 l("{}.uniforms[0].name = c\"{}\".as_ptr();\n", ubn, ub->struct_info.name);
                                 // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
@@ -312,6 +338,23 @@ void SokolRustGenerator::gen_shader_desc_func(const GenInput& gen, const Program
     l_close("}}\n"); // close switch statement
     l("desc\n");
     l_close("}}\n"); // close function
+    if (gen.args.const_desc) {
+        gen_const_shader_desc_func(gen, prog);
+    }
+}
+
+void SokolRustGenerator::gen_const_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("pub fn {}_shader_desc(backend: sg::Backend) -> sg::ShaderDesc {{\n", prog.name);
+    l_open("match backend {{\n");
+    for (const std::string& be: unique_backends(gen)) {
+        l_open("{} => {{\n", be);
+        l("const DESC: sg::ShaderDesc = {}_shader_desc_init({});\n", prog.name, be);
+        l("DESC\n");
+        l_close("}},\n");
+    }
+    l("_ => sg::ShaderDesc::new(),\n");
+    l_close("}}\n");
+    l_close("}}\n");
 }
 
 void SokolRustGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -322,6 +365,10 @@ void SokolRustGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n];\n");
 }
 
+void SokolRustGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("pub const {}: [u8; {}] = *include_bytes!(\"{}\");\n", array_name, num_bytes, file_name);
+}
+
 std::string SokolRustGenerator::lang_name() {
     return "Rust";
 }
@@ -423,6 +470,8 @@ std::string SokolRustGenerator::backend(Slang::Enum e) {
         case Slang::HLSL4:
         case Slang::HLSL5:
             return "sg::Backend::D3d11";
+        case Slang::HLSL6:
+            return "sg::Backend::D3d12";
         case Slang::METAL_MACOS:
             return "sg::Backend::MetalMacos";
         case Slang::METAL_IOS:
@@ -431,6 +480,8 @@ std::string SokolRustGenerator::backend(Slang::Enum e) {
             return "sg::Backend::MetalSimulator";
         case Slang::WGSL:
             return "sg::Backend::Wgpu";
+        case Slang::SPIRV:
+            return "sg::Backend::Vulkan";
         default:
             return "INVALID";
     }
@@ -460,6 +511,18 @@ std::string SokolRustGenerator::storage_buffer_bind_slot_name(const StorageBuffe
     return pystring::upper(fmt::format("SLOT_{}", sbuf.struct_info.name));
 }
 
+std::string SokolRustGenerator::spec_constant_name(const SpecConstant& spec) {
+    return pystring::upper(fmt::format("SPEC_{}", spec.name));
+}
+
+std::string SokolRustGenerator::program_hash_name(const ProgramReflection& prog, Slang::Enum slang) {
+    return pystring::upper(fmt::format("HASH_{}_{}", prog.name, Slang::to_str(slang)));
+}
+
+std::string SokolRustGenerator::layout_class_name(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return pystring::upper(fmt::format("{}_CLASS_{}", LayoutClass::to_str(cls), prog.name));
+}
+
 std::string SokolRustGenerator::vertex_attr_definition(const StageAttr& attr) {
     return fmt::format("pub const {}: usize = {};", vertex_attr_name(attr), attr.slot);
 }
@@ -480,4 +543,16 @@ std::string SokolRustGenerator::storage_buffer_bind_slot_definition(const Storag
     return fmt::format("pub const {}: usize = {};", storage_buffer_bind_slot_name(sbuf), sbuf.slot);
 }
 
+std::string SokolRustGenerator::spec_constant_definition(const SpecConstant& spec) {
+    return fmt::format("pub const {}: u32 = {};", spec_constant_name(spec), spec.id);
+}
+
+std::string SokolRustGenerator::program_hash_definition(const ProgramReflection& prog, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("pub const {}: u64 = 0x{:016X};", program_hash_name(prog, slang), hash);
+}
+
+std::string SokolRustGenerator::layout_class_definition(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("pub const {}: u64 = 0x{:016X};", layout_class_name(prog, cls), prog.layout_classes[cls]);
+}
+
 } // namespace
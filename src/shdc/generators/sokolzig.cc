@@ -5,6 +5,7 @@
 #include "fmt/format.h"
 #include "pystring.h"
 #include <stdio.h>
+#include <set>
 
 namespace shdc::gen {
 
@@ -50,6 +51,10 @@ void SokolZigGenerator::gen_uniform_block_decl(const GenInput& gen, const Unifor
                     case Type::Float2:  l("{}: [2]f32", uniform.name); break;
                     case Type::Float3:  l("{}: [3]f32", uniform.name); break;
                     case Type::Float4:  l("{}: [4]f32", uniform.name); break;
+                    case Type::Half:    l("{}: f16", uniform.name); break;
+                    case Type::Half2:   l("{}: [2]f16", uniform.name); break;
+                    case Type::Half3:   l("{}: [3]f16", uniform.name); break;
+                    case Type::Half4:   l("{}: [4]f16", uniform.name); break;
                     case Type::Int:     l("{}: i32", uniform.name); break;
                     case Type::Int2:    l("{}: [2]i32", uniform.name); break;
                     case Type::Int3:    l("{}: [3]i32", uniform.name); break;
@@ -131,6 +136,10 @@ void SokolZigGenerator::gen_struct_interior_decl_std430(const GenInput& gen, con
                     case Type::Float2:  l("{}: [2]f32", item.name); break;
                     case Type::Float3:  l("{}: [3]f32", item.name); break;
                     case Type::Float4:  l("{}: [4]f32", item.name); break;
+                    case Type::Half:    l("{}: f16", item.name); break;
+                    case Type::Half2:   l("{}: [2]f16", item.name); break;
+                    case Type::Half3:   l("{}: [3]f16", item.name); break;
+                    case Type::Half4:   l("{}: [4]f16", item.name); break;
                     case Type::Mat2x1:  l("{}: [2]f32", item.name); break;
                     case Type::Mat2x2:  l("{}: [4]f32", item.name); break;
                     case Type::Mat2x3:  l("{}: [6]f32", item.name); break;
@@ -164,6 +173,10 @@ void SokolZigGenerator::gen_struct_interior_decl_std430(const GenInput& gen, con
                     case Type::Float2:  l("{}: [{}][2]f32", item.name, item.array_count); break;
                     case Type::Float3:  l("{}: [{}][3]f32", item.name, item.array_count); break;
                     case Type::Float4:  l("{}: [{}][4]f32", item.name, item.array_count); break;
+                    case Type::Half:    l("{}: [{}]f16", item.name, item.array_count); break;
+                    case Type::Half2:   l("{}: [{}][2]f16", item.name, item.array_count); break;
+                    case Type::Half3:   l("{}: [{}][3]f16", item.name, item.array_count); break;
+                    case Type::Half4:   l("{}: [{}][4]f16", item.name, item.array_count); break;
                     case Type::Mat2x1:  l("{}: [{}][2]f32", item.name, item.array_count); break;
                     case Type::Mat2x2:  l("{}: [{}][4]f32", item.name, item.array_count); break;
                     case Type::Mat2x3:  l("{}: [{}][6]f32", item.name, item.array_count); break;
@@ -193,15 +206,122 @@ void SokolZigGenerator::gen_struct_interior_decl_std430(const GenInput& gen, con
     }
 }
 
+// component type of a std430 struct item in aligned storage buffer structs
+static const char* std430_scalar_type(Type::Enum type) {
+    switch (type) {
+        // NOTE: bool => int is not a bug!
+        case Type::Bool: case Type::Bool2: case Type::Bool3: case Type::Bool4:
+        case Type::Int: case Type::Int2: case Type::Int3: case Type::Int4:
+            return "i32";
+        case Type::UInt: case Type::UInt2: case Type::UInt3: case Type::UInt4:
+            return "u32";
+        case Type::Half: case Type::Half2: case Type::Half3: case Type::Half4:
+            return "f16";
+        default:
+            return "f32";
+    }
+}
+
+static int std430_scalar_size(Type::Enum type) {
+    switch (type) {
+        case Type::Half: case Type::Half2: case Type::Half3: case Type::Half4:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+// with --aligned-sbufs: fields are placed at their natural std430 alignment instead
+// of align(1), see SokolCGenerator::gen_struct_interior_decl_std430_aligned()
+void SokolZigGenerator::gen_struct_interior_decl_std430_aligned(const GenInput& gen, const Type& struc, int pad_to_size) {
+    assert(struc.type == Type::Struct);
+    assert(pad_to_size > 0);
+
+    int cur_offset = 0;
+    for (const Type& item: struc.struct_items) {
+        int next_offset = item.offset;
+        if (next_offset > cur_offset) {
+            l("_pad_{}: [{}]u8 = undefined,\n", cur_offset, next_offset - cur_offset);
+            cur_offset = next_offset;
+        }
+        const std::string array_prefix = (item.array_count > 0) ? fmt::format("[{}]", item.array_count) : "";
+        // NOTE: unbounded arrays are written as regular items
+        const int elem_size = (item.array_count > 0) ? item.array_stride : item.size;
+        if (item.type == Type::Struct) {
+            // recurse into nested struct, padded to the multiple of its alignment
+            l_open("{}: {}extern struct {{\n", item.name, array_prefix);
+            gen_struct_interior_decl_std430_aligned(gen, item, roundup(elem_size, item.align));
+            l_close("}},\n");
+            cur_offset += (item.array_count > 0) ? (item.array_count * item.array_stride) : roundup(item.size, item.align);
+            continue;
+        }
+        const int scalar_size = std430_scalar_size(item.type);
+        if (gen.inp.ctype_map.count(item.type_as_glsl()) > 0) {
+            // user-provided type names, the size is checked by the comptime layout checks
+            l("{}: {}{}", item.name, array_prefix, gen.inp.ctype_map.at(item.type_as_glsl()));
+        } else {
+            const int num_components = elem_size / scalar_size;
+            if (num_components == 1) {
+                l("{}: {}{}", item.name, array_prefix, std430_scalar_type(item.type));
+            } else {
+                l("{}: {}[{}]{}", item.name, array_prefix, num_components, std430_scalar_type(item.type));
+            }
+        }
+        if (item.align > scalar_size) {
+            l_append(" align({}),\n", item.align);
+        } else {
+            l_append(",\n");
+        }
+        cur_offset += item.size;
+    }
+    if (cur_offset < pad_to_size) {
+        l("_pad_{}: [{}]u8 = undefined,\n", cur_offset, pad_to_size - cur_offset);
+    }
+}
+
+// check the host struct layout against the reflected std430 layout, offsets
+// of nested struct fields are relative to the nested struct
+void SokolZigGenerator::gen_struct_layout_checks(const std::string& type_name, const Type& struc, const std::string& path) {
+    const std::string container = path.empty() ? type_name : fmt::format("@TypeOf(@as({}, undefined).{})", type_name, path);
+    for (const Type& item: struc.struct_items) {
+        const std::string item_path = path.empty() ? item.name : fmt::format("{}.{}", path, item.name);
+        l("if (@offsetOf({}, \"{}\") != {}) @compileError(\"{}.{} offset mismatch\");\n", container, item.name, item.offset, type_name, item_path);
+        if (item.array_count > 0) {
+            l("if (@sizeOf(@TypeOf(@as({}, undefined).{}[0])) != {}) @compileError(\"{}.{} array stride mismatch\");\n",
+                type_name, item_path, item.array_stride, type_name, item_path);
+        }
+        if (item.type == Type::Struct) {
+            gen_struct_layout_checks(type_name, item, (item.array_count > 0) ? (item_path + "[0]") : item_path);
+        }
+    }
+}
+
 void SokolZigGenerator::gen_storage_buffer_decl(const GenInput& gen, const StorageBuffer& sbuf) {
     const auto& item = sbuf.struct_info.struct_items[0];
+    if (gen.args.aligned_sbufs) {
+        const std::string name = struct_name(item.struct_typename);
+        l_open("pub const {} = extern struct {{\n", name);
+        gen_struct_interior_decl_std430_aligned(gen, item, sbuf.struct_info.size);
+        l_close("}};\n");
+        l_open("comptime {{\n");
+        l("if (@sizeOf({}) != {}) @compileError(\"{} size mismatch\");\n", name, sbuf.struct_info.size, name);
+        gen_struct_layout_checks(name, item, "");
+        l_close("}}\n");
+        return;
+    }
     l_open("pub const {} = extern struct {{\n", struct_name(item.struct_typename));
     gen_struct_interior_decl_std430(gen, item, sbuf.struct_info.align, sbuf.struct_info.size);
     l_close("}};\n");
 }
 
 void SokolZigGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("pub fn {}ShaderDesc(backend: sg.Backend) sg.ShaderDesc {{\n", to_camel_case(prog.name));
+    // with --const-desc, the shader desc is built by a private init function
+    // which is evaluated at comptime for each backend (see gen_const_shader_desc_func())
+    if (gen.args.const_desc) {
+        l_open("fn {}ShaderDescInit(backend: sg.Backend) sg.ShaderDesc {{\n", to_camel_case(prog.name));
+    } else {
+        l_open("pub fn {}ShaderDesc(backend: sg.Backend) sg.ShaderDesc {{\n", to_camel_case(prog.name));
+    }
     l("var desc: sg.ShaderDesc = .{{}};\n");
     l("desc.label = \"{}_shader\";\n", prog.name);
     l_open("switch (backend) {{\n");
@@ -221,6 +341,9 @@ void SokolZigGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                 }
             }
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                    continue;
+                }
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 const StageReflection& refl = prog.stages[stage_index];
                 const std::string dsn = fmt::format("desc.{}", pystring::lower(refl.stage_name));
@@ -233,20 +356,25 @@ void SokolZigGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     if (slang == Slang::HLSL4) {
                         d3d11_tgt = (0 == stage_index) ? "vs_4_0" : "ps_4_0";
                     } else if (slang == Slang::HLSL5) {
-                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : "ps_5_0";
+                        d3d11_tgt = (0 == stage_index) ? "vs_5_0" : (1 == stage_index) ? "ps_5_0" : "cs_5_0";
                     }
                     if (d3d11_tgt) {
                         l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
                     }
                 }
                 l("{}.entry = \"{}\";\n", dsn, refl.entry_point_by_slang(slang));
+                if (Slang::is_msl(slang) && ShaderStage::is_cs(refl.stage)) {
+                    l("desc.mtl_threads_per_threadgroup.x = {};\n", refl.workgroup_size[0]);
+                    l("desc.mtl_threads_per_threadgroup.y = {};\n", refl.workgroup_size[1]);
+                    l("desc.mtl_threads_per_threadgroup.z = {};\n", refl.workgroup_size[2]);
+                }
                 for (int ub_index = 0; ub_index < UniformBlock::Num; ub_index++) {
                     const UniformBlock* ub = refl.bindings.find_uniform_block_by_slot(ub_index);
                     if (ub) {
                         const std::string ubn = fmt::format("{}.uniform_blocks[{}]", dsn, ub_index);
                         l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
                         l("{}.layout = .STD140;\n", ubn);
-                        if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
+                        if (Slang::is_glsl(slang) && !uses_glsl_uniform_buffers(gen, refl, slang) && (ub->struct_info.struct_items.size() > 0)) {
                             if (ub->flattened) {
                                 l("{}.uniforms[0].name = \"{}\";\n", ubn, ub->struct_info.name);
                                 // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
@@ -310,6 +438,21 @@ void SokolZigGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
     l_close("}}\n"); // close switch statement
     l("return desc;\n");
     l_close("}}\n"); // close function
+    if (gen.args.const_desc) {
+        gen_const_shader_desc_func(gen, prog);
+    }
+}
+
+void SokolZigGenerator::gen_const_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
+    const std::string name = to_camel_case(prog.name);
+    l_open("pub fn {}ShaderDesc(backend: sg.Backend) sg.ShaderDesc {{\n", name);
+    l_open("return switch (backend) {{\n");
+    for (const std::string& be: unique_backends(gen)) {
+        l("{} => comptime {}ShaderDescInit({}),\n", be, name, be);
+    }
+    l("else => .{{}},\n");
+    l_close("}};\n");
+    l_close("}}\n");
 }
 
 void SokolZigGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -320,6 +463,10 @@ void SokolZigGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n}};\n");
 }
 
+void SokolZigGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("const {}: [{}]u8 = @embedFile(\"{}\").*;\n", array_name, num_bytes, file_name);
+}
+
 std::string SokolZigGenerator::lang_name() {
     return "Zig";
 }
@@ -359,6 +506,12 @@ std::string SokolZigGenerator::uniform_type(Type::Enum e) {
         case Type::Int3:   return ".INT3";
         case Type::Int4:   return ".INT4";
         case Type::Mat4x4: return ".MAT4";
+        // there are no 16-bit uniform types, uniform blocks with 16-bit
+        // types are only supported on backends without uniform flattening
+        case Type::Half:
+        case Type::Half2:
+        case Type::Half3:
+        case Type::Half4:  return ".INVALID";
         default: return "INVALID";
     }
 }
@@ -421,6 +574,8 @@ std::string SokolZigGenerator::backend(Slang::Enum e) {
         case Slang::HLSL4:
         case Slang::HLSL5:
             return ".D3D11";
+        case Slang::HLSL6:
+            return ".D3D12";
         case Slang::METAL_MACOS:
             return ".METAL_MACOS";
         case Slang::METAL_IOS:
@@ -429,6 +584,8 @@ std::string SokolZigGenerator::backend(Slang::Enum e) {
             return ".METAL_SIMULATOR";
         case Slang::WGSL:
             return ".WGPU";
+        case Slang::SPIRV:
+            return ".VULKAN";
         default:
             return "INVALID";
     }
@@ -458,6 +615,18 @@ std::string SokolZigGenerator::storage_buffer_bind_slot_name(const refl::Storage
     return fmt::format("SLOT_{}", sb.struct_info.name);
 }
 
+std::string SokolZigGenerator::spec_constant_name(const SpecConstant& spec) {
+    return fmt::format("SPEC_{}", spec.name);
+}
+
+std::string SokolZigGenerator::program_hash_name(const ProgramReflection& prog, Slang::Enum slang) {
+    return fmt::format("HASH_{}_{}", prog.name, Slang::to_str(slang));
+}
+
+std::string SokolZigGenerator::layout_class_name(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("{}_CLASS_{}", LayoutClass::to_str(cls), prog.name);
+}
+
 std::string SokolZigGenerator::vertex_attr_definition(const StageAttr& attr) {
     return fmt::format("pub const {} = {};", vertex_attr_name(attr), attr.slot);
 }
@@ -478,18 +647,76 @@ std::string SokolZigGenerator::storage_buffer_bind_slot_definition(const Storage
     return fmt::format("pub const {} = {};", storage_buffer_bind_slot_name(sb), sb.slot);
 }
 
+std::string SokolZigGenerator::spec_constant_definition(const SpecConstant& spec) {
+    return fmt::format("pub const {} = {};", spec_constant_name(spec), spec.id);
+}
+
+std::string SokolZigGenerator::program_hash_definition(const ProgramReflection& prog, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("pub const {}: u64 = 0x{:016X};", program_hash_name(prog, slang), hash);
+}
+
+std::string SokolZigGenerator::layout_class_definition(const ProgramReflection& prog, LayoutClass::Enum cls) {
+    return fmt::format("pub const {}: u64 = 0x{:016X};", layout_class_name(prog, cls), prog.layout_classes[cls]);
+}
+
+// a switch over the hashed name (std.hash.Fnv1a_32 matches Generator::name_hash())
+// with one verifying std.mem.eql() per name, gen_match() is called with the names
+// index to generate the code for a match
+void SokolZigGenerator::gen_name_switch(const std::string& var_name, const std::vector<std::string>& names, const std::function<void(int)>& gen_match) {
+    if (names.empty()) {
+        return;
+    }
+    l_open("switch (std.hash.Fnv1a_32.hash({})) {{\n", var_name);
+    for (const NameHashCase& c: name_hash_cases(names)) {
+        l_open("0x{:08X} => {{\n", c.hash);
+        for (int item: c.items) {
+            l_open("if (std.mem.eql(u8, {}, \"{}\")) {{\n", var_name, names[item]);
+            gen_match(item);
+            l_close("}}\n");
+        }
+        l_close("}},\n");
+    }
+    l("else => {{}},\n");
+    l_close("}}\n");
+}
+
+// vertex attributes without @vertex_format tag use the format matching their
+// type, strides and offsets are left to sokol-gfx (tightly packed)
+void SokolZigGenerator::gen_vertex_layout_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("pub fn {}VertexLayout() sg.VertexLayoutState {{\n", to_camel_case(prog.name));
+    l("var layout: sg.VertexLayoutState = .{{}};\n");
+    std::set<int> instanced_buffers;
+    for (const StageAttr& attr: prog.vs().inputs) {
+        if (attr.slot >= 0) {
+            const VertexFormat::Enum vfmt = (attr.format != VertexFormat::INVALID) ? attr.format : VertexFormat::from_type(attr.type_info.type);
+            l("layout.attrs[{}].format = .{};\n", vertex_attr_name(attr), pystring::upper(VertexFormat::to_str(vfmt)));
+            if (attr.buffer_index != 0) {
+                l("layout.attrs[{}].buffer_index = {};\n", vertex_attr_name(attr), attr.buffer_index);
+            }
+            if (attr.per_instance) {
+                instanced_buffers.insert(attr.buffer_index);
+            }
+        }
+    }
+    for (int buffer_index: instanced_buffers) {
+        l("layout.buffers[{}].step_func = .PER_INSTANCE;\n", buffer_index);
+    }
+    l("return layout;\n");
+    l_close("}}\n");
+}
+
 void SokolZigGenerator::gen_attr_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("pub fn {}AttrSlot(attr_name: []const u8) ?usize {{\n", to_camel_case(prog.name));
-    bool wrote_attr_name = false;
+    std::vector<std::string> names;
+    std::vector<int> slots;
     for (const StageAttr& attr: prog.vs().inputs) {
         if (attr.slot >= 0) {
-            l_open("if (std.mem.eql(u8, attr_name, \"{}\")) {{\n", attr.name);
-            l("return {};\n", attr.slot);
-            l_close("}}\n");
-            wrote_attr_name = true;
+            names.push_back(attr.name);
+            slots.push_back(attr.slot);
         }
     }
-    if(!wrote_attr_name) l("_ = attr_name;\n");
+    gen_name_switch("attr_name", names, [&](int i) { l("return {};\n", slots[i]); });
+    if (names.empty()) l("_ = attr_name;\n");
     l("return null;\n");
     l_close("}}\n");
 }
@@ -502,14 +729,16 @@ void SokolZigGenerator::gen_image_slot_refl_func(const GenInput& gen, const Prog
         if (!refl.bindings.images.empty()) {
             l_open("if (sg.ShaderStage.{} == stage) {{\n", pystring::upper(refl.stage_name));
             wrote_stage = true;
+            std::vector<std::string> names;
+            std::vector<int> slots;
             for (const Image& img: refl.bindings.images) {
                 if (img.slot >= 0) {
-                    l_open("if (std.mem.eql(u8, img_name, \"{}\")) {{\n", img.name);
-                    l("return {};\n", img.slot);
-                    l_close("}}\n");
+                    names.push_back(img.name);
+                    slots.push_back(img.slot);
                     wrote_image = true;
                 }
             }
+            gen_name_switch("img_name", names, [&](int i) { l("return {};\n", slots[i]); });
             l_close("}}\n");
         }
     }
@@ -527,14 +756,16 @@ void SokolZigGenerator::gen_sampler_slot_refl_func(const GenInput& gen, const Pr
         if (!refl.bindings.samplers.empty()) {
             l_open("if (sg.ShaderStage.{} == stage) {{\n", pystring::upper(refl.stage_name));
             wrote_stage = true;
+            std::vector<std::string> names;
+            std::vector<int> slots;
             for (const Sampler& smp: refl.bindings.samplers) {
                 if (smp.slot >= 0) {
-                    l_open("if (std.mem.eql(u8, smp_name, \"{}\")) {{\n", smp.name);
-                    l("return {};\n", smp.slot);
-                    l_close("}}\n");
+                    names.push_back(smp.name);
+                    slots.push_back(smp.slot);
                     wrote_smp = true;
                 }
             }
+            gen_name_switch("smp_name", names, [&](int i) { l("return {};\n", slots[i]); });
             l_close("}}\n");
         }
     }
@@ -544,6 +775,27 @@ void SokolZigGenerator::gen_sampler_slot_refl_func(const GenInput& gen, const Pr
     l_close("}}\n");
 }
 
+// the uniform blocks with a valid bind slot, and their struct names
+static std::vector<const UniformBlock*> valid_uniform_blocks(const StageReflection& refl, std::vector<std::string>& out_names) {
+    std::vector<const UniformBlock*> res;
+    out_names.clear();
+    for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
+        if (ub.slot >= 0) {
+            res.push_back(&ub);
+            out_names.push_back(ub.struct_info.name);
+        }
+    }
+    return res;
+}
+
+static std::vector<std::string> uniform_names(const UniformBlock& ub) {
+    std::vector<std::string> res;
+    for (const Type& u: ub.struct_info.struct_items) {
+        res.push_back(u.name);
+    }
+    return res;
+}
+
 void SokolZigGenerator::gen_uniform_block_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("pub fn {}UniformblockSlot(stage: sg.ShaderStage, ub_name: []const u8) ?usize {{\n", to_camel_case(prog.name));
     bool wrote_stage = false;
@@ -552,14 +804,10 @@ void SokolZigGenerator::gen_uniform_block_slot_refl_func(const GenInput& gen, co
         if (!refl.bindings.uniform_blocks.empty()) {
             l_open("if (sg.ShaderStage.{} == stage) {{\n", pystring::upper(refl.stage_name));
             wrote_stage = true;
-            for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
-                if (ub.slot >= 0) {
-                    l_open("if (std.mem.eql(u8, ub_name, \"{}\")) {{\n", ub.struct_info.name);
-                    l("return {};\n", ub.slot);
-                    l_close("}}\n");
-                    wrote_ub_name = true;
-                }
-            }
+            std::vector<std::string> names;
+            const std::vector<const UniformBlock*> ubs = valid_uniform_blocks(refl, names);
+            wrote_ub_name |= !ubs.empty();
+            gen_name_switch("ub_name", names, [&](int i) { l("return {};\n", ubs[i]->slot); });
             l_close("}}\n");
         }
     }
@@ -577,14 +825,10 @@ void SokolZigGenerator::gen_uniform_block_size_refl_func(const GenInput& gen, co
         if (!refl.bindings.uniform_blocks.empty()) {
             l_open("if (sg.ShaderStage.{} == stage) {{\n", pystring::upper(refl.stage_name));
             wrote_stage = true;
-            for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
-                if (ub.slot >= 0) {
-                    l_open("if (std.mem.eql(u8, ub_name, \"{}\")) {{\n", ub.struct_info.name);
-                    l("return @sizeOf({});\n", struct_name(ub.struct_info.name));
-                    l_close("}}\n");
-                    wrote_ub_name = true;
-                }
-            }
+            std::vector<std::string> names;
+            const std::vector<const UniformBlock*> ubs = valid_uniform_blocks(refl, names);
+            wrote_ub_name |= !ubs.empty();
+            gen_name_switch("ub_name", names, [&](int i) { l("return @sizeOf({});\n", struct_name(ubs[i]->struct_info.name)); });
             l_close("}}\n");
         }
     }
@@ -602,14 +846,16 @@ void SokolZigGenerator::gen_storage_buffer_slot_refl_func(const GenInput& gen, c
         if (!refl.bindings.storage_buffers.empty()) {
             l_open("if (sg.ShaderStage.{} == stage) {{\n", pystring::upper(refl.stage_name));
             wrote_stage = true;
+            std::vector<std::string> names;
+            std::vector<int> slots;
             for (const StorageBuffer& sbuf: refl.bindings.storage_buffers) {
                 if (sbuf.slot >= 0) {
-                    l_open("if (std.mem.eql(u8, sbuf_name, \"{}\")) {{\n", sbuf.struct_info.name);
-                    l("return {};\n", sbuf.slot);
-                    l_close("}}\n");
+                    names.push_back(sbuf.struct_info.name);
+                    slots.push_back(sbuf.slot);
                     wrote_sbuf_name = true;
                 }
             }
+            gen_name_switch("sbuf_name", names, [&](int i) { l("return {};\n", slots[i]); });
             l_close("}}\n");
         }
     }
@@ -628,19 +874,16 @@ void SokolZigGenerator::gen_uniform_offset_refl_func(const GenInput& gen, const
         if (!refl.bindings.uniform_blocks.empty()) {
             l_open("if (sg.ShaderStage.{} == stage) {{\n", pystring::upper(refl.stage_name));
             wrote_stage = true;
-            for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
-                if (ub.slot >= 0) {
-                    l_open("if (std.mem.eql(u8, ub_name, \"{}\")) {{\n", ub.struct_info.name);
-                    wrote_ub_name = true;
-                    for (const Type& u: ub.struct_info.struct_items) {
-                        l_open("if (std.mem.eql(u8, u_name, \"{}\")) {{\n", u.name);
-                        l("return {};\n", u.offset);
-                        l_close("}}\n");
-                        wrote_u_name = true;
-                    }
-                    l_close("}}\n");
-                }
-            }
+            std::vector<std::string> names;
+            const std::vector<const UniformBlock*> ubs = valid_uniform_blocks(refl, names);
+            wrote_ub_name |= !ubs.empty();
+            gen_name_switch("ub_name", names, [&](int i) {
+                const UniformBlock& ub = *ubs[i];
+                wrote_u_name |= !ub.struct_info.struct_items.empty();
+                gen_name_switch("u_name", uniform_names(ub), [&](int u_index) {
+                    l("return {};\n", ub.struct_info.struct_items[u_index].offset);
+                });
+            });
             l_close("}}\n");
         }
     }
@@ -661,23 +904,21 @@ void SokolZigGenerator::gen_uniform_desc_refl_func(const GenInput& gen, const Pr
         if (!refl.bindings.uniform_blocks.empty()) {
             l_open("if (sg.ShaderStage.{} == stage) {{\n", pystring::upper(refl.stage_name));
             wrote_stage = true;
-            for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
-                if (ub.slot >= 0) {
-                    l_open("if (std.mem.eql(u8, ub_name, \"{}\")) {{\n", ub.struct_info.name);
-                    wrote_ub_name = true;
-                    for (const Type& u: ub.struct_info.struct_items) {
-                        l_open("if (std.mem.eql(u8, u_name, \"{}\")) {{\n", u.name);
-                        l("var desc: sg.ShaderUniformDesc = .{{}};\n");
-                        l("desc.name = \"{}\";\n", u.name);
-                        l("desc.type = {};\n", uniform_type(u.type));
-                        l("desc.array_count = {};\n", u.array_count);
-                        l("return desc;\n");
-                        l_close("}}\n");
-                        wrote_u_name = true;
-                    }
-                    l_close("}}\n");
-                }
-            }
+            std::vector<std::string> names;
+            const std::vector<const UniformBlock*> ubs = valid_uniform_blocks(refl, names);
+            wrote_ub_name |= !ubs.empty();
+            gen_name_switch("ub_name", names, [&](int i) {
+                const UniformBlock& ub = *ubs[i];
+                wrote_u_name |= !ub.struct_info.struct_items.empty();
+                gen_name_switch("u_name", uniform_names(ub), [&](int u_index) {
+                    const Type& u = ub.struct_info.struct_items[u_index];
+                    l("var desc: sg.ShaderUniformDesc = .{{}};\n");
+                    l("desc.name = \"{}\";\n", u.name);
+                    l("desc.type = {};\n", uniform_type(u.type));
+                    l("desc.array_count = {};\n", u.array_count);
+                    l("return desc;\n");
+                });
+            });
             l_close("}}\n");
         }
     }
@@ -3,6 +3,7 @@
 */
 #include "yaml.h"
 #include "bare.h"
+#include "types/msl_argument_buffer.h"
 #include "fmt/format.h"
 #include "pystring.h"
 #include <stdio.h>
@@ -20,96 +21,272 @@ ErrMsg YamlGenerator::generate(const GenInput& gen) {
     }
     // next generate a YAML file with reflection info
     content.clear();
+    if (gen.args.pack) {
+        // the shader file paths below are the entry paths in the pack file
+        l("pack: {}\n", gen.args.reproducible_path(pack_file_path(gen)));
+    }
+    if (gen.args.yaml_schema >= 2) {
+        gen_schema_v2(gen);
+    } else {
+        gen_schema_v1(gen);
+    }
+
+    // write result into output file
+    const std::string file_path = fmt::format("{}_{}reflection.yaml", gen.args.output, mod_prefix);
+    if (!write_output_file(gen, file_path, content.data(), content.size(), false)) {
+        return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", file_path));
+    }
+    return ErrMsg();
+}
+
+// the original schema repeats the complete reflection info for each target language
+void YamlGenerator::gen_schema_v1(const GenInput& gen) {
     l_open("shaders:\n");
     for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
         Slang::Enum slang = Slang::from_index(slang_idx);
         if (gen.args.slang & Slang::bit(slang)) {
-            // FIXME: all slang outputs will be the same, so this is kinda redundant
             l_open("-\n");
             l("slang: {}\n", Slang::to_str(slang));
             l_open("programs:\n");
             const Spirvcross& spirvcross = gen.spirvcross[slang];
-            const Bytecode& bytecode = gen.bytecode[slang];
             for (const ProgramReflection& prog: gen.refl.progs) {
                 l_open("-\n");
                 l("name: {}\n", prog.name);
+                l("hash: 0x{:016X}\n", program_hash(gen, prog, slang));
+                gen_layout_classes(prog);
                 for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                    if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                        continue;
+                    }
                     const StageReflection& refl = prog.stages[stage_index];
                     const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(refl.snippet_index);
-                    const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(refl.snippet_index);
-                    const std::string file_path = shader_file_path(gen, prog.name, refl.stage_name, slang, blob != nullptr);
                     l_open("{}:\n", pystring::lower(refl.stage_name));
-                    l("path: {}\n", file_path);
-                    l("is_binary: {}\n", blob != nullptr);
-                    l("entry_point: {}\n", refl.entry_point_by_slang(slang));
-                    l_open("inputs:\n");
-                    for (const auto& input: src->stage_refl.inputs) {
-                        if (input.slot != -1) {
-                            gen_attr(input);
-                        }
-                    }
+                    gen_stage_slang(gen, prog, refl, slang);
+                    gen_workgroup_size(refl);
+                    gen_early_fragment_tests(refl);
+                    gen_spec_constants(refl);
+                    gen_stage_refl(gen, src->stage_refl->inputs, src->stage_refl->outputs, refl.bindings, src->stage_refl->bindings.image_samplers);
                     l_close();
-                    l_open("outputs:\n");
-                    for (const auto& output: src->stage_refl.outputs) {
-                        if (output.slot != -1) {
-                            gen_attr(output);
-                        }
-                    }
-                    l_close();
-                    if (refl.bindings.uniform_blocks.size() > 0) {
-                        l_open("uniform_blocks:\n");
-                        for (const auto& uniform_block: refl.bindings.uniform_blocks) {
-                            gen_uniform_block(gen, uniform_block);
-                        }
-                        l_close();
-                    }
-                    if (refl.bindings.storage_buffers.size() > 0) {
-                        l_open("storage_buffers:\n");
-                        for (const auto& sbuf: refl.bindings.storage_buffers) {
-                            gen_storage_buffer(sbuf);
-                        }
-                        l_close();
-                    }
-                    if (refl.bindings.images.size() > 0) {
-                        l_open("images:\n");
-                        for (const auto& image: refl.bindings.images) {
-                            gen_image(image);
-                        }
-                        l_close();
-                    }
-                    if (refl.bindings.samplers.size() > 0) {
-                        l_open("samplers:\n");
-                        for (const auto& sampler: refl.bindings.samplers) {
-                            gen_sampler(sampler);
-                        }
-                        l_close();
-                    }
-                    if (src->stage_refl.bindings.image_samplers.size() > 0) {
-                        l_open("image_sampler_pairs:\n");
-                        for (const auto& image_sampler: src->stage_refl.bindings.image_samplers) {
-                            gen_image_sampler(image_sampler);
-                        }
-                        l_close();
+                }
+                l_close();
+            }
+            l_close();
+            l_close();
+        }
+    }
+    l_close();
+}
+
+// schema version 2 writes the reflection info only once per program, and only
+// the target language specific items for each target language
+void YamlGenerator::gen_schema_v2(const GenInput& gen) {
+    l("schema: 2\n");
+    l_open("programs:\n");
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        l_open("-\n");
+        l("name: {}\n", prog.name);
+        gen_layout_classes(prog);
+        for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+            if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                continue;
+            }
+            const StageReflection& refl = prog.stages[stage_index];
+            l_open("{}:\n", pystring::lower(refl.stage_name));
+            gen_workgroup_size(refl);
+            gen_early_fragment_tests(refl);
+            gen_spec_constants(refl);
+            gen_stage_refl(gen, refl.inputs, refl.outputs, refl.bindings, refl.bindings.image_samplers);
+            l_close();
+        }
+        l_open("slangs:\n");
+        for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
+            Slang::Enum slang = Slang::from_index(slang_idx);
+            if (gen.args.slang & Slang::bit(slang)) {
+                l_open("-\n");
+                l("slang: {}\n", Slang::to_str(slang));
+                l("hash: 0x{:016X}\n", program_hash(gen, prog, slang));
+                for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                    if (!prog.has_stage(ShaderStage::from_index(stage_index))) {
+                        continue;
                     }
+                    const StageReflection& refl = prog.stages[stage_index];
+                    l_open("{}:\n", pystring::lower(refl.stage_name));
+                    gen_stage_slang(gen, prog, refl, slang);
                     l_close();
                 }
                 l_close();
             }
+        }
+        l_close();
+        l_close();
+    }
+    l_close();
+}
+
+void YamlGenerator::gen_stage_slang(const GenInput& gen, const ProgramReflection& prog, const StageReflection& refl, Slang::Enum slang) {
+    const BytecodeBlob* blob = gen.bytecode[slang].find_blob_by_snippet_index(refl.snippet_index);
+    const std::string file_path = shader_file_path(gen, prog.name, refl.stage_name, slang, blob != nullptr);
+    l("path: {}\n", gen.args.reproducible_path(file_path));
+    l("is_binary: {}\n", blob != nullptr);
+    l("entry_point: {}\n", refl.entry_point_by_slang(slang));
+    if (uses_msl_argument_buffer(gen, refl, slang)) {
+        gen_msl_argument_buffer(refl);
+    }
+    if (uses_glsl_uniform_buffers(gen, refl, slang)) {
+        gen_glsl_uniform_buffers(refl);
+    }
+}
+
+// only written for desktop GLSL targets with @glsl_options uniform_buffers
+void YamlGenerator::gen_glsl_uniform_buffers(const StageReflection& refl) {
+    if (refl.bindings.uniform_blocks.size() > 0) {
+        l_open("uniform_buffers:\n");
+        for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
+            l_open("-\n");
+            l("slot: {}\n", ub.slot);
+            l("block_name: {}\n", ub.struct_info.name);
+            l("binding: {}\n", UniformBlock::glsl_binding(ShaderStage::is_fs(refl.stage), ub.slot));
+            l_close();
+        }
+        l_close();
+    }
+}
+
+// only written for Metal targets with @msl_options argument_buffers
+void YamlGenerator::gen_msl_argument_buffer(const StageReflection& refl) {
+    l_open("argument_buffer:\n");
+    l("buffer: {}\n", MslArgumentBuffer::buffer_index(ShaderStage::is_vs(refl.stage)));
+    if (refl.bindings.storage_buffers.size() > 0) {
+        l_open("storage_buffers:\n");
+        for (const StorageBuffer& sbuf: refl.bindings.storage_buffers) {
+            l_open("-\n");
+            l("slot: {}\n", sbuf.slot);
+            l("id: {}\n", MslArgumentBuffer::storage_buffer_id(sbuf.slot));
+            l_close();
+        }
+        l_close();
+    }
+    if (refl.bindings.images.size() > 0) {
+        l_open("images:\n");
+        for (const Image& img: refl.bindings.images) {
+            l_open("-\n");
+            l("slot: {}\n", img.slot);
+            l("id: {}\n", MslArgumentBuffer::image_id(img.slot));
             l_close();
+        }
+        l_close();
+    }
+    if (refl.bindings.samplers.size() > 0) {
+        l_open("samplers:\n");
+        for (const Sampler& smp: refl.bindings.samplers) {
+            l_open("-\n");
+            l("slot: {}\n", smp.slot);
+            l("id: {}\n", MslArgumentBuffer::sampler_id(smp.slot));
             l_close();
         }
+        l_close();
     }
     l_close();
+}
 
-    // write result into output file
-    const std::string file_path = fmt::format("{}_{}reflection.yaml", gen.args.output, mod_prefix);
-    FILE* f = fopen(file_path.c_str(), "w");
-    if (!f) {
-        return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", file_path));
+// only written for compute shaders
+// compute programs don't have a vertex layout class
+void YamlGenerator::gen_layout_classes(const ProgramReflection& prog) {
+    if (!prog.is_compute()) {
+        l("vertex_layout_class: 0x{:016X}\n", prog.layout_classes[LayoutClass::VertexLayout]);
+    }
+    l("bindings_layout_class: 0x{:016X}\n", prog.layout_classes[LayoutClass::Bindings]);
+}
+
+void YamlGenerator::gen_workgroup_size(const StageReflection& refl) {
+    if (ShaderStage::is_cs(refl.stage)) {
+        l("workgroup_size: [ {}, {}, {} ]\n", refl.workgroup_size[0], refl.workgroup_size[1], refl.workgroup_size[2]);
+    }
+}
+
+// fragment stage only
+void YamlGenerator::gen_early_fragment_tests(const StageReflection& refl) {
+    if (ShaderStage::is_fs(refl.stage)) {
+        l_open("early_fragment_tests:\n");
+        l("disabled: {}\n", refl.disables_early_fragment_tests());
+        l("forced: {}\n", refl.early_fragment_tests);
+        l("discards: {}\n", refl.discards);
+        l("writes_frag_depth: {}\n", refl.writes_frag_depth);
+        l_close();
+    }
+}
+
+// only written when the stage has specialization constants
+void YamlGenerator::gen_spec_constants(const StageReflection& refl) {
+    if (refl.spec_constants.size() > 0) {
+        l_open("spec_constants:\n");
+        for (const SpecConstant& spec: refl.spec_constants) {
+            l_open("-\n");
+            l("id: {}\n", spec.id);
+            l("name: {}\n", spec.name);
+            l("type: {}\n", Type::type_to_glsl(spec.type));
+            l("default_value: {}\n", spec.default_value);
+            l_close();
+        }
+        l_close();
+    }
+}
+
+void YamlGenerator::gen_stage_refl(const GenInput& gen,
+    const std::array<StageAttr, StageAttr::Num>& inputs,
+    const std::array<StageAttr, StageAttr::Num>& outputs,
+    const Bindings& bindings,
+    const std::vector<ImageSampler>& image_samplers)
+{
+    l_open("inputs:\n");
+    for (const auto& input: inputs) {
+        if (input.slot != -1) {
+            gen_attr(input);
+        }
+    }
+    l_close();
+    l_open("outputs:\n");
+    for (const auto& output: outputs) {
+        if (output.slot != -1) {
+            gen_attr(output);
+        }
+    }
+    l_close();
+    if (bindings.uniform_blocks.size() > 0) {
+        l_open("uniform_blocks:\n");
+        for (const auto& uniform_block: bindings.uniform_blocks) {
+            gen_uniform_block(gen, uniform_block);
+        }
+        l_close();
+    }
+    if (bindings.storage_buffers.size() > 0) {
+        l_open("storage_buffers:\n");
+        for (const auto& sbuf: bindings.storage_buffers) {
+            gen_storage_buffer(sbuf);
+        }
+        l_close();
+    }
+    if (bindings.images.size() > 0) {
+        l_open("images:\n");
+        for (const auto& image: bindings.images) {
+            gen_image(image);
+        }
+        l_close();
+    }
+    if (bindings.samplers.size() > 0) {
+        l_open("samplers:\n");
+        for (const auto& sampler: bindings.samplers) {
+            gen_sampler(sampler);
+        }
+        l_close();
+    }
+    if (image_samplers.size() > 0) {
+        l_open("image_sampler_pairs:\n");
+        for (const auto& image_sampler: image_samplers) {
+            gen_image_sampler(image_sampler);
+        }
+        l_close();
     }
-    fwrite(content.c_str(), content.length(), 1, f);
-    fclose(f);
-    return ErrMsg();
 }
 
 void YamlGenerator::gen_attr(const StageAttr& att) {
@@ -13,6 +13,20 @@ protected:
     virtual std::string image_sample_type(refl::ImageSampleType::Enum e);
     virtual std::string sampler_type(refl::SamplerType::Enum e);
 private:
+    void gen_schema_v1(const GenInput& gen);
+    void gen_schema_v2(const GenInput& gen);
+    void gen_stage_slang(const GenInput& gen, const refl::ProgramReflection& prog, const refl::StageReflection& refl, Slang::Enum slang);
+    void gen_layout_classes(const refl::ProgramReflection& prog);
+    void gen_workgroup_size(const refl::StageReflection& refl);
+    void gen_early_fragment_tests(const refl::StageReflection& refl);
+    void gen_msl_argument_buffer(const refl::StageReflection& refl);
+    void gen_glsl_uniform_buffers(const refl::StageReflection& refl);
+    void gen_spec_constants(const refl::StageReflection& refl);
+    void gen_stage_refl(const GenInput& gen,
+        const std::array<refl::StageAttr, refl::StageAttr::Num>& inputs,
+        const std::array<refl::StageAttr, refl::StageAttr::Num>& outputs,
+        const refl::Bindings& bindings,
+        const std::vector<refl::ImageSampler>& image_samplers);
     void gen_attr(const refl::StageAttr& attr);
     void gen_uniform_block(const GenInput& gen, const refl::UniformBlock& ub);
     void gen_uniform_block_refl(const refl::UniformBlock& ub);
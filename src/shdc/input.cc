@@ -4,9 +4,12 @@
 #include "input.h"
 #include "types/reflection/type.h"
 #include "types/option.h"
+#include "types/file_stamp.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <ctype.h>
+#include <mutex>
 #include "fmt/format.h"
 #include "pystring.h"
 
@@ -14,35 +17,31 @@ namespace shdc {
 
 using namespace refl;
 
-static std::string load_file_into_str(const std::string& path) {
-    FILE* f = fopen(path.c_str(), "rb");
-    if (!f) {
-        return std::string();
-    }
-    fseek(f, 0, SEEK_END);
-    const size_t file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    char* buf = (char*) malloc(file_size + 1);
-    fread((void*)buf, file_size, 1, f);
-    buf[file_size] = 0;
-    std::string str(buf);
-    free((void*)buf);
-    return str;
-}
-
-/* removes comments from string
+/* single-pass lexer: removes comments in-place and splits the source into lines
     - FIXME: doesn't detect block-comment in block-comment bugs
     - also removes comments in string literals (no problem for shader langs)
+    - line splitting has the same semantics as pystring::splitlines()
 */
-static bool remove_comments(std::string& str) {
+static bool lex_source(char* str, size_t len, std::vector<std::string_view>& out_lines) {
+    out_lines.clear();
     bool in_winged_comment = false;
     bool in_block_comment = false;
     bool maybe_start = false;
     bool maybe_end = false;
-    const size_t len = str.length();
+    size_t line_start = 0;
     for (size_t pos = 0; pos < len; pos++) {
         const char c = str[pos];
-        if (!(in_winged_comment || in_block_comment)) {
+        if ((c == '\r') || (c == '\n')) {
+            // end of line reached (newlines are preserved in block comments)
+            out_lines.push_back(std::string_view(str + line_start, pos - line_start));
+            if ((c == '\r') && ((pos + 1) < len) && (str[pos + 1] == '\n')) {
+                pos++;
+            }
+            line_start = pos + 1;
+            in_winged_comment = false;
+            maybe_start = false;
+            maybe_end = false;
+        } else if (!(in_winged_comment || in_block_comment)) {
             // not currently in a comment
             if (maybe_start) {
                 // next character after a '/'
@@ -64,54 +63,107 @@ static bool remove_comments(std::string& str) {
                     maybe_start = true;
                 }
             }
-        } else if (in_winged_comment || in_block_comment) {
-            if (in_winged_comment) {
-                if ((c == '\r') || (c == '\n')) {
-                    // end of line reached
-                    in_winged_comment = false;
-                } else {
-                    str[pos] = ' ';
+        } else if (in_winged_comment) {
+            str[pos] = ' ';
+        } else {
+            // in block comment
+            str[pos] = ' ';
+            if (maybe_end) {
+                if (c == '/') {
+                    // end of block comment
+                    in_block_comment = false;
                 }
+                maybe_end = false;
             } else {
-                // in block comment (preserve newlines)
-                if ((c != '\r') && (c != '\n')) {
-                    str[pos] = ' ';
-                }
-                if (maybe_end) {
-                    if (c == '/') {
-                        // end of block comment
-                        in_block_comment = false;
-                    }
-                    maybe_end = false;
-                } else {
-                    if (c == '*') {
-                        // potential end of block comment
-                        maybe_end = true;
-                    }
+                if (c == '*') {
+                    // potential end of block comment
+                    maybe_end = true;
                 }
             }
         }
     }
+    if (line_start < len) {
+        out_lines.push_back(std::string_view(str + line_start, len - line_start));
+    }
     return true;
 }
 
+static bool is_space(char c) {
+    return (c == ' ') || (c == '\t') || (c == '\v') || (c == '\f');
+}
+
+static size_t skip_space(std::string_view line, size_t pos) {
+    while ((pos < line.length()) && is_space(line[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// check if a line starts with a @tag
+static bool is_tag_line(std::string_view line) {
+    const size_t pos = skip_space(line, 0);
+    return (pos < line.length()) && (line[pos] == '@');
+}
+
+// check if a line starts with '#pragma sokol' (with optional whitespace after '#')
+static bool is_pragma_sokol_line(std::string_view line) {
+    size_t pos = skip_space(line, 0);
+    if ((pos >= line.length()) || (line[pos] != '#')) {
+        return false;
+    }
+    pos = skip_space(line, pos + 1);
+    if (line.substr(pos, 6) != "pragma") {
+        return false;
+    }
+    pos += 6;
+    const size_t sokol_pos = skip_space(line, pos);
+    if ((sokol_pos == pos) || (line.substr(sokol_pos, 5) != "sokol")) {
+        return false;
+    }
+    pos = sokol_pos + 5;
+    return (pos == line.length()) || is_space(line[pos]);
+}
+
+// split a line into whitespace-separated tokens, reuses the token strings
+static void split_tokens(std::string_view line, std::vector<std::string>& out_tokens) {
+    size_t num_tokens = 0;
+    size_t pos = skip_space(line, 0);
+    while (pos < line.length()) {
+        const size_t start = pos;
+        while ((pos < line.length()) && !is_space(line[pos])) {
+            pos++;
+        }
+        if (num_tokens == out_tokens.size()) {
+            out_tokens.emplace_back();
+        }
+        out_tokens[num_tokens++].assign(line.data() + start, pos - start);
+        pos = skip_space(line, pos);
+    }
+    out_tokens.resize(num_tokens);
+}
+
 static const std::string module_tag = "@module";
 static const std::string ctype_tag = "@ctype";
 static const std::string header_tag = "@header";
 static const std::string vs_tag = "@vs";
 static const std::string fs_tag = "@fs";
+static const std::string cs_tag = "@cs";
 static const std::string block_tag = "@block";
 static const std::string inclblock_tag = "@include_block";
 static const std::string end_tag = "@end";
 static const std::string prog_tag = "@program";
+static const std::string permutation_tag = "@permutation";
 static const std::string glsl_options_tag = "@glsl_options";
 static const std::string hlsl_options_tag = "@hlsl_options";
 static const std::string msl_options_tag = "@msl_options";
 static const std::string include_tag = "@include";
+static const std::string include_once_tag = "@include_once";
 static const std::string image_sample_type_tag = "@image_sample_type";
 static const std::string sampler_type_tag = "@sampler_type";
+static const std::string vertex_format_tag = "@vertex_format";
+static const std::string early_fragment_tests_tag = "@early_fragment_tests";
 
-static bool normalize_pragma_sokol(std::vector<std::string>& toks, std::string &line, int line_index, Input& inp) {
+static bool normalize_pragma_sokol(std::vector<std::string>& toks, std::string_view& line, int line_index, Input& inp) {
     // Returns true if it saw no errors, even if it did nothing.
     // If it sees #pragma sokol, it modifies both `toks` and `line`
     // in-place so that they no longer contain them.
@@ -139,8 +191,8 @@ static bool normalize_pragma_sokol(std::vector<std::string>& toks, std::string &
     // We don't know where in the line itself this is, so just drop everything
     // before the first @.
     auto at_pos = line.find('@');
-    assert(at_pos != std::string::npos);
-    line.erase(line.begin(), line.begin() + at_pos);
+    assert(at_pos != std::string_view::npos);
+    line.remove_prefix(at_pos);
     return true;;
 }
 
@@ -199,7 +251,7 @@ static bool validate_block_tag(const std::vector<std::string>& tokens, bool in_s
         return false;
     }
     if (inp.snippet_map.count(tokens[1]) > 0) {
-        inp.out_error = inp.error(line_index, fmt::format("@block, @vs and @fs tag names must be unique (@block {}).", tokens[1]));
+        inp.out_error = inp.error(line_index, fmt::format("@block, @vs, @fs and @cs tag names must be unique (@block {}).", tokens[1]));
         return false;
     }
     return true;
@@ -215,7 +267,7 @@ static bool validate_vs_tag(const std::vector<std::string>& tokens, bool in_snip
         return false;
     }
     if (inp.snippet_map.count(tokens[1]) > 0) {
-        inp.out_error = inp.error(line_index, fmt::format("@block, @vs and @fs tag names must be unique (@vs {}).", tokens[1]));
+        inp.out_error = inp.error(line_index, fmt::format("@block, @vs, @fs and @cs tag names must be unique (@vs {}).", tokens[1]));
         return false;
     }
     return true;
@@ -231,7 +283,23 @@ static bool validate_fs_tag(const std::vector<std::string>& tokens, bool in_snip
         return false;
     }
     if (inp.snippet_map.count(tokens[1]) > 0) {
-        inp.out_error = inp.error(line_index, fmt::format("@block, @vs and @fs tag names must be unique (@fs {}).", tokens[1]));
+        inp.out_error = inp.error(line_index, fmt::format("@block, @vs, @fs and @cs tag names must be unique (@fs {}).", tokens[1]));
+        return false;
+    }
+    return true;
+}
+
+static bool validate_cs_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+    if (tokens.size() != 2) {
+        inp.out_error = inp.error(line_index, "@cs tag must have exactly one arg (@cs name).");
+        return false;
+    }
+    if (in_snippet) {
+        inp.out_error = inp.error(line_index, "@cs tag cannot be inside other tag block (missing @end?).");
+        return false;
+    }
+    if (inp.snippet_map.count(tokens[1]) > 0) {
+        inp.out_error = inp.error(line_index, fmt::format("@block, @vs, @fs and @cs tag names must be unique (@cs {}).", tokens[1]));
         return false;
     }
     return true;
@@ -243,7 +311,7 @@ static bool validate_inclblock_tag(const std::vector<std::string>& tokens, bool
         return false;
     }
     if (!in_snippet) {
-        inp.out_error = inp.error(line_index, "@include_block must be inside a @block, @vs or @fs block.");
+        inp.out_error = inp.error(line_index, "@include_block must be inside a @block, @vs, @fs or @cs block.");
         return false;
     }
     if (inp.snippet_map.count(tokens[1]) != 1) {
@@ -259,15 +327,15 @@ static bool validate_end_tag(const std::vector<std::string>& tokens, bool in_sni
         return false;
     }
     if (!in_snippet) {
-        inp.out_error = inp.error(line_index, "@end tag must come after a @block, @vs or @fs tag.");
+        inp.out_error = inp.error(line_index, "@end tag must come after a @block, @vs, @fs or @cs tag.");
         return false;
     }
     return true;
 }
 
 static bool validate_program_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
-    if (tokens.size() != 4) {
-        inp.out_error = inp.error(line_index, "@program tag must have exactly 3 args (@program name vs_name fs_name).");
+    if ((tokens.size() != 3) && (tokens.size() != 4)) {
+        inp.out_error = inp.error(line_index, "@program tag must have 3 args (@program name vs_name fs_name), or 2 args for compute programs (@program name cs_name).");
         return false;
     }
     if (in_snippet) {
@@ -278,6 +346,13 @@ static bool validate_program_tag(const std::vector<std::string>& tokens, bool in
         inp.out_error = inp.error(line_index, fmt::format("@program '{}' already defined.", tokens[1]));
         return false;
     }
+    if (tokens.size() == 3) {
+        if (inp.cs_map.count(tokens[2]) != 1) {
+            inp.out_error = inp.error(line_index, fmt::format("@cs '{}' not found for @program '{}'.", tokens[2], tokens[1]));
+            return false;
+        }
+        return true;
+    }
     if (inp.vs_map.count(tokens[2]) != 1) {
         inp.out_error = inp.error(line_index, fmt::format("@vs '{}' not found for @program '{}'.", tokens[2], tokens[1]));
         return false;
@@ -289,18 +364,87 @@ static bool validate_program_tag(const std::vector<std::string>& tokens, bool in
     return true;
 }
 
+// max number of features in a @permutation (=> max 256 variants per program)
+static const int max_permutation_features = 8;
+
+static bool validate_permutation_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+    if (tokens.size() < 3) {
+        inp.out_error = inp.error(line_index, "@permutation tag must have at least 2 args (@permutation program_name feature1 feature2...).");
+        return false;
+    }
+    if (in_snippet) {
+        inp.out_error = inp.error(line_index, "@permutation tag cannot be inside a block tag.");
+        return false;
+    }
+    if (inp.programs.count(tokens[1]) != 1) {
+        inp.out_error = inp.error(line_index, fmt::format("@program '{}' not found for @permutation (must be defined before the @permutation tag).", tokens[1]));
+        return false;
+    }
+    if (!inp.programs.at(tokens[1]).features.empty()) {
+        inp.out_error = inp.error(line_index, fmt::format("@permutation for program '{}' already defined.", tokens[1]));
+        return false;
+    }
+    if ((int)tokens.size() - 2 > max_permutation_features) {
+        inp.out_error = inp.error(line_index, fmt::format("@permutation can have at most {} features.", max_permutation_features));
+        return false;
+    }
+    for (int i = 2; i < (int)tokens.size(); i++) {
+        const std::string& feature = tokens[i];
+        bool valid = !isdigit((unsigned char)feature[0]);
+        for (char c: feature) {
+            if (!(isalnum((unsigned char)c) || (c == '_'))) {
+                valid = false;
+            }
+        }
+        if (!valid) {
+            inp.out_error = inp.error(line_index, fmt::format("@permutation feature '{}' is not a valid preprocessor define name.", feature));
+            return false;
+        }
+        for (int j = 2; j < i; j++) {
+            if (tokens[j] == feature) {
+                inp.out_error = inp.error(line_index, fmt::format("@permutation feature '{}' appears more than once.", feature));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 static bool validate_options_tag(const std::vector<std::string>& tokens, const Snippet& cur_snippet, int line_index, Input& inp) {
     if (tokens.size() < 2) {
-        inp.out_error = inp.error(line_index, fmt::format("{} must have at least 1 arg ('fixup_clipspace', 'flip_vert_y')", tokens[0]));
+        inp.out_error = inp.error(line_index, fmt::format("{} must have at least 1 arg ('fixup_clipspace', 'flip_vert_y', 'fs_default_precision=mediump', 'argument_buffers', 'uniform_buffers', 'precise_math')", tokens[0]));
         return false;
     }
-    if (cur_snippet.type != Snippet::VS) {
-        inp.out_error = inp.error(line_index, fmt::format("{} must be inside a @vs block", tokens[0]));
+    if (!Snippet::is_shader(cur_snippet.type)) {
+        inp.out_error = inp.error(line_index, fmt::format("{} must be inside a @vs, @fs or @cs block", tokens[0]));
         return false;
     }
     for (int i = 1; i < (int)tokens.size(); i++) {
-        if (Option::from_string(tokens[i]) == Option::INVALID) {
-            inp.out_error = inp.error(line_index, fmt::format("unknown option '{}' (must be 'fixup_clipspace', 'flip_vert_y')", tokens[i]));
+        const Option::Enum option = Option::from_string(tokens[i]);
+        if (option == Option::INVALID) {
+            inp.out_error = inp.error(line_index, fmt::format("unknown option '{}' (must be 'fixup_clipspace', 'flip_vert_y', 'fs_default_precision=mediump', 'argument_buffers', 'uniform_buffers', 'precise_math')", tokens[i]));
+            return false;
+        }
+        if (Option::is_vertex_option(option) && (cur_snippet.type != Snippet::VS)) {
+            inp.out_error = inp.error(line_index, fmt::format("option '{}' must be inside a @vs block", tokens[i]));
+            return false;
+        }
+        if (option == Option::FS_MEDIUMP) {
+            if (cur_snippet.type != Snippet::FS) {
+                inp.out_error = inp.error(line_index, fmt::format("option '{}' must be inside a @fs block", tokens[i]));
+                return false;
+            }
+            if (tokens[0] != glsl_options_tag) {
+                inp.out_error = inp.error(line_index, fmt::format("option '{}' is only supported in @glsl_options (use float16_t types for half precision on other targets)", tokens[i]));
+                return false;
+            }
+        }
+        if (((option == Option::ARGUMENT_BUFFERS) || (option == Option::PRECISE_MATH)) && (tokens[0] != msl_options_tag)) {
+            inp.out_error = inp.error(line_index, fmt::format("option '{}' is only supported in @msl_options", tokens[i]));
+            return false;
+        }
+        if ((option == Option::UNIFORM_BUFFERS) && (tokens[0] != glsl_options_tag)) {
+            inp.out_error = inp.error(line_index, fmt::format("option '{}' is only supported in @glsl_options", tokens[i]));
             return false;
         }
     }
@@ -312,8 +456,8 @@ static bool validate_image_sample_type_tag(const std::vector<std::string>& token
         inp.out_error = inp.error(line_index, fmt::format("@image_sample_type must have at least 2 arg (@image_sample_type [texture] {})", ImageSampleType::valid_image_sample_types_as_str()));
         return false;
     }
-    if ((cur_snippet.type != Snippet::VS) && (cur_snippet.type != Snippet::FS)) {
-        inp.out_error = inp.error(line_index, "@image_sample_type tag must be inside a @vs or @fs block");
+    if (!Snippet::is_shader(cur_snippet.type)) {
+        inp.out_error = inp.error(line_index, "@image_sample_type tag must be inside a @vs, @fs or @cs block");
         return false;
     }
     if (nullptr != cur_snippet.lookup_image_sample_type_tag(tokens[1])) {
@@ -332,8 +476,8 @@ static bool validate_sampler_type_tag(const std::vector<std::string>& tokens, co
         inp.out_error = inp.error(line_index, fmt::format("@sampler_type must have at least 2 arg (@sampler_type [sampler] {})", SamplerType::valid_sampler_types_as_str()));
         return false;
     }
-    if ((cur_snippet.type != Snippet::VS) && (cur_snippet.type != Snippet::FS)) {
-        inp.out_error = inp.error(line_index, "@sampler_type tag must be inside a @vs or @fs block");
+    if (!Snippet::is_shader(cur_snippet.type)) {
+        inp.out_error = inp.error(line_index, "@sampler_type tag must be inside a @vs, @fs or @cs block");
         return false;
     }
     if (nullptr != cur_snippet.lookup_sampler_type_tag(tokens[1])) {
@@ -348,7 +492,58 @@ static bool validate_sampler_type_tag(const std::vector<std::string>& tokens, co
 
 }
 
-/* This parses the split input line array for custom tags (@vs, @fs, @block,
+static bool validate_vertex_format_tag(const std::vector<std::string>& tokens, const Snippet& cur_snippet, int line_index, Input& inp) {
+    if ((tokens.size() < 3) || (tokens.size() > 5)) {
+        inp.out_error = inp.error(line_index, "@vertex_format must have 2 to 4 args (@vertex_format [attr] [format] [buffer_index] [per_vertex|per_instance])");
+        return false;
+    }
+    if (cur_snippet.type != Snippet::VS) {
+        inp.out_error = inp.error(line_index, "@vertex_format tag must be inside a @vs block");
+        return false;
+    }
+    if (nullptr != cur_snippet.lookup_vertex_format_tag(tokens[1])) {
+        inp.out_error = inp.error(line_index, "duplicate @vertex_format (attribute name must be unique)");
+        return false;
+    }
+    if (!VertexFormat::is_valid_str(tokens[2])) {
+        inp.out_error = inp.error(line_index, fmt::format("second arg of @vertex_format tag must be one of {}", VertexFormat::valid_vertex_formats_as_str()));
+        return false;
+    }
+    if (tokens.size() > 3) {
+        const std::string& buf = tokens[3];
+        if ((buf.length() != 1) || (buf[0] < '0') || (buf[0] > '7')) {
+            inp.out_error = inp.error(line_index, "third arg of @vertex_format tag must be a vertex buffer index (0..7)");
+            return false;
+        }
+    }
+    if ((tokens.size() > 4) && (tokens[4] != "per_vertex") && (tokens[4] != "per_instance")) {
+        inp.out_error = inp.error(line_index, "fourth arg of @vertex_format tag must be per_vertex or per_instance");
+        return false;
+    }
+    const int buffer_index = (tokens.size() > 3) ? (tokens[3][0] - '0') : 0;
+    const bool per_instance = (tokens.size() > 4) && (tokens[4] == "per_instance");
+    for (const auto& [key, tag]: cur_snippet.vertex_format_tags) {
+        if ((tag.buffer_index == buffer_index) && (tag.per_instance != per_instance)) {
+            inp.out_error = inp.error(line_index, fmt::format("@vertex_format: conflicting step function for vertex buffer {} (see attribute '{}')", buffer_index, key));
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool validate_early_fragment_tests_tag(const std::vector<std::string>& tokens, const Snippet& cur_snippet, int line_index, Input& inp) {
+    if (tokens.size() != 1) {
+        inp.out_error = inp.error(line_index, "@early_fragment_tests tag doesn't have args");
+        return false;
+    }
+    if (cur_snippet.type != Snippet::FS) {
+        inp.out_error = inp.error(line_index, "@early_fragment_tests tag must be inside a @fs block");
+        return false;
+    }
+    return true;
+}
+
+/* This parses the split input line array for custom tags (@vs, @fs, @cs, @block,
     @end and @program), and fills the respective members. If a parsing error
     happens, the inp.error object is setup accordingly.
 */
@@ -359,9 +554,13 @@ static bool parse(Input& inp) {
     std::vector<std::string> tokens;
     int line_index = 0;
     for (const Line& line_info : inp.lines) {
-        const std::string& line = line_info.line;
+        const std::string_view line = line_info.line;
         add_line = in_snippet;
-        pystring::split(line, tokens);
+        // only lines starting with a @tag need to be split into tokens
+        tokens.clear();
+        if (is_tag_line(line)) {
+            split_tokens(line, tokens);
+        }
         if (tokens.size() > 0) {
             if (tokens[0] == module_tag) {
                 if (!validate_module_tag(tokens, in_snippet, line_index, inp)) {
@@ -392,7 +591,10 @@ static bool parse(Input& inp) {
                     uint32_t option_bit = Option::from_string(tokens[i]);
                     cur_snippet.options[Slang::GLSL410] |= option_bit;
                     cur_snippet.options[Slang::GLSL430] |= option_bit;
-                    cur_snippet.options[Slang::GLSL300ES] |= option_bit;
+                    // GLSL ES always uses flattened uniform blocks
+                    if (option_bit != Option::UNIFORM_BUFFERS) {
+                        cur_snippet.options[Slang::GLSL300ES] |= option_bit;
+                    }
                 }
                 add_line = false;
             } else if (tokens[0] == hlsl_options_tag) {
@@ -403,6 +605,7 @@ static bool parse(Input& inp) {
                     uint32_t option_bit = Option::from_string(tokens[i]);
                     cur_snippet.options[Slang::HLSL4] |= option_bit;
                     cur_snippet.options[Slang::HLSL5] |= option_bit;
+                    cur_snippet.options[Slang::HLSL6] |= option_bit;
                 }
                 add_line = false;
             } else if (tokens[0] == msl_options_tag) {
@@ -437,6 +640,13 @@ static bool parse(Input& inp) {
                 cur_snippet = Snippet(Snippet::FS, tokens[1]);
                 add_line = false;
                 in_snippet = true;
+            } else if (tokens[0] == cs_tag) {
+                if (!validate_cs_tag(tokens, in_snippet, line_index, inp)) {
+                    return false;
+                }
+                cur_snippet = Snippet(Snippet::CS, tokens[1]);
+                add_line = false;
+                in_snippet = true;
             } else if (tokens[0] == inclblock_tag) {
                 if (!validate_inclblock_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
@@ -462,6 +672,9 @@ static bool parse(Input& inp) {
                     case Snippet::FS:
                         inp.fs_map[cur_snippet.name] = cur_snippet.index;
                         break;
+                    case Snippet::CS:
+                        inp.cs_map[cur_snippet.name] = cur_snippet.index;
+                        break;
                     default: break;
                 }
                 inp.snippets.push_back(std::move(cur_snippet));
@@ -472,7 +685,19 @@ static bool parse(Input& inp) {
                 if (!validate_program_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                inp.programs[tokens[1]] = Program(tokens[1], tokens[2], tokens[3], line_index);
+                if (tokens.size() == 3) {
+                    inp.programs[tokens[1]] = Program::compute(tokens[1], tokens[2], line_index);
+                } else {
+                    inp.programs[tokens[1]] = Program(tokens[1], tokens[2], tokens[3], line_index);
+                }
+                add_line = false;
+            } else if (tokens[0] == permutation_tag) {
+                if (!validate_permutation_tag(tokens, in_snippet, line_index, inp)) {
+                    return false;
+                }
+                Program& prog = inp.programs[tokens[1]];
+                prog.features.assign(tokens.begin() + 2, tokens.end());
+                prog.permutation_line_index = line_index;
                 add_line = false;
             } else if (tokens[0] == image_sample_type_tag) {
                 if (!validate_image_sample_type_tag(tokens, cur_snippet, line_index, inp)) {
@@ -486,6 +711,26 @@ static bool parse(Input& inp) {
                 }
                 cur_snippet.sampler_type_tags[tokens[1]] = SamplerTypeTag(tokens[1], SamplerType::from_str(tokens[2]), line_index);
                 add_line = false;
+            } else if (tokens[0] == vertex_format_tag) {
+                if (!validate_vertex_format_tag(tokens, cur_snippet, line_index, inp)) {
+                    return false;
+                }
+                const int buffer_index = (tokens.size() > 3) ? (tokens[3][0] - '0') : 0;
+                const bool per_instance = (tokens.size() > 4) && (tokens[4] == "per_instance");
+                cur_snippet.vertex_format_tags[tokens[1]] = VertexFormatTag(tokens[1], VertexFormat::from_str(tokens[2]), buffer_index, per_instance, line_index);
+                add_line = false;
+            } else if (tokens[0] == early_fragment_tests_tag) {
+                if (!validate_early_fragment_tests_tag(tokens, cur_snippet, line_index, inp)) {
+                    return false;
+                }
+                // GLSL410, GLSL300ES, HLSL4 and WGSL have no way to force early fragment tests
+                cur_snippet.early_fragment_tests = true;
+                for (int i = 0; i < Slang::Num; i++) {
+                    if (Slang::has_early_fragment_tests(Slang::from_index(i))) {
+                        cur_snippet.options[i] |= Option::EARLY_FRAGMENT_TESTS;
+                    }
+                }
+                add_line = false;
             } else if (tokens[0][0] == '@') {
                 inp.out_error = inp.error(line_index, fmt::format("unknown meta tag: {}", tokens[0]));
                 return false;
@@ -505,102 +750,285 @@ static bool parse(Input& inp) {
 
 static bool validate_include_tag(const std::vector<std::string>& tokens, int line_nr, const std::string& path, Input& inp) {
     if (tokens.size() != 2) {
-        inp.out_error = ErrMsg::error(path, line_nr, "@include tag must have exactly one arg (@include filename).");
+        inp.out_error = ErrMsg::error(path, line_nr, fmt::format("{} tag must have exactly one arg ({} filename).", tokens[0], tokens[0]));
         return false;
     }
     return true;
 }
 
-static bool load_and_preprocess(const std::string& path, const std::vector<std::string>& include_dirs,
-                                Input& inp, int parent_line_index) {
+// a source file with comments removed and split into lines, loaded source
+// files are cached, so that common include files are only loaded once in
+// batch- and watch-mode, entries of modified or deleted files are dropped
+struct SourceFile {
+    FileStamp stamp;
+    bool comments_removed = false;
+    std::shared_ptr<SourceBuffer> buf;
+    std::vector<std::string_view> lines;
+};
+static std::mutex source_cache_mutex;
+static std::map<std::string, std::shared_ptr<const SourceFile>> source_cache;
+
+// load a source file or get it from the source cache, returns nullptr if the file can't be loaded,
+// files provided by an in-memory read hook bypass the source cache
+static std::shared_ptr<const SourceFile> load_source_file(const std::string& path, const IoHooks& io) {
+    std::string content;
+    if (io.read && io.read(path, content)) {
+        auto file = std::make_shared<SourceFile>();
+        file->buf = SourceBuffer::from_string(std::move(content));
+        if (file->buf->size == 0) {
+            return nullptr;
+        }
+        file->comments_removed = lex_source(file->buf->data, file->buf->size, file->lines);
+        return file;
+    }
+    const std::string key = pystring::os::path::normpath(path);
+    const FileStamp stamp = FileStamp::of(path);
+    {
+        std::lock_guard<std::mutex> lock(source_cache_mutex);
+        auto it = source_cache.find(key);
+        if (it != source_cache.end()) {
+            if (it->second->stamp == stamp) {
+                return it->second;
+            }
+            source_cache.erase(it);
+        }
+    }
+    if (!stamp.exists) {
+        return nullptr;
+    }
+    auto file = std::make_shared<SourceFile>();
+    file->stamp = stamp;
+    file->buf = SourceBuffer::load(path);
+    if (!file->buf || (file->buf->size == 0)) {
+        return nullptr;
+    }
+    // remove comments and split into lines (this writes into the source buffer)
+    file->comments_removed = lex_source(file->buf->data, file->buf->size, file->lines);
+    std::lock_guard<std::mutex> lock(source_cache_mutex);
+    source_cache[key] = file;
+    return file;
+}
+
+// drop the cache entries of all files which have been modified or deleted
+// since they were loaded, called before loading a new input file
+static void prune_source_cache() {
+    std::lock_guard<std::mutex> lock(source_cache_mutex);
+    for (auto it = source_cache.begin(); it != source_cache.end();) {
+        if (FileStamp::of(it->first) != it->second->stamp) {
+            it = source_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+static bool load_and_preprocess(const std::string& path, const std::vector<std::string>& include_dirs, const IoHooks& io,
+                                Input& inp, int parent_line_index, std::vector<int>& include_stack, bool include_once) {
     std::string path_used = path;
-    std::string str = load_file_into_str(path_used);
-    if (str.empty()) {
+    std::shared_ptr<const SourceFile> src = load_source_file(path_used, io);
+    if (!src) {
         // check include directories
         for (const std::string& include_dir : include_dirs) {
             path_used = pystring::os::path::join(include_dir, path);
-            str = load_file_into_str(path_used);
-            if (!str.empty()) {
+            src = load_source_file(path_used, io);
+            if (src) {
                 break;
             }
         }
         // failure?
-        if (str.empty()) {
-            if (inp.base_path == path) {
+        if (!src) {
+            if (include_stack.empty()) {
                 inp.out_error = ErrMsg::error(path, 0, fmt::format("Failed to open input file '{}'", path));
             } else {
-                inp.out_error = ErrMsg::error(inp.filenames.back(), parent_line_index, fmt::format("Failed to open @include file '{}'", path));
+                inp.out_error = ErrMsg::error(inp.filenames[include_stack.back()], parent_line_index, fmt::format("Failed to open @include file '{}'", path));
             }
             return false;
         }
     }
-    // check for include cycles
-    for (const std::string& filename : inp.filenames) {
-        if (filename == path_used) {
-            inp.out_error = ErrMsg::error(inp.filenames.back(), parent_line_index, fmt::format("Detected @include file cycle: '{}'", path_used));
+    // check for include cycles (a file including itself directly or indirectly),
+    // with @include_once, files which have already been included are skipped
+    const std::string norm_path = pystring::os::path::normpath(path_used);
+    for (int stack_index : include_stack) {
+        if (pystring::os::path::normpath(inp.filenames[stack_index]) == norm_path) {
+            inp.out_error = ErrMsg::error(inp.filenames[include_stack.back()], parent_line_index, fmt::format("Detected @include file cycle: '{}'", path_used));
             return false;
         }
     }
+    if (include_once) {
+        for (const std::string& filename : inp.filenames) {
+            if (pystring::os::path::normpath(filename) == norm_path) {
+                return true;
+            }
+        }
+    }
     // add to filenames
     int filename_index = (int)inp.filenames.size();
     inp.filenames.push_back(path_used);
-
-    // remove comments before splitting into lines
-    if (!remove_comments(str)) {
+    inp.sources.push_back(src->buf);
+    if (!src->comments_removed) {
         inp.out_error = ErrMsg::error(path_used, 0, fmt::format("(FIXME) Error during removing comments in '{}'", path_used));
     }
+    include_stack.push_back(filename_index);
 
-    // split source file into lines
-    int line_index = 0;
-    std::vector<std::string> lines;
-    pystring::splitlines(str, lines);
-
-    // preprocess
+    // preprocess, lines point into the source buffer, which is owned by the Input object
     std::vector<std::string> tokens;
-    for (std::string& line : lines) {
-        // look for @include tags
-        pystring::split(line, tokens);
-        if (tokens.size() > 0) {
+    int line_index = 0;
+    for (std::string_view line : src->lines) {
+        // look for @include tags, only lines starting with a @tag or
+        // '#pragma sokol' need to be split into tokens
+        if (is_tag_line(line) || is_pragma_sokol_line(line)) {
+            split_tokens(line, tokens);
             if (!normalize_pragma_sokol(tokens, line, line_index, inp)) {
                 return false;
             }
-            if (tokens[0] == include_tag) {
+            if ((tokens[0] == include_tag) || (tokens[0] == include_once_tag)) {
                 if (!validate_include_tag(tokens, line_index, path_used, inp)) {
                     return false;
                 }
-                // insert included file
+                // insert included file (a file which is included several times
+                // gets one filenames entry per include site)
                 const std::string& include_filename = tokens[1];
-                if (!load_and_preprocess(include_filename, include_dirs, inp, line_index)) {
+                if (!load_and_preprocess(include_filename, include_dirs, io, inp, line_index, include_stack, tokens[0] == include_once_tag)) {
                     return false;
                 }
-            } else {
-                // otherwise process file as normal
-                inp.lines.push_back({line, filename_index, line_index});
+                line_index++;
+                continue;
             }
-        } else {
-            // this is an empty line, but add it anyway so the error line
-            // indices are always correct
-            inp.lines.push_back({ line, filename_index, line_index});
         }
+        // otherwise process line as normal, empty lines are added too so
+        // that the error line indices are always correct
+        inp.lines.push_back({line, filename_index, line_index});
         line_index++;
     }
+    include_stack.pop_back();
+    return true;
+}
+
+// add a copy of a @vs, @fs or @cs snippet with additional defines for a @permutation
+// variant, returns the index of the new snippet or -1 on name collision
+static int add_snippet_variant(Input& inp, int snippet_index, const std::vector<std::string>& defines, const std::string& suffix) {
+    const std::string name = fmt::format("{}_{}", inp.snippets[snippet_index].name, suffix);
+    auto it = inp.snippet_map.find(name);
+    if (it != inp.snippet_map.end()) {
+        // the same snippet variant may already been created by another program's @permutation
+        const Snippet& other = inp.snippets[it->second];
+        if ((other.permutation_base == snippet_index) && (other.defines == defines)) {
+            return it->second;
+        }
+        return -1;
+    }
+    Snippet snippet = inp.snippets[snippet_index];
+    snippet.index = (int)inp.snippets.size();
+    snippet.name = name;
+    snippet.defines = defines;
+    snippet.permutation_base = snippet_index;
+    inp.snippet_map[name] = snippet.index;
+    if (snippet.type == Snippet::VS) {
+        inp.vs_map[name] = snippet.index;
+    } else if (snippet.type == Snippet::FS) {
+        inp.fs_map[name] = snippet.index;
+    } else {
+        inp.cs_map[name] = snippet.index;
+    }
+    inp.snippets.push_back(std::move(snippet));
+    return (int)inp.snippets.size() - 1;
+}
 
+// create the variant programs and snippets of each @permutation, each variant
+// is a regular program named after its enabled features, so that all variants
+// are compiled in parallel like any other program
+static bool expand_permutations(Input& inp) {
+    std::vector<std::string> base_progs;
+    for (const auto& item: inp.programs) {
+        if (!item.second.features.empty()) {
+            base_progs.push_back(item.first);
+        }
+    }
+    for (const std::string& base_name: base_progs) {
+        const Program base = inp.programs.at(base_name);
+        const int num_variants = 1 << base.features.size();
+        std::vector<std::string> variants = { base.name };
+        for (int mask = 1; mask < num_variants; mask++) {
+            std::vector<std::string> defines;
+            std::string suffix;
+            for (int i = 0; i < (int)base.features.size(); i++) {
+                if (mask & (1 << i)) {
+                    defines.push_back(base.features[i]);
+                    suffix += (suffix.empty() ? "" : "_") + pystring::lower(base.features[i]);
+                }
+            }
+            const std::string name = fmt::format("{}_{}", base.name, suffix);
+            if (base.is_compute()) {
+                const int cs_index = add_snippet_variant(inp, inp.snippet_map.at(base.cs_name), defines, suffix);
+                if ((cs_index < 0) || (inp.programs.count(name) > 0)) {
+                    inp.out_error = inp.error(base.permutation_line_index, fmt::format("@permutation variant '{}' of program '{}' collides with an existing name.", name, base.name));
+                    return false;
+                }
+                inp.programs[name] = Program::compute(name, inp.snippets[cs_index].name, base.line_index);
+                variants.push_back(name);
+                continue;
+            }
+            const int vs_index = add_snippet_variant(inp, inp.snippet_map.at(base.vs_name), defines, suffix);
+            const int fs_index = add_snippet_variant(inp, inp.snippet_map.at(base.fs_name), defines, suffix);
+            if ((vs_index < 0) || (fs_index < 0) || (inp.programs.count(name) > 0)) {
+                inp.out_error = inp.error(base.permutation_line_index, fmt::format("@permutation variant '{}' of program '{}' collides with an existing name.", name, base.name));
+                return false;
+            }
+            inp.programs[name] = Program(name, inp.snippets[vs_index].name, inp.snippets[fs_index].name, base.line_index);
+            variants.push_back(name);
+        }
+        inp.programs[base_name].variants = std::move(variants);
+    }
     return true;
 }
 
+// merge the lines of each shader snippet into a single source string, this
+// is only done once and shared by all target languages
+static void merge_snippet_sources(Input& inp) {
+    for (Snippet& snippet : inp.snippets) {
+        if (!Snippet::is_shader(snippet.type)) {
+            continue;
+        }
+        size_t len = 0;
+        for (int line_index : snippet.lines) {
+            len += inp.lines[line_index].line.length() + 1;
+        }
+        snippet.source.reserve(len);
+        for (int line_index : snippet.lines) {
+            snippet.source.append(inp.lines[line_index].line);
+            snippet.source.push_back('\n');
+        }
+    }
+}
+
+Input::Input():
+    arena(std::make_shared<std::pmr::monotonic_buffer_resource>()),
+    ctype_map(arena.get()),
+    snippet_map(arena.get()),
+    block_map(arena.get()),
+    vs_map(arena.get()),
+    fs_map(arena.get()),
+    cs_map(arena.get()),
+    programs(arena.get())
+{ }
+
 /* load file and parse into an Input object,
    check valid and error fields in returned object
 */
-Input Input::load_and_parse(const std::string& path, const std::string& module_override) {
+Input Input::load_and_parse(const std::string& path, const std::string& module_override, const IoHooks& io) {
     std::string dir;
     std::string filename;
     pystring::os::path::split(dir, filename, path);
     std::vector<std::string> include_dirs = { dir };
 
+    prune_source_cache();
     Input inp;
     inp.base_path = path;
-    if (load_and_preprocess(path, include_dirs, inp, 0)) {
-        parse(inp);
+    std::vector<int> include_stack;
+    if (load_and_preprocess(path, include_dirs, io, inp, 0, include_stack, false)) {
+        if (parse(inp) && expand_permutations(inp)) {
+            merge_snippet_sources(inp);
+        }
     }
     if (!module_override.empty()) {
         inp.module = module_override;
@@ -657,6 +1085,13 @@ void Input::dump_debug(ErrMsg::Format err_fmt) const {
             fmt::print(stderr, "    snippet {}:\n", snippet_nr++);
             fmt::print(stderr, "      name: {}\n", snippet.name);
             fmt::print(stderr, "      type: {}\n", Snippet::type_to_str(snippet.type));
+            if (snippet.permutation_base >= 0) {
+                fmt::print(stderr, "      permutation of: {}\n", snippets[snippet.permutation_base].name);
+                fmt::print(stderr, "      defines: {}\n", pystring::join(" ", snippet.defines));
+            }
+            if (snippet.early_fragment_tests) {
+                fmt::print(stderr, "      early fragment tests: true\n");
+            }
             fmt::print(stderr, "      image sample type tags:\n");
             for (const auto& [key, val]: snippet.image_sample_type_tags) {
                 fmt::print(stderr, "        {}: {} (line: {})\n", key, ImageSampleType::to_str(val.type), val.line_index);
@@ -665,6 +1100,10 @@ void Input::dump_debug(ErrMsg::Format err_fmt) const {
             for (const auto& [key, val]: snippet.sampler_type_tags) {
                 fmt::print(stderr, "        {}: {} (line: {})\n", key, SamplerType::to_str(val.type), val.line_index);
             }
+            fmt::print(stderr, "      vertex format tags:\n");
+            for (const auto& [key, val]: snippet.vertex_format_tags) {
+                fmt::print(stderr, "        {}: {} buffer={} {} (line: {})\n", key, VertexFormat::to_str(val.format), val.buffer_index, val.per_instance ? "per_instance" : "per_vertex", val.line_index);
+            }
             fmt::print(stderr, "      lines:\n");
             int line_nr = 1;
             for (int line_index : snippet.lines) {
@@ -688,15 +1127,27 @@ void Input::dump_debug(ErrMsg::Format err_fmt) const {
     for (const auto& item : fs_map) {
         fmt::print(stderr, "    {} => snippet {}\n", item.first, item.second);
     }
+    fmt::print(stderr, "  cs_map:\n");
+    for (const auto& item : cs_map) {
+        fmt::print(stderr, "    {} => snippet {}\n", item.first, item.second);
+    }
     fmt::print(stderr, "  programs:\n");
     for (const auto& item : programs) {
         const std::string& key = item.first;
         const Program& prog = item.second;
         fmt::print(stderr, "    program {}:\n", key);
         fmt::print(stderr, "      name: {}\n", prog.name);
-        fmt::print(stderr, "      vs: {}\n", prog.vs_name);
-        fmt::print(stderr, "      fs: {}\n", prog.fs_name);
+        if (prog.is_compute()) {
+            fmt::print(stderr, "      cs: {}\n", prog.cs_name);
+        } else {
+            fmt::print(stderr, "      vs: {}\n", prog.vs_name);
+            fmt::print(stderr, "      fs: {}\n", prog.fs_name);
+        }
         fmt::print(stderr, "      line_index: {}\n", prog.line_index);
+        if (!prog.features.empty()) {
+            fmt::print(stderr, "      features: {}\n", pystring::join(" ", prog.features));
+            fmt::print(stderr, "      variants: {}\n", pystring::join(" ", prog.variants));
+        }
     }
     fmt::print("\n");
 }
@@ -2,30 +2,49 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include "types/errmsg.h"
 #include "types/line.h"
 #include "types/snippet.h"
 #include "types/program.h"
+#include "types/io_hooks.h"
+#include "source_buffer.h"
 
 namespace shdc {
 
 // pre-parsed GLSL source file, with content split into snippets
 struct Input {
+    // the nodes of the name lookup tables below are allocated from a per-input arena
+    // which is released in one go (the std::string keys and values still use the
+    // default heap), the tables are only modified while parsing (on a single
+    // thread), and are read-only afterwards, the arena must be declared before
+    // the tables so that it outlives them
+    std::shared_ptr<std::pmr::monotonic_buffer_resource> arena;
     ErrMsg out_error;
     std::string base_path;              // path to base file
     std::string module;                 // optional module name
     std::vector<std::string> filenames; // all source files, base is first entry
+    std::vector<std::shared_ptr<SourceBuffer>> sources; // content of all source files, in filenames order
     std::vector<Line> lines;          // input source files split into lines
-    std::vector<Snippet> snippets;    // @block, @vs and @fs snippets
-    std::map<std::string, std::string> ctype_map;    // @ctype uniform type definitions
+    std::vector<Snippet> snippets;    // @block, @vs, @fs and @cs snippets
+    std::pmr::map<std::string, std::string> ctype_map;    // @ctype uniform type definitions
     std::vector<std::string> headers;       // @header statements
-    std::map<std::string, int> snippet_map; // name-index mapping for all code snippets
-    std::map<std::string, int> block_map;   // name-index mapping for @block snippets
-    std::map<std::string, int> vs_map;      // name-index mapping for @vs snippets
-    std::map<std::string, int> fs_map;      // name-index mapping for @fs snippets
-    std::map<std::string, Program> programs;    // all @program definitions
+    std::pmr::map<std::string, int> snippet_map; // name-index mapping for all code snippets
+    std::pmr::map<std::string, int> block_map;   // name-index mapping for @block snippets
+    std::pmr::map<std::string, int> vs_map;      // name-index mapping for @vs snippets
+    std::pmr::map<std::string, int> fs_map;      // name-index mapping for @fs snippets
+    std::pmr::map<std::string, int> cs_map;      // name-index mapping for @cs snippets
+    std::pmr::map<std::string, Program> programs;    // all @program definitions
 
-    static Input load_and_parse(const std::string& path, const std::string& module_override);
+    Input();
+    // a moved-to Input takes over the arena together with the tables, copies and
+    // assignments would leave tables behind which point into a foreign arena
+    Input(Input&&) = default;
+    Input(const Input&) = delete;
+    Input& operator=(const Input&) = delete;
+    Input& operator=(Input&&) = delete;
+    static Input load_and_parse(const std::string& path, const std::string& module_override, const IoHooks& io = IoHooks());
     ErrMsg error(int line_index, const std::string& msg) const;
     ErrMsg warning(int line_index, const std::string& msg) const;
     void dump_debug(ErrMsg::Format err_fmt) const;
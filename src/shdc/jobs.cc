@@ -0,0 +1,111 @@
+/*
+    a minimal worker thread pool
+*/
+#include "jobs.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace shdc {
+
+struct Batch {
+    const std::function<void(int)>* func = nullptr;
+    int remaining = 0;
+};
+
+struct Task {
+    Batch* batch = nullptr;
+    int index = 0;
+};
+
+struct State {
+    std::vector<std::thread> threads;
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable task_added;
+    std::condition_variable task_done;
+    bool quit = false;
+};
+
+static State state;
+
+// must be called with the state mutex locked, unlocks the mutex while running the task
+static void run_task(std::unique_lock<std::mutex>& lock) {
+    Task task = state.tasks.front();
+    state.tasks.pop_front();
+    lock.unlock();
+    (*task.batch->func)(task.index);
+    lock.lock();
+    if (--task.batch->remaining == 0) {
+        state.task_done.notify_all();
+    }
+}
+
+static void worker_func() {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (true) {
+        state.task_added.wait(lock, [] { return state.quit || !state.tasks.empty(); });
+        if (state.quit) {
+            return;
+        }
+        run_task(lock);
+    }
+}
+
+void Jobs::setup(int num_jobs) {
+    if (num_jobs <= 0) {
+        num_jobs = (int) std::thread::hardware_concurrency();
+    }
+    // the calling thread counts as one job
+    for (int i = 1; i < num_jobs; i++) {
+        state.threads.emplace_back(worker_func);
+    }
+}
+
+void Jobs::discard() {
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.quit = true;
+    }
+    state.task_added.notify_all();
+    for (std::thread& thread: state.threads) {
+        thread.join();
+    }
+    state.threads.clear();
+    state.quit = false;
+}
+
+int Jobs::num_jobs() {
+    return (int)state.threads.size() + 1;
+}
+
+void Jobs::run(int num, const std::function<void(int index)>& func) {
+    if (state.threads.empty() || (num <= 1)) {
+        for (int i = 0; i < num; i++) {
+            func(i);
+        }
+        return;
+    }
+    Batch batch;
+    batch.func = &func;
+    batch.remaining = num;
+    std::unique_lock<std::mutex> lock(state.mutex);
+    for (int i = 0; i < num; i++) {
+        state.tasks.push_back({ &batch, i });
+    }
+    state.task_added.notify_all();
+    state.task_done.notify_all();
+    // help out until all tasks of this batch have finished, this also picks up
+    // tasks of other batches, which guarantees progress for nested run() calls
+    while (batch.remaining > 0) {
+        if (!state.tasks.empty()) {
+            run_task(lock);
+        } else {
+            state.task_done.wait(lock);
+        }
+    }
+}
+
+} // namespace shdc
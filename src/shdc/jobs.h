@@ -0,0 +1,19 @@
+#pragma once
+#include <functional>
+
+namespace shdc {
+
+// a minimal worker thread pool for running independent compile jobs in parallel
+struct Jobs {
+    // start worker threads, num_jobs == 0 means one job per hardware thread
+    static void setup(int num_jobs);
+    static void discard();
+    // max number of jobs running at the same time (including the calling thread)
+    static int num_jobs();
+    // call func(index) for each index in [0, num) and wait until all calls have
+    // finished, the calling thread helps out, so run() may also be called from
+    // inside a running job
+    static void run(int num, const std::function<void(int index)>& func);
+};
+
+} // namespace shdc
@@ -1,131 +1,113 @@
 /*
     sokol-shdc main source file.
 */
+#include <thread>
+#include <chrono>
+#include "fmt/format.h"
 #include "spirv.h"
 #include "args.h"
-#include "input.h"
-#include "spirvcross.h"
-#include "bytecode.h"
-#include "reflection.h"
-#include "generators/generate.h"
+#include "compile.h"
+#include "jobs.h"
+#include "cache.h"
+#include "timings.h"
+#include "types/file_stamp.h"
 
 using namespace shdc;
-using namespace shdc::refl;
-using namespace shdc::gen;
 
-int main(int argc, const char** argv) {
-    Spirv::initialize_spirv_tools();
-
-    // parse command line args
-    const Args args = Args::parse(argc, argv);
-    if (args.debug_dump) {
-        args.dump_debug();
+// print and/or write the recorded compile phase timings, and start over
+static void report_timings(const Args& args) {
+    if (args.timings) {
+        Timings::print_summary();
     }
-    if (!args.valid) {
-        return args.exit_code;
+    if (!args.trace_json.empty()) {
+        ErrMsg err = Timings::write_trace_json(args.trace_json);
+        if (err.valid()) {
+            err.print(args.error_format);
+        }
     }
+    Timings::clear();
+}
 
-    // load the source and parse tagged blocks
-    const Input inp = Input::load_and_parse(args.input, args.module);
-    if (args.debug_dump) {
-        inp.dump_debug(args.error_format);
-    }
-    if (inp.out_error.valid()) {
-        inp.out_error.print(args.error_format);
+// compile all input files of a batch manifest in parallel, returns the process exit code
+static int compile_batch(const Args& args) {
+    std::vector<Args> batch_args;
+    if (!Args::parse_batch(args, batch_args)) {
         return 10;
     }
-
-    // compile source snippets to SPIRV blobs (multiple compilations is necessary
-    // because of conditional compilation by target language)
-    std::array<Spirv,Slang::Num> spirv;
-    for (int i = 0; i < Slang::Num; i++) {
-        Slang::Enum slang = Slang::from_index(i);
-        if (args.slang & Slang::bit(slang)) {
-            spirv[i] = Spirv::compile_glsl(inp, slang, args.defines);
-            if (args.debug_dump) {
-                spirv[i].dump_debug(inp, args.error_format);
-            }
-            if (!spirv[i].errors.empty()) {
-                bool has_errors = false;
-                for (const ErrMsg& err: spirv[i].errors) {
-                    if (err.type == ErrMsg::ERROR) {
-                        has_errors = true;
-                    }
-                    err.print(args.error_format);
-                }
-                if (has_errors) {
-                    return 10;
-                }
-            }
-            if (args.save_intermediate_spirv) {
-                if (!spirv[i].write_to_file(args, inp, slang)) {
-                    return 10;
-                }
-            }
+    std::vector<int> exit_codes(batch_args.size(), 0);
+    Jobs::run((int)batch_args.size(), [&](int i) {
+        exit_codes[i] = Compile::input(batch_args[i]);
+    });
+    for (int exit_code: exit_codes) {
+        if (exit_code != 0) {
+            return exit_code;
         }
     }
+    return 0;
+}
 
-    // cross-translate SPIRV to shader dialects
-    std::array<Spirvcross,Slang::Num> spirvcross;
-    for (int i = 0; i < Slang::Num; i++) {
-        Slang::Enum slang = Slang::from_index(i);
-        if (args.slang & Slang::bit(slang)) {
-            spirvcross[i] = Spirvcross::translate(inp, spirv[i], slang);
-            if (args.debug_dump) {
-                spirvcross[i].dump_debug(args.error_format, slang);
-            }
-            if (spirvcross[i].error.valid()) {
-                spirvcross[i].error.print(args.error_format);
-                return 10;
-            }
+// compile the input file whenever one of its source files changes,
+// this never returns, stop with Ctrl-C
+static int watch_input(const Args& args) {
+    // keep compile results in memory, so that only modified snippets must be recompiled
+    Cache::enable_memory_tier();
+    std::vector<std::string> filenames;
+    std::vector<FileStamp> stamps;
+    while (true) {
+        filenames.clear();
+        const int exit_code = Compile::input(args, &filenames);
+        report_timings(args);
+        if (exit_code == 0) {
+            fmt::print(stderr, "sokol-shdc: compiled '{}', watching for changes...\n", args.input);
         }
-    }
-
-    // compile shader-byte code if requested (HLSL / Metal)
-    std::array<Bytecode, Slang::Num> bytecode;
-    if (args.byte_code) {
-        for (int i = 0; i < Slang::Num; i++) {
-            Slang::Enum slang = Slang::from_index(i);
-            if (args.slang & Slang::bit(slang)) {
-                bytecode[i] = Bytecode::compile(args, inp, spirvcross[i], slang);
-                if (args.debug_dump) {
-                    bytecode[i].dump_debug();
-                }
-                if (!bytecode[i].errors.empty()) {
-                    bool has_errors = false;
-                    for (const ErrMsg& err: bytecode[i].errors) {
-                        if (err.type == ErrMsg::ERROR) {
-                            has_errors = true;
-                        }
-                        err.print(args.error_format);
-                    }
-                    if (has_errors) {
-                        return 10;
-                    }
+        // on error, the file list may be incomplete, but the base file is always watched
+        if (filenames.empty()) {
+            filenames.push_back(args.input);
+        }
+        stamps.clear();
+        for (const std::string& filename: filenames) {
+            stamps.push_back(FileStamp::of(filename));
+        }
+        // poll for changes
+        bool changed = false;
+        while (!changed) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            for (int i = 0; i < (int)filenames.size(); i++) {
+                if (FileStamp::of(filenames[i]) != stamps[i]) {
+                    changed = true;
                 }
             }
         }
     }
+}
 
-    // build merged Reflection info
-    const Reflection refl = Reflection::build(args, inp, spirvcross);
-    if (refl.error.valid()) {
-        refl.error.print(args.error_format);
-        return 10;
-    }
+int main(int argc, const char** argv) {
+    Spirv::initialize_spirv_tools();
+
+    // parse command line args
+    const Args args = Args::parse(argc, argv);
     if (args.debug_dump) {
-        refl.dump_debug(args.error_format);
+        args.dump_debug();
     }
-
-    // generate output files
-    const GenInput gen_input(args, inp, spirvcross, bytecode, refl);
-    ErrMsg gen_error = generate(args.output_format, gen_input);
-    if (gen_error.valid()) {
-        gen_error.print(args.error_format);
-        return 10;
+    if (!args.valid) {
+        return args.exit_code;
     }
 
-    // success
+    Jobs::setup(args.jobs);
+    Cache::setup(args.cache_dir, args.cache_url, args.cache_timeout, args.gen_version);
+    Timings::setup(args.timings || !args.trace_json.empty());
+    int exit_code;
+    if (!args.batch.empty()) {
+        exit_code = compile_batch(args);
+    } else if (args.watch) {
+        exit_code = watch_input(args);
+    } else {
+        exit_code = Compile::input(args);
+    }
+    report_timings(args);
+    Timings::discard();
+    Cache::discard();
+    Jobs::discard();
     Spirv::finalize_spirv_tools();
-    return 0;
+    return exit_code;
 }
@@ -0,0 +1,241 @@
+/*
+    minification of cross-compiled shader source code
+*/
+#include "minify.h"
+#include <ctype.h>
+#include <string.h>
+#include <set>
+#include <map>
+#include <vector>
+#include <string_view>
+#include <algorithm>
+#include "fmt/format.h"
+
+namespace shdc {
+
+using namespace refl;
+
+struct Token {
+    enum Type {
+        DIRECTIVE,      // a complete preprocessor line
+        IDENT,
+        OTHER,          // a number or a single punctuation character
+    };
+    Type type = OTHER;
+    std::string_view text;
+    bool space_before = false;
+};
+
+static bool is_ident_start(char c) {
+    return isalpha((unsigned char)c) || (c == '_');
+}
+
+static bool is_ident_char(char c) {
+    return isalnum((unsigned char)c) || (c == '_');
+}
+
+// SPIRV-Cross temporaries are named _[number]
+static bool is_temp_name(std::string_view name) {
+    if ((name.length() < 2) || (name[0] != '_')) {
+        return false;
+    }
+    for (size_t i = 1; i < name.length(); i++) {
+        if (!isdigit((unsigned char)name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// check if whitespace between two characters must be preserved
+static bool needs_space(char prev, char next) {
+    static const char* ops = "+-*/%<>=!&|^~?:";
+    const bool prev_word = is_ident_char(prev) || (prev == '.');
+    const bool next_word = is_ident_char(next) || (next == '.');
+    if (prev_word && next_word) {
+        return true;
+    }
+    return (strchr(ops, prev) != nullptr) && (strchr(ops, next) != nullptr);
+}
+
+static void tokenize(const std::string& src, std::vector<Token>& out_tokens) {
+    const size_t len = src.length();
+    size_t pos = 0;
+    bool line_start = true;
+    bool space = false;
+    while (pos < len) {
+        const char c = src[pos];
+        const char next = ((pos + 1) < len) ? src[pos + 1] : 0;
+        if (c == '\n') {
+            line_start = true;
+            space = true;
+            pos++;
+        } else if (isspace((unsigned char)c)) {
+            space = true;
+            pos++;
+        } else if ((c == '/') && (next == '/')) {
+            // winged comment, skip to end of line
+            while ((pos < len) && (src[pos] != '\n')) {
+                pos++;
+            }
+            space = true;
+        } else if ((c == '/') && (next == '*')) {
+            // block comment
+            const size_t end = src.find("*/", pos + 2);
+            pos = (end == std::string::npos) ? len : end + 2;
+            space = true;
+        } else if (line_start && (c == '#')) {
+            // preprocessor lines are kept as is
+            size_t end = src.find('\n', pos);
+            if (end == std::string::npos) {
+                end = len;
+            }
+            size_t last = end;
+            while ((last > pos) && isspace((unsigned char)src[last - 1])) {
+                last--;
+            }
+            Token tok;
+            tok.type = Token::DIRECTIVE;
+            tok.text = std::string_view(src.data() + pos, last - pos);
+            out_tokens.push_back(tok);
+            pos = end;
+        } else {
+            line_start = false;
+            const size_t start = pos;
+            Token tok;
+            if (is_ident_start(c)) {
+                tok.type = Token::IDENT;
+                while ((pos < len) && is_ident_char(src[pos])) {
+                    pos++;
+                }
+            } else if (isdigit((unsigned char)c) || ((c == '.') && isdigit((unsigned char)next))) {
+                while ((pos < len) && (is_ident_char(src[pos]) || (src[pos] == '.'))) {
+                    pos++;
+                }
+            } else {
+                pos++;
+            }
+            tok.text = std::string_view(src.data() + start, pos - start);
+            tok.space_before = space;
+            out_tokens.push_back(tok);
+            space = false;
+        }
+    }
+}
+
+// all names which are visible through reflection must not be renamed
+static void add_reflection_names(const StageReflection& refl, std::set<std::string>& names) {
+    names.insert(refl.entry_point);
+    names.insert(refl.entry_point + "0");
+    for (const StageAttr& attr: refl.inputs) {
+        names.insert(attr.name);
+    }
+    for (const StageAttr& attr: refl.outputs) {
+        names.insert(attr.name);
+    }
+    for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
+        names.insert(ub.struct_info.name);
+        names.insert(ub.inst_name);
+    }
+    for (const StorageBuffer& sbuf: refl.bindings.storage_buffers) {
+        names.insert(sbuf.struct_info.name);
+        names.insert(sbuf.inst_name);
+    }
+    for (const Image& img: refl.bindings.images) {
+        names.insert(img.name);
+    }
+    for (const Sampler& smp: refl.bindings.samplers) {
+        names.insert(smp.name);
+    }
+    for (const ImageSampler& img_smp: refl.bindings.image_samplers) {
+        names.insert(img_smp.name);
+    }
+    for (const SpecConstant& spec: refl.spec_constants) {
+        names.insert(spec.name);
+    }
+}
+
+/*
+    Remove comments and all whitespace which isn't needed to separate tokens
+    (preprocessor lines are kept on separate lines), and renumber SPIRV-Cross
+    temporaries (_1234) by frequency, so that the most often used temporaries
+    get the shortest names. Function-local names and struct members are left
+    alone.
+*/
+std::string Minify::source(const std::string& src, const StageReflection& refl) {
+    std::vector<Token> tokens;
+    tokenize(src, tokens);
+
+    // count temporaries, names used in preprocessor lines are never renamed
+    std::set<std::string> reserved;
+    add_reflection_names(refl, reserved);
+    std::map<std::string_view, int> counts;
+    std::vector<std::string_view> order;
+    for (const Token& tok: tokens) {
+        if (tok.type == Token::DIRECTIVE) {
+            size_t pos = 0;
+            while (pos < tok.text.length()) {
+                if (is_ident_start(tok.text[pos]) && ((pos == 0) || !is_ident_char(tok.text[pos-1]))) {
+                    size_t end = pos;
+                    while ((end < tok.text.length()) && is_ident_char(tok.text[end])) {
+                        end++;
+                    }
+                    reserved.insert(std::string(tok.text.substr(pos, end - pos)));
+                    pos = end;
+                } else {
+                    pos++;
+                }
+            }
+        } else if ((tok.type == Token::IDENT) && is_temp_name(tok.text)) {
+            if (counts[tok.text]++ == 0) {
+                order.push_back(tok.text);
+            }
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&counts](std::string_view a, std::string_view b) {
+        return counts[a] > counts[b];
+    });
+    std::map<std::string_view, std::string> renames;
+    int next_index = 0;
+    for (std::string_view name: order) {
+        if (reserved.count(std::string(name)) > 0) {
+            continue;
+        }
+        std::string new_name;
+        do {
+            new_name = fmt::format("_{}", next_index++);
+        } while (reserved.count(new_name) > 0);
+        renames[name] = new_name;
+    }
+
+    // write minified source
+    std::string res;
+    res.reserve(src.length());
+    for (const Token& tok: tokens) {
+        if (tok.type == Token::DIRECTIVE) {
+            if (!res.empty() && (res.back() != '\n')) {
+                res.push_back('\n');
+            }
+            res.append(tok.text);
+            res.push_back('\n');
+            continue;
+        }
+        std::string_view text = tok.text;
+        if (tok.type == Token::IDENT) {
+            auto it = renames.find(text);
+            if (it != renames.end()) {
+                text = it->second;
+            }
+        }
+        if (tok.space_before && !res.empty() && (res.back() != '\n') && needs_space(res.back(), text[0])) {
+            res.push_back(' ');
+        }
+        res.append(text);
+    }
+    if (!res.empty() && (res.back() != '\n')) {
+        res.push_back('\n');
+    }
+    return res;
+}
+
+} // namespace shdc
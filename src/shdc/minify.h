@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+#include <assert.h>
+#include "types/slang.h"
+#include "types/spirvcross_source.h"
+
+namespace shdc {
+
+// shrink cross-compiled shader source code for embedding (--minify)
+struct Minify {
+    static std::string source(const std::string& src, const refl::StageReflection& refl);
+};
+
+} // namespace shdc
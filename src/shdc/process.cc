@@ -0,0 +1,180 @@
+/*
+    run command line tools (the Metal toolchain, HLSL compilers on Linux and
+    macOS, and curl for the remote compile cache) without going through the
+    shell, so that paths and URLs are never interpreted as shell syntax
+*/
+#include "process.h"
+#include "fmt/format.h"
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <mutex>
+#include <thread>
+#include <errno.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+namespace shdc {
+
+#if defined(_WIN32)
+// quote an argument for the MSVC runtime command line parser
+static std::string quote_arg(const std::string& arg) {
+    std::string res = "\"";
+    int num_backslashes = 0;
+    for (char c: arg) {
+        if (c == '\\') {
+            num_backslashes++;
+        } else {
+            if (c == '"') {
+                // backslashes before a quote are doubled, and the quote is escaped
+                res.append(num_backslashes + 1, '\\');
+            }
+            num_backslashes = 0;
+        }
+        res += c;
+    }
+    // backslashes before the closing quote are doubled
+    res.append(num_backslashes, '\\');
+    res += '"';
+    return res;
+}
+
+int Process::run(const std::vector<std::string>& args, std::string& output, const std::string* input) {
+    if (input) {
+        output += "stdin input not supported on Windows\n";
+        return 10;
+    }
+    // _spawnvp() joins the args with spaces, but doesn't start a shell
+    std::vector<std::string> quoted_args;
+    for (const std::string& arg: args) {
+        quoted_args.push_back(quote_arg(arg));
+    }
+    std::vector<const char*> argv;
+    for (const std::string& arg: quoted_args) {
+        argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+    const intptr_t exit_code = _spawnvp(_P_WAIT, args[0].c_str(), argv.data());
+    if (exit_code < 0) {
+        output += fmt::format("failed to run '{}'\n", args[0]);
+        return 10;
+    }
+    return (int)exit_code;
+}
+#else
+// pipe creation and posix_spawn() are serialized, so that a child can't inherit
+// the pipe ends of other jobs which are created while the FD_CLOEXEC flag isn't
+// set yet (pipe2() with O_CLOEXEC isn't available on macOS)
+static std::mutex spawn_mutex;
+
+static bool cloexec_pipe(int fds[2]) {
+    if (0 != pipe(fds)) {
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+int Process::run(const std::vector<std::string>& args, std::string& output, const std::string* input) {
+    std::unique_lock<std::mutex> spawn_lock(spawn_mutex);
+    int fds[2];
+    if (!cloexec_pipe(fds)) {
+        return 10;
+    }
+    int in_fds[2] = { -1, -1 };
+    if (input && !cloexec_pipe(in_fds)) {
+        close(fds[0]);
+        close(fds[1]);
+        return 10;
+    }
+    // only the dup2() targets stay open in the child, all pipe ends are FD_CLOEXEC
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (input) {
+        posix_spawn_file_actions_adddup2(&actions, in_fds[0], STDIN_FILENO);
+    }
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDERR_FILENO);
+    std::vector<char*> argv;
+    for (const std::string& arg: args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    pid_t pid;
+    const int spawn_res = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    spawn_lock.unlock();
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (input) {
+        close(in_fds[0]);
+    }
+    if (spawn_res != 0) {
+        close(fds[0]);
+        if (input) {
+            close(in_fds[1]);
+        }
+        output += fmt::format("failed to run '{}'\n", args[0]);
+        return 10;
+    }
+    // feed stdin from a separate thread while the output is drained below, so that
+    // a tool which writes more than the pipe buffer before it has read all of its
+    // input can't deadlock, a tool which exits without reading all of its input
+    // must not kill sokol-shdc with SIGPIPE (the write fails with EPIPE instead)
+    std::thread writer;
+    if (input) {
+        #if defined(F_SETNOSIGPIPE)
+        fcntl(in_fds[1], F_SETNOSIGPIPE, 1);
+        #endif
+        const int in_fd = in_fds[1];
+        writer = std::thread([in_fd, input]() {
+            #if !defined(F_SETNOSIGPIPE)
+            // a SIGPIPE raised by write() is directed at this thread and
+            // discarded when the thread exits
+            sigset_t sigpipe_set;
+            sigemptyset(&sigpipe_set);
+            sigaddset(&sigpipe_set, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &sigpipe_set, nullptr);
+            #endif
+            size_t pos = 0;
+            while (pos < input->size()) {
+                const ssize_t num_written = write(in_fd, input->data() + pos, input->size() - pos);
+                if (num_written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    break;
+                }
+                pos += (size_t)num_written;
+            }
+            close(in_fd);
+        });
+    }
+    char buf[1024];
+    ssize_t num_bytes;
+    while (((num_bytes = read(fds[0], buf, sizeof(buf))) > 0) || ((num_bytes < 0) && (errno == EINTR))) {
+        if (num_bytes > 0) {
+            output.append(buf, (size_t)num_bytes);
+        }
+    }
+    close(fds[0]);
+    if (writer.joinable()) {
+        writer.join();
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return 10;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 10;
+}
+#endif
+
+} // namespace shdc
@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace shdc {
+
+// run command line tools without going through the shell
+struct Process {
+    // run a program (args[0], looked up in the PATH if it doesn't contain a path
+    // separator) and return its exit code, or 10 if it couldn't be started,
+    // on POSIX platforms, the combined stdout and stderr output is captured and
+    // the optional input is written to the program's stdin, on Windows, the
+    // output isn't captured and input isn't supported
+    static int run(const std::vector<std::string>& args, std::string& output, const std::string* input = nullptr);
+};
+
+} // namespace shdc
@@ -3,6 +3,9 @@
 */
 #include "reflection.h"
 #include "spirvcross.h"
+#include "pystring.h"
+#include "types/reflection/program_hasher.h"
+#include <algorithm>
 
 // workaround for Compiler.comparison_ids being protected
 class UnprotectedCompiler: spirv_cross::Compiler {
@@ -49,6 +52,12 @@ static const Type::Enum float_types[4][4] = {
     { Type::Mat3x1, Type::Mat3x2, Type::Mat3x3, Type::Mat3x4 },
     { Type::Mat4x1, Type::Mat4x2, Type::Mat4x3, Type::Mat4x4 },
 };
+static const Type::Enum half_types[4][4] = {
+    { Type::Half,    Type::Half2,   Type::Half3,   Type::Half4 },
+    { Type::Invalid, Type::Invalid, Type::Invalid, Type::Invalid },
+    { Type::Invalid, Type::Invalid, Type::Invalid, Type::Invalid },
+    { Type::Invalid, Type::Invalid, Type::Invalid, Type::Invalid },
+};
 
 
 // check that a program's vertex shader outputs match the fragment shader inputs
@@ -71,6 +80,128 @@ static ErrMsg validate_linking(const Input& inp, const Program& prog, const Prog
     return ErrMsg();
 }
 
+// apply the @vertex_format tags of a program's vertex shader to the vertex shader inputs
+static ErrMsg apply_vertex_format_tags(const Input& inp, const Program& prog, ProgramReflection& prog_refl) {
+    const Snippet& vs_snippet = inp.snippets[inp.snippet_map.at(prog.vs_name)];
+    if (vs_snippet.vertex_format_tags.empty()) {
+        return ErrMsg();
+    }
+    // the vertex stage reflection is shared with the SpirvcrossSource, modify a private copy
+    auto vs_refl = std::make_shared<StageReflection>(prog_refl.vs());
+    for (const auto& [attr_name, tag]: vs_snippet.vertex_format_tags) {
+        StageAttr* attr = nullptr;
+        for (StageAttr& inp_attr: vs_refl->inputs) {
+            if ((inp_attr.slot >= 0) && (inp_attr.name == attr_name)) {
+                attr = &inp_attr;
+                break;
+            }
+        }
+        if (nullptr == attr) {
+            return inp.error(tag.line_index, fmt::format("@vertex_format: '{}' is not an input of vertex shader '{}'", attr_name, prog.vs_name));
+        }
+        if (!VertexFormat::is_compatible(tag.format, attr->type_info.type)) {
+            return inp.error(tag.line_index, fmt::format("@vertex_format: format '{}' can't be used for vertex shader input '{}' of type '{}'",
+                VertexFormat::to_str(tag.format), attr_name, Type::type_to_glsl(attr->type_info.type)));
+        }
+        attr->format = tag.format;
+        attr->buffer_index = tag.buffer_index;
+        attr->per_instance = tag.per_instance;
+    }
+    // a vertex buffer has a single step function, this also catches inputs without
+    // @vertex_format tag (which go per-vertex into buffer 0) sharing an instanced buffer
+    for (const StageAttr& attr: vs_refl->inputs) {
+        if ((attr.slot < 0) || attr.per_instance) {
+            continue;
+        }
+        for (const auto& [attr_name, tag]: vs_snippet.vertex_format_tags) {
+            if (tag.per_instance && (tag.buffer_index == attr.buffer_index)) {
+                return inp.error(tag.line_index, fmt::format("@vertex_format: vertex buffer {} has the per-instance input '{}' and the per-vertex input '{}' in vertex shader '{}'",
+                    attr.buffer_index, attr_name, attr.name, prog.vs_name));
+            }
+        }
+    }
+    prog_refl.stages.ptrs[ShaderStage::Vertex] = vs_refl;
+    return ErrMsg();
+}
+
+// the memory layout of a uniform block or storage buffer struct, without member names
+static void add_struct_layout(ProgramHasher& hasher, const Type& type) {
+    hasher.add((int)type.type);
+    hasher.add(type.offset);
+    hasher.add(type.size);
+    hasher.add(type.align);
+    hasher.add(type.matrix_stride);
+    hasher.add(type.array_count);
+    hasher.add(type.array_stride);
+    hasher.add((int)type.struct_items.size());
+    for (const Type& item: type.struct_items) {
+        add_struct_layout(hasher, item);
+    }
+}
+
+// the bindings layout of a shader stage, only bind slots, types and formats, but
+// no resource, struct or member names
+static void add_bindings_layout(ProgramHasher& hasher, const Bindings& bindings) {
+    hasher.add((int)bindings.uniform_blocks.size());
+    for (const UniformBlock& ub: bindings.uniform_blocks) {
+        hasher.add(ub.slot);
+        hasher.add(ub.flattened ? 1 : 0);
+        add_struct_layout(hasher, ub.struct_info);
+    }
+    hasher.add((int)bindings.storage_buffers.size());
+    for (const StorageBuffer& sbuf: bindings.storage_buffers) {
+        hasher.add(sbuf.slot);
+        hasher.add(sbuf.readonly ? 1 : 0);
+        add_struct_layout(hasher, sbuf.struct_info);
+    }
+    hasher.add((int)bindings.images.size());
+    for (const Image& img: bindings.images) {
+        hasher.add(img.slot);
+        hasher.add((int)img.type);
+        hasher.add((int)img.sample_type);
+        hasher.add(img.multisampled ? 1 : 0);
+    }
+    hasher.add((int)bindings.samplers.size());
+    for (const Sampler& smp: bindings.samplers) {
+        hasher.add(smp.slot);
+        hasher.add((int)smp.type);
+    }
+    hasher.add((int)bindings.image_samplers.size());
+    for (const ImageSampler& img_smp: bindings.image_samplers) {
+        hasher.add(img_smp.slot);
+        hasher.add(bindings.find_image_by_name(img_smp.image_name)->slot);
+        hasher.add(bindings.find_sampler_by_name(img_smp.sampler_name)->slot);
+    }
+}
+
+// the layout-compatibility classes only depend on the layout relevant reflection
+// info, not on the shader code, snippet names or vertex attribute names
+static void compute_layout_classes(ProgramReflection& prog_refl) {
+    if (!prog_refl.is_compute()) {
+        ProgramHasher hasher;
+        for (const StageAttr& attr: prog_refl.vs().inputs) {
+            if (attr.slot >= 0) {
+                hasher.add(attr.slot);
+                hasher.add(attr.sem_name);
+                hasher.add(attr.sem_index);
+                hasher.add((int)attr.type_info.type);
+                hasher.add((int)attr.format);
+                hasher.add(attr.buffer_index);
+                hasher.add(attr.per_instance ? 1 : 0);
+            }
+        }
+        prog_refl.layout_classes[LayoutClass::VertexLayout] = hasher.hash;
+    }
+    ProgramHasher hasher;
+    for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+        if (prog_refl.has_stage(ShaderStage::from_index(stage_index))) {
+            hasher.add(stage_index);
+            add_bindings_layout(hasher, prog_refl.stages[stage_index].bindings);
+        }
+    }
+    prog_refl.layout_classes[LayoutClass::Bindings] = hasher.hash;
+}
+
 Reflection Reflection::build(const Args& args, const Input& inp, const std::array<Spirvcross,Slang::Num>& spirvcross_array) {
     Reflection res;
 
@@ -78,23 +209,37 @@ Reflection Reflection::build(const Args& args, const Input& inp, const std::arra
     // FIXME: we should check whether the reflection info of all compiled slangs actually matches
     for (const auto& item: inp.programs) {
         const Program& prog = item.second;
-        int vs_snippet_index = inp.snippet_map.at(prog.vs_name);
-        int fs_snippet_index = inp.snippet_map.at(prog.fs_name);
         const Slang::Enum slang = Slang::first_valid(args.slang);
         const Spirvcross& spirvcross = spirvcross_array[slang];
+        ProgramReflection prog_refl;
+        prog_refl.name = prog.name;
+
+        // compute programs only have a single stage, no linking checks needed
+        if (prog.is_compute()) {
+            const SpirvcrossSource* cs_src = spirvcross.find_source_by_snippet_index(inp.snippet_map.at(prog.cs_name));
+            assert(cs_src);
+            prog_refl.stages.ptrs[ShaderStage::Compute] = cs_src->stage_refl;
+            res.progs.push_back(prog_refl);
+            continue;
+        }
+
+        int vs_snippet_index = inp.snippet_map.at(prog.vs_name);
+        int fs_snippet_index = inp.snippet_map.at(prog.fs_name);
         const SpirvcrossSource* vs_src = spirvcross.find_source_by_snippet_index(vs_snippet_index);
         const SpirvcrossSource* fs_src = spirvcross.find_source_by_snippet_index(fs_snippet_index);
         assert(vs_src && fs_src);
-        ProgramReflection prog_refl;
-        prog_refl.name = prog.name;
-        prog_refl.stages[ShaderStage::Vertex] = vs_src->stage_refl;
-        prog_refl.stages[ShaderStage::Fragment] = fs_src->stage_refl;
+        prog_refl.stages.ptrs[ShaderStage::Vertex] = vs_src->stage_refl;
+        prog_refl.stages.ptrs[ShaderStage::Fragment] = fs_src->stage_refl;
 
         // check that the outputs of the vertex stage match the input stage
         res.error = validate_linking(inp, prog, prog_refl);
         if (res.error.valid()) {
             return res;
         }
+        res.error = apply_vertex_format_tags(inp, prog, prog_refl);
+        if (res.error.valid()) {
+            return res;
+        }
         res.progs.push_back(prog_refl);
     }
 
@@ -108,18 +253,58 @@ Reflection Reflection::build(const Args& args, const Input& inp, const std::arra
     }
 
     // create a merged set of resource bindings
-    std::vector<Bindings> snippet_bindings;
+    std::vector<const Bindings*> snippet_bindings;
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (args.slang & Slang::bit(slang)) {
             for (const SpirvcrossSource& src: spirvcross_array[i].sources) {
-                snippet_bindings.push_back(src.stage_refl.bindings);
+                snippet_bindings.push_back(&src.stage_refl->bindings);
             }
         }
     }
     res.bindings = merge_bindings(snippet_bindings, error);
     if (error.valid()) {
         res.error = inp.error(0, error.msg);
+        return res;
+    }
+
+    // programs with identical vertex input or resource binding layouts get the same
+    // layout-compatibility class, the merged bindings guarantee that same-named
+    // resources have the same definition in all programs
+    for (ProgramReflection& prog_refl: res.progs) {
+        compute_layout_classes(prog_refl);
+    }
+
+    // create a merged set of specialization constants (reflection is identical for all slangs)
+    std::vector<const StageReflection*> stage_refls;
+    for (const SpirvcrossSource& src: spirvcross_array[Slang::first_valid(args.slang)].sources) {
+        stage_refls.push_back(src.stage_refl.get());
+    }
+    res.spec_constants = merge_spec_constants(stage_refls, error);
+    if (error.valid()) {
+        res.error = inp.error(0, error.msg);
+        return res;
+    }
+
+    // optionally warn about uniform block members which are never read by a shader
+    // snippet (only for the first compiled slang, reflection is identical for all slangs)
+    if (args.warn_unused_uniforms) {
+        for (const SpirvcrossSource& src: spirvcross_array[Slang::first_valid(args.slang)].sources) {
+            res.warnings_unused_uniforms(inp, src);
+        }
+    }
+    // optionally warn about fragment shaders which disable early depth/stencil tests
+    if (args.warn_early_fragment_tests) {
+        for (const SpirvcrossSource& src: spirvcross_array[Slang::first_valid(args.slang)].sources) {
+            res.warnings_early_fragment_tests(inp, src);
+        }
+    }
+    // optionally suggest a uniform block member order with less std140 padding
+    if (args.warn_uniform_padding) {
+        std::set<std::string> seen_ubs;
+        for (const SpirvcrossSource& src: spirvcross_array[Slang::first_valid(args.slang)].sources) {
+            res.warnings_uniform_padding(inp, src, seen_ubs);
+        }
     }
     return res;
 }
@@ -185,6 +370,9 @@ Type get_type_for_attribute(const Compiler& compiler, const Resource& res_attr)
             case SPIRType::Float:
                 out.type = float_types[col_idx][vec_idx];
                 break;
+            case SPIRType::Half:
+                out.type = half_types[col_idx][vec_idx];
+                break;
             case SPIRType::Struct:
                 out.type = Type::Struct;
                 break;
@@ -195,6 +383,15 @@ Type get_type_for_attribute(const Compiler& compiler, const Resource& res_attr)
     return out;
 }
 
+// a float as literal which always has a fractional part or exponent, e.g. "1.0"
+static std::string float_literal(float val) {
+    std::string str = fmt::format("{}", val);
+    if (str.find_first_of(".en") == std::string::npos) {
+        str += ".0";
+    }
+    return str;
+}
+
 StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, const Snippet& snippet, ErrMsg& out_error) {
     out_error = ErrMsg();
     StageReflection refl;
@@ -208,9 +405,25 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
     switch (compiler.get_execution_model()) {
         case spv::ExecutionModelVertex:   refl.stage = ShaderStage::Vertex; break;
         case spv::ExecutionModelFragment: refl.stage = ShaderStage::Fragment; break;
+        case spv::ExecutionModelGLCompute: refl.stage = ShaderStage::Compute; break;
         default: refl.stage = ShaderStage::Invalid; break;
     }
     refl.stage_name = ShaderStage::to_str(refl.stage);
+    if (ShaderStage::is_cs(refl.stage)) {
+        for (uint32_t i = 0; i < 3; i++) {
+            refl.workgroup_size[i] = (int)compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, i);
+        }
+    }
+    // fragment stage conditions which disable early depth/stencil tests (discards
+    // are found by scanning the SPIRV instructions in Spirvcross::analyze())
+    if (ShaderStage::is_fs(refl.stage)) {
+        for (const BuiltInResource& res: shd_resources.builtin_outputs) {
+            if (res.builtin == spv::BuiltInFragDepth) {
+                refl.writes_frag_depth = true;
+            }
+        }
+        refl.early_fragment_tests = snippet.early_fragment_tests || compiler.get_execution_mode_bitset().get(spv::ExecutionModeEarlyFragmentTests);
+    }
 
     // find entry point
     const auto entry_points = compiler.get_entry_points_and_stages();
@@ -220,6 +433,62 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
             break;
         }
     }
+    // 16-bit types need extra compile options on some targets, and aren't supported on others
+    for (spv::Capability cap: compiler.get_declared_capabilities()) {
+        switch (cap) {
+            case spv::CapabilityFloat16:
+            case spv::CapabilityStorageUniformBufferBlock16:
+            case spv::CapabilityStorageUniform16:
+            case spv::CapabilityStoragePushConstant16:
+            case spv::CapabilityStorageInputOutput16:
+                refl.uses_16bit_types = true;
+                break;
+            default:
+                break;
+        }
+    }
+    // specialization constants, these are specialized by the target
+    // shading languages in different ways, see the documentation
+    for (const SpecializationConstant& sc: compiler.get_specialization_constants()) {
+        const SPIRConstant& constant = compiler.get_constant(sc.id);
+        const SPIRType& type = compiler.get_type(constant.constant_type);
+        SpecConstant refl_spec;
+        refl_spec.id = (int)sc.constant_id;
+        refl_spec.name = compiler.get_name(sc.id);
+        if (refl_spec.name.empty()) {
+            refl_spec.name = compiler.get_fallback_name(sc.id);
+        }
+        if ((type.vecsize == 1) && (type.columns == 1)) {
+            switch (type.basetype) {
+                case SPIRType::Boolean:
+                    refl_spec.type = Type::Bool;
+                    refl_spec.default_value = (0 != constant.scalar()) ? "true" : "false";
+                    break;
+                case SPIRType::Int:
+                    refl_spec.type = Type::Int;
+                    refl_spec.default_value = fmt::format("{}", constant.scalar_i32());
+                    break;
+                case SPIRType::UInt:
+                    refl_spec.type = Type::UInt;
+                    refl_spec.default_value = fmt::format("{}", constant.scalar());
+                    break;
+                case SPIRType::Float:
+                    refl_spec.type = Type::Float;
+                    refl_spec.default_value = float_literal(constant.scalar_f32());
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (refl_spec.type == Type::Invalid) {
+            out_error = ErrMsg::error(fmt::format("specialization constant '{}' must be a bool, int, uint or float scalar", refl_spec.name));
+            return refl;
+        }
+        refl.spec_constants.push_back(refl_spec);
+    }
+    std::sort(refl.spec_constants.begin(), refl.spec_constants.end(), [](const SpecConstant& a, const SpecConstant& b) {
+        return a.id < b.id;
+    });
     // stage inputs and outputs
     for (const Resource& res_attr: shd_resources.stage_inputs) {
         StageAttr refl_attr;
@@ -259,7 +528,20 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
         }
         // uniform blocks always have 16 byte alignment
         refl_ub.struct_info.align = 16;
-        refl.bindings.uniform_blocks.push_back(refl_ub);
+        // find the struct items which are actually read by the shader
+        std::vector<bool> active(refl_ub.struct_info.struct_items.size(), false);
+        for (const BufferRange& range: compiler.get_active_buffer_ranges(ub_res.id)) {
+            if (range.index < active.size()) {
+                active[range.index] = true;
+                refl_ub.active_size += (int)range.range;
+            }
+        }
+        for (int i = 0; i < (int)active.size(); i++) {
+            if (!active[i]) {
+                refl_ub.unused_items.push_back(i);
+            }
+        }
+        refl.bindings.add_uniform_block(refl_ub);
     }
     // storage buffers
     for (const Resource& sbuf_res: shd_resources.storage_buffers) {
@@ -275,7 +557,7 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
         if (out_error.valid()) {
             return refl;
         }
-        refl.bindings.storage_buffers.push_back(refl_sbuf);
+        refl.bindings.add_storage_buffer(refl_sbuf);
     }
 
     // (separate) images
@@ -292,7 +574,7 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
             refl_img.sample_type = spirtype_to_image_sample_type(compiler.get_type(img_type.image.type));
         }
         refl_img.multisampled = spirtype_to_image_multisampled(img_type);
-        refl.bindings.images.push_back(refl_img);
+        refl.bindings.add_image(refl_img);
     }
     // (separate) samplers
     for (const Resource& smp_res: shd_resources.separate_samplers) {
@@ -307,7 +589,7 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
         } else {
             refl_smp.type = SamplerType::FILTERING;
         }
-        refl.bindings.samplers.push_back(refl_smp);
+        refl.bindings.add_sampler(refl_smp);
     }
     // combined image samplers
     for (auto& img_smp_res: compiler.get_combined_image_samplers()) {
@@ -317,7 +599,7 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
         refl_img_smp.name = compiler.get_name(img_smp_res.combined_id);
         refl_img_smp.image_name = compiler.get_name(img_smp_res.image_id);
         refl_img_smp.sampler_name = compiler.get_name(img_smp_res.sampler_id);
-        refl.bindings.image_samplers.push_back(refl_img_smp);
+        refl.bindings.add_image_sampler(refl_img_smp);
     }
     // patch textures with overridden image-sample-types
     for (auto& img: refl.bindings.images) {
@@ -336,22 +618,16 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
     return refl;
 }
 
-const StageAttr* find_attr_by_name(const std::vector<StageAttr>& attrs, const std::string& snippet_name, const std::string& attr_name) {
-    for (const StageAttr& attr: attrs) {
-        if ((attr.name == attr_name) && (attr.snippet_name == snippet_name)) {
-            return &attr;
-        }
-    }
-    return nullptr;
-}
-
 std::vector<StageAttr> Reflection::merge_vs_inputs(const std::vector<ProgramReflection>& progs, ErrMsg& out_error) {
     std::vector<StageAttr> out_attrs;
+    // hashed (snippet_name, attr_name) => index into out_attrs
+    std::unordered_map<std::string, int> attr_index;
     out_error = ErrMsg();
     for (const ProgramReflection& prog: progs) {
         for (const StageAttr& attr: prog.vs().inputs) {
             if (attr.slot != -1) {
-                const StageAttr* other_attr = find_attr_by_name(out_attrs, attr.snippet_name, attr.name);
+                auto it = attr_index.find(attr.snippet_name + '/' + attr.name);
+                const StageAttr* other_attr = (it != attr_index.end()) ? &out_attrs[it->second] : nullptr;
                 if (other_attr) {
                     // take snippet-name into account for equality check
                     if (!attr.equals(*other_attr, true)) {
@@ -359,6 +635,7 @@ std::vector<StageAttr> Reflection::merge_vs_inputs(const std::vector<ProgramRefl
                         return std::vector<StageAttr>{};
                     }
                 } else {
+                    attr_index.emplace(attr.snippet_name + '/' + attr.name, (int)out_attrs.size());
                     out_attrs.push_back(attr);
                 }
             }
@@ -367,10 +644,30 @@ std::vector<StageAttr> Reflection::merge_vs_inputs(const std::vector<ProgramRefl
     return out_attrs;
 }
 
-Bindings Reflection::merge_bindings(const std::vector<Bindings>& in_bindings, ErrMsg& out_error) {
+std::vector<SpecConstant> Reflection::merge_spec_constants(const std::vector<const StageReflection*>& stage_refls, ErrMsg& out_error) {
+    std::vector<SpecConstant> out_specs;
+    out_error = ErrMsg();
+    for (const StageReflection* stage_refl: stage_refls) {
+        for (const SpecConstant& spec: stage_refl->spec_constants) {
+            auto it = std::find_if(out_specs.begin(), out_specs.end(), [&](const SpecConstant& other) { return other.name == spec.name; });
+            if (it != out_specs.end()) {
+                if (!spec.equals(*it)) {
+                    out_error = ErrMsg::error(fmt::format("conflicting specialization constant definitions found for '{}'", spec.name));
+                    return std::vector<SpecConstant>{};
+                }
+            } else {
+                out_specs.push_back(spec);
+            }
+        }
+    }
+    return out_specs;
+}
+
+Bindings Reflection::merge_bindings(const std::vector<const Bindings*>& in_bindings, ErrMsg& out_error) {
     Bindings out_bindings;
     out_error = ErrMsg();
-    for (const Bindings& src_bindings: in_bindings) {
+    for (const Bindings* src_bindings_ptr: in_bindings) {
+        const Bindings& src_bindings = *src_bindings_ptr;
 
         // merge identical uniform blocks
         for (const UniformBlock& ub: src_bindings.uniform_blocks) {
@@ -382,7 +679,7 @@ Bindings Reflection::merge_bindings(const std::vector<Bindings>& in_bindings, Er
                     return Bindings();
                 }
             } else {
-                out_bindings.uniform_blocks.push_back(ub);
+                out_bindings.add_uniform_block(ub);
             }
         }
 
@@ -396,7 +693,7 @@ Bindings Reflection::merge_bindings(const std::vector<Bindings>& in_bindings, Er
                     return Bindings();
                 }
             } else {
-                out_bindings.storage_buffers.push_back(sbuf);
+                out_bindings.add_storage_buffer(sbuf);
             }
         }
 
@@ -410,7 +707,7 @@ Bindings Reflection::merge_bindings(const std::vector<Bindings>& in_bindings, Er
                     return Bindings();
                 }
             } else {
-                out_bindings.images.push_back(img);
+                out_bindings.add_image(img);
             }
         }
 
@@ -424,7 +721,7 @@ Bindings Reflection::merge_bindings(const std::vector<Bindings>& in_bindings, Er
                     return Bindings();
                 }
             } else {
-                out_bindings.samplers.push_back(smp);
+                out_bindings.add_sampler(smp);
             }
         }
 
@@ -438,7 +735,7 @@ Bindings Reflection::merge_bindings(const std::vector<Bindings>& in_bindings, Er
                     return Bindings();
                 }
             } else {
-                out_bindings.image_samplers.push_back(img_smp);
+                out_bindings.add_image_sampler(img_smp);
             }
         }
     }
@@ -470,6 +767,9 @@ Type Reflection::parse_struct_item(const Compiler& compiler, const TypeID& type_
             case SPIRType::Float:
                 out.type = float_types[col_idx][vec_idx];
                 break;
+            case SPIRType::Half:
+                out.type = half_types[col_idx][vec_idx];
+                break;
             case SPIRType::Struct:
                 out.type = Type::Struct;
                 break;
@@ -487,10 +787,11 @@ Type Reflection::parse_struct_item(const Compiler& compiler, const TypeID& type_
         out.size = (int) compiler.get_declared_struct_size_runtime_array(item_base_type, 1);
     } else {
         out.size = (int) compiler.get_declared_struct_member_size(base_type, item_index);
+        const int comp_size = (item_base_type.basetype == SPIRType::Half) ? 2 : 4;
         if (item_base_type.vecsize == 3) {
-            out.align = 4 * 4;
+            out.align = comp_size * 4;
         } else {
-            out.align = 4 * item_base_type.vecsize;
+            out.align = comp_size * item_base_type.vecsize;
         }
     }
     out.is_matrix = item_base_type.columns > 1;
@@ -547,6 +848,128 @@ Type Reflection::parse_toplevel_struct(const Compiler& compiler, const Resource&
     return out;
 }
 
+void Reflection::warnings_unused_uniforms(const Input& inp, const SpirvcrossSource& src) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    for (const UniformBlock& ub: src.stage_refl->bindings.uniform_blocks) {
+        if (ub.unused_items.empty()) {
+            continue;
+        }
+        std::vector<std::string> names;
+        for (int item_index: ub.unused_items) {
+            names.push_back(fmt::format("'{}'", ub.struct_info.struct_items[item_index].name));
+        }
+        const int size = (ub.struct_info.size + 15) & ~15;
+        warnings.push_back(inp.warning(snippet.lines[0],
+            fmt::format("uniform block '{}' has members which are never read in '{}': {} ({} of {} bytes unused)",
+                ub.struct_info.name, snippet.name, pystring::join(", ", names), size - ub.active_size, size)));
+    }
+}
+
+void Reflection::warnings_early_fragment_tests(const Input& inp, const SpirvcrossSource& src) {
+    const StageReflection& refl = *src.stage_refl;
+    if (!refl.disables_early_fragment_tests()) {
+        return;
+    }
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    warnings.push_back(inp.warning(snippet.lines[0],
+        fmt::format("fragment shader '{}' disables early depth/stencil tests ({}), use @early_fragment_tests to force them if this is safe",
+            snippet.name, refl.early_fragment_tests_hazards())));
+}
+
+// std140 base alignment of the uniform types which are allowed in uniform blocks
+static int std140_align(const Type& item) {
+    if (item.array_count > 0) {
+        return 16;
+    }
+    switch (item.type) {
+        case Type::Half:
+            return 2;
+        case Type::Half2:
+            return 4;
+        case Type::Float2:
+        case Type::Int2:
+        case Type::Half3:
+        case Type::Half4:
+            return 8;
+        case Type::Float3:
+        case Type::Int3:
+        case Type::Float4:
+        case Type::Int4:
+        case Type::Mat4x4:
+            return 16;
+        default:
+            return 4;
+    }
+}
+
+// std140 size of a uniform block with the struct items in the given order, rounded up to 16 bytes
+static int std140_packed_size(const std::vector<const Type*>& items) {
+    int offset = 0;
+    for (const Type* item: items) {
+        const int align = std140_align(*item);
+        offset = ((offset + align - 1) / align) * align + item->size;
+    }
+    return (offset + 15) & ~15;
+}
+
+// a simple greedy member order which avoids most std140 holes: 16-byte items
+// first, then each 12-byte vec3 followed by a 4-byte scalar, then 8-byte items
+// and finally the remaining 4-byte scalars (the original order is kept within
+// each group)
+static std::vector<const Type*> std140_suggested_order(const std::vector<Type>& struct_items) {
+    std::vector<const Type*> items16, items12, items8, items4;
+    for (const Type& item: struct_items) {
+        const int align = std140_align(item);
+        if ((align == 16) && ((item.size % 16) == 0)) {
+            items16.push_back(&item);
+        } else if (align == 16) {
+            items12.push_back(&item);
+        } else if (align == 8) {
+            items8.push_back(&item);
+        } else {
+            items4.push_back(&item);
+        }
+    }
+    std::vector<const Type*> res = items16;
+    size_t next4 = 0;
+    for (const Type* item: items12) {
+        res.push_back(item);
+        if (next4 < items4.size()) {
+            res.push_back(items4[next4++]);
+        }
+    }
+    res.insert(res.end(), items8.begin(), items8.end());
+    res.insert(res.end(), items4.begin() + next4, items4.end());
+    return res;
+}
+
+void Reflection::warnings_uniform_padding(const Input& inp, const SpirvcrossSource& src, std::set<std::string>& seen_ubs) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    for (const UniformBlock& ub: src.stage_refl->bindings.uniform_blocks) {
+        if (!seen_ubs.insert(ub.struct_info.name).second) {
+            continue;
+        }
+        std::vector<const Type*> cur_order;
+        int used_bytes = 0;
+        for (const Type& item: ub.struct_info.struct_items) {
+            cur_order.push_back(&item);
+            used_bytes += item.size;
+        }
+        const int cur_size = std140_packed_size(cur_order);
+        const std::vector<const Type*> new_order = std140_suggested_order(ub.struct_info.struct_items);
+        const int new_size = std140_packed_size(new_order);
+        if (new_size < cur_size) {
+            std::vector<std::string> names;
+            for (const Type* item: new_order) {
+                names.push_back(fmt::format("'{}'", item->name));
+            }
+            warnings.push_back(inp.warning(snippet.lines[0],
+                fmt::format("uniform block '{}' has {} of {} bytes std140 padding, reordering the members as {} reduces its size to {} bytes",
+                    ub.struct_info.name, cur_size - used_bytes, cur_size, pystring::join(", ", names), new_size)));
+        }
+    }
+}
+
 void Reflection::dump_debug(ErrMsg::Format err_fmt) const {
     const std::string indent = "  ";
     const std::string indent2 = indent + "  ";
@@ -558,6 +981,10 @@ void Reflection::dump_debug(ErrMsg::Format err_fmt) const {
     }
     fmt::print(stderr, "{}merged bindings:\n", indent);
     bindings.dump_debug(indent2);
+    fmt::print(stderr, "{}merged spec_constants:\n", indent);
+    for (const SpecConstant& spec: spec_constants) {
+        spec.dump_debug(indent2);
+    }
     fmt::print(stderr, "{}programs:\n", indent);
     for (const auto& prog: progs) {
         prog.dump_debug(indent2);
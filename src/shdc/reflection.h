@@ -2,6 +2,7 @@
 #include <string>
 #include <array>
 #include <vector>
+#include <set>
 #include "spirv_cross.hpp"
 #include "spirvcross.h"
 #include "types/errmsg.h"
@@ -11,6 +12,7 @@
 #include "types/reflection/stage_reflection.h"
 #include "types/reflection/program_reflection.h"
 #include "types/reflection/type.h"
+#include "types/reflection/spec_constant.h"
 
 namespace shdc::refl {
 
@@ -18,7 +20,9 @@ struct Reflection {
     std::vector<ProgramReflection> progs;
     std::vector<StageAttr> unique_vs_inputs;
     Bindings bindings;
+    std::vector<SpecConstant> spec_constants;
     ErrMsg error;
+    std::vector<ErrMsg> warnings;
 
     // build merged reflection object from per-slang / per-snippet reflections, error will be in .error
     static Reflection build(const Args& args, const Input& inp, const std::array<Spirvcross,Slang::Num>& spirvcross);
@@ -31,7 +35,15 @@ private:
     // create a set of unique vertex shader inputs across all programs
     static std::vector<StageAttr> merge_vs_inputs(const std::vector<ProgramReflection>& progs, ErrMsg& out_error);
     // create a set of unique resource bindings from shader snippet input bindings
-    static Bindings merge_bindings(const std::vector<Bindings>& in_bindings, ErrMsg& out_error);
+    static Bindings merge_bindings(const std::vector<const Bindings*>& in_bindings, ErrMsg& out_error);
+    // create a set of unique specialization constants across all shader snippets
+    static std::vector<SpecConstant> merge_spec_constants(const std::vector<const StageReflection*>& stage_refls, ErrMsg& out_error);
+    // add warnings for uniform block members which are never read by a shader snippet
+    void warnings_unused_uniforms(const Input& inp, const SpirvcrossSource& src);
+    // add a warning if a fragment shader snippet disables early depth/stencil tests
+    void warnings_early_fragment_tests(const Input& inp, const SpirvcrossSource& src);
+    // add warnings for uniform blocks which would be smaller with a different member order
+    void warnings_uniform_padding(const Input& inp, const SpirvcrossSource& src, std::set<std::string>& seen_ubs);
     // parse a struct
     static Type parse_toplevel_struct(const spirv_cross::Compiler& compiler, const spirv_cross::Resource& res, ErrMsg& out_error);
     // parse a struct item
@@ -0,0 +1,78 @@
+/*
+    embeddable libshdc API
+*/
+#include "shdc.h"
+#include <assert.h>
+#include <mutex>
+#include "pystring.h"
+#include "spirv.h"
+#include "compile.h"
+#include "jobs.h"
+#include "cache.h"
+#include "timings.h"
+
+namespace shdc {
+
+static bool shdc_valid = false;
+
+void Shdc::setup(int num_jobs, const std::string& cache_dir) {
+    assert(!shdc_valid);
+    Spirv::initialize_spirv_tools();
+    Jobs::setup(num_jobs);
+    Cache::setup(cache_dir, "", 0, Args().gen_version);
+    // keep compile results in memory, so that recompiling a modified
+    // source only needs to compile the modified snippets
+    Cache::enable_memory_tier();
+    Timings::setup(false);
+    shdc_valid = true;
+}
+
+void Shdc::discard() {
+    assert(shdc_valid);
+    Timings::discard();
+    Cache::discard();
+    Jobs::discard();
+    Spirv::finalize_spirv_tools();
+    shdc_valid = false;
+}
+
+Args Shdc::args(const std::vector<std::string>& options) {
+    std::vector<const char*> argv = { "sokol-shdc" };
+    for (const std::string& opt: options) {
+        argv.push_back(opt.c_str());
+    }
+    return Args::parse((int)argv.size(), argv.data());
+}
+
+Shdc::Result Shdc::compile(const Args& args, const std::string& source, const ReadFunc& read_file) {
+    assert(shdc_valid);
+    Result res;
+    // output files and messages may be produced by parallel compile jobs
+    std::mutex mutex;
+    Args compile_args = args;
+    const std::string input_path = pystring::os::path::normpath(args.input);
+    compile_args.io.read = [&](const std::string& path, std::string& out_content) {
+        if (pystring::os::path::normpath(path) == input_path) {
+            out_content = source;
+            return true;
+        }
+        return read_file && read_file(path, out_content);
+    };
+    compile_args.io.write = [&](const std::string& path, const void* data, size_t num_bytes, bool binary) {
+        OutputFile file;
+        file.path = path;
+        file.data.assign((const uint8_t*)data, (const uint8_t*)data + num_bytes);
+        file.binary = binary;
+        std::lock_guard<std::mutex> lock(mutex);
+        res.files.push_back(std::move(file));
+        return true;
+    };
+    compile_args.io.message = [&](const ErrMsg& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        res.messages.push_back(msg);
+    };
+    res.exit_code = Compile::input(compile_args);
+    return res;
+}
+
+} // namespace shdc
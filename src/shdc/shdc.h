@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include "args.h"
+#include "types/errmsg.h"
+
+namespace shdc {
+
+// the embeddable libshdc API: compiles in-memory shader sources and returns the
+// generated files in memory, glslang and the worker threads are initialized once
+// in setup() and reused for all compile() calls
+struct Shdc {
+    struct OutputFile {
+        std::string path;               // output path as it would be written by sokol-shdc
+        std::vector<uint8_t> data;
+        bool binary = false;
+    };
+    struct Result {
+        int exit_code = 10;             // same as the sokol-shdc process exit code (0: success)
+        std::vector<OutputFile> files;
+        std::vector<ErrMsg> messages;   // errors and warnings
+    };
+    // provide the content of an @include file, return false to load it from the filesystem instead
+    typedef std::function<bool(const std::string& path, std::string& out_content)> ReadFunc;
+
+    // num_jobs: max parallel compile jobs (0: one per hardware thread), cache_dir: optional persistent compile cache
+    static void setup(int num_jobs = 0, const std::string& cache_dir = std::string());
+    static void discard();
+    // parse sokol-shdc command line options (without the program name), the
+    // --input path names the in-memory source, --output the main output file
+    static Args args(const std::vector<std::string>& options);
+    // compile an in-memory source for args.input, the args.io hooks are overridden
+    static Result compile(const Args& args, const std::string& source, const ReadFunc& read_file = nullptr);
+};
+
+} // namespace shdc
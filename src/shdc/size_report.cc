@@ -0,0 +1,176 @@
+/*
+    size of the embedded shader data (--size-report and --size-budget)
+*/
+#include "size_report.h"
+#include <stdio.h>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <string_view>
+#include "fmt/format.h"
+#include "compress.h"
+#include "generators/generator.h"
+
+namespace shdc {
+
+using namespace refl;
+
+static std::string json_escape(const std::string& str) {
+    std::string res;
+    for (char c: str) {
+        if ((c == '"') || (c == '\\')) {
+            res += '\\';
+        }
+        res += c;
+    }
+    return res;
+}
+
+// mirrors Generator::gen_shader_arrays(): identical payloads within the same
+// shared array group are only written once, by the first (slang, snippet)
+SizeReport SizeReport::build(const Args& args, const Input& inp, const std::array<Spirvcross, Slang::Num>& spirvcross, const std::array<Bytecode, Slang::Num>& bytecode) {
+    SizeReport res;
+    std::map<std::tuple<int, bool, std::string_view>, int> owners;
+    for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
+        const Slang::Enum slang = Slang::from_index(slang_idx);
+        if (0 == (args.slang & Slang::bit(slang))) {
+            continue;
+        }
+        for (int snippet_index = 0; snippet_index < (int)inp.snippets.size(); snippet_index++) {
+            if (!Snippet::is_shader(inp.snippets[snippet_index].type)) {
+                continue;
+            }
+            const SpirvcrossSource* src = spirvcross[slang].find_source_by_snippet_index(snippet_index);
+            if (!src) {
+                continue;
+            }
+            const BytecodeBlob* blob = bytecode[slang].find_blob_by_snippet_index(snippet_index);
+            Item item;
+            item.snippet_index = snippet_index;
+            item.slang = slang;
+            item.is_bytecode = blob != nullptr;
+            std::string_view payload;
+            if (blob) {
+                payload = std::string_view((const char*)blob->data.data(), blob->data.size());
+                item.payload_bytes = blob->data.size();
+            } else {
+                payload = src->source_code;
+                item.payload_bytes = src->source_code.length() + 1;
+            }
+            const int item_index = (int)res.items.size();
+            auto ins = owners.insert({ { gen::Generator::shared_array_group(slang), item.is_bytecode, payload }, item_index });
+            if (!ins.second) {
+                item.shared_with = ins.first->second;
+            } else {
+                if (args.compression == Compression::NONE) {
+                    item.stored_bytes = item.payload_bytes;
+                } else {
+                    const uint8_t* data = blob ? blob->data.data() : (const uint8_t*)src->source_code.c_str();
+                    item.stored_bytes = Compress::lz4(data, item.payload_bytes).size();
+                }
+                item.comment_bytes = args.minify ? 0 : src->source_code.length();
+                res.total_stored_bytes += item.stored_bytes;
+            }
+            res.items.push_back(item);
+        }
+    }
+    return res;
+}
+
+static void write_item(std::string& out, const Input& inp, const std::vector<SizeReport::Item>& items, const SizeReport::Item& item) {
+    const Snippet& snippet = inp.snippets[item.snippet_index];
+    out += fmt::format("            {{ \"snippet\": \"{}\", \"stage\": \"{}\", \"slang\": \"{}\", ",
+        snippet.name, Snippet::type_to_str(snippet.type), Slang::to_str(item.slang));
+    out += fmt::format("\"kind\": \"{}\", \"payload_bytes\": {}, \"stored_bytes\": {}, \"comment_bytes\": {}, ",
+        item.is_bytecode ? "bytecode" : "source", item.payload_bytes, item.stored_bytes, item.comment_bytes);
+    if (item.shared_with >= 0) {
+        const SizeReport::Item& owner = items[item.shared_with];
+        out += fmt::format("\"shared_with\": {{ \"snippet\": \"{}\", \"slang\": \"{}\" }} }}",
+            inp.snippets[owner.snippet_index].name, Slang::to_str(owner.slang));
+    } else {
+        out += "\"shared_with\": null }";
+    }
+}
+
+ErrMsg SizeReport::write_json(const Args& args, const Input& inp) const {
+    std::string out = "{\n";
+    out += fmt::format("  \"input\": \"{}\",\n", json_escape(args.reproducible_path(args.input)));
+    out += fmt::format("  \"module\": \"{}\",\n", inp.module);
+    out += fmt::format("  \"compression\": \"{}\",\n", Compression::to_str(args.compression));
+    out += fmt::format("  \"total_bytes\": {},\n", total_stored_bytes);
+    out += fmt::format("  \"budget\": {},\n", (args.size_budget > 0) ? fmt::format("{}", args.size_budget) : "null");
+
+    // per target language
+    out += "  \"slangs\": [\n";
+    bool first = true;
+    for (int i = 0; i < Slang::Num; i++) {
+        const Slang::Enum slang = Slang::from_index(i);
+        if (0 == (args.slang & Slang::bit(slang))) {
+            continue;
+        }
+        size_t source_bytes = 0;
+        size_t bytecode_bytes = 0;
+        size_t comment_bytes = 0;
+        for (const Item& item: items) {
+            if (item.slang == slang) {
+                (item.is_bytecode ? bytecode_bytes : source_bytes) += item.stored_bytes;
+                comment_bytes += item.comment_bytes;
+            }
+        }
+        out += first ? "" : ",\n";
+        first = false;
+        out += fmt::format("    {{ \"slang\": \"{}\", \"total_bytes\": {}, \"source_bytes\": {}, \"bytecode_bytes\": {}, \"comment_bytes\": {} }}",
+            Slang::to_str(slang), source_bytes + bytecode_bytes, source_bytes, bytecode_bytes, comment_bytes);
+    }
+    out += "\n  ],\n";
+
+    // per program and stage, snippets which are used by several programs are counted in each program
+    out += "  \"programs\": [\n";
+    size_t prog_index = 0;
+    for (const auto& prog_item: inp.programs) {
+        const Program& prog = prog_item.second;
+        std::vector<int> snippet_indices;
+        if (prog.is_compute()) {
+            snippet_indices.push_back(inp.snippet_map.at(prog.cs_name));
+        } else {
+            snippet_indices.push_back(inp.snippet_map.at(prog.vs_name));
+            snippet_indices.push_back(inp.snippet_map.at(prog.fs_name));
+        }
+        std::vector<const Item*> prog_items;
+        size_t prog_bytes = 0;
+        for (const Item& item: items) {
+            if (std::find(snippet_indices.begin(), snippet_indices.end(), item.snippet_index) != snippet_indices.end()) {
+                prog_items.push_back(&item);
+                prog_bytes += item.stored_bytes;
+            }
+        }
+        out += "    {\n";
+        out += fmt::format("      \"name\": \"{}\",\n", prog.name);
+        out += fmt::format("      \"total_bytes\": {},\n", prog_bytes);
+        out += "      \"stages\": [\n";
+        for (size_t i = 0; i < prog_items.size(); i++) {
+            write_item(out, inp, items, *prog_items[i]);
+            out += (i + 1 < prog_items.size()) ? ",\n" : "\n";
+        }
+        out += "      ]\n";
+        out += (++prog_index < inp.programs.size()) ? "    },\n" : "    }\n";
+    }
+    out += "  ]\n}\n";
+    FILE* fp = fopen(args.size_report.c_str(), "w");
+    if (!fp) {
+        return ErrMsg::error(args.size_report, 0, fmt::format("failed to open size report file '{}' for writing", args.size_report));
+    }
+    fwrite(out.c_str(), out.length(), 1, fp);
+    fclose(fp);
+    return ErrMsg();
+}
+
+ErrMsg SizeReport::check_budget(const Args& args, const Input& inp) const {
+    if ((args.size_budget > 0) && (total_stored_bytes > (size_t)args.size_budget)) {
+        return ErrMsg::error(inp.base_path, 0, fmt::format("embedded shader data of module '{}' is {} bytes, exceeds --size-budget={} bytes by {} bytes",
+            inp.module, total_stored_bytes, args.size_budget, total_stored_bytes - (size_t)args.size_budget));
+    }
+    return ErrMsg();
+}
+
+} // namespace shdc
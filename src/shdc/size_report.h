@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <string>
+#include <stddef.h>
+#include "args.h"
+#include "input.h"
+#include "spirvcross.h"
+#include "bytecode.h"
+#include "types/errmsg.h"
+#include "types/slang.h"
+
+namespace shdc {
+
+// size of the shader data embedded into generated files (--size-report and --size-budget)
+struct SizeReport {
+    // one shader array as written by Generator::gen_shader_arrays()
+    struct Item {
+        int snippet_index = -1;
+        Slang::Enum slang = Slang::Num;
+        bool is_bytecode = false;
+        size_t payload_bytes = 0;       // uncompressed array size (source code includes the terminating zero)
+        size_t stored_bytes = 0;        // array size as stored in the generated file (after --compress)
+        size_t comment_bytes = 0;       // size of the source code comment block (0 with --minify)
+        int shared_with = -1;           // index of the item whose identical array is used instead, or -1
+    };
+    std::vector<Item> items;
+    size_t total_stored_bytes = 0;
+
+    static SizeReport build(const Args& args, const Input& inp, const std::array<Spirvcross, Slang::Num>& spirvcross, const std::array<Bytecode, Slang::Num>& bytecode);
+    // write the report as JSON file
+    ErrMsg write_json(const Args& args, const Input& inp) const;
+    // check the total stored size against --size-budget
+    ErrMsg check_budget(const Args& args, const Input& inp) const;
+};
+
+} // namespace shdc
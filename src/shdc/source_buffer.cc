@@ -0,0 +1,43 @@
+/*
+    source file loading
+*/
+#include "source_buffer.h"
+#include <stdio.h>
+
+namespace shdc {
+
+std::shared_ptr<SourceBuffer> SourceBuffer::load(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return nullptr;
+    }
+    auto buf = std::make_shared<SourceBuffer>();
+    fseek(f, 0, SEEK_END);
+    const long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool ok = file_size >= 0;
+    if (ok && (file_size > 0)) {
+        buf->storage.resize((size_t)file_size);
+        // the file may have been truncated since ftell()
+        const size_t num_read = fread(buf->storage.data(), 1, (size_t)file_size, f);
+        buf->storage.resize(num_read);
+        ok = !ferror(f);
+    }
+    fclose(f);
+    if (!ok) {
+        return nullptr;
+    }
+    buf->data = buf->storage.data();
+    buf->size = buf->storage.size();
+    return buf;
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::from_string(std::string&& content) {
+    auto buf = std::make_shared<SourceBuffer>();
+    buf->storage.assign(content.begin(), content.end());
+    buf->data = buf->storage.data();
+    buf->size = buf->storage.size();
+    return buf;
+}
+
+} // namespace shdc
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <memory>
+#include <vector>
+
+namespace shdc {
+
+// the content of a source file, Line objects in the Input struct point into it,
+// NOTE: files are read into memory instead of being memory-mapped, a mapping
+// raises SIGBUS when the file is truncated by an in-place save (e.g. in --watch)
+struct SourceBuffer {
+    char* data = nullptr;
+    size_t size = 0;
+
+    // returns nullptr if the file can't be opened
+    static std::shared_ptr<SourceBuffer> load(const std::string& path);
+    // wrap an in-memory source
+    static std::shared_ptr<SourceBuffer> from_string(std::string&& content);
+    std::string_view view() const { return std::string_view(data, size); };
+
+private:
+    std::vector<char> storage;
+};
+
+} // namespace shdc
@@ -2,12 +2,22 @@
     compile GLSL to SPIRV, wrapper around https://github.com/KhronosGroup/glslang
 */
 #include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <set>
+#include <numeric>
 #include "spirv.h"
+#include "jobs.h"
+#include "cache.h"
+#include "timings.h"
+#include "stats.h"
+#include "types/option.h"
 #include "fmt/format.h"
 #include "pystring.h"
 #include "ShaderLang.h"
 #include "ResourceLimits.h"
 #include "GlslangToSpv.h"
+#include "spirv.hpp"
 #include "spirv-tools/libspirv.hpp"
 #include "spirv-tools/optimizer.hpp"
 
@@ -24,44 +34,64 @@ void Spirv::finalize_spirv_tools() {
 // defined at end of file
 extern const TBuiltInResource DefaultTBuiltInResource;
 
-struct MergedSource {
-    std::string src;
-    int linenr_offset = 0;
-};
+// the version statement is passed as separate source string in front of
+// the snippet source, so that error line numbers map directly to snippet lines
+static const char* version_str = "#version 450\n";
 
-/* merge shader snippet source into a single string */
-static MergedSource merge_source(const Input& inp, const Snippet& snippet, Slang::Enum slang, const std::vector<std::string>& defines) {
-    MergedSource res;
-    res.linenr_offset += 1;
-    res.src = "#version 450\n";
+/* build the glslang preamble with target-language and user defines */
+static std::string merge_preamble(Slang::Enum slang, const std::vector<std::string>& defines) {
+    // 16-bit types are always allowed in the GLSL input, unsupported
+    // target languages are rejected after SPIRV compilation
+    std::string res =
+        "#extension GL_EXT_shader_explicit_arithmetic_types_float16 : enable\n"
+        "#extension GL_EXT_shader_16bit_storage : enable\n";
     if (Slang::is_glsl(slang)) {
-        res.linenr_offset += 1;
-        res.src += "#define SOKOL_GLSL (1)\n";
+        res += "#define SOKOL_GLSL (1)\n";
     }
     if (Slang::is_hlsl(slang)) {
-        res.linenr_offset += 1;
-        res.src += "#define SOKOL_HLSL (1)\n";
+        res += "#define SOKOL_HLSL (1)\n";
+    }
+    if (slang == Slang::HLSL6) {
+        res += "#define SOKOL_HLSL6 (1)\n";
     }
     if (Slang::is_msl(slang)) {
-        res.linenr_offset += 1;
-        res.src += "#define SOKOL_MSL (1)\n";
+        res += "#define SOKOL_MSL (1)\n";
     }
     if (Slang::is_wgsl(slang)) {
-        res.linenr_offset += 1;
-        res.src += "#define SOKOL_WGSL (1)\n";
+        res += "#define SOKOL_WGSL (1)\n";
+    }
+    if (Slang::is_spirv(slang)) {
+        res += "#define SOKOL_SPIRV (1)\n";
     }
     for (const std::string& define : defines) {
-        res.linenr_offset += 1;
-        res.src += fmt::format("#define {} (1)\n", define);
+        res += fmt::format("#define {} (1)\n", define);
+    }
+    return res;
+}
+
+/* add the feature defines of @permutation variant snippets to the preamble, and
+   with the 'fs_default_precision=mediump' option, a default precision statement
+   (glslang translates mediump to RelaxedPrecision because of the Vulkan client
+   semantics, and SPIRV-Cross emits that as mediump for GLSL ES)
+*/
+static std::string merge_snippet_preamble(const std::string& preamble, const Snippet& snippet, Slang::Enum slang) {
+    std::string res = preamble;
+    for (const std::string& define : snippet.defines) {
+        res += fmt::format("#define {} (1)\n", define);
     }
-    for (int line_index : snippet.lines) {
-        res.src += fmt::format("{}\n", inp.lines[line_index].line);
+    if ((snippet.type == Snippet::FS) && (0 != (snippet.options[slang] & Option::FS_MEDIUMP))) {
+        res += "precision mediump float;\n";
     }
     return res;
 }
 
+/* the complete source as seen by glslang, only needed for debugging output */
+static std::string merged_source(const SpirvBlob& blob, const Snippet& snippet) {
+    return fmt::format("{}{}{}", version_str, blob.preamble, snippet.source);
+}
+
 /* convert a glslang info-log string to ErrMsg's and append to out_errors */
-static void infolog_to_errors(const std::string& log, const Input& inp, int snippet_index, int linenr_offset, std::vector<ErrMsg>& out_errors) {
+static void infolog_to_errors(const std::string& log, const Input& inp, int snippet_index, std::vector<ErrMsg>& out_errors) {
     /*
         format for errors is "[ERROR|WARNING]: [pos=0?]:[line]: message"
         And a last line we need to ignore: "ERROR: N compilation errors. ..."
@@ -90,8 +120,8 @@ static void infolog_to_errors(const std::string& log, const Input& inp, int snip
             if (tokens.size() >= 4) {
                 // extract line index and message
                 int snippet_line_index = atoi(tokens[2].c_str());
-                // correct for 1-based and additional #defines that had been injected in front of actual snippet source
-                snippet_line_index -= (linenr_offset + 1);
+                // correct for 1-based line numbers (the snippet source is a separate source string)
+                snippet_line_index -= 1;
                 if (snippet_line_index < 0) {
                     snippet_line_index = 0;
                 }
@@ -129,24 +159,34 @@ static void infolog_to_errors(const std::string& log, const Input& inp, int snip
     }
 }
 
+// the effective optimization level for a target language
+static OptLevel::Enum spirv_opt_level(Slang::Enum slang, OptLevel::Enum opt_level) {
+    // the performance passes may create code which is invalid in WebGL2,
+    // GLSL ES always uses the WebGL-safe size pipeline instead, WGSL
+    // always uses its own pass list (only with --wgsl-opt, otherwise
+    // the optimization level is already NONE, see Args::spirv_opt_level())
+    if (((slang == Slang::GLSL300ES) || (slang == Slang::WGSL)) && (opt_level == OptLevel::PERF)) {
+        return OptLevel::SIZE;
+    }
+    return opt_level;
+}
+
+static std::string spirv_optimize_config(Slang::Enum slang, OptLevel::Enum opt_level) {
+    opt_level = spirv_opt_level(slang, opt_level);
+    if ((slang == Slang::WGSL) && (opt_level != OptLevel::NONE)) {
+        return "opt:wgsl";
+    }
+    return fmt::format("opt:{}", OptLevel::to_str(opt_level));
+}
+
 /* this is a clone of SpvTools.cpp/SpirvToolsLegalize with better control over
     what optimization passes are run (some passes may generate shader code
     which translates to valid GLSL, but invalid WebGL GLSL - e.g. simple
     bounded for-loops are converted to what looks like an unbounded loop
     ("for (;;) { }") to WebGL
 */
-static void spirv_optimize(Slang::Enum slang, std::vector<uint32_t>& spirv) {
-    if (slang == Slang::WGSL) {
-        return;
-    }
-    spv_target_env target_env;
-    target_env = SPV_ENV_UNIVERSAL_1_2;
-    spvtools::Optimizer optimizer(target_env);
-    optimizer.SetMessageConsumer(
-        [](spv_message_level_t level, const char *source, const spv_position_t &position, const char *message) {
-            // FIXME
-        });
-
+// this conservative pass list is safe for all target languages
+static void register_size_passes(spvtools::Optimizer& optimizer) {
     optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
 /*
     optimizer.RegisterPass(spvtools::CreateMergeReturnPass());
@@ -176,6 +216,88 @@ static void spirv_optimize(Slang::Enum slang, std::vector<uint32_t>& spirv) {
     optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
     optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
     optimizer.RegisterPass(spvtools::CreateCFGCleanupPass());
+}
+
+// the performance pass list with full inlining and loop optimizations, this is
+// not safe for WebGL2 (see above), and needs to preserve unused interface
+// variables for reflection
+static void register_perf_passes(spvtools::Optimizer& optimizer) {
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateMergeReturnPass());
+    optimizer.RegisterPass(spvtools::CreateInlineExhaustivePass());
+    optimizer.RegisterPass(spvtools::CreateEliminateDeadFunctionsPass());
+    optimizer.RegisterPass(spvtools::CreatePrivateToLocalPass());
+    optimizer.RegisterPass(spvtools::CreateScalarReplacementPass());
+    optimizer.RegisterPass(spvtools::CreateLocalAccessChainConvertPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateLocalMultiStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateCCPPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateLoopUnrollPass(true));
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
+    optimizer.RegisterPass(spvtools::CreateCombineAccessChainsPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateScalarReplacementPass());
+    optimizer.RegisterPass(spvtools::CreateLocalAccessChainConvertPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateVectorDCEPass());
+    optimizer.RegisterPass(spvtools::CreateDeadInsertElimPass());
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateIfConversionPass());
+    optimizer.RegisterPass(spvtools::CreateCopyPropagateArraysPass());
+    optimizer.RegisterPass(spvtools::CreateReduceLoadSizePass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateBlockMergePass());
+    optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateBlockMergePass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateCFGCleanupPass());
+}
+
+// a subset of the size passes which only create SPIRV that's accepted by
+// Tint's SPIRV reader: no if-conversion (which may create OpSelect on
+// pointers and composites), and no passes which restructure control flow
+static void register_wgsl_passes(spvtools::Optimizer& optimizer) {
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateEliminateDeadFunctionsPass());
+    optimizer.RegisterPass(spvtools::CreateScalarReplacementPass());
+    optimizer.RegisterPass(spvtools::CreateLocalAccessChainConvertPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateDeadInsertElimPass());
+    optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+}
+
+static void spirv_optimize(Slang::Enum slang, OptLevel::Enum opt_level, std::vector<uint32_t>& spirv) {
+    opt_level = spirv_opt_level(slang, opt_level);
+    if (opt_level == OptLevel::NONE) {
+        return;
+    }
+    spv_target_env target_env;
+    target_env = (slang == Slang::HLSL6) ? SPV_ENV_UNIVERSAL_1_3 : SPV_ENV_UNIVERSAL_1_2;
+    spvtools::Optimizer optimizer(target_env);
+    optimizer.SetMessageConsumer(
+        [](spv_message_level_t level, const char *source, const spv_position_t &position, const char *message) {
+            // FIXME
+        });
+    if (slang == Slang::WGSL) {
+        register_wgsl_passes(optimizer);
+    } else if (opt_level == OptLevel::PERF) {
+        register_perf_passes(optimizer);
+    } else {
+        register_size_passes(optimizer);
+    }
 
     spvtools::OptimizerOptions spvOptOptions;
     spvOptOptions.set_run_validator(false); // The validator may run as a separate step later on
@@ -183,27 +305,49 @@ static void spirv_optimize(Slang::Enum slang, std::vector<uint32_t>& spirv) {
 }
 
 /* compile a vertex or fragment shader to SPIRV */
-static bool compile(EShLanguage stage, Slang::Enum slang, const MergedSource& source, const Input& inp, int snippet_index, Spirv& out_spirv) {
-    const char* sources[1] = { source.src.c_str() };
-    const int sourcesLen[1] = { (int) source.src.length() };
-    const char* sourcesNames[1] = { inp.base_path.c_str() };
-    const int linenr_offset = source.linenr_offset;
+static bool compile(EShLanguage stage, Slang::Enum slang, OptLevel::Enum opt_level, bool debug_info, const std::string& preamble, const Input& inp, int snippet_index, Spirv& out_spirv) {
+    // the snippet source is built once in Input and shared by all target languages
+    const Snippet& snippet = inp.snippets[snippet_index];
+    const char* sources[2] = { version_str, snippet.source.c_str() };
+    const int sourcesLen[2] = { (int) strlen(version_str), (int) snippet.source.length() };
+    const char* sourcesNames[2] = { inp.base_path.c_str(), inp.base_path.c_str() };
 
-    // compile GLSL vertex- or fragment-shader
+    // check the compile cache first, cached items have the unoptimized instruction
+    // count (for --stats) as extra word after the bytecode
+    const Cache::Key cache_key = Cache::Key("spirv").add((int)stage).add(version_str).add(preamble).add(snippet.source).add(spirv_optimize_config(slang, opt_level)).add(debug_info ? 1 : 0);
+    SpirvBlob cached_blob(snippet_index);
+    if (Cache::get(cache_key, cached_blob.bytecode) && !cached_blob.bytecode.empty()) {
+        cached_blob.num_unoptimized_instructions = (int)cached_blob.bytecode.back();
+        cached_blob.bytecode.pop_back();
+        cached_blob.preamble = preamble;
+        out_spirv.blobs.push_back(std::move(cached_blob));
+        return true;
+    }
+
+    // compile GLSL vertex- or fragment-shader, defines are passed in the preamble
+    Timings::Scope glslang_scope("glslang", snippet.name, Slang::to_str(slang));
     glslang::TShader shader(stage);
-    // FIXME: add custom defines here: compiler.addProcess(...)
-    shader.setStringsWithLengthsAndNames(sources, sourcesLen, sourcesNames, 1);
+    shader.setPreamble(preamble.c_str());
+    shader.setStringsWithLengthsAndNames(sources, sourcesLen, sourcesNames, 2);
     shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
-    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
-    shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_0);
+    // HLSL6 targets SPIRV 1.3 so that subgroup operations (which are translated
+    // to HLSL wave intrinsics) are available, the distinct SOKOL_HLSL6 define
+    // in the preamble keeps the SPIRV results of other target languages apart
+    if (slang == Slang::HLSL6) {
+        shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_1);
+        shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_3);
+    } else {
+        shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+        shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_0);
+    }
     // NOTE: where using AutoMapBinding here, but this will just throw all bindings
     // into descriptor set null, which is not what we actually want.
     // We'll fix up the bindings later before calling SPIRVCross.
     shader.setAutoMapLocations(true);
     shader.setAutoMapBindings(true);
     bool parse_success = shader.parse(GetDefaultResources(), 100, false, EShMsgDefault);
-    infolog_to_errors(shader.getInfoLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
-    infolog_to_errors(shader.getInfoDebugLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
+    infolog_to_errors(shader.getInfoLog(), inp, snippet_index, out_spirv.errors);
+    infolog_to_errors(shader.getInfoDebugLog(), inp, snippet_index, out_spirv.errors);
     if (!parse_success) {
         return false;
     }
@@ -212,14 +356,14 @@ static bool compile(EShLanguage stage, Slang::Enum slang, const MergedSource& so
     glslang::TProgram program;
     program.addShader(&shader);
     bool link_success = program.link(EShMsgDefault);
-    infolog_to_errors(program.getInfoLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
-    infolog_to_errors(program.getInfoDebugLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
+    infolog_to_errors(program.getInfoLog(), inp, snippet_index, out_spirv.errors);
+    infolog_to_errors(program.getInfoDebugLog(), inp, snippet_index, out_spirv.errors);
     if (!link_success) {
         return false;
     }
     bool map_success = program.mapIO();
-    infolog_to_errors(program.getInfoLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
-    infolog_to_errors(program.getInfoDebugLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
+    infolog_to_errors(program.getInfoLog(), inp, snippet_index, out_spirv.errors);
+    infolog_to_errors(program.getInfoDebugLog(), inp, snippet_index, out_spirv.errors);
     if (!map_success) {
         return false;
     }
@@ -230,7 +374,8 @@ static bool compile(EShLanguage stage, Slang::Enum slang, const MergedSource& so
     spv::SpvBuildLogger spv_logger;
     glslang::SpvOptions spv_options;
     // disable the optimizer passes, we'll run our own after the translation
-    spv_options.generateDebugInfo = false;
+    // with --profile-build, the OpLine debug instructions are translated into line directives
+    spv_options.generateDebugInfo = debug_info;
     spv_options.stripDebugInfo = false; // NOTE: don't set this to true as the info is needed for reflection!
     spv_options.disableOptimizer = true;
     spv_options.optimizeSize = true;
@@ -239,7 +384,7 @@ static bool compile(EShLanguage stage, Slang::Enum slang, const MergedSource& so
     spv_options.emitNonSemanticShaderDebugInfo = false;
     spv_options.emitNonSemanticShaderDebugSource = false;
     out_spirv.blobs.push_back(SpirvBlob(snippet_index));
-    out_spirv.blobs.back().source = source.src;
+    out_spirv.blobs.back().preamble = preamble;
     glslang::GlslangToSpv(*im, out_spirv.blobs.back().bytecode, &spv_logger, &spv_options);
     std::string spirv_log = spv_logger.getAllMessages();
     if (!spirv_log.empty()) {
@@ -247,34 +392,67 @@ static bool compile(EShLanguage stage, Slang::Enum slang, const MergedSource& so
         // haven't seen a case yet where this generates log messages
         fmt::print("{}", spirv_log);
     }
+    glslang_scope.end();
+    out_spirv.blobs.back().num_unoptimized_instructions = Stats::spirv_instruction_count(out_spirv.blobs.back().bytecode);
     // run optimizer passes
-    spirv_optimize(slang, out_spirv.blobs.back().bytecode);
+    Timings::Scope optimize_scope("spirv_optimize", snippet.name, Slang::to_str(slang));
+    spirv_optimize(slang, opt_level, out_spirv.blobs.back().bytecode);
+    optimize_scope.end();
+
+    // only cache results without warnings, so that warnings are reported every time
+    if (out_spirv.errors.empty()) {
+        std::vector<uint32_t> item = out_spirv.blobs.back().bytecode;
+        item.push_back((uint32_t)out_spirv.blobs.back().num_unoptimized_instructions);
+        Cache::put(cache_key, item);
+    }
     return true;
 }
 
+// all inputs which influence SPIRV generation for a target language except the
+// snippet sources (which are identical for all target languages), target languages
+// with the same key can share the same compile_glsl() result
+std::string Spirv::source_key(Slang::Enum slang, const std::vector<std::string>& defines, OptLevel::Enum opt_level) {
+    std::string key = merge_preamble(slang, defines);
+    key += spirv_optimize_config(slang, opt_level);
+    return key;
+}
+
 // compile all shader-snippets into SPIRV bytecode
-Spirv Spirv::compile_glsl(const Input& inp, Slang::Enum slang, const std::vector<std::string>& defines) {
-    Spirv out_spirv;
+Spirv Spirv::compile_glsl(const Input& inp, Slang::Enum slang, const std::vector<std::string>& defines, OptLevel::Enum opt_level, bool debug_info) {
 
-    // compile shader-snippets
-    int snippet_index = 0;
-    for (const Snippet& snippet: inp.snippets) {
+    // compile vertex-, fragment- and compute-shader snippets in parallel, each into
+    // its own Spirv object, the preamble is the same for all snippets
+    const std::string preamble = merge_preamble(slang, defines);
+    const int num_snippets = (int)inp.snippets.size();
+    std::vector<Spirv> snippet_spirv(num_snippets);
+    // NOTE: not std::vector<bool>, parallel jobs write to neighbouring items
+    std::vector<uint8_t> snippet_ok(num_snippets, 1);
+    Jobs::run(num_snippets, [&](int snippet_index) {
+        const Snippet& snippet = inp.snippets[snippet_index];
         if (snippet.type == Snippet::VS) {
             // vertex shader
-            const MergedSource src = merge_source(inp, snippet, slang, defines);
-            if (!compile(EShLangVertex, slang, src, inp, snippet_index, out_spirv)) {
-                // spirv.errors contains error list
-                return out_spirv;
-            }
+            snippet_ok[snippet_index] = compile(EShLangVertex, slang, opt_level, debug_info, merge_snippet_preamble(preamble, snippet, slang), inp, snippet_index, snippet_spirv[snippet_index]);
         } else if (snippet.type == Snippet::FS) {
             // fragment shader
-            const MergedSource src = merge_source(inp, snippet, slang, defines);
-            if (!compile(EShLangFragment, slang, src, inp, snippet_index, out_spirv)) {
-                // spirv.errors contains error list
-                return out_spirv;
-            }
+            snippet_ok[snippet_index] = compile(EShLangFragment, slang, opt_level, debug_info, merge_snippet_preamble(preamble, snippet, slang), inp, snippet_index, snippet_spirv[snippet_index]);
+        } else if (snippet.type == Snippet::CS) {
+            // compute shader
+            snippet_ok[snippet_index] = compile(EShLangCompute, slang, opt_level, debug_info, merge_snippet_preamble(preamble, snippet, slang), inp, snippet_index, snippet_spirv[snippet_index]);
+        }
+    });
+
+    // gather results in snippet order, stop at the first snippet with compile errors
+    Spirv out_spirv;
+    for (int snippet_index = 0; snippet_index < num_snippets; snippet_index++) {
+        Spirv& src = snippet_spirv[snippet_index];
+        out_spirv.errors.insert(out_spirv.errors.end(), src.errors.begin(), src.errors.end());
+        if (!snippet_ok[snippet_index]) {
+            // spirv.errors contains error list
+            return out_spirv;
+        }
+        for (SpirvBlob& blob: src.blobs) {
+            out_spirv.blobs.push_back(std::move(blob));
         }
-        snippet_index++;
     }
     // when arriving here, no compile errors occurred
     // spirv.bytecodes array contains the SPIRV-bytecode
@@ -282,6 +460,208 @@ Spirv Spirv::compile_glsl(const Input& inp, Slang::Enum slang, const std::vector
     return out_spirv;
 }
 
+// a Location-decorated Input or Output variable of a SPIRV module
+struct SpirvVarying {
+    uint32_t var_id = 0;
+    int location = -1;
+    bool read = false;      // referenced by anything else than stores (or access chains for stores)
+};
+
+static const size_t spirv_header_words = 5;
+
+// call func(word_index, opcode, num_words) for each instruction
+template<typename F> static void spirv_for_each_instruction(const std::vector<uint32_t>& words, F func) {
+    size_t i = spirv_header_words;
+    while (i < words.size()) {
+        const uint32_t num_words = words[i] >> spv::WordCountShift;
+        if ((num_words == 0) || ((i + num_words) > words.size())) {
+            break;
+        }
+        func(i, (spv::Op)(words[i] & spv::OpCodeMask), (size_t)num_words);
+        i += num_words;
+    }
+}
+
+// debug names, decorations and the entry point interface don't count as references
+static bool spirv_is_annotation(spv::Op op) {
+    return (op == spv::OpName) || (op == spv::OpEntryPoint) || (op == spv::OpDecorate)
+        || (op == spv::OpDecorateId) || (op == spv::OpDecorateString) || (op == spv::OpMemberDecorate);
+}
+
+// find all Location-decorated variables of a storage class, variables are considered read
+// if they (or access chains into them) are used other than as the pointer of an OpStore,
+// operands are compared as raw words, so literals may cause false positives (which only
+// prevents pruning)
+static std::vector<SpirvVarying> spirv_find_varyings(const std::vector<uint32_t>& words, spv::StorageClass storage_class) {
+    std::map<uint32_t, int> locations;
+    spirv_for_each_instruction(words, [&](size_t i, spv::Op op, size_t num_words) {
+        if ((op == spv::OpDecorate) && (num_words >= 4) && (words[i + 2] == spv::DecorationLocation)) {
+            locations[words[i + 1]] = (int)words[i + 3];
+        }
+    });
+    std::vector<SpirvVarying> res;
+    // access chain result id => varying index
+    std::map<uint32_t, size_t> chains;
+    spirv_for_each_instruction(words, [&](size_t i, spv::Op op, size_t num_words) {
+        if ((op == spv::OpVariable) && (num_words >= 4) && (words[i + 3] == (uint32_t)storage_class)) {
+            auto it = locations.find(words[i + 2]);
+            if (it != locations.end()) {
+                SpirvVarying var;
+                var.var_id = words[i + 2];
+                var.location = it->second;
+                chains[var.var_id] = res.size();
+                res.push_back(var);
+            }
+        }
+    });
+    spirv_for_each_instruction(words, [&](size_t i, spv::Op op, size_t num_words) {
+        if (spirv_is_annotation(op) || (op == spv::OpVariable)) {
+            return;
+        }
+        const bool is_chain = ((op == spv::OpAccessChain) || (op == spv::OpInBoundsAccessChain)) && (num_words >= 4);
+        for (size_t operand = 1; operand < num_words; operand++) {
+            auto it = chains.find(words[i + operand]);
+            if (it == chains.end()) {
+                continue;
+            }
+            if (is_chain && (operand == 3)) {
+                chains[words[i + 2]] = it->second;
+            } else if (!((op == spv::OpStore) && (operand == 1))) {
+                res[it->second].read = true;
+            }
+        }
+    });
+    return res;
+}
+
+// remove variables, their stores, access chains, decorations and entry point interface items,
+// the computation which only fed the removed stores is left to the dead code elimination
+static void spirv_remove_varyings(std::vector<uint32_t>& words, const std::set<uint32_t>& var_ids) {
+    std::set<uint32_t> ids = var_ids;
+    spirv_for_each_instruction(words, [&](size_t i, spv::Op op, size_t num_words) {
+        if (((op == spv::OpAccessChain) || (op == spv::OpInBoundsAccessChain)) && (num_words >= 4) && ids.count(words[i + 3])) {
+            ids.insert(words[i + 2]);
+        }
+    });
+    std::vector<uint32_t> res(words.begin(), words.begin() + spirv_header_words);
+    spirv_for_each_instruction(words, [&](size_t i, spv::Op op, size_t num_words) {
+        bool remove = false;
+        switch (op) {
+            case spv::OpName:
+            case spv::OpDecorate:
+            case spv::OpDecorateId:
+            case spv::OpDecorateString:
+            case spv::OpMemberDecorate:
+            case spv::OpStore:
+                remove = ids.count(words[i + 1]) > 0;
+                break;
+            case spv::OpVariable:
+            case spv::OpAccessChain:
+            case spv::OpInBoundsAccessChain:
+                remove = ids.count(words[i + 2]) > 0;
+                break;
+            case spv::OpEntryPoint: {
+                // execution model, entry point id, name string (zero-terminated and padded), interface ids
+                size_t interface_start = 3;
+                while ((interface_start < num_words) && ((words[i + interface_start] >> 24) != 0)) {
+                    interface_start++;
+                }
+                interface_start++;
+                const size_t start = res.size();
+                res.insert(res.end(), words.begin() + i, words.begin() + i + std::min(interface_start, num_words));
+                for (size_t operand = interface_start; operand < num_words; operand++) {
+                    if (!ids.count(words[i + operand])) {
+                        res.push_back(words[i + operand]);
+                    }
+                }
+                res[start] = ((uint32_t)(res.size() - start) << spv::WordCountShift) | spv::OpEntryPoint;
+                return;
+            }
+            default:
+                break;
+        }
+        if (!remove) {
+            res.insert(res.end(), words.begin() + i, words.begin() + i + num_words);
+        }
+    });
+    words = std::move(res);
+}
+
+// prune vertex shader outputs which aren't read by any fragment shader they are linked with, and
+// the matching unread fragment shader inputs, programs which share a vertex or fragment shader are
+// pruned together so that the vertex shader outputs still exactly match the fragment shader inputs
+void Spirv::link_programs(const Input& inp, Slang::Enum slang, OptLevel::Enum opt_level) {
+    if (spirv_opt_level(slang, opt_level) == OptLevel::NONE) {
+        return;
+    }
+    std::map<int, size_t> blob_index;
+    for (size_t i = 0; i < blobs.size(); i++) {
+        blob_index[blobs[i].snippet_index] = i;
+    }
+    // group linked snippets (union-find over snippet indices)
+    std::vector<int> group(inp.snippets.size());
+    std::iota(group.begin(), group.end(), 0);
+    auto find_group = [&](int snippet_index) {
+        while (group[snippet_index] != snippet_index) {
+            snippet_index = group[snippet_index] = group[group[snippet_index]];
+        }
+        return snippet_index;
+    };
+    std::set<int> linked;
+    for (const auto& item: inp.programs) {
+        const Program& prog = item.second;
+        if (!prog.is_compute()) {
+            const int vs_index = inp.snippet_map.at(prog.vs_name);
+            const int fs_index = inp.snippet_map.at(prog.fs_name);
+            group[find_group(vs_index)] = find_group(fs_index);
+            linked.insert(vs_index);
+            linked.insert(fs_index);
+        }
+    }
+    // snippets which aren't used by any program are left alone
+    std::map<size_t, std::vector<SpirvVarying>> varyings;
+    for (const auto& [snippet_index, index]: blob_index) {
+        if (!linked.count(snippet_index)) {
+            continue;
+        }
+        const Snippet::Type type = inp.snippets[snippet_index].type;
+        if (type == Snippet::VS) {
+            varyings[index] = spirv_find_varyings(blobs[index].bytecode, spv::StorageClassOutput);
+        } else if (type == Snippet::FS) {
+            varyings[index] = spirv_find_varyings(blobs[index].bytecode, spv::StorageClassInput);
+        }
+    }
+    // a location can be pruned in a group if no fragment shader reads it, and
+    // no vertex shader reads back its output
+    std::map<int, std::set<int>> live_locations;
+    for (const auto& [index, vars]: varyings) {
+        const int grp = find_group(blobs[index].snippet_index);
+        for (const SpirvVarying& var: vars) {
+            if (var.read) {
+                live_locations[grp].insert(var.location);
+            }
+        }
+    }
+    for (auto& [index, vars]: varyings) {
+        const std::set<int>& live = live_locations[find_group(blobs[index].snippet_index)];
+        std::set<uint32_t> dead_ids;
+        for (const SpirvVarying& var: vars) {
+            if (!live.count(var.location)) {
+                dead_ids.insert(var.var_id);
+            }
+        }
+        if (dead_ids.empty()) {
+            continue;
+        }
+        SpirvBlob& blob = blobs[index];
+        spirv_remove_varyings(blob.bytecode, dead_ids);
+        if (inp.snippets[blob.snippet_index].type == Snippet::VS) {
+            // remove the vertex shader computation which only fed the pruned outputs
+            spirv_optimize(slang, opt_level, blob.bytecode);
+        }
+    }
+}
+
 bool Spirv::write_to_file(const Args& args, const Input& inp, Slang::Enum slang) {
     std::string base_dir;
     std::string base_filename;
@@ -304,7 +684,8 @@ bool Spirv::write_to_file(const Args& args, const Input& inp, Slang::Enum slang)
             const std::string path = fmt::format("{}{}.glsl", base_path, snippet.name);
             FILE* fp = fopen(path.c_str(), "w");
             if (fp) {
-                fwrite(blob.source.c_str(), 1, blob.source.length(), fp);
+                const std::string source = merged_source(blob, snippet);
+                fwrite(source.c_str(), 1, source.length(), fp);
                 fclose(fp);
             } else {
                 fmt::print("Failed to open '{}' for writing!\n", path);
@@ -329,14 +710,15 @@ void Spirv::dump_debug(const Input& inp, ErrMsg::Format err_fmt) const {
     for (const SpirvBlob& blob : blobs) {
         fmt::print(stderr, "  source for snippet '{}':\n", inp.snippets[blob.snippet_index].name);
         std::vector<std::string> src_lines;
-        pystring::splitlines(blob.source, src_lines);
+        pystring::splitlines(merged_source(blob, inp.snippets[blob.snippet_index]), src_lines);
         for (const std::string& src_line: src_lines) {
             fmt::print(stderr, "    {}\n", src_line);
         }
         fmt::print(stderr, "\n");
 
         fmt::print(stderr, "  SPIR-V for snippet '{}':\n", inp.snippets[blob.snippet_index].name);
-        spvtools::SpirvTools spirv_tools(SPV_ENV_OPENGL_4_5);
+        // NOTE: the universal 1.3 env also accepts the SPIRV 1.3 blobs of the HLSL6 target
+        spvtools::SpirvTools spirv_tools(SPV_ENV_UNIVERSAL_1_3);
         std::string dasm_str;
         spirv_tools.Disassemble(blob.bytecode, &dasm_str, spvtools::SpirvTools::kDefaultDisassembleOption);
         std::vector<std::string> dasm_lines;
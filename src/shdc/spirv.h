@@ -6,6 +6,7 @@
 #include "types/errmsg.h"
 #include "types/spirv_blob.h"
 #include "types/slang.h"
+#include "types/opt_level.h"
 
 namespace shdc {
 
@@ -16,7 +17,10 @@ struct Spirv {
 
     static void initialize_spirv_tools();
     static void finalize_spirv_tools();
-    static Spirv compile_glsl(const Input& inp, Slang::Enum slang, const std::vector<std::string>& defines);
+    static std::string source_key(Slang::Enum slang, const std::vector<std::string>& defines, OptLevel::Enum opt_level);
+    static Spirv compile_glsl(const Input& inp, Slang::Enum slang, const std::vector<std::string>& defines, OptLevel::Enum opt_level, bool debug_info);
+    // program-level link step, prunes varyings which no linked fragment shader reads
+    void link_programs(const Input& inp, Slang::Enum slang, OptLevel::Enum opt_level);
     bool write_to_file(const Args& args, const Input& inp, Slang::Enum slang);
     void dump_debug(const Input& inp, ErrMsg::Format err_fmt) const;
 };
@@ -5,12 +5,19 @@
 */
 #include "spirvcross.h"
 #include "reflection.h"
+#include "jobs.h"
+#include "cache.h"
+#include "timings.h"
+#include "stats.h"
 #include "types/option.h"
+#include "types/msl_argument_buffer.h"
+#include "types/bind_slots.h"
 #include "fmt/format.h"
 #include "pystring.h"
 #include "spirv_hlsl.hpp"
 #include "spirv_msl.hpp"
 #include "spirv_reflect.hpp"
+#include "spirv-tools/libspirv.hpp"
 #include "tint/tint.h"
 
 #include "spirv_glsl.hpp"
@@ -30,15 +37,26 @@ const SpirvcrossSource* Spirvcross::find_source_by_snippet_index(int snippet_ind
     return nullptr;
 }
 
-static void fix_bind_slots(Compiler& compiler, Snippet::Type type, Slang::Enum slang) {
+// assigns bind slots in declaration order per snippet, or from the module-wide
+// bind slot table with --module-bind-slots
+static void fix_bind_slots(Compiler& compiler, Snippet::Type type, Slang::Enum slang, const BindSlots& bind_slots) {
     ShaderResources shader_resources = compiler.get_shader_resources();
+    auto set_binding = [&](const Resource& res, BindSlots::Kind kind, uint32_t base, uint32_t& inout_binding) {
+        uint32_t binding = inout_binding++;
+        if (bind_slots.enabled) {
+            const int slot = bind_slots.find(type, kind, res.name);
+            assert(slot >= 0);
+            binding = base + (uint32_t)slot;
+        }
+        compiler.set_decoration(res.id, spv::DecorationDescriptorSet, 0);
+        compiler.set_decoration(res.id, spv::DecorationBinding, binding);
+    };
 
     // uniform buffers
     {
         uint32_t binding = 0;
         for (const Resource& res: shader_resources.uniform_buffers) {
-            compiler.set_decoration(res.id, spv::DecorationDescriptorSet, 0);
-            compiler.set_decoration(res.id, spv::DecorationBinding, binding++);
+            set_binding(res, BindSlots::UNIFORM_BLOCK, 0, binding);
         }
     }
 
@@ -55,8 +73,7 @@ static void fix_bind_slots(Compiler& compiler, Snippet::Type type, Slang::Enum s
     {
         uint32_t binding = 0;
         for (const Resource& res: shader_resources.separate_images) {
-            compiler.set_decoration(res.id, spv::DecorationDescriptorSet, 0);
-            compiler.set_decoration(res.id, spv::DecorationBinding, binding++);
+            set_binding(res, BindSlots::IMAGE, 0, binding);
         }
     }
 
@@ -64,40 +81,41 @@ static void fix_bind_slots(Compiler& compiler, Snippet::Type type, Slang::Enum s
     {
         uint32_t binding = 0;
         for (const Resource& res: shader_resources.separate_samplers) {
-            compiler.set_decoration(res.id, spv::DecorationDescriptorSet, 0);
-            compiler.set_decoration(res.id, spv::DecorationBinding, binding++);
+            set_binding(res, BindSlots::SAMPLER, 0, binding);
         }
     }
 
     // storage buffers
     {
-        uint32_t binding;
+        uint32_t base;
         if (Slang::is_msl(slang)) {
             // in Metal, on the vertex stage, storage buffers are bound after uniform- and vertex-buffers,
-            // and on the fragment stage, after the uniform buffers
-            binding = Snippet::is_vs(type) ? 12 : 4;
+            // and on the fragment and compute stage, after the uniform buffers
+            base = Snippet::is_vs(type) ? 12 : 4;
         } else if (Slang::is_hlsl(slang)) {
             // in D3D11, storage buffers share bind slots with textures, put textures into
             // the first 16 slots, and storage buffers starting at slot 16
-            binding = 16;
+            base = 16;
         } else if (Slang::is_glsl(slang)) {
             // in GL, the shader stages share a common bind space, need to offset
-            // fragment bindings
-            binding = Snippet::is_vs(type) ? 0 : 8;
+            // fragment bindings (compute programs only have a single stage)
+            base = Snippet::is_fs(type) ? 8 : 0;
         } else {
-            binding = 0;
+            base = 0;
         }
+        uint32_t binding = base;
         for (const Resource& res: shader_resources.storage_buffers) {
-            compiler.set_decoration(res.id, spv::DecorationDescriptorSet, 0);
-            compiler.set_decoration(res.id, spv::DecorationBinding, binding++);
+            set_binding(res, BindSlots::STORAGE_BUFFER, base, binding);
         }
     }
 }
 
 // This directly patches the descriptor set and bindslot decorators in the input SPIRV
 // via SPIRVCross helper functions. This patched SPIRV is then used as input to Tint
-// for the SPIRV-to-WGSL translation.
-static void wgsl_patch_bind_slots(Compiler& compiler, Snippet::Type type, std::vector<uint32_t>& inout_bytecode) {
+// for the SPIRV-to-WGSL translation, and is the output of the SPIRV target (where
+// bindgroups are Vulkan descriptor sets). Must be called after fix_bind_slots(), the
+// bind slots are added to the per-stage binding offsets.
+static void patch_bind_slots(Compiler& compiler, Snippet::Type type, std::vector<uint32_t>& inout_bytecode) {
     ShaderResources shader_resources = compiler.get_shader_resources();
 
     // WGPU bindgroups and binding offsets are hardwired:
@@ -111,6 +129,7 @@ static void wgsl_patch_bind_slots(Compiler& compiler, Snippet::Type type, std::v
     //      - fragment stage image bindings start at 48
     //      - fragment stage sampler bindings start at 64
     //      - fragment stage storage buffer bindings start at 80
+    //  - compute programs only have a single stage and use the vertex stage offsets
     const uint32_t wgsl_vs_ub_bind_offset = 0;
     const uint32_t wgsl_fs_ub_bind_offset = 4;
     const uint32_t wgsl_vs_img_bind_offset = 0;
@@ -122,10 +141,10 @@ static void wgsl_patch_bind_slots(Compiler& compiler, Snippet::Type type, std::v
 
     const uint32_t ub_bindgroup = 0;
     const uint32_t res_bindgroup = 1;
-    uint32_t cur_ub_binding = Snippet::is_vs(type) ? wgsl_vs_ub_bind_offset : wgsl_fs_ub_bind_offset;
-    uint32_t cur_image_binding = Snippet::is_vs(type) ? wgsl_vs_img_bind_offset : wgsl_fs_img_bind_offset;
-    uint32_t cur_sampler_binding = Snippet::is_vs(type) ? wgsl_vs_smp_bind_offset : wgsl_fs_smp_bind_offset;
-    uint32_t cur_sbuf_binding = Snippet::is_vs(type) ? wgsl_vs_sbuf_bind_offset : wgsl_fs_sbuf_bind_offset;
+    const uint32_t base_ub_binding = Snippet::is_fs(type) ? wgsl_fs_ub_bind_offset : wgsl_vs_ub_bind_offset;
+    const uint32_t base_image_binding = Snippet::is_fs(type) ? wgsl_fs_img_bind_offset : wgsl_vs_img_bind_offset;
+    const uint32_t base_sampler_binding = Snippet::is_fs(type) ? wgsl_fs_smp_bind_offset : wgsl_vs_smp_bind_offset;
+    const uint32_t base_sbuf_binding = Snippet::is_fs(type) ? wgsl_fs_sbuf_bind_offset : wgsl_vs_sbuf_bind_offset;
 
 
     // uniform buffers
@@ -138,8 +157,7 @@ static void wgsl_patch_bind_slots(Compiler& compiler, Snippet::Type type, std::v
                 // FIXME handle error
             }
             if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                inout_bytecode[out_offset] = cur_ub_binding;
-                cur_ub_binding += 1;
+                inout_bytecode[out_offset] = base_ub_binding + compiler.get_decoration(res.id, spv::DecorationBinding);
             } else {
                 // FIXME: handle error
             }
@@ -156,8 +174,7 @@ static void wgsl_patch_bind_slots(Compiler& compiler, Snippet::Type type, std::v
                 // FIXME: handle error
             }
             if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                inout_bytecode[out_offset] = cur_image_binding;
-                cur_image_binding += 1;
+                inout_bytecode[out_offset] = base_image_binding + compiler.get_decoration(res.id, spv::DecorationBinding);
             } else {
                 // FIXME: handle error
             }
@@ -174,8 +191,7 @@ static void wgsl_patch_bind_slots(Compiler& compiler, Snippet::Type type, std::v
                 // FIXME: handle error
             }
             if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                inout_bytecode[out_offset] = cur_sampler_binding;
-                cur_sampler_binding += 1;
+                inout_bytecode[out_offset] = base_sampler_binding + compiler.get_decoration(res.id, spv::DecorationBinding);
             } else {
                 // FIXME: handle error
             }
@@ -192,8 +208,7 @@ static void wgsl_patch_bind_slots(Compiler& compiler, Snippet::Type type, std::v
                 // FIXME: handle error
             }
             if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                inout_bytecode[out_offset] = cur_sbuf_binding;
-                cur_sbuf_binding += 1;
+                inout_bytecode[out_offset] = base_sbuf_binding + compiler.get_decoration(res.id, spv::DecorationBinding);
             } else {
                 // FIXME: handle error
             }
@@ -201,16 +216,16 @@ static void wgsl_patch_bind_slots(Compiler& compiler, Snippet::Type type, std::v
     }
 }
 
-static ErrMsg validate_resource_restrictions(const Input& inp, const SpirvBlob& blob) {
-    CompilerGLSL compiler(blob.bytecode);
+static ErrMsg validate_resource_restrictions(const Input& inp, const Snippet& snippet, const Compiler& compiler) {
     ShaderResources res = compiler.get_shader_resources();
     // - uniform blocks:
-    //   - must only have float and int base types
+    //   - must only have float, int and (on some targets) 16-bit float base types
+    //   - arrays must not have 16-bit float base types
     //   - arrays must be of type vec4[], ivec4[] or mat4[]
     //   - arrays must be 1-dimensional
     // - storage buffers:
     //   - must only have a single flexible array struct item
-    //   - must be readonly
+    //   - must be readonly (except in compute shaders)
     // - must use separate image and sampler objects
     //
     // FIXME: disallow vec3 arrays
@@ -219,8 +234,11 @@ static ErrMsg validate_resource_restrictions(const Input& inp, const SpirvBlob&
         const SPIRType& ub_type = compiler.get_type(ub_res.base_type_id);
         for (int m_index = 0; m_index < (int)ub_type.member_types.size(); m_index++) {
             const SPIRType& m_type = compiler.get_type(ub_type.member_types[m_index]);
-            if ((m_type.basetype != SPIRType::Float) && (m_type.basetype != SPIRType::Int)) {
-                return ErrMsg::error(inp.base_path, 0, fmt::format("uniform block '{}': uniform blocks can only contain float or int base types", ub_res.name));
+            if ((m_type.basetype != SPIRType::Float) && (m_type.basetype != SPIRType::Int) && (m_type.basetype != SPIRType::Half)) {
+                return ErrMsg::error(inp.base_path, 0, fmt::format("uniform block '{}': uniform blocks can only contain float, float16 or int base types", ub_res.name));
+            }
+            if ((m_type.basetype == SPIRType::Half) && ((m_type.columns > 1) || (m_type.array.size() > 0))) {
+                return ErrMsg::error(inp.base_path, 0, fmt::format("uniform block '{}': float16 matrices and arrays are not supported", ub_res.name));
             }
             if (m_type.array.size() > 0) {
                 if (m_type.vecsize != 4) {
@@ -247,8 +265,8 @@ static ErrMsg validate_resource_restrictions(const Input& inp, const SpirvBlob&
             return ErrMsg::error(inp.base_path, 0, fmt::format("storage buffer '{}': must contain exactly one flexible array of a struct", sbuf_res.name));
         }
         bool readonly = compiler.get_buffer_block_flags(sbuf_res.id).get(spv::DecorationNonWritable);
-        if (!readonly) {
-            return ErrMsg::error(inp.base_path, 0, fmt::format("storage buffer '{}': only 'readonly' SSBOs are allowed currently", sbuf_res.name));
+        if (!readonly && !Snippet::is_cs(snippet.type)) {
+            return ErrMsg::error(inp.base_path, 0, fmt::format("storage buffer '{}': only 'readonly' SSBOs are allowed in vertex and fragment shaders", sbuf_res.name));
         }
     }
     if (res.sampled_images.size() > 0) {
@@ -286,6 +304,17 @@ static void flatten_uniform_blocks(CompilerGLSL& compiler) {
     }
 }
 
+// native GL uniform buffers share a common bind space across shader stages, the
+// binding is only written to the GLSL code for GLSL430 (for GLSL410 the bind point
+// must be assigned at runtime via glUniformBlockBinding())
+static void fix_glsl_uniform_buffer_bindings(CompilerGLSL& compiler, Snippet::Type type) {
+    ShaderResources shader_resources = compiler.get_shader_resources();
+    for (const Resource& res: shader_resources.uniform_buffers) {
+        const int slot = (int)compiler.get_decoration(res.id, spv::DecorationBinding);
+        compiler.set_decoration(res.id, spv::DecorationBinding, UniformBlock::glsl_binding(Snippet::is_fs(type), slot));
+    }
+}
+
 static void to_combined_image_samplers(CompilerGLSL& compiler) {
     compiler.build_combined_image_samplers();
     // give the combined samplers new names
@@ -298,10 +327,9 @@ static void to_combined_image_samplers(CompilerGLSL& compiler) {
     }
 }
 
-static StageReflection parse_reflection(const std::vector<uint32_t>& bytecode, const Snippet& snippet, ErrMsg& out_error) {
+static StageReflection parse_reflection(CompilerGLSL& compiler, const Snippet& snippet, const BindSlots& bind_slots, ErrMsg& out_error) {
     // NOTE: do *NOT* use CompilerReflection here, this doesn't generate
     // the right reflection info for depth textures and comparison samplers
-    CompilerGLSL compiler(bytecode);
     CompilerGLSL::Options options;
     options.emit_line_directives = false;
     options.version = 430;
@@ -312,17 +340,27 @@ static StageReflection parse_reflection(const std::vector<uint32_t>& bytecode, c
     compiler.set_common_options(options);
     flatten_uniform_blocks(compiler);
     to_combined_image_samplers(compiler);
-    fix_bind_slots(compiler, snippet.type, Slang::REFLECTION);
+    fix_bind_slots(compiler, snippet.type, Slang::REFLECTION, bind_slots);
     // NOTE: we need to compile here, otherwise the reflection won't be
     // able to detect depth-textures and comparison-samplers!
     compiler.compile();
     return Reflection::parse_snippet_reflection(compiler, snippet, out_error);
 }
 
-static SpirvcrossSource to_glsl(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet) {
+// force early fragment tests (@early_fragment_tests) via the SPIRV execution mode,
+// SPIRV-Cross writes this as layout(early_fragment_tests), [earlydepthstencil]
+// or [[early_fragment_tests]], the option bit is only set for target languages
+// which support it
+static void fix_early_fragment_tests(Compiler& compiler, uint32_t opt_mask) {
+    if (0 != (opt_mask & Option::EARLY_FRAGMENT_TESTS)) {
+        compiler.set_execution_mode(spv::ExecutionModeEarlyFragmentTests);
+    }
+}
+
+static SpirvcrossSource to_glsl(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet, const BindSlots& bind_slots, bool line_directives) {
     CompilerGLSL compiler(blob.bytecode);
     CompilerGLSL::Options options;
-    options.emit_line_directives = false;
+    options.emit_line_directives = line_directives;
     switch (slang) {
         case Slang::GLSL410:
             options.version = 410;
@@ -343,29 +381,36 @@ static SpirvcrossSource to_glsl(const Input& inp, const SpirvBlob& blob, Slang::
     }
     options.vulkan_semantics = false;
     options.enable_420pack_extension = false;
-    options.emit_uniform_buffer_as_plain_uniforms = true;
+    // with @glsl_options uniform_buffers, uniform blocks are kept as native uniform buffers
+    const bool uniform_buffers = (0 != (opt_mask & Option::UNIFORM_BUFFERS));
+    options.emit_uniform_buffer_as_plain_uniforms = !uniform_buffers;
     options.vertex.support_nonzero_base_instance = false;
     options.vertex.fixup_clipspace = (0 != (opt_mask & Option::FIXUP_CLIPSPACE));
     options.vertex.flip_vert_y = (0 != (opt_mask & Option::FLIP_VERT_Y));
     compiler.set_common_options(options);
-    flatten_uniform_blocks(compiler);
+    if (!uniform_buffers) {
+        flatten_uniform_blocks(compiler);
+    }
     to_combined_image_samplers(compiler);
-    fix_bind_slots(compiler, snippet.type, slang);
+    fix_bind_slots(compiler, snippet.type, slang, bind_slots);
+    if (uniform_buffers) {
+        fix_glsl_uniform_buffer_bindings(compiler, snippet.type);
+    }
+    fix_early_fragment_tests(compiler, opt_mask);
     std::string src = compiler.compile();
     SpirvcrossSource res;
     res.snippet_index = blob.snippet_index;
     if (!src.empty()) {
         res.source_code = std::move(src);
-        res.stage_refl = parse_reflection(blob.bytecode, snippet, res.error);
     }
-    res.valid = !res.error.valid();
+    res.valid = true;
     return res;
 }
 
-static SpirvcrossSource to_hlsl(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet) {
+static SpirvcrossSource to_hlsl(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet, const BindSlots& bind_slots, bool uses_16bit_types, bool line_directives) {
     CompilerHLSL compiler(blob.bytecode);
     CompilerGLSL::Options commonOptions;
-    commonOptions.emit_line_directives = false;
+    commonOptions.emit_line_directives = line_directives;
     commonOptions.vertex.fixup_clipspace = (0 != (opt_mask & Option::FIXUP_CLIPSPACE));
     commonOptions.vertex.flip_vert_y = (0 != (opt_mask & Option::FLIP_VERT_Y));
     commonOptions.vertex.support_nonzero_base_instance = false;
@@ -375,6 +420,11 @@ static SpirvcrossSource to_hlsl(const Input& inp, const SpirvBlob& blob, Slang::
         case Slang::HLSL4:
             hlslOptions.shader_model = 40;
             break;
+        case Slang::HLSL6:
+            // native 16-bit types need shader model 6.2
+            hlslOptions.shader_model = uses_16bit_types ? 62 : 60;
+            hlslOptions.enable_16bit_types = uses_16bit_types;
+            break;
         default:
             hlslOptions.shader_model = 50;
             break;
@@ -382,22 +432,78 @@ static SpirvcrossSource to_hlsl(const Input& inp, const SpirvBlob& blob, Slang::
     hlslOptions.point_size_compat = true;
     hlslOptions.support_nonzero_base_vertex_base_instance = false;
     compiler.set_hlsl_options(hlslOptions);
-    fix_bind_slots(compiler, snippet.type, slang);
+    fix_bind_slots(compiler, snippet.type, slang, bind_slots);
+    fix_early_fragment_tests(compiler, opt_mask);
     std::string src = compiler.compile();
     SpirvcrossSource res;
     res.snippet_index = blob.snippet_index;
     if (!src.empty()) {
         res.source_code = std::move(src);
-        res.stage_refl = parse_reflection(blob.bytecode, snippet, res.error);
     }
-    res.valid = !res.error.valid();
+    res.valid = true;
     return res;
 }
 
-static SpirvcrossSource to_msl(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet) {
+// Moves images, samplers and storage buffers into a Metal argument buffer with a
+// fixed layout (see MslArgumentBuffer), must be called after fix_bind_slots(). Uniform
+// blocks stay in descriptor set 0 which is marked as discrete. The member ids are
+// also used as bindings in the argument buffer descriptor set so that images
+// and samplers with the same bind slot don't collide.
+static void fix_msl_argument_buffer(CompilerMSL& compiler, Snippet::Type type) {
+    ShaderResources shader_resources = compiler.get_shader_resources();
+    const spv::ExecutionModel model = compiler.get_execution_model();
+    const uint32_t set = MslArgumentBuffer::DescriptorSet;
+    const uint32_t sbuf_base = Snippet::is_vs(type) ? 12 : 4;
+    auto add_binding = [&](const Resource& res, uint32_t id, uint32_t msl_texture, uint32_t msl_sampler, uint32_t msl_buffer) {
+        compiler.set_decoration(res.id, spv::DecorationDescriptorSet, set);
+        compiler.set_decoration(res.id, spv::DecorationBinding, id);
+        MSLResourceBinding binding;
+        binding.stage = model;
+        binding.desc_set = set;
+        binding.binding = id;
+        binding.count = 1;
+        binding.msl_texture = msl_texture;
+        binding.msl_sampler = msl_sampler;
+        binding.msl_buffer = msl_buffer;
+        compiler.add_msl_resource_binding(binding);
+    };
+    compiler.add_discrete_descriptor_set(0);
+    for (const Resource& res: shader_resources.sampled_images) {
+        const int slot = (int)compiler.get_decoration(res.id, spv::DecorationBinding);
+        const uint32_t img_id = MslArgumentBuffer::image_id(slot);
+        const uint32_t smp_id = MslArgumentBuffer::sampler_id(slot);
+        add_binding(res, img_id, img_id, smp_id, 0);
+    }
+    for (const Resource& res: shader_resources.separate_images) {
+        const uint32_t id = MslArgumentBuffer::image_id((int)compiler.get_decoration(res.id, spv::DecorationBinding));
+        add_binding(res, id, id, 0, 0);
+    }
+    for (const Resource& res: shader_resources.separate_samplers) {
+        const uint32_t id = MslArgumentBuffer::sampler_id((int)compiler.get_decoration(res.id, spv::DecorationBinding));
+        add_binding(res, id, 0, id, 0);
+    }
+    for (const Resource& res: shader_resources.storage_buffers) {
+        const uint32_t id = MslArgumentBuffer::storage_buffer_id((int)(compiler.get_decoration(res.id, spv::DecorationBinding) - sbuf_base));
+        add_binding(res, id, 0, 0, id);
+    }
+    // the location of the argument buffer itself
+    MSLResourceBinding arg_buf_binding;
+    arg_buf_binding.stage = model;
+    arg_buf_binding.desc_set = set;
+    arg_buf_binding.binding = kArgumentBufferBinding;
+    arg_buf_binding.msl_buffer = (uint32_t)MslArgumentBuffer::buffer_index(Snippet::is_vs(type));
+    compiler.add_msl_resource_binding(arg_buf_binding);
+}
+
+static SpirvcrossSource to_msl(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet, const BindSlots& bind_slots, const std::string& entry_point, MslVersion::Enum msl_version, bool line_directives) {
     CompilerMSL compiler(blob.bytecode);
+    if (!entry_point.empty()) {
+        for (const auto& item: compiler.get_entry_points_and_stages()) {
+            compiler.rename_entry_point(item.name, entry_point, item.execution_model);
+        }
+    }
     CompilerGLSL::Options commonOptions;
-    commonOptions.emit_line_directives = false;
+    commonOptions.emit_line_directives = line_directives;
     commonOptions.vertex.fixup_clipspace = (0 != (opt_mask & Option::FIXUP_CLIPSPACE));
     commonOptions.vertex.flip_vert_y = (0 != (opt_mask & Option::FLIP_VERT_Y));
     compiler.set_common_options(commonOptions);
@@ -411,24 +517,32 @@ static SpirvcrossSource to_msl(const Input& inp, const SpirvBlob& blob, Slang::E
             break;
     }
     mslOptions.enable_decoration_binding = true;
+    mslOptions.set_msl_version(MslVersion::major(msl_version), MslVersion::minor(msl_version));
+    const bool argument_buffers = (0 != (opt_mask & Option::ARGUMENT_BUFFERS));
+    if (argument_buffers) {
+        mslOptions.argument_buffers = true;
+    }
     compiler.set_msl_options(mslOptions);
-    fix_bind_slots(compiler, snippet.type, slang);
+    fix_bind_slots(compiler, snippet.type, slang, bind_slots);
+    if (argument_buffers) {
+        fix_msl_argument_buffer(compiler, snippet.type);
+    }
+    fix_early_fragment_tests(compiler, opt_mask);
     std::string src = compiler.compile();
     SpirvcrossSource res;
     res.snippet_index = blob.snippet_index;
     if (!src.empty()) {
         res.source_code = std::move(src);
-        res.stage_refl = parse_reflection(blob.bytecode, snippet, res.error);
     }
-    res.valid = !res.error.valid();
+    res.valid = true;
     return res;
 }
 
-static SpirvcrossSource to_wgsl(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet) {
+static SpirvcrossSource to_wgsl(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet, const BindSlots& bind_slots) {
     std::vector<uint32_t> patched_bytecode = blob.bytecode;
     CompilerGLSL compiler_temp(blob.bytecode);
-    fix_bind_slots(compiler_temp, snippet.type, slang);
-    wgsl_patch_bind_slots(compiler_temp, snippet.type, patched_bytecode);
+    fix_bind_slots(compiler_temp, snippet.type, slang, bind_slots);
+    patch_bind_slots(compiler_temp, snippet.type, patched_bytecode);
     SpirvcrossSource res;
     res.snippet_index = blob.snippet_index;
     tint::reader::spirv::Options spirv_options;
@@ -439,17 +553,114 @@ static SpirvcrossSource to_wgsl(const Input& inp, const SpirvBlob& blob, Slang::
         tint::writer::wgsl::Result result = tint::writer::wgsl::Generate(&program, wgsl_options);
         if (result.success) {
             res.source_code = result.wgsl;
-            res.stage_refl = parse_reflection(blob.bytecode, snippet, res.error);
         } else {
-            res.error = inp.error(blob.snippet_index, result.error);
+            res.error = inp.error(inp.snippets[blob.snippet_index].lines[0], result.error);
         }
     } else {
-        res.error = inp.error(blob.snippet_index, program.Diagnostics().str());
+        res.error = inp.error(inp.snippets[blob.snippet_index].lines[0], program.Diagnostics().str());
     }
     res.valid = !res.error.valid();
     return res;
 }
 
+// the SPIRV target equivalent of fix_early_fragment_tests(), inserts an
+// 'OpExecutionMode [entry] EarlyFragmentTests' instruction directly after
+// the OpEntryPoint instruction (unless the shader already has it)
+static void patch_early_fragment_tests(std::vector<uint32_t>& inout_bytecode) {
+    const size_t header_words = 5;
+    size_t insert_pos = 0;
+    uint32_t entry_point_id = 0;
+    size_t i = header_words;
+    while (i < inout_bytecode.size()) {
+        const uint32_t num_words = inout_bytecode[i] >> spv::WordCountShift;
+        const uint32_t opcode = inout_bytecode[i] & spv::OpCodeMask;
+        if ((num_words == 0) || ((i + num_words) > inout_bytecode.size())) {
+            return;
+        }
+        if ((opcode == spv::OpEntryPoint) && (insert_pos == 0)) {
+            entry_point_id = inout_bytecode[i + 2];
+            insert_pos = i + num_words;
+        } else if ((opcode == spv::OpExecutionMode) && (inout_bytecode[i + 2] == (uint32_t)spv::ExecutionModeEarlyFragmentTests)) {
+            return;
+        } else if (opcode == spv::OpFunction) {
+            break;
+        }
+        i += num_words;
+    }
+    if (insert_pos != 0) {
+        const uint32_t instr[3] = { (3 << spv::WordCountShift) | spv::OpExecutionMode, entry_point_id, (uint32_t)spv::ExecutionModeEarlyFragmentTests };
+        inout_bytecode.insert(inout_bytecode.begin() + insert_pos, instr, instr + 3);
+    }
+}
+
+// the SPIRV target's 'source code' is the disassembly of the SPIRV with patched
+// bind slots, it's assembled back to binary SPIRV in Bytecode::compile()
+static SpirvcrossSource to_spirv(const Input& inp, const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask, const Snippet& snippet, const BindSlots& bind_slots) {
+    std::vector<uint32_t> patched_bytecode = blob.bytecode;
+    CompilerGLSL compiler_temp(blob.bytecode);
+    fix_bind_slots(compiler_temp, snippet.type, slang, bind_slots);
+    patch_bind_slots(compiler_temp, snippet.type, patched_bytecode);
+    // must happen after patch_bind_slots(), which patches words at fixed offsets
+    if (0 != (opt_mask & Option::EARLY_FRAGMENT_TESTS)) {
+        patch_early_fragment_tests(patched_bytecode);
+    }
+    SpirvcrossSource res;
+    res.snippet_index = blob.snippet_index;
+    spvtools::SpirvTools spirv_tools(SPV_ENV_UNIVERSAL_1_0);
+    if (spirv_tools.Disassemble(patched_bytecode, &res.source_code, spvtools::SpirvTools::kDefaultDisassembleOption)) {
+        res.valid = true;
+    } else {
+        res.error = inp.error(inp.snippets[blob.snippet_index].lines[0], "failed to disassemble SPIRV");
+    }
+    return res;
+}
+
+// escape a file name for the string literal of a C-style line directive
+static std::string line_directive_escape(const std::string& str) {
+    std::string res;
+    res.reserve(str.size());
+    for (const char c: str) {
+        if ((c == '\\') || (c == '"')) {
+            res.push_back('\\');
+        }
+        res.push_back(c);
+    }
+    return res;
+}
+
+// with --profile-build, SPIRV-Cross writes C-style line directives ('#line N "file"')
+// which refer to the line numbers of the merged snippet source, map those through
+// Input::lines back to the original input or @include file and line, GLSL only
+// accepts a source string number instead of a file name for which the @include
+// file index is used
+static std::string remap_line_directives(const Args& args, const Input& inp, const Snippet& snippet, Slang::Enum slang, const std::string& source_code) {
+    std::vector<std::string> lines;
+    pystring::splitlines(source_code, lines);
+    std::string res;
+    res.reserve(source_code.size());
+    for (const std::string& line: lines) {
+        const std::string stripped = pystring::strip(line);
+        if (pystring::startswith(stripped, "#extension GL_GOOGLE_cpp_style_line_directive")) {
+            continue;
+        }
+        if (pystring::startswith(stripped, "#line ")) {
+            const int snippet_line_index = atoi(stripped.c_str() + 6) - 1;
+            if ((snippet_line_index >= 0) && (snippet_line_index < (int)snippet.lines.size())) {
+                const Line& src_line = inp.lines[snippet.lines[snippet_line_index]];
+                if (Slang::is_glsl(slang)) {
+                    res.append(fmt::format("#line {} {}\n", src_line.index + 1, src_line.filename));
+                } else {
+                    res.append(fmt::format("#line {} \"{}\"\n", src_line.index + 1, line_directive_escape(args.reproducible_path(inp.filenames[src_line.filename]))));
+                }
+            }
+            continue;
+        }
+        res.append(line);
+        res.push_back('\n');
+    }
+    return res;
+}
+
 struct SnippetRefls {
     const Snippet& vs_snippet;
     const Snippet& fs_snippet;
@@ -457,44 +668,174 @@ struct SnippetRefls {
     const StageReflection fs_refl;
 };
 
-Spirvcross Spirvcross::translate(const Input& inp, const Spirv& spirv, Slang::Enum slang) {
-    Spirvcross spv_cross;
+// run resource validation and reflection for a single SPIRV blob,
+// may be called from parallel jobs
+static SpirvcrossAnalysis analyze_blob(const Input& inp, const SpirvBlob& blob, const BindSlots& bind_slots, bool unique_msl_entry_points) {
+    SpirvcrossAnalysis res;
+    res.snippet_index = blob.snippet_index;
+    try {
+        const Snippet& snippet = inp.snippets[blob.snippet_index];
+        assert(Snippet::is_shader(snippet.type));
+        Timings::Scope scope("parse_reflection", snippet.name);
+        CompilerGLSL compiler(blob.bytecode);
+        res.error = validate_resource_restrictions(inp, snippet, compiler);
+        if (!res.error.valid()) {
+            StageReflection stage_refl = parse_reflection(compiler, snippet, bind_slots, res.refl_error);
+            if (ShaderStage::is_fs(stage_refl.stage)) {
+                stage_refl.discards = Stats::spirv_counts(blob.bytecode).discards > 0;
+            }
+            if (unique_msl_entry_points) {
+                stage_refl.msl_entry_point = fmt::format("{}_{}", snippet.name, stage_refl.entry_point);
+            }
+            res.stage_refl = std::make_shared<const StageReflection>(std::move(stage_refl));
+        }
+    } catch (const std::runtime_error& err) {
+        res.error = inp.error(0, fmt::format("SPIRVCross exception: {}\n", err.what()));
+    }
+    return res;
+}
+
+std::vector<SpirvcrossAnalysis> Spirvcross::analyze(const Input& inp, const Spirv& spirv, const BindSlots& bind_slots, bool unique_msl_entry_points) {
+    std::vector<SpirvcrossAnalysis> analysis(spirv.blobs.size());
+    Jobs::run((int)spirv.blobs.size(), [&](int i) {
+        analysis[i] = analyze_blob(inp, spirv.blobs[i], bind_slots, unique_msl_entry_points);
+    });
+    return analysis;
+}
+
+BindSlots Spirvcross::assign_module_bind_slots(const Input& inp, const Spirv& spirv, ErrMsg& out_error) {
+    BindSlots bind_slots;
+    bind_slots.enabled = true;
     try {
-        for (const auto& blob: spirv.blobs) {
-            SpirvcrossSource src;
-            uint32_t opt_mask = inp.snippets[blob.snippet_index].options[(int)slang];
+        for (const SpirvBlob& blob: spirv.blobs) {
             const Snippet& snippet = inp.snippets[blob.snippet_index];
-            assert((snippet.type == Snippet::VS) || (snippet.type == Snippet::FS));
-            spv_cross.error = validate_resource_restrictions(inp, blob);
-            if (spv_cross.error.valid()) {
-                return spv_cross;
+            const Compiler compiler(blob.bytecode);
+            const ShaderResources shader_resources = compiler.get_shader_resources();
+            auto assign = [&](const SmallVector<Resource>& resources, BindSlots::Kind kind) {
+                for (const Resource& res: resources) {
+                    if (bind_slots.assign(snippet.type, kind, res.name) >= BindSlots::max_slots(kind)) {
+                        out_error = inp.error(snippet.lines[0], fmt::format("--module-bind-slots: more than {} distinct {}s on the {} stage across all programs of the module ('{}' in '{}')",
+                            BindSlots::max_slots(kind), BindSlots::kind_to_str(kind), Snippet::type_to_str(snippet.type), res.name, snippet.name));
+                        return false;
+                    }
+                }
+                return true;
+            };
+            if (!assign(shader_resources.uniform_buffers, BindSlots::UNIFORM_BLOCK)
+                || !assign(shader_resources.storage_buffers, BindSlots::STORAGE_BUFFER)
+                || !assign(shader_resources.separate_images, BindSlots::IMAGE)
+                || !assign(shader_resources.separate_samplers, BindSlots::SAMPLER))
+            {
+                break;
             }
+        }
+    } catch (const std::runtime_error& err) {
+        out_error = inp.error(0, fmt::format("SPIRVCross exception: {}\n", err.what()));
+    }
+    return bind_slots;
+}
+
+// translate a single SPIRV blob, may be called from parallel jobs
+static SpirvcrossSource translate_blob(const Args& args, const Input& inp, const SpirvBlob& blob, const SpirvcrossAnalysis& analysis, Slang::Enum slang, const BindSlots& bind_slots, ErrMsg& out_error) {
+    const MslVersion::Enum msl_version = args.metal_version;
+    const bool line_directives = args.profile_build;
+    SpirvcrossSource src;
+    assert(analysis.snippet_index == blob.snippet_index);
+    if (analysis.error.valid()) {
+        out_error = analysis.error;
+        return src;
+    }
+    if (Snippet::is_cs(inp.snippets[blob.snippet_index].type) && !Slang::has_compute(slang)) {
+        const Snippet& snippet = inp.snippets[blob.snippet_index];
+        out_error = inp.error(snippet.lines[0], fmt::format("compute shader '{}' is not supported by target language {} (compute shaders need glsl430, hlsl5, hlsl6, metal, wgsl or spirv)", snippet.name, Slang::to_str(slang)));
+        return src;
+    }
+    if (analysis.stage_refl->uses_16bit_types && !Slang::has_16bit_types(slang)) {
+        const Snippet& snippet = inp.snippets[blob.snippet_index];
+        out_error = inp.error(snippet.lines[0], fmt::format("shader '{}' uses 16-bit types (float16_t, f16vec*) which are not supported by target language {} (only by hlsl6, metal, wgsl and spirv)", snippet.name, Slang::to_str(slang)));
+        return src;
+    }
+    try {
+        uint32_t opt_mask = inp.snippets[blob.snippet_index].options[(int)slang];
+        const Snippet& snippet = inp.snippets[blob.snippet_index];
+        // NOTE: the reflection info isn't cached, it comes from the shared per-blob analysis
+        const std::string& msl_entry_point = analysis.stage_refl->msl_entry_point;
+        // the MSL version depends on the shader features, and is kept in sync with the Metal compiler flags
+        const MslVersion::Enum shader_msl_version = MslVersion::for_shader(msl_version, !analysis.stage_refl->spec_constants.empty(), 0 != (opt_mask & Option::ARGUMENT_BUFFERS));
+        Cache::Key cache_key = Cache::Key("spirvcross").add((int)slang).add((int)snippet.type).add((int)opt_mask).add(msl_entry_point).add(blob.bytecode);
+        if (Slang::is_msl(slang)) {
+            cache_key.add((int)shader_msl_version);
+        }
+        cache_key.add(line_directives ? 1 : 0).add(bind_slots.key(snippet.type));
+        if (Cache::get(cache_key, src.source_code)) {
+            src.valid = true;
+            src.snippet_index = blob.snippet_index;
+        } else {
+            // the WGSL translation is done by Tint instead of SPIRV-Cross
+            Timings::Scope scope(Slang::is_wgsl(slang) ? "tint" : "spirvcross", snippet.name, Slang::to_str(slang));
             if (Slang::is_glsl(slang)) {
-                src = to_glsl(inp, blob, slang, opt_mask, snippet);
+                src = to_glsl(inp, blob, slang, opt_mask, snippet, bind_slots, line_directives);
             } else if (Slang::is_hlsl(slang)) {
-                src = to_hlsl(inp, blob, slang, opt_mask, snippet);
+                src = to_hlsl(inp, blob, slang, opt_mask, snippet, bind_slots, analysis.stage_refl->uses_16bit_types, line_directives);
             } else if (Slang::is_msl(slang)) {
-                src = to_msl(inp, blob, slang, opt_mask, snippet);
+                src = to_msl(inp, blob, slang, opt_mask, snippet, bind_slots, msl_entry_point, shader_msl_version, line_directives);
             } else if (Slang::is_wgsl(slang)) {
-                src = to_wgsl(inp, blob, slang, opt_mask, snippet);
+                src = to_wgsl(inp, blob, slang, opt_mask, snippet, bind_slots);
+            } else if (Slang::is_spirv(slang)) {
+                src = to_spirv(inp, blob, slang, opt_mask, snippet, bind_slots);
+            }
+            if (src.valid && !src.source_code.empty()) {
+                Cache::put(cache_key, src.source_code);
             }
-            if (src.valid) {
-                assert(src.snippet_index == blob.snippet_index);
-                spv_cross.sources.push_back(std::move(src));
+        }
+        // the line directives refer to the merged snippet source, and the mapping to the
+        // original files isn't part of the cache key, so this must happen after the cache lookup
+        if (src.valid && line_directives) {
+            src.source_code = remap_line_directives(args, inp, snippet, slang, src.source_code);
+        }
+        if (src.valid && !src.source_code.empty()) {
+            if (analysis.refl_error.valid()) {
+                src.error = analysis.refl_error;
+                src.valid = false;
             } else {
-                const int line_index = snippet.lines[0];
-                std::string err_msg;
-                if (src.error.valid()) {
-                    err_msg = fmt::format("Failed to cross-compile to {} with:\n{}\n", Slang::to_str(slang), src.error.msg);
-                } else {
-                    err_msg = fmt::format("Failed to cross-compile to {}\n", Slang::to_str(slang));
-                }
-                spv_cross.error = inp.error(line_index, err_msg);
-                return spv_cross;
+                src.stage_refl = analysis.stage_refl;
             }
         }
+        if (src.valid) {
+            assert(src.snippet_index == blob.snippet_index);
+        } else {
+            const int line_index = snippet.lines[0];
+            std::string err_msg;
+            if (src.error.valid()) {
+                err_msg = fmt::format("Failed to cross-compile to {} with:\n{}\n", Slang::to_str(slang), src.error.msg);
+            } else {
+                err_msg = fmt::format("Failed to cross-compile to {}\n", Slang::to_str(slang));
+            }
+            out_error = inp.error(line_index, err_msg);
+        }
     } catch (const std::runtime_error& err) {
-        spv_cross.error = inp.error(0, fmt::format("SPIRVCross exception: {}\n", err.what()));
+        out_error = inp.error(0, fmt::format("SPIRVCross exception: {}\n", err.what()));
+    }
+    return src;
+}
+
+Spirvcross Spirvcross::translate(const Args& args, const Input& inp, const Spirv& spirv, const std::vector<SpirvcrossAnalysis>& analysis, Slang::Enum slang, const BindSlots& bind_slots) {
+    // translate all blobs in parallel, and collect the results in blob order,
+    // the first error terminates the translation
+    assert(analysis.size() == spirv.blobs.size());
+    const int num_blobs = (int)spirv.blobs.size();
+    std::vector<SpirvcrossSource> sources(num_blobs);
+    std::vector<ErrMsg> errors(num_blobs);
+    Jobs::run(num_blobs, [&](int i) {
+        sources[i] = translate_blob(args, inp, spirv.blobs[i], analysis[i], slang, bind_slots, errors[i]);
+    });
+    Spirvcross spv_cross;
+    for (int i = 0; i < num_blobs; i++) {
+        if (errors[i].valid()) {
+            spv_cross.error = errors[i];
+            return spv_cross;
+        }
+        spv_cross.sources.push_back(std::move(sources[i]));
     }
     return spv_cross;
 }
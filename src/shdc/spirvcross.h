@@ -1,11 +1,15 @@
 #pragma once
 #include <vector>
 #include "spirv_cross.hpp"
+#include "args.h"
 #include "input.h"
 #include "spirv.h"
 #include "types/errmsg.h"
 #include "types/slang.h"
+#include "types/msl_version.h"
+#include "types/bind_slots.h"
 #include "types/spirvcross_source.h"
+#include "types/spirvcross_analysis.h"
 #include "types/reflection/bindings.h"
 
 namespace shdc {
@@ -15,7 +19,13 @@ struct Spirvcross {
     ErrMsg error;
     std::vector<SpirvcrossSource> sources;
 
-    static Spirvcross translate(const Input& inp, const Spirv& spirv, Slang::Enum slang);
+    // assign bind slots by resource name across all snippets of the SPIRV compile result (--module-bind-slots)
+    static BindSlots assign_module_bind_slots(const Input& inp, const Spirv& spirv, ErrMsg& out_error);
+    // with unique_msl_entry_points, MSL entry points are renamed to [snippet]_[entry] (needed for --single-metallib)
+    static std::vector<SpirvcrossAnalysis> analyze(const Input& inp, const Spirv& spirv, const BindSlots& bind_slots, bool unique_msl_entry_points);
+    // the minimum Metal shading language version comes from --metal-version, and the
+    // line directives are enabled by --profile-build
+    static Spirvcross translate(const Args& args, const Input& inp, const Spirv& spirv, const std::vector<SpirvcrossAnalysis>& analysis, Slang::Enum slang, const BindSlots& bind_slots);
     static bool can_flatten_uniform_block(const spirv_cross::Compiler& compiler, const spirv_cross::Resource& ub_res);
     const SpirvcrossSource* find_source_by_snippet_index(int snippet_index) const;
     void dump_debug(ErrMsg::Format err_fmt, Slang::Enum slang) const;
@@ -0,0 +1,261 @@
+/*
+    static shader cost statistics (--stats)
+*/
+#include "stats.h"
+#include <stdio.h>
+#include "fmt/format.h"
+#include "spirv.hpp"
+
+namespace shdc {
+
+using namespace refl;
+
+// SPIRV starts with a 5-word header, followed by instructions which
+// have their word count in the upper and the opcode in the lower 16 bits
+static const size_t spirv_header_words = 5;
+
+int Stats::spirv_instruction_count(const std::vector<uint32_t>& bytecode) {
+    int count = 0;
+    size_t i = spirv_header_words;
+    while (i < bytecode.size()) {
+        const uint32_t num_words = bytecode[i] >> spv::WordCountShift;
+        if (num_words == 0) {
+            break;
+        }
+        count++;
+        i += num_words;
+    }
+    return count;
+}
+
+Stats::SpirvCounts Stats::spirv_counts(const std::vector<uint32_t>& bytecode) {
+    SpirvCounts res;
+    size_t i = spirv_header_words;
+    while (i < bytecode.size()) {
+        const uint32_t num_words = bytecode[i] >> spv::WordCountShift;
+        if (num_words == 0) {
+            break;
+        }
+        res.instructions++;
+        switch (bytecode[i] & spv::OpCodeMask) {
+            case spv::OpImageSampleImplicitLod:
+            case spv::OpImageSampleExplicitLod:
+            case spv::OpImageSampleDrefImplicitLod:
+            case spv::OpImageSampleDrefExplicitLod:
+            case spv::OpImageSampleProjImplicitLod:
+            case spv::OpImageSampleProjExplicitLod:
+            case spv::OpImageSampleProjDrefImplicitLod:
+            case spv::OpImageSampleProjDrefExplicitLod:
+            case spv::OpImageSparseSampleImplicitLod:
+            case spv::OpImageSparseSampleExplicitLod:
+            case spv::OpImageSparseSampleDrefImplicitLod:
+            case spv::OpImageSparseSampleDrefExplicitLod:
+                res.texture_samples++;
+                break;
+            case spv::OpImageFetch:
+            case spv::OpImageRead:
+            case spv::OpImageGather:
+            case spv::OpImageDrefGather:
+            case spv::OpImageSparseFetch:
+            case spv::OpImageSparseGather:
+            case spv::OpImageSparseDrefGather:
+                res.texture_fetches++;
+                break;
+            case spv::OpLoopMerge:
+                res.loops++;
+                break;
+            case spv::OpBranchConditional:
+            case spv::OpSwitch:
+                res.branches++;
+                break;
+            case spv::OpKill:
+            case spv::OpTerminateInvocation:
+            case spv::OpDemoteToHelperInvocation:
+                res.discards++;
+                break;
+            case spv::OpFunctionCall:
+                res.function_calls++;
+                break;
+            default:
+                break;
+        }
+        i += num_words;
+    }
+    return res;
+}
+
+static std::string json_escape(const std::string& str) {
+    std::string res;
+    for (char c: str) {
+        if ((c == '"') || (c == '\\')) {
+            res += '\\';
+        }
+        res += c;
+    }
+    return res;
+}
+
+// -1 is written as null (the value isn't available)
+static std::string json_int(int val) {
+    return (val < 0) ? "null" : fmt::format("{}", val);
+}
+
+static const SpirvBlob* find_spirv_blob(const Spirv& spirv, int snippet_index) {
+    for (const SpirvBlob& blob: spirv.blobs) {
+        if (blob.snippet_index == snippet_index) {
+            return &blob;
+        }
+    }
+    return nullptr;
+}
+
+static void write_snippet(std::string& out, const Input& inp, const SpirvcrossSource& src, const SpirvBlob* spirv_blob, const BytecodeBlob* bc_blob) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    const StageReflection& refl = *src.stage_refl;
+    out += "        {\n";
+    out += fmt::format("          \"name\": \"{}\",\n", snippet.name);
+    out += fmt::format("          \"stage\": \"{}\",\n", refl.stage_name);
+    if (spirv_blob) {
+        const Stats::SpirvCounts counts = Stats::spirv_counts(spirv_blob->bytecode);
+        out += "          \"spirv\": {\n";
+        out += fmt::format("            \"unoptimized_instructions\": {},\n", json_int(spirv_blob->num_unoptimized_instructions));
+        out += fmt::format("            \"instructions\": {},\n", counts.instructions);
+        out += fmt::format("            \"texture_samples\": {},\n", counts.texture_samples);
+        out += fmt::format("            \"texture_fetches\": {},\n", counts.texture_fetches);
+        out += fmt::format("            \"loops\": {},\n", counts.loops);
+        out += fmt::format("            \"branches\": {},\n", counts.branches);
+        out += fmt::format("            \"discards\": {},\n", counts.discards);
+        out += fmt::format("            \"function_calls\": {}\n", counts.function_calls);
+        out += "          },\n";
+    }
+    int num_inputs = 0;
+    for (const StageAttr& attr: refl.inputs) {
+        num_inputs += (attr.slot >= 0) ? 1 : 0;
+    }
+    int num_outputs = 0;
+    for (const StageAttr& attr: refl.outputs) {
+        num_outputs += (attr.slot >= 0) ? 1 : 0;
+    }
+    int uniform_bytes = 0;
+    for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
+        uniform_bytes += ub.struct_info.size;
+    }
+    out += "          \"resources\": {\n";
+    out += fmt::format("            \"inputs\": {},\n", num_inputs);
+    out += fmt::format("            \"outputs\": {},\n", num_outputs);
+    out += fmt::format("            \"uniform_blocks\": {},\n", refl.bindings.uniform_blocks.size());
+    out += fmt::format("            \"uniform_bytes\": {},\n", uniform_bytes);
+    out += fmt::format("            \"storage_buffers\": {},\n", refl.bindings.storage_buffers.size());
+    out += fmt::format("            \"images\": {},\n", refl.bindings.images.size());
+    out += fmt::format("            \"samplers\": {}\n", refl.bindings.samplers.size());
+    out += "          },\n";
+    if (ShaderStage::is_fs(refl.stage)) {
+        out += "          \"early_fragment_tests\": {\n";
+        out += fmt::format("            \"disabled\": {},\n", refl.disables_early_fragment_tests());
+        out += fmt::format("            \"forced\": {},\n", refl.early_fragment_tests);
+        out += fmt::format("            \"discards\": {},\n", refl.discards);
+        out += fmt::format("            \"writes_frag_depth\": {}\n", refl.writes_frag_depth);
+        out += "          },\n";
+    }
+    if (bc_blob && bc_blob->has_d3d_stats) {
+        out += "          \"d3d\": {\n";
+        out += fmt::format("            \"instructions\": {},\n", bc_blob->d3d_instruction_count);
+        out += fmt::format("            \"temp_registers\": {},\n", bc_blob->d3d_temp_register_count);
+        out += fmt::format("            \"alu_instructions\": {},\n", bc_blob->d3d_alu_instruction_count);
+        out += fmt::format("            \"texture_instructions\": {}\n", bc_blob->d3d_texture_instruction_count);
+        out += "          },\n";
+    }
+    out += fmt::format("          \"source_size\": {},\n", src.source_code.size());
+    out += fmt::format("          \"bytecode_size\": {}\n", bc_blob ? json_int((int)bc_blob->data.size()) : "null");
+    out += "        }";
+}
+
+static void write_program(std::string& out, const Input& inp, const Program& prog, const Spirv& spirv, const Spirvcross& spirvcross, const Bytecode& bytecode) {
+    std::vector<std::string> snippet_names;
+    if (prog.is_compute()) {
+        snippet_names.push_back(prog.cs_name);
+    } else {
+        snippet_names.push_back(prog.vs_name);
+        snippet_names.push_back(prog.fs_name);
+    }
+    int instructions = 0;
+    int texture_samples = 0;
+    size_t source_size = 0;
+    size_t bytecode_size = 0;
+    for (const std::string& name: snippet_names) {
+        const int snippet_index = inp.snippet_map.at(name);
+        const SpirvBlob* spirv_blob = find_spirv_blob(spirv, snippet_index);
+        if (spirv_blob) {
+            const Stats::SpirvCounts counts = Stats::spirv_counts(spirv_blob->bytecode);
+            instructions += counts.instructions;
+            texture_samples += counts.texture_samples;
+        }
+        const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(snippet_index);
+        if (src) {
+            source_size += src->source_code.size();
+        }
+        const BytecodeBlob* bc_blob = bytecode.find_blob_by_snippet_index(snippet_index);
+        if (bc_blob) {
+            bytecode_size += bc_blob->data.size();
+        }
+    }
+    out += "        {\n";
+    out += fmt::format("          \"name\": \"{}\",\n", prog.name);
+    out += "          \"snippets\": [ ";
+    for (size_t i = 0; i < snippet_names.size(); i++) {
+        out += fmt::format("{}\"{}\"", (i > 0) ? ", " : "", snippet_names[i]);
+    }
+    out += " ],\n";
+    out += fmt::format("          \"instructions\": {},\n", instructions);
+    out += fmt::format("          \"texture_samples\": {},\n", texture_samples);
+    out += fmt::format("          \"source_size\": {},\n", source_size);
+    out += fmt::format("          \"bytecode_size\": {}\n", bytecode_size);
+    out += "        }";
+}
+
+ErrMsg Stats::write_json(const Args& args,
+    const Input& inp,
+    const std::array<const Spirv*, Slang::Num>& spirv,
+    const std::array<Spirvcross, Slang::Num>& spirvcross,
+    const std::array<Bytecode, Slang::Num>& bytecode)
+{
+    std::string out = "{\n";
+    out += fmt::format("  \"input\": \"{}\",\n", json_escape(args.input));
+    out += "  \"slangs\": [\n";
+    bool first_slang = true;
+    for (int i = 0; i < Slang::Num; i++) {
+        const Slang::Enum slang = Slang::from_index(i);
+        if (0 == (args.slang & Slang::bit(slang))) {
+            continue;
+        }
+        assert(spirv[slang]);
+        out += first_slang ? "    {\n" : ",\n    {\n";
+        first_slang = false;
+        out += fmt::format("      \"slang\": \"{}\",\n", Slang::to_str(slang));
+        out += "      \"snippets\": [\n";
+        for (size_t src_index = 0; src_index < spirvcross[slang].sources.size(); src_index++) {
+            const SpirvcrossSource& src = spirvcross[slang].sources[src_index];
+            write_snippet(out, inp, src, find_spirv_blob(*spirv[slang], src.snippet_index), bytecode[slang].find_blob_by_snippet_index(src.snippet_index));
+            out += (src_index + 1 < spirvcross[slang].sources.size()) ? ",\n" : "\n";
+        }
+        out += "      ],\n";
+        out += "      \"programs\": [\n";
+        size_t prog_index = 0;
+        for (const auto& item: inp.programs) {
+            write_program(out, inp, item.second, *spirv[slang], spirvcross[slang], bytecode[slang]);
+            out += (++prog_index < inp.programs.size()) ? ",\n" : "\n";
+        }
+        out += "      ]\n";
+        out += "    }";
+    }
+    out += "\n  ]\n}\n";
+    FILE* fp = fopen(args.stats.c_str(), "w");
+    if (!fp) {
+        return ErrMsg::error(args.stats, 0, fmt::format("failed to open stats file '{}' for writing", args.stats));
+    }
+    fwrite(out.c_str(), out.length(), 1, fp);
+    fclose(fp);
+    return ErrMsg();
+}
+
+} // namespace shdc
@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <stdint.h>
+#include "args.h"
+#include "input.h"
+#include "spirv.h"
+#include "spirvcross.h"
+#include "bytecode.h"
+#include "types/errmsg.h"
+#include "types/slang.h"
+
+namespace shdc {
+
+// static shader cost statistics per snippet and target language (--stats)
+struct Stats {
+    // instruction statistics of a SPIRV blob
+    struct SpirvCounts {
+        int instructions = 0;
+        int texture_samples = 0;    // OpImageSample* and OpImageSparseSample*
+        int texture_fetches = 0;    // OpImageFetch, OpImageRead and gathers
+        int loops = 0;              // OpLoopMerge
+        int branches = 0;           // OpBranchConditional and OpSwitch
+        int discards = 0;           // OpKill, OpTerminateInvocation and OpDemoteToHelperInvocation
+        int function_calls = 0;     // OpFunctionCall
+    };
+    static int spirv_instruction_count(const std::vector<uint32_t>& bytecode);
+    static SpirvCounts spirv_counts(const std::vector<uint32_t>& bytecode);
+    // write the statistics of all compiled snippets as JSON file, spirv is indexed by Slang
+    static ErrMsg write_json(const Args& args,
+        const Input& inp,
+        const std::array<const Spirv*, Slang::Num>& spirv,
+        const std::array<Spirvcross, Slang::Num>& spirvcross,
+        const std::array<Bytecode, Slang::Num>& bytecode);
+};
+
+} // namespace shdc
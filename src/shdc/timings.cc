@@ -0,0 +1,216 @@
+/*
+    timing instrumentation of the compile phases
+*/
+#include "timings.h"
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include "fmt/format.h"
+
+namespace shdc {
+
+const std::string Timings::empty_string;
+
+struct TimingSpan {
+    const char* phase = nullptr;
+    std::string snippet;
+    const char* slang = nullptr;
+    int64_t start_us = 0;
+    int64_t dur_us = 0;
+    int tid = 0;
+};
+
+struct TimingState {
+    bool enabled = false;
+    std::chrono::steady_clock::time_point start_time;
+    std::mutex mutex;
+    std::vector<TimingSpan> spans;
+    // small sequential thread ids in order of the first recorded span
+    std::map<std::thread::id, int> thread_ids;
+};
+
+static TimingState state;
+
+static int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - state.start_time).count();
+}
+
+Timings::Scope::Scope(const char* phase, const std::string& snippet, const char* slang):
+    phase(phase),
+    slang(slang)
+{
+    if (state.enabled) {
+        this->snippet = snippet;
+        start_us = now_us();
+    }
+}
+
+Timings::Scope::~Scope() {
+    end();
+}
+
+void Timings::Scope::end() {
+    if (start_us < 0) {
+        return;
+    }
+    TimingSpan span;
+    span.phase = phase;
+    span.snippet = std::move(snippet);
+    span.slang = slang;
+    span.start_us = start_us;
+    span.dur_us = now_us() - start_us;
+    start_us = -1;
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto it = state.thread_ids.find(std::this_thread::get_id());
+    if (it == state.thread_ids.end()) {
+        it = state.thread_ids.emplace(std::this_thread::get_id(), (int)state.thread_ids.size()).first;
+    }
+    span.tid = it->second;
+    state.spans.push_back(std::move(span));
+}
+
+void Timings::setup(bool enabled) {
+    state.enabled = enabled;
+    state.start_time = std::chrono::steady_clock::now();
+}
+
+void Timings::discard() {
+    clear();
+    state.enabled = false;
+}
+
+bool Timings::enabled() {
+    return state.enabled;
+}
+
+void Timings::clear() {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.spans.clear();
+    state.thread_ids.clear();
+}
+
+static std::string span_item(const TimingSpan& span) {
+    if (span.snippet.empty()) {
+        return span.slang ? span.slang : "";
+    } else if (span.slang) {
+        return fmt::format("{} ({})", span.snippet, span.slang);
+    } else {
+        return span.snippet;
+    }
+}
+
+struct TimingPhase {
+    const char* name = nullptr;
+    int count = 0;
+    int64_t total_us = 0;
+    const TimingSpan* slowest = nullptr;
+};
+
+// phases in order of their first recorded span, spans are recorded when
+// they end, so that the phase order roughly follows the compile pipeline,
+// must be called with the state mutex locked
+static std::vector<TimingPhase> collect_phases() {
+    std::vector<TimingPhase> phases;
+    for (const TimingSpan& span: state.spans) {
+        auto it = std::find_if(phases.begin(), phases.end(), [&](const TimingPhase& p) { return 0 == strcmp(p.name, span.phase); });
+        if (it == phases.end()) {
+            TimingPhase phase;
+            phase.name = span.phase;
+            phases.push_back(phase);
+            it = phases.end() - 1;
+        }
+        it->count++;
+        it->total_us += span.dur_us;
+        if ((nullptr == it->slowest) || (span.dur_us > it->slowest->dur_us)) {
+            it->slowest = &span;
+        }
+    }
+    return phases;
+}
+
+std::vector<Timings::PhaseTotal> Timings::phase_totals() {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    std::vector<PhaseTotal> res;
+    for (const TimingPhase& phase: collect_phases()) {
+        PhaseTotal total;
+        total.name = phase.name;
+        total.count = phase.count;
+        total.total_us = phase.total_us;
+        res.push_back(total);
+    }
+    return res;
+}
+
+void Timings::print_summary() {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.spans.empty()) {
+        return;
+    }
+    const std::vector<TimingPhase> phases = collect_phases();
+    int64_t end_us = 0;
+    for (const TimingSpan& span: state.spans) {
+        end_us = std::max(end_us, span.start_us + span.dur_us);
+    }
+    fmt::print(stderr, "sokol-shdc: timings ({} threads, {:.2f} ms):\n", state.thread_ids.size(), end_us / 1000.0);
+    fmt::print(stderr, "  {:<20} {:>6} {:>11} {:>11}  {}\n", "phase", "count", "total ms", "max ms", "slowest");
+    for (const TimingPhase& phase: phases) {
+        fmt::print(stderr, "  {:<20} {:>6} {:>11.2f} {:>11.2f}  {}\n",
+            phase.name,
+            phase.count,
+            phase.total_us / 1000.0,
+            phase.slowest->dur_us / 1000.0,
+            span_item(*phase.slowest));
+    }
+}
+
+static std::string json_escape(const std::string& str) {
+    std::string res;
+    for (char c: str) {
+        if ((c == '"') || (c == '\\')) {
+            res += '\\';
+            res += c;
+        } else if ((unsigned char)c < 0x20) {
+            res += fmt::format("\\u{:04x}", (int)c);
+        } else {
+            res += c;
+        }
+    }
+    return res;
+}
+
+ErrMsg Timings::write_trace_json(const std::string& path) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    // complete events ("ph":"X"), see the Chrome Trace Event Format documentation
+    std::string content = "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < state.spans.size(); i++) {
+        const TimingSpan& span = state.spans[i];
+        content += fmt::format("{{\"name\":\"{}\",\"cat\":\"shdc\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":{}",
+            span.phase, span.start_us, span.dur_us, span.tid);
+        if (!span.snippet.empty() || span.slang) {
+            content += ",\"args\":{";
+            if (!span.snippet.empty()) {
+                content += fmt::format("\"snippet\":\"{}\"", json_escape(span.snippet));
+            }
+            if (span.slang) {
+                content += fmt::format("{}\"slang\":\"{}\"", span.snippet.empty() ? "" : ",", span.slang);
+            }
+            content += "}";
+        }
+        content += (i + 1 < state.spans.size()) ? "},\n" : "}\n";
+    }
+    content += "],\"displayTimeUnit\":\"ms\"}\n";
+    FILE* fp = fopen(path.c_str(), "w");
+    if (!fp) {
+        return ErrMsg::error(path, 0, fmt::format("failed to open trace file '{}' for writing", path));
+    }
+    fwrite(content.c_str(), content.length(), 1, fp);
+    fclose(fp);
+    return ErrMsg();
+}
+
+} // namespace shdc
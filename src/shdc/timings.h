@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "types/errmsg.h"
+
+namespace shdc {
+
+// optional timing instrumentation of the compile phases (--timings and --trace-json),
+// all functions are thread-safe and may be called from parallel jobs
+struct Timings {
+    // records a span of a compile phase from construction to destruction, does
+    // nothing when timings are disabled, the phase name and target language must
+    // be string literals, the optional snippet name is copied when timings are enabled
+    struct Scope {
+        Scope(const char* phase, const std::string& snippet = empty_string, const char* slang = nullptr);
+        ~Scope();
+        // optionally end the span before the scope ends
+        void end();
+        const char* phase;
+        std::string snippet;
+        const char* slang;
+        int64_t start_us = -1;
+    };
+
+    static void setup(bool enabled);
+    static void discard();
+    static bool enabled();
+    // forget all recorded spans (e.g. after each compile in --watch mode)
+    static void clear();
+    // accumulated time per phase, in order of the first recorded span
+    struct PhaseTotal {
+        const char* name = nullptr;
+        int count = 0;
+        int64_t total_us = 0;
+    };
+    static std::vector<PhaseTotal> phase_totals();
+    // print a per-phase summary to stderr (--timings)
+    static void print_summary();
+    // write all recorded spans as Chrome trace event JSON (--trace-json)
+    static ErrMsg write_trace_json(const std::string& path);
+
+private:
+    static const std::string empty_string;
+};
+
+} // namespace shdc
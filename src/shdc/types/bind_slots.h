@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <map>
+#include <string>
+#include "fmt/format.h"
+#include "snippet.h"
+#include "reflection/uniform_block.h"
+#include "reflection/storage_buffer.h"
+#include "reflection/image.h"
+#include "reflection/sampler.h"
+
+namespace shdc {
+
+// module-wide bind slot assignment (--module-bind-slots): resources with the same
+// name and resource type get the same bind slot on the same shader stage in all
+// programs of a module, so that switching between programs doesn't require
+// rebinding shared resources, bind slots are assigned in order of first appearance,
+// if disabled, bind slots are assigned per shader snippet in declaration order
+struct BindSlots {
+    enum Kind {
+        UNIFORM_BLOCK,
+        STORAGE_BUFFER,
+        IMAGE,
+        SAMPLER,
+        NUM_KINDS,
+    };
+    enum Stage {
+        VS,
+        FS,
+        CS,
+        NUM_STAGES,
+    };
+    bool enabled = false;
+    std::array<std::array<std::map<std::string, int>, NUM_KINDS>, NUM_STAGES> slots;
+
+    static Stage stage(Snippet::Type type);
+    static int max_slots(Kind kind);
+    static const char* kind_to_str(Kind kind);
+    // return the bind slot of a resource, or -1 if not assigned
+    int find(Snippet::Type type, Kind kind, const std::string& name) const;
+    // assign the next free bind slot if the resource doesn't have one yet, returns the bind slot
+    int assign(Snippet::Type type, Kind kind, const std::string& name);
+    // string representation of a stage's bind slots for cache keys
+    std::string key(Snippet::Type type) const;
+};
+
+inline BindSlots::Stage BindSlots::stage(Snippet::Type type) {
+    if (Snippet::is_fs(type)) {
+        return FS;
+    } else if (Snippet::is_cs(type)) {
+        return CS;
+    } else {
+        return VS;
+    }
+}
+
+inline int BindSlots::max_slots(Kind kind) {
+    switch (kind) {
+        case UNIFORM_BLOCK: return refl::UniformBlock::Num;
+        case STORAGE_BUFFER: return refl::StorageBuffer::Num;
+        case IMAGE: return refl::Image::Num;
+        case SAMPLER: return refl::Sampler::Num;
+        default: return 0;
+    }
+}
+
+inline const char* BindSlots::kind_to_str(Kind kind) {
+    switch (kind) {
+        case UNIFORM_BLOCK: return "uniform block";
+        case STORAGE_BUFFER: return "storage buffer";
+        case IMAGE: return "image";
+        case SAMPLER: return "sampler";
+        default: return "<invalid>";
+    }
+}
+
+inline int BindSlots::find(Snippet::Type type, Kind kind, const std::string& name) const {
+    const std::map<std::string, int>& map = slots[stage(type)][kind];
+    auto it = map.find(name);
+    if (it != map.end()) {
+        return it->second;
+    } else {
+        return -1;
+    }
+}
+
+inline int BindSlots::assign(Snippet::Type type, Kind kind, const std::string& name) {
+    std::map<std::string, int>& map = slots[stage(type)][kind];
+    auto ins = map.insert({ name, (int)map.size() });
+    return ins.first->second;
+}
+
+inline std::string BindSlots::key(Snippet::Type type) const {
+    if (!enabled) {
+        return "";
+    }
+    std::string res;
+    for (int kind = 0; kind < NUM_KINDS; kind++) {
+        for (const auto& item: slots[stage(type)][kind]) {
+            res += fmt::format("{}:{}={};", kind, item.first, item.second);
+        }
+    }
+    return res;
+}
+
+} // namespace shdc
@@ -9,6 +9,12 @@ struct BytecodeBlob {
     bool valid = false;
     int snippet_index = -1;
     std::vector<uint8_t> data;
+    // optional D3DReflect statistics (only HLSL4/5 compiled with d3dcompiler.dll)
+    bool has_d3d_stats = false;
+    int d3d_instruction_count = 0;
+    int d3d_temp_register_count = 0;
+    int d3d_alu_instruction_count = 0;      // float, int and uint instructions
+    int d3d_texture_instruction_count = 0;  // texture sample, load, compare, bias and gradient instructions
 };
 
 } // namespace shdc
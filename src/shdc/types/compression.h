@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+
+namespace shdc {
+
+// the compression method for embedded shader arrays
+struct Compression {
+    enum Enum {
+        NONE = 0,
+        LZ4,
+        NUM,
+        INVALID,
+    };
+
+    static const char* to_str(Enum c);
+    static Enum from_str(const std::string& str);
+};
+
+inline const char* Compression::to_str(Enum c) {
+    switch (c) {
+        case NONE:  return "none";
+        case LZ4:   return "lz4";
+        default:    return "<invalid>";
+    }
+}
+
+inline Compression::Enum Compression::from_str(const std::string& str) {
+    if (str == "none") {
+        return NONE;
+    } else if (str == "lz4") {
+        return LZ4;
+    } else {
+        return INVALID;
+    }
+}
+
+} // namespace shdc
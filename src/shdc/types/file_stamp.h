@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <sys/stat.h>
+
+namespace shdc {
+
+// a file's modification stamp for change detection (--watch and the source
+// file cache), the mtime has nanosecond resolution where the platform provides
+// it, together with inode and size an in-place edit within the same second is
+// detected on all file systems with sub-second timestamps
+struct FileStamp {
+    bool exists = false;
+    int64_t mtime_sec = 0;
+    int64_t mtime_nsec = 0;
+    uint64_t inode = 0;
+    int64_t size = 0;
+
+    static FileStamp of(const std::string& path);
+    bool operator==(const FileStamp& other) const;
+    bool operator!=(const FileStamp& other) const;
+};
+
+inline FileStamp FileStamp::of(const std::string& path) {
+    FileStamp res;
+    struct stat st;
+    if (0 == stat(path.c_str(), &st)) {
+        res.exists = true;
+        res.mtime_sec = (int64_t)st.st_mtime;
+        #if defined(__APPLE__)
+        res.mtime_nsec = (int64_t)st.st_mtimespec.tv_nsec;
+        #elif !defined(_WIN32)
+        res.mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+        #endif
+        res.inode = (uint64_t)st.st_ino;
+        res.size = (int64_t)st.st_size;
+    }
+    return res;
+}
+
+inline bool FileStamp::operator==(const FileStamp& other) const {
+    return (exists == other.exists) &&
+           (mtime_sec == other.mtime_sec) &&
+           (mtime_nsec == other.mtime_nsec) &&
+           (inode == other.inode) &&
+           (size == other.size);
+}
+
+inline bool FileStamp::operator!=(const FileStamp& other) const {
+    return !(*this == other);
+}
+
+} // namespace shdc
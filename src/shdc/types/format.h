@@ -16,12 +16,16 @@ struct Format	{
         SOKOL_JAI,
         BARE,
         BARE_YAML,
+        BARE_BIN,
         NUM,
         INVALID,
     };
 
     static const char* to_str(Enum f);
     static Enum from_str(const std::string& str);
+    // true if compute programs are supported (the sokol header formats target
+    // a sokol_gfx.h without compute shaders)
+    static bool has_compute(Enum f);
 };
 
 inline const char* Format::to_str(Enum f) {
@@ -36,10 +40,15 @@ inline const char* Format::to_str(Enum f) {
         case SOKOL_JAI:     return "sokol_jai";
         case BARE:          return "bare";
         case BARE_YAML:     return "bare_yaml";
+        case BARE_BIN:      return "bare_bin";
         default:            return "<invalid>";
     }
 }
 
+inline bool Format::has_compute(Enum f) {
+    return (BARE == f) || (BARE_YAML == f) || (BARE_BIN == f);
+}
+
 inline Format::Enum Format::from_str(const std::string& str) {
     if (str == "sokol") {
         return SOKOL;
@@ -61,6 +70,8 @@ inline Format::Enum Format::from_str(const std::string& str) {
         return BARE;
     } else if (str == "bare_yaml") {
         return BARE_YAML;
+    } else if (str == "bare_bin") {
+        return BARE_BIN;
     } else {
         return INVALID;
     }
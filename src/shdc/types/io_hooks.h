@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <functional>
+#include "errmsg.h"
+
+namespace shdc {
+
+// optional in-memory replacements for file and console access, used by the
+// libshdc API (see shdc.h), unset hooks use the filesystem and stderr
+struct IoHooks {
+    // provide the content of a source file (the input file or an @include), return
+    // false if the file isn't provided, it's then loaded from the filesystem
+    std::function<bool(const std::string& path, std::string& out_content)> read;
+    // receive a generated output file instead of writing it to the filesystem
+    std::function<bool(const std::string& path, const void* data, size_t num_bytes, bool binary)> write;
+    // receive compile errors and warnings instead of printing them to stderr
+    std::function<void(const ErrMsg& msg)> message;
+};
+
+} // namespace shdc
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+
+namespace shdc {
+
+// the fixed layout of the optional per-stage Metal argument buffer (@msl_options argument_buffers):
+//  - uniform blocks are not part of the argument buffer and stay bound at [[buffer(0..3)]]
+//  - the argument buffer is bound at the first storage buffer slot of the
+//    regular MSL layout ([[buffer(12)]] on the vertex stage, [[buffer(4)]]
+//    on the fragment and compute stage)
+//  - image member ids start at [[id(0)]]
+//  - sampler member ids start at [[id(16)]]
+//  - storage buffer member ids start at [[id(32)]]
+struct MslArgumentBuffer {
+    static const uint32_t DescriptorSet = 1;
+    static const int ImageIdOffset = 0;
+    static const int SamplerIdOffset = 16;
+    static const int StorageBufferIdOffset = 32;
+
+    static int buffer_index(bool is_vertex_stage) { return is_vertex_stage ? 12 : 4; }
+    static int image_id(int slot) { return ImageIdOffset + slot; }
+    static int sampler_id(int slot) { return SamplerIdOffset + slot; }
+    static int storage_buffer_id(int slot) { return StorageBufferIdOffset + slot; }
+};
+
+} // namespace shdc
@@ -0,0 +1,120 @@
+#pragma once
+#include <string>
+#include <stdlib.h>
+
+namespace shdc {
+
+// the Metal shading language version, used both for the SPIRV-Cross MSL
+// output and the Metal compiler -std flag, each version has a matching
+// minimum macOS and iOS deployment target
+struct MslVersion {
+    enum Enum {
+        MSL_1_1 = 0,
+        MSL_1_2,
+        MSL_2_0,
+        MSL_2_1,
+        MSL_2_2,
+        MSL_2_3,
+        MSL_2_4,
+        MSL_3_0,
+        NUM,
+        INVALID,
+    };
+
+    static const char* to_str(Enum v);
+    static Enum from_str(const std::string& str);
+    static int major(Enum v);
+    static int minor(Enum v);
+    static const char* macos_min(Enum v);
+    static const char* ios_min(Enum v);
+    // the version a shader is compiled with, function constants (from specialization
+    // constants) need at least Metal 1.2, and argument buffers need at least Metal 2.0
+    static Enum for_shader(Enum requested, bool function_constants, bool argument_buffers);
+    // convert an OS version string 'major.minor' into a comparable number, -1 if invalid
+    static int os_version_value(const std::string& str);
+};
+
+inline const char* MslVersion::to_str(Enum v) {
+    switch (v) {
+        case MSL_1_1: return "1.1";
+        case MSL_1_2: return "1.2";
+        case MSL_2_0: return "2.0";
+        case MSL_2_1: return "2.1";
+        case MSL_2_2: return "2.2";
+        case MSL_2_3: return "2.3";
+        case MSL_2_4: return "2.4";
+        case MSL_3_0: return "3.0";
+        default: return "<invalid>";
+    }
+}
+
+inline MslVersion::Enum MslVersion::from_str(const std::string& str) {
+    for (int i = 0; i < NUM; i++) {
+        if (str == to_str((Enum)i)) {
+            return (Enum)i;
+        }
+    }
+    return INVALID;
+}
+
+inline int MslVersion::major(Enum v) {
+    return to_str(v)[0] - '0';
+}
+
+inline int MslVersion::minor(Enum v) {
+    return to_str(v)[2] - '0';
+}
+
+inline const char* MslVersion::macos_min(Enum v) {
+    switch (v) {
+        case MSL_1_1: return "10.11";
+        case MSL_1_2: return "10.12";
+        case MSL_2_0: return "10.13";
+        case MSL_2_1: return "10.14";
+        case MSL_2_2: return "10.15";
+        case MSL_2_3: return "11.0";
+        case MSL_2_4: return "12.0";
+        case MSL_3_0: return "13.0";
+        default: return "<invalid>";
+    }
+}
+
+inline const char* MslVersion::ios_min(Enum v) {
+    switch (v) {
+        case MSL_1_1: return "9.0";
+        case MSL_1_2: return "10.0";
+        case MSL_2_0: return "11.0";
+        case MSL_2_1: return "12.0";
+        case MSL_2_2: return "13.0";
+        case MSL_2_3: return "14.0";
+        case MSL_2_4: return "15.0";
+        case MSL_3_0: return "16.0";
+        default: return "<invalid>";
+    }
+}
+
+inline MslVersion::Enum MslVersion::for_shader(Enum requested, bool function_constants, bool argument_buffers) {
+    Enum v = requested;
+    if (function_constants && (v < MSL_1_2)) {
+        v = MSL_1_2;
+    }
+    if (argument_buffers && (v < MSL_2_0)) {
+        v = MSL_2_0;
+    }
+    return v;
+}
+
+inline int MslVersion::os_version_value(const std::string& str) {
+    const size_t dot = str.find('.');
+    if ((dot == std::string::npos) || (dot == 0) || (dot + 1 == str.size())) {
+        return -1;
+    }
+    for (size_t i = 0; i < str.size(); i++) {
+        if ((i != dot) && ((str[i] < '0') || (str[i] > '9'))) {
+            return -1;
+        }
+    }
+    return atoi(str.substr(0, dot).c_str()) * 100 + atoi(str.substr(dot + 1).c_str());
+}
+
+} // namespace shdc
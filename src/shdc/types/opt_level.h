@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+
+namespace shdc {
+
+// the SPIRV optimization level
+struct OptLevel {
+    enum Enum {
+        NONE = 0,
+        SIZE,
+        PERF,
+        NUM,
+        INVALID,
+    };
+
+    static const char* to_str(Enum o);
+    static Enum from_str(const std::string& str);
+};
+
+inline const char* OptLevel::to_str(Enum o) {
+    switch (o) {
+        case NONE:  return "none";
+        case SIZE:  return "size";
+        case PERF:  return "perf";
+        default:    return "<invalid>";
+    }
+}
+
+inline OptLevel::Enum OptLevel::from_str(const std::string& str) {
+    if (str == "none") {
+        return NONE;
+    } else if (str == "size") {
+        return SIZE;
+    } else if (str == "perf") {
+        return PERF;
+    } else {
+        return INVALID;
+    }
+}
+
+} // namespace shdc
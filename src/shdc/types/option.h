@@ -9,8 +9,14 @@ struct Option {
         INVALID = 0,
         FIXUP_CLIPSPACE = (1<<0),
         FLIP_VERT_Y = (1<<1),
+        FS_MEDIUMP = (1<<2),    // fragment shader default float precision is mediump (GLSL ES only)
+        ARGUMENT_BUFFERS = (1<<3),  // bind images, samplers and storage buffers through a Metal argument buffer (MSL only)
+        UNIFORM_BUFFERS = (1<<4),   // keep uniform blocks as native uniform buffers (desktop GLSL only)
+        PRECISE_MATH = (1<<5),      // compile Metal bytecode without -ffast-math (MSL only)
+        EARLY_FRAGMENT_TESTS = (1<<6),  // force early fragment tests (set by @early_fragment_tests where supported)
     };
     static Enum from_string(const std::string& str);
+    static bool is_vertex_option(Enum e);
 };
 
 inline Option::Enum Option::from_string(const std::string& str) {
@@ -18,9 +24,21 @@ inline Option::Enum Option::from_string(const std::string& str) {
         return FIXUP_CLIPSPACE;
     } else if (str == "flip_vert_y") {
         return FLIP_VERT_Y;
+    } else if (str == "fs_default_precision=mediump") {
+        return FS_MEDIUMP;
+    } else if (str == "argument_buffers") {
+        return ARGUMENT_BUFFERS;
+    } else if (str == "uniform_buffers") {
+        return UNIFORM_BUFFERS;
+    } else if (str == "precise_math") {
+        return PRECISE_MATH;
     } else {
         return INVALID;
     }
 }
 
+inline bool Option::is_vertex_option(Enum e) {
+    return (e == FIXUP_CLIPSPACE) || (e == FLIP_VERT_Y);
+}
+
 } // namespace shdc
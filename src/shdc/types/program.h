@@ -1,17 +1,24 @@
 #pragma once
 #include <string>
+#include <vector>
 
 namespace shdc {
 
-// a vertex-/fragment-shader pair (@program)
+// a vertex-/fragment-shader pair, or a single compute shader (@program)
 struct Program {
     std::string name;
     std::string vs_name;    // name of vertex shader snippet
     std::string fs_name;    // name of fragment shader snippet
+    std::string cs_name;    // name of compute shader snippet (vs_name and fs_name are empty)
     int line_index = -1;    // line index in input source (zero-based)
+    std::vector<std::string> features;  // optional @permutation feature defines
+    std::vector<std::string> variants;  // with @permutation: program names of all variants, indexed by feature mask
+    int permutation_line_index = -1;    // line index of the @permutation tag
 
     Program();
     Program(const std::string& n, const std::string& vs, const std::string& fs, int l);
+    static Program compute(const std::string& n, const std::string& cs, int l);
+    bool is_compute() const;
 };
 
 inline Program::Program() { };
@@ -23,4 +30,16 @@ inline Program::Program(const std::string& n, const std::string& vs, const std::
     line_index(l)
 { };
 
+inline Program Program::compute(const std::string& n, const std::string& cs, int l) {
+    Program prog;
+    prog.name = n;
+    prog.cs_name = cs;
+    prog.line_index = l;
+    return prog;
+}
+
+inline bool Program::is_compute() const {
+    return !cs_name.empty();
+}
+
 } // namespace shdc
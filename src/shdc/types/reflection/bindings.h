@@ -1,4 +1,5 @@
 #pragma once
+#include <unordered_map>
 #include "uniform_block.h"
 #include "image.h"
 #include "sampler.h"
@@ -8,12 +9,19 @@
 namespace shdc::refl {
 
 struct Bindings {
+    // don't add items directly, use the add_*() functions which also update the lookup tables
     std::vector<UniformBlock> uniform_blocks;
     std::vector<StorageBuffer> storage_buffers;
     std::vector<Image> images;
     std::vector<Sampler> samplers;
     std::vector<ImageSampler> image_samplers;
 
+    void add_uniform_block(const UniformBlock& ub);
+    void add_storage_buffer(const StorageBuffer& sbuf);
+    void add_image(const Image& img);
+    void add_sampler(const Sampler& smp);
+    void add_image_sampler(const ImageSampler& img_smp);
+
     const UniformBlock* find_uniform_block_by_slot(int slot) const;
     const StorageBuffer* find_storage_buffer_by_slot(int slot) const;
     const Image* find_image_by_slot(int slot) const;
@@ -27,96 +35,112 @@ struct Bindings {
     const ImageSampler* find_image_sampler_by_name(const std::string& name) const;
 
     void dump_debug(const std::string& indent) const;
+
+private:
+    // hashed name lookup and dense slot-to-item-index tables (-1 for unused slots),
+    // if several items have the same slot or name, the first one wins
+    struct Index {
+        std::unordered_map<std::string, int> names;
+        std::vector<int> slots;
+        void add(const std::string& name, int slot, int item_index);
+        int find_slot(int slot) const;
+        int find_name(const std::string& name) const;
+    };
+    Index uniform_block_index;
+    Index storage_buffer_index;
+    Index image_index;
+    Index sampler_index;
+    Index image_sampler_index;
+
+    template<typename T> static const T* item_at(const std::vector<T>& items, int item_index) {
+        return (item_index >= 0) ? &items[item_index] : nullptr;
+    }
 };
 
-inline const UniformBlock* Bindings::find_uniform_block_by_slot(int slot) const {
-    for (const UniformBlock& ub: uniform_blocks) {
-        if (ub.slot == slot) {
-            return &ub;
+inline void Bindings::Index::add(const std::string& name, int slot, int item_index) {
+    names.emplace(name, item_index);
+    if (slot >= 0) {
+        if (slot >= (int)slots.size()) {
+            slots.resize(slot + 1, -1);
+        }
+        if (slots[slot] == -1) {
+            slots[slot] = item_index;
         }
     }
-    return nullptr;
+}
+
+inline int Bindings::Index::find_slot(int slot) const {
+    return ((slot >= 0) && (slot < (int)slots.size())) ? slots[slot] : -1;
+}
+
+inline int Bindings::Index::find_name(const std::string& name) const {
+    auto it = names.find(name);
+    return (it != names.end()) ? it->second : -1;
+}
+
+inline void Bindings::add_uniform_block(const UniformBlock& ub) {
+    uniform_block_index.add(ub.struct_info.name, ub.slot, (int)uniform_blocks.size());
+    uniform_blocks.push_back(ub);
+}
+
+inline void Bindings::add_storage_buffer(const StorageBuffer& sbuf) {
+    storage_buffer_index.add(sbuf.struct_info.name, sbuf.slot, (int)storage_buffers.size());
+    storage_buffers.push_back(sbuf);
+}
+
+inline void Bindings::add_image(const Image& img) {
+    image_index.add(img.name, img.slot, (int)images.size());
+    images.push_back(img);
+}
+
+inline void Bindings::add_sampler(const Sampler& smp) {
+    sampler_index.add(smp.name, smp.slot, (int)samplers.size());
+    samplers.push_back(smp);
+}
+
+inline void Bindings::add_image_sampler(const ImageSampler& img_smp) {
+    image_sampler_index.add(img_smp.name, img_smp.slot, (int)image_samplers.size());
+    image_samplers.push_back(img_smp);
+}
+
+inline const UniformBlock* Bindings::find_uniform_block_by_slot(int slot) const {
+    return item_at(uniform_blocks, uniform_block_index.find_slot(slot));
 }
 
 inline const StorageBuffer* Bindings::find_storage_buffer_by_slot(int slot) const {
-    for (const StorageBuffer& sbuf: storage_buffers) {
-        if (sbuf.slot == slot) {
-            return &sbuf;
-        }
-    }
-    return nullptr;
+    return item_at(storage_buffers, storage_buffer_index.find_slot(slot));
 }
 
 inline const Image* Bindings::find_image_by_slot(int slot) const {
-    for (const Image& img: images) {
-        if (img.slot == slot) {
-            return &img;
-        }
-    }
-    return nullptr;
+    return item_at(images, image_index.find_slot(slot));
 }
 
 inline const Sampler* Bindings::find_sampler_by_slot(int slot) const {
-    for (const Sampler& smp: samplers) {
-        if (smp.slot == slot) {
-            return &smp;
-        }
-    }
-    return nullptr;
+    return item_at(samplers, sampler_index.find_slot(slot));
 }
 
 inline const ImageSampler* Bindings::find_image_sampler_by_slot(int slot) const {
-    for (const ImageSampler& img_smp: image_samplers) {
-        if (img_smp.slot == slot) {
-            return &img_smp;
-        }
-    }
-    return nullptr;
+    return item_at(image_samplers, image_sampler_index.find_slot(slot));
 }
 
 inline const UniformBlock* Bindings::find_uniform_block_by_name(const std::string& name) const {
-    for (const UniformBlock& ub: uniform_blocks) {
-        if (ub.struct_info.name == name) {
-            return &ub;
-        }
-    }
-    return nullptr;
+    return item_at(uniform_blocks, uniform_block_index.find_name(name));
 }
 
 inline const StorageBuffer* Bindings::find_storage_buffer_by_name(const std::string& name) const {
-    for (const StorageBuffer& sbuf: storage_buffers) {
-        if (sbuf.struct_info.name == name) {
-            return &sbuf;
-        }
-    }
-    return nullptr;
+    return item_at(storage_buffers, storage_buffer_index.find_name(name));
 }
 
 inline const Image* Bindings::find_image_by_name(const std::string& name) const {
-    for (const Image& img: images) {
-        if (img.name == name) {
-            return &img;
-        }
-    }
-    return nullptr;
+    return item_at(images, image_index.find_name(name));
 }
 
 inline const Sampler* Bindings::find_sampler_by_name(const std::string& name) const {
-    for (const Sampler& smp: samplers) {
-        if (smp.name == name) {
-            return &smp;
-        }
-    }
-    return nullptr;
+    return item_at(samplers, sampler_index.find_name(name));
 }
 
 inline const ImageSampler* Bindings::find_image_sampler_by_name(const std::string& name) const {
-    for (const ImageSampler& img_smp: image_samplers) {
-        if (img_smp.name == name) {
-            return &img_smp;
-        }
-    }
-    return nullptr;
+    return item_at(image_samplers, image_sampler_index.find_name(name));
 }
 
 inline void Bindings::dump_debug(const std::string& indent) const {
@@ -0,0 +1,32 @@
+#pragma once
+#include <assert.h>
+
+namespace shdc::refl {
+
+// program layout-compatibility classes, programs with the same class value
+// have an identical layout for this class and can share bindings when batching draws
+struct LayoutClass {
+    enum Enum {
+        VertexLayout = 0,   // vertex shader inputs (slots, formats, semantics, vertex buffers)
+        Bindings,           // uniform blocks, storage buffers, images and samplers on all stages
+        Num,
+        Invalid,
+    };
+    static const char* to_str(Enum e);
+    static Enum from_index(int idx);
+};
+
+inline const char* LayoutClass::to_str(LayoutClass::Enum e) {
+    switch (e) {
+        case VertexLayout: return "VERTEX_LAYOUT";
+        case Bindings: return "BINDINGS_LAYOUT";
+        default: return "INVALID";
+    }
+}
+
+inline LayoutClass::Enum LayoutClass::from_index(int idx) {
+    assert((idx >= 0) && (idx < Num));
+    return (LayoutClass::Enum)idx;
+}
+
+} // namespace
@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+#include "type.h"
+#include "stage_attr.h"
+#include "bindings.h"
+
+namespace shdc::refl {
+
+// a 64-bit FNV-1a hash over the content of a program, integers are hashed as
+// little-endian 32-bit words and strings are prefixed with their length, so
+// that the result doesn't depend on the host platform
+struct ProgramHasher {
+    uint64_t hash = 0xCBF29CE484222325;
+
+    void add(const void* data, size_t num_bytes) {
+        const uint8_t* ptr = (const uint8_t*)data;
+        for (size_t i = 0; i < num_bytes; i++) {
+            hash ^= ptr[i];
+            hash *= 0x00000100000001B3;
+        }
+    }
+    void add(int val) {
+        const uint8_t bytes[4] = { (uint8_t)val, (uint8_t)(val >> 8), (uint8_t)(val >> 16), (uint8_t)(val >> 24) };
+        add(bytes, sizeof(bytes));
+    }
+    void add(const std::string& str) {
+        add((int)str.size());
+        add(str.data(), str.size());
+    }
+    void add(const Type& type) {
+        add(type.name);
+        add(type.struct_typename);
+        add((int)type.type);
+        add(type.is_matrix ? 1 : 0);
+        add(type.is_array ? 1 : 0);
+        add(type.offset);
+        add(type.size);
+        add(type.align);
+        add(type.matrix_stride);
+        add(type.array_count);
+        add(type.array_stride);
+        add((int)type.struct_items.size());
+        for (const Type& item: type.struct_items) {
+            add(item);
+        }
+    }
+    void add(const StageAttr& attr) {
+        add(attr.slot);
+        add(attr.name);
+        add(attr.sem_name);
+        add(attr.sem_index);
+        add((int)attr.type_info.type);
+        add((int)attr.format);
+        add(attr.buffer_index);
+        add(attr.per_instance ? 1 : 0);
+    }
+    void add(const Bindings& bindings) {
+        add((int)bindings.uniform_blocks.size());
+        for (const UniformBlock& ub: bindings.uniform_blocks) {
+            add(ub.slot);
+            add(ub.inst_name);
+            add(ub.flattened ? 1 : 0);
+            add(ub.struct_info);
+        }
+        add((int)bindings.storage_buffers.size());
+        for (const StorageBuffer& sbuf: bindings.storage_buffers) {
+            add(sbuf.slot);
+            add(sbuf.inst_name);
+            add(sbuf.readonly ? 1 : 0);
+            add(sbuf.struct_info);
+        }
+        add((int)bindings.images.size());
+        for (const Image& img: bindings.images) {
+            add(img.slot);
+            add(img.name);
+            add((int)img.type);
+            add((int)img.sample_type);
+            add(img.multisampled ? 1 : 0);
+        }
+        add((int)bindings.samplers.size());
+        for (const Sampler& smp: bindings.samplers) {
+            add(smp.slot);
+            add(smp.name);
+            add((int)smp.type);
+        }
+        add((int)bindings.image_samplers.size());
+        for (const ImageSampler& img_smp: bindings.image_samplers) {
+            add(img_smp.slot);
+            add(img_smp.name);
+            add(img_smp.image_name);
+            add(img_smp.sampler_name);
+        }
+    }
+};
+
+} // namespace
@@ -1,21 +1,55 @@
 #pragma once
 #include <array>
+#include <memory>
 #include "stage_reflection.h"
+#include "layout_class.h"
 
 namespace shdc::refl {
 
 struct ProgramReflection {
+    // the stage reflections are shared with the SpirvcrossSource objects instead
+    // of copied, a missing stage reads as a default StageReflection
+    struct Stages {
+        std::array<std::shared_ptr<const StageReflection>, ShaderStage::Num> ptrs;
+
+        struct Iterator {
+            const Stages* stages;
+            int index;
+            const StageReflection& operator*() const { return (*stages)[index]; }
+            Iterator& operator++() { index++; return *this; }
+            bool operator!=(const Iterator& other) const { return index != other.index; }
+        };
+        const StageReflection& operator[](int i) const;
+        Iterator begin() const { return Iterator{ this, 0 }; }
+        Iterator end() const { return Iterator{ this, ShaderStage::Num }; }
+    };
     std::string name;
-    std::array<StageReflection, ShaderStage::Num> stages;
+    Stages stages;
+    // layout-compatibility class hashes (see Reflection::build()), the vertex layout class
+    // of compute programs is 0
+    std::array<uint64_t, LayoutClass::Num> layout_classes = { };
 
     const StageReflection& stage(ShaderStage::Enum s) const;
     const StageReflection& vs() const;
     const StageReflection& fs() const;
+    const StageReflection& cs() const;
     const std::string& vs_name() const;
     const std::string& fs_name() const;
+    const std::string& cs_name() const;
+    // true if the program has a shader for this stage (compute programs only have a compute stage)
+    bool has_stage(ShaderStage::Enum s) const;
+    bool is_compute() const;
+    // true if any vertex shader input has an @vertex_format tag
+    bool has_vertex_layout() const;
     void dump_debug(const std::string& indent) const;
 };
 
+inline const StageReflection& ProgramReflection::Stages::operator[](int i) const {
+    static const StageReflection empty;
+    assert((i >= 0) && (i < ShaderStage::Num));
+    return ptrs[i] ? *ptrs[i] : empty;
+}
+
 inline const StageReflection& ProgramReflection::stage(ShaderStage::Enum s) const {
     assert((s >= 0) && (s < ShaderStage::Num));
     return stages[s];
@@ -29,6 +63,10 @@ inline const StageReflection& ProgramReflection::fs() const {
     return stages[ShaderStage::Fragment];
 }
 
+inline const StageReflection& ProgramReflection::cs() const {
+    return stages[ShaderStage::Compute];
+}
+
 inline const std::string& ProgramReflection::vs_name() const {
     return stages[ShaderStage::Vertex].snippet_name;
 }
@@ -37,13 +75,39 @@ inline const std::string& ProgramReflection::fs_name() const {
     return stages[ShaderStage::Fragment].snippet_name;
 }
 
+inline const std::string& ProgramReflection::cs_name() const {
+    return stages[ShaderStage::Compute].snippet_name;
+}
+
+inline bool ProgramReflection::has_stage(ShaderStage::Enum s) const {
+    return stage(s).stage != ShaderStage::Invalid;
+}
+
+inline bool ProgramReflection::is_compute() const {
+    return has_stage(ShaderStage::Compute);
+}
+
+inline bool ProgramReflection::has_vertex_layout() const {
+    for (const StageAttr& attr: vs().inputs) {
+        if ((attr.slot >= 0) && (attr.format != VertexFormat::INVALID)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 inline void ProgramReflection::dump_debug(const std::string& indent) const {
     const std::string indent2 = indent + "  ";
     fmt::print(stderr, "{}-\n", indent);
     fmt::print(stderr, "{}name: {}\n", indent2, name);
+    for (int i = 0; i < LayoutClass::Num; i++) {
+        fmt::print(stderr, "{}layout_class {}: 0x{:016X}\n", indent2, LayoutClass::to_str(LayoutClass::from_index(i)), layout_classes[i]);
+    }
     fmt::print(stderr, "{}stages:\n", indent2);
     for (const auto& stage: stages) {
-        stage.dump_debug(indent2);
+        if (stage.stage != ShaderStage::Invalid) {
+            stage.dump_debug(indent2);
+        }
     }
 }
 
@@ -7,6 +7,7 @@ struct ShaderStage {
     enum Enum {
         Vertex = 0,
         Fragment,
+        Compute,
         Num,
         Invalid,
     };
@@ -14,12 +15,14 @@ struct ShaderStage {
     static Enum from_index(int idx);
     static bool is_vs(Enum e);
     static bool is_fs(Enum e);
+    static bool is_cs(Enum e);
 };
 
 inline const char* ShaderStage::to_str(ShaderStage::Enum e) {
     switch (e) {
         case Vertex: return "VS";
         case Fragment: return "FS";
+        case Compute: return "CS";
         default: return "INVALID";
     }
 }
@@ -37,4 +40,8 @@ inline bool ShaderStage::is_fs(ShaderStage::Enum e) {
     return Fragment == e;
 }
 
+inline bool ShaderStage::is_cs(ShaderStage::Enum e) {
+    return Compute == e;
+}
+
 } // namespace
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include "fmt/format.h"
+#include "type.h"
+
+namespace shdc::refl {
+
+// a specialization constant declared with layout(constant_id=N)
+struct SpecConstant {
+    int id = -1;                        // the constant_id
+    std::string name;
+    Type::Enum type = Type::Invalid;    // Bool, Int, UInt or Float
+    std::string default_value;          // as literal, e.g. "true", "-1", "0.5"
+
+    bool equals(const SpecConstant& other) const;
+    void dump_debug(const std::string& indent) const;
+};
+
+inline bool SpecConstant::equals(const SpecConstant& other) const {
+    return (id == other.id)
+        && (name == other.name)
+        && (type == other.type)
+        && (default_value == other.default_value);
+}
+
+inline void SpecConstant::dump_debug(const std::string& indent) const {
+    const std::string indent2 = indent + "  ";
+    fmt::print(stderr, "{}-\n", indent);
+    fmt::print(stderr, "{}id: {}\n", indent2, id);
+    fmt::print(stderr, "{}name: {}\n", indent2, name);
+    fmt::print(stderr, "{}type: {}\n", indent2, Type::type_to_glsl(type));
+    fmt::print(stderr, "{}default_value: {}\n", indent2, default_value);
+}
+
+} // namespace
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include "type.h"
+#include "vertex_format.h"
 
 namespace shdc::refl {
 
@@ -12,6 +13,10 @@ struct StageAttr {
     int sem_index = 0;
     std::string snippet_name;
     Type type_info;
+    // vertex layout info, from an optional @vertex_format tag (vertex shader inputs only)
+    VertexFormat::Enum format = VertexFormat::INVALID;
+    int buffer_index = 0;
+    bool per_instance = false;
 
     bool equals(const StageAttr& rhs, bool with_snippet_name) const;
     void dump_debug(const std::string& indent) const;
@@ -40,6 +45,11 @@ inline void StageAttr::dump_debug(const std::string& indent) const {
     fmt::print(stderr, "{}sem_name: {}\n", indent2, sem_name);
     fmt::print(stderr, "{}sem_index: {}\n", indent2, sem_index);
     fmt::print(stderr, "{}snippet_name: {}\n", indent2, snippet_name);
+    if (format != VertexFormat::INVALID) {
+        fmt::print(stderr, "{}format: {}\n", indent2, VertexFormat::to_str(format));
+        fmt::print(stderr, "{}buffer_index: {}\n", indent2, buffer_index);
+        fmt::print(stderr, "{}per_instance: {}\n", indent2, per_instance);
+    }
 }
 
 } // namespace
@@ -1,10 +1,12 @@
 #pragma once
 #include <string>
 #include <array>
+#include <vector>
 #include "fmt/format.h"
 #include "shader_stage.h"
 #include "stage_attr.h"
 #include "bindings.h"
+#include "spec_constant.h"
 
 namespace shdc::refl {
 
@@ -14,22 +16,50 @@ struct StageReflection {
     ShaderStage::Enum stage = ShaderStage::Invalid;
     std::string stage_name;                             // same as ShaderStage::to_str(stage)
     std::string entry_point;
+    std::string msl_entry_point;                        // optional unique MSL entry point name (--single-metallib)
     std::array<StageAttr, StageAttr::Num> inputs;       // index == attribute slot
     std::array<StageAttr, StageAttr::Num> outputs;      // index == attribute slot
     Bindings bindings;
+    bool uses_16bit_types = false;                      // float16_t/f16vec* in shader code or resources
+    std::array<int, 3> workgroup_size = { 0, 0, 0 };    // compute shader local_size_x/y/z, otherwise zero
+    std::vector<SpecConstant> spec_constants;           // layout(constant_id=N) constants, sorted by id
+    // fragment stage only, conditions which disable early depth/stencil tests
+    bool discards = false;                              // OpKill, OpTerminateInvocation or OpDemoteToHelperInvocation
+    bool writes_frag_depth = false;                     // gl_FragDepth is written
+    bool early_fragment_tests = false;                  // @early_fragment_tests or layout(early_fragment_tests) in
 
     std::string entry_point_by_slang(Slang::Enum slang) const;
+    // true if the fragment stage may run depth/stencil tests only after the fragment shader
+    bool disables_early_fragment_tests() const;
+    // comma-separated list of the conditions which disable early fragment tests
+    std::string early_fragment_tests_hazards() const;
     void dump_debug(const std::string& indent) const;
 };
 
 inline std::string StageReflection::entry_point_by_slang(Slang::Enum slang) const {
     if (Slang::is_msl(slang)) {
-        return entry_point + "0";
+        return msl_entry_point.empty() ? (entry_point + "0") : msl_entry_point;
     } else {
         return entry_point;
     }
 }
 
+inline bool StageReflection::disables_early_fragment_tests() const {
+    return ShaderStage::is_fs(stage) && !early_fragment_tests && (discards || writes_frag_depth);
+}
+
+inline std::string StageReflection::early_fragment_tests_hazards() const {
+    std::string res;
+    auto add = [&res](bool cond, const char* str) {
+        if (cond) {
+            res += res.empty() ? str : fmt::format(", {}", str);
+        }
+    };
+    add(discards, "discard");
+    add(writes_frag_depth, "gl_FragDepth write");
+    return res;
+}
+
 inline void StageReflection::dump_debug(const std::string& indent) const {
     const std::string indent2 = indent + "  ";
     fmt::print(stderr, "{}-\n", indent);
@@ -37,6 +67,16 @@ inline void StageReflection::dump_debug(const std::string& indent) const {
     fmt::print(stderr, "{}snippet_index: {}\n", indent2, snippet_index);
     fmt::print(stderr, "{}snippet_name: {}\n", indent2, snippet_name);
     fmt::print(stderr, "{}entry_point: {}\n", indent2, entry_point);
+    fmt::print(stderr, "{}uses_16bit_types: {}\n", indent2, uses_16bit_types);
+    if (ShaderStage::is_cs(stage)) {
+        fmt::print(stderr, "{}workgroup_size: [{}, {}, {}]\n", indent2, workgroup_size[0], workgroup_size[1], workgroup_size[2]);
+    }
+    if (ShaderStage::is_fs(stage)) {
+        fmt::print(stderr, "{}discards: {}\n", indent2, discards);
+        fmt::print(stderr, "{}writes_frag_depth: {}\n", indent2, writes_frag_depth);
+        fmt::print(stderr, "{}early_fragment_tests: {}\n", indent2, early_fragment_tests);
+    }
+    fmt::print(stderr, "{}msl_entry_point: {}\n", indent2, msl_entry_point);
     fmt::print(stderr, "{}inputs:\n", indent2);
     for (const auto& input: inputs) {
         if (input.slot != -1) {
@@ -49,6 +89,10 @@ inline void StageReflection::dump_debug(const std::string& indent) const {
             output.dump_debug(indent2);
         }
     }
+    fmt::print(stderr, "{}spec_constants:\n", indent2);
+    for (const auto& spec: spec_constants) {
+        spec.dump_debug(indent2);
+    }
     fmt::print(stderr, "{}bindings:\n", indent2);
     bindings.dump_debug(indent2);
 }
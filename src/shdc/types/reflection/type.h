@@ -37,6 +37,11 @@ struct Type {
         Mat4x3,
         Mat4x4,
         Struct,
+        // 16-bit types are appended to keep the enum values stable
+        Half,
+        Half2,
+        Half3,
+        Half4,
     };
     std::string name;
     std::string struct_typename;
@@ -141,6 +146,10 @@ inline std::string Type::type_to_str(Type::Enum e) {
         case Mat4x3:    return "Mat4x3";
         case Mat4x4:    return "Mat4x4";
         case Struct:    return "Struct";
+        case Half:      return "Half";
+        case Half2:     return "Half2";
+        case Half3:     return "Half3";
+        case Half4:     return "Half4";
         default:        return "INVALID";
     }
 }
@@ -179,6 +188,10 @@ inline std::string Type::type_to_glsl(Type::Enum e) {
         case Mat4x2:    return "mat4x2";
         case Mat4x3:    return "mat4x3";
         case Mat4x4:    return "mat4";
+        case Half:      return "float16_t";
+        case Half2:     return "f16vec2";
+        case Half3:     return "f16vec3";
+        case Half4:     return "f16vec4";
         default:        return "INVALID";
     }
 }
@@ -214,11 +227,15 @@ inline bool Type::is_valid_glsl_type(const std::string& str) {
         (str == "mat4x1") ||
         (str == "mat4x2") ||
         (str == "mat4x3") ||
-        (str == "mat4x4");
+        (str == "mat4x4") ||
+        (str == "float16_t") ||
+        (str == "f16vec2") ||
+        (str == "f16vec3") ||
+        (str == "f16vec4");
 }
 
 inline std::string Type::valid_glsl_types_as_str() {
-    return "float|vec[2..4]|bool|bvec[2..4]|int|ivec[2..4]|uint|uvec[2..4]|mat[2..4]|mat[2..4]x[1..4]";
+    return "float|vec[2..4]|bool|bvec[2..4]|int|ivec[2..4]|uint|uvec[2..4]|mat[2..4]|mat[2..4]x[1..4]|float16_t|f16vec[2..4]";
 }
 
 inline void Type::dump_debug(const std::string& indent) const {
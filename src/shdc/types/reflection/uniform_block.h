@@ -9,11 +9,19 @@ namespace shdc::refl {
 
 struct UniformBlock {
     static const int Num = 4;     // must be identical with SG_MAX_SHADERSTAGE_UBS
+    // the GL bind point of a native uniform buffer (@glsl_options uniform_buffers),
+    // GL has a common bind space for all shader stages, so fragment shader bind
+    // points are offset (compute programs only have a single stage)
+    static int glsl_binding(bool is_fs, int slot) { return (is_fs ? Num : 0) + slot; }
     ShaderStage::Enum stage = ShaderStage::Invalid;
     int slot = -1;
     std::string inst_name;
     bool flattened = false;
     Type struct_info;
+    // active-member analysis, not part of equals() since the same uniform block
+    // may be used differently by different shader snippets
+    std::vector<int> unused_items;  // indices of struct items which are never read by the shader
+    int active_size = 0;            // number of bytes which are actually read by the shader
 
     bool equals(const UniformBlock& other) const;
     void dump_debug(const std::string& indent) const;
@@ -34,6 +42,11 @@ inline void UniformBlock::dump_debug(const std::string& indent) const {
     fmt::print(stderr, "{}slot: {}\n", indent2, slot);
     fmt::print(stderr, "{}inst_name: {}\n", indent2, inst_name);
     fmt::print(stderr, "{}flattened: {}\n", indent2, flattened);
+    fmt::print(stderr, "{}active_size: {}\n", indent2, active_size);
+    fmt::print(stderr, "{}unused_items:\n", indent2);
+    for (int item_index: unused_items) {
+        fmt::print(stderr, "{}  - {}\n", indent2, item_index);
+    }
     fmt::print(stderr, "{}struct:\n", indent2);
     struct_info.dump_debug(indent2);
 }
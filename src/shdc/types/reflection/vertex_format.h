@@ -0,0 +1,174 @@
+#pragma once
+#include <string>
+#include "type.h"
+
+namespace shdc::refl {
+
+// vertex-format (see sg_vertex_format)
+struct VertexFormat {
+    enum Enum {
+        INVALID,
+        FLOAT,
+        FLOAT2,
+        FLOAT3,
+        FLOAT4,
+        INT,
+        INT2,
+        INT3,
+        INT4,
+        UINT,
+        UINT2,
+        UINT3,
+        UINT4,
+        BYTE4,
+        BYTE4N,
+        UBYTE4,
+        UBYTE4N,
+        SHORT2,
+        SHORT2N,
+        USHORT2,
+        USHORT2N,
+        SHORT4,
+        SHORT4N,
+        USHORT4,
+        USHORT4N,
+        UINT10_N2,
+        HALF2,
+        HALF4,
+        NUM,
+    };
+    static const char* to_str(Enum e);
+    static Enum from_str(const std::string& str);
+    static bool is_valid_str(const std::string& str);
+    static std::string valid_vertex_formats_as_str();
+    // the vertex format which matches a vertex shader input type
+    static Enum from_type(Type::Enum t);
+    // check if a vertex format can be read by a vertex shader input type
+    static bool is_compatible(Enum e, Type::Enum t);
+};
+
+inline const char* VertexFormat::to_str(Enum e) {
+    switch (e) {
+        case FLOAT:     return "float";
+        case FLOAT2:    return "float2";
+        case FLOAT3:    return "float3";
+        case FLOAT4:    return "float4";
+        case INT:       return "int";
+        case INT2:      return "int2";
+        case INT3:      return "int3";
+        case INT4:      return "int4";
+        case UINT:      return "uint";
+        case UINT2:     return "uint2";
+        case UINT3:     return "uint3";
+        case UINT4:     return "uint4";
+        case BYTE4:     return "byte4";
+        case BYTE4N:    return "byte4n";
+        case UBYTE4:    return "ubyte4";
+        case UBYTE4N:   return "ubyte4n";
+        case SHORT2:    return "short2";
+        case SHORT2N:   return "short2n";
+        case USHORT2:   return "ushort2";
+        case USHORT2N:  return "ushort2n";
+        case SHORT4:    return "short4";
+        case SHORT4N:   return "short4n";
+        case USHORT4:   return "ushort4";
+        case USHORT4N:  return "ushort4n";
+        case UINT10_N2: return "uint10_n2";
+        case HALF2:     return "half2";
+        case HALF4:     return "half4";
+        default:        return "invalid";
+    }
+}
+
+inline VertexFormat::Enum VertexFormat::from_str(const std::string& str) {
+    for (int i = FLOAT; i < NUM; i++) {
+        if (str == to_str((Enum)i)) {
+            return (Enum)i;
+        }
+    }
+    return INVALID;
+}
+
+inline bool VertexFormat::is_valid_str(const std::string& str) {
+    return from_str(str) != INVALID;
+}
+
+inline std::string VertexFormat::valid_vertex_formats_as_str() {
+    std::string res;
+    for (int i = FLOAT; i < NUM; i++) {
+        if (i != FLOAT) {
+            res += "|";
+        }
+        res += to_str((Enum)i);
+    }
+    return res;
+}
+
+inline VertexFormat::Enum VertexFormat::from_type(Type::Enum t) {
+    switch (t) {
+        case Type::Float:   return FLOAT;
+        case Type::Float2:  return FLOAT2;
+        case Type::Float3:  return FLOAT3;
+        case Type::Float4:  return FLOAT4;
+        case Type::Int:     return INT;
+        case Type::Int2:    return INT2;
+        case Type::Int3:    return INT3;
+        case Type::Int4:    return INT4;
+        case Type::UInt:    return UINT;
+        case Type::UInt2:   return UINT2;
+        case Type::UInt3:   return UINT3;
+        case Type::UInt4:   return UINT4;
+        case Type::Half2:   return HALF2;
+        case Type::Half4:   return HALF4;
+        default:            return INVALID;
+    }
+}
+
+// float inputs can read float, half and normalized formats, signed and unsigned
+// integer inputs can only read non-normalized integer formats of the same signedness
+inline bool VertexFormat::is_compatible(Enum e, Type::Enum t) {
+    switch (t) {
+        case Type::Float:
+        case Type::Float2:
+        case Type::Float3:
+        case Type::Float4:
+        case Type::Half:
+        case Type::Half2:
+        case Type::Half3:
+        case Type::Half4:
+            switch (e) {
+                case FLOAT: case FLOAT2: case FLOAT3: case FLOAT4:
+                case BYTE4N: case UBYTE4N: case SHORT2N: case USHORT2N:
+                case SHORT4N: case USHORT4N: case UINT10_N2: case HALF2: case HALF4:
+                    return true;
+                default:
+                    return false;
+            }
+        case Type::Int:
+        case Type::Int2:
+        case Type::Int3:
+        case Type::Int4:
+            switch (e) {
+                case INT: case INT2: case INT3: case INT4:
+                case BYTE4: case SHORT2: case SHORT4:
+                    return true;
+                default:
+                    return false;
+            }
+        case Type::UInt:
+        case Type::UInt2:
+        case Type::UInt3:
+        case Type::UInt4:
+            switch (e) {
+                case UINT: case UINT2: case UINT3: case UINT4:
+                case UBYTE4: case USHORT2: case USHORT4:
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+} // namespace
@@ -13,10 +13,12 @@ struct Slang {
         GLSL300ES,
         HLSL4,
         HLSL5,
+        HLSL6,
         METAL_MACOS,
         METAL_IOS,
         METAL_SIM,
         WGSL,
+        SPIRV,
         REFLECTION,     // special 'virtual slang' for extracting reflection info
         Num,
     };
@@ -29,7 +31,14 @@ struct Slang {
     static bool is_hlsl(Enum c);
     static bool is_msl(Enum c);
     static bool is_wgsl(Enum c);
+    static bool is_spirv(Enum c);
     static bool is_reflection(Enum c);
+    // true if 16-bit types (float16_t, f16vec*) are supported in shader code and resources
+    static bool has_16bit_types(Enum c);
+    // true if compute shaders are supported
+    static bool has_compute(Enum c);
+    // true if early fragment tests can be forced (@early_fragment_tests)
+    static bool has_early_fragment_tests(Enum c);
     static Slang::Enum first_valid(uint32_t mask);
 };
 
@@ -49,10 +58,12 @@ inline const char* Slang::to_str(Enum c) {
         case GLSL300ES:     return "glsl300es";
         case HLSL4:         return "hlsl4";
         case HLSL5:         return "hlsl5";
+        case HLSL6:         return "hlsl6";
         case METAL_MACOS:   return "metal_macos";
         case METAL_IOS:     return "metal_ios";
         case METAL_SIM:     return "metal_sim";
         case WGSL:          return "wgsl";
+        case SPIRV:         return "spirv";
         case REFLECTION:    return "reflection";
         default:            return "<invalid>";
     }
@@ -88,6 +99,7 @@ inline bool Slang::is_hlsl(Enum c) {
     switch (c) {
         case HLSL4:
         case HLSL5:
+        case HLSL6:
             return true;
         default:
             return false;
@@ -109,10 +121,26 @@ inline bool Slang::is_wgsl(Enum c) {
     return WGSL == c;
 }
 
+inline bool Slang::is_spirv(Enum c) {
+    return SPIRV == c;
+}
+
 inline bool Slang::is_reflection(Enum c) {
     return REFLECTION == c;
 }
 
+inline bool Slang::has_16bit_types(Enum c) {
+    return is_msl(c) || is_wgsl(c) || is_spirv(c) || (HLSL6 == c);
+}
+
+inline bool Slang::has_compute(Enum c) {
+    return (GLSL410 != c) && (GLSL300ES != c) && (HLSL4 != c);
+}
+
+inline bool Slang::has_early_fragment_tests(Enum c) {
+    return (GLSL430 == c) || (HLSL5 == c) || (HLSL6 == c) || is_msl(c) || is_spirv(c);
+}
+
 inline Slang::Enum Slang::first_valid(uint32_t mask) {
     int i = 0;
     for (i = 0; i < Num; i++) {
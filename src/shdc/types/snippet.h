@@ -6,32 +6,42 @@
 #include "slang.h"
 #include "image_sample_type_tag.h"
 #include "sampler_type_tag.h"
+#include "vertex_format_tag.h"
 
 namespace shdc {
 
-// a named code-snippet (@block, @vs or @fs) in the input source file
+// a named code-snippet (@block, @vs, @fs or @cs) in the input source file
 struct Snippet {
     enum Type {
         INVALID,
         BLOCK,
         VS,
-        FS
+        FS,
+        CS
     };
     int index = -1;
     Type type = INVALID;
     std::array<uint32_t, Slang::Num> options = { };
     std::map<std::string, ImageSampleTypeTag> image_sample_type_tags;
     std::map<std::string, SamplerTypeTag> sampler_type_tags;
+    std::map<std::string, VertexFormatTag> vertex_format_tags;
     std::string name;
     std::vector<int> lines; // resolved zero-based line-indices (including @include_block)
+    std::string source;     // merged source code of all lines (only for @vs, @fs and @cs)
+    std::vector<std::string> defines;   // additional defines of @permutation variants
+    int permutation_base = -1;          // for @permutation variants: index of the original snippet
+    bool early_fragment_tests = false;  // @early_fragment_tests (only for @fs)
 
     Snippet();
     Snippet(Type t, const std::string& n);
     const ImageSampleTypeTag* lookup_image_sample_type_tag(const std::string& tex_name) const;
     const SamplerTypeTag* lookup_sampler_type_tag(const std::string& smp_name) const;
+    const VertexFormatTag* lookup_vertex_format_tag(const std::string& attr_name) const;
     static const char* type_to_str(Type t);
     static bool is_vs(Type t);
     static bool is_fs(Type t);
+    static bool is_cs(Type t);
+    static bool is_shader(Type t);
 };
 
 inline Snippet::Snippet() { };
@@ -56,11 +66,21 @@ inline const SamplerTypeTag* Snippet::lookup_sampler_type_tag(const std::string&
     }
 }
 
+inline const VertexFormatTag* Snippet::lookup_vertex_format_tag(const std::string& attr_name) const {
+    auto it = vertex_format_tags.find(attr_name);
+    if (it != vertex_format_tags.end()) {
+        return &vertex_format_tags.at(attr_name);
+    } else {
+        return nullptr;
+    }
+}
+
 inline const char* Snippet::type_to_str(Type t) {
     switch (t) {
         case BLOCK: return "block";
         case VS: return "vs";
         case FS: return "fs";
+        case CS: return "cs";
         default: return "<invalid>";
     }
 }
@@ -73,4 +93,13 @@ inline bool Snippet::is_fs(Type t) {
     return FS == t;
 }
 
+inline bool Snippet::is_cs(Type t) {
+    return CS == t;
+}
+
+// true for snippets which are compiled to SPIRV (@vs, @fs and @cs)
+inline bool Snippet::is_shader(Type t) {
+    return (VS == t) || (FS == t) || (CS == t);
+}
+
 } // namespace shdc
@@ -7,8 +7,9 @@ namespace shdc {
 // a SPIRV-bytecode blob with "back-link" to Input.snippets
 struct SpirvBlob {
     int snippet_index = -1;         // index into Input.snippets
-    std::string source;             // source code this blob was compiled from
+    std::string preamble;           // defines in front of the snippet source this blob was compiled from
     std::vector<uint32_t> bytecode; // the resulting SPIRV blob
+    int num_unoptimized_instructions = -1;  // before spirv_optimize
 
     SpirvBlob(int snippet_index);
 };
@@ -0,0 +1,17 @@
+#pragma once
+#include <memory>
+#include "errmsg.h"
+#include "reflection/stage_reflection.h"
+
+namespace shdc {
+
+// target-language independent spirv-cross results for one SPIRV blob,
+// computed once and shared by all target languages which use the same blob
+struct SpirvcrossAnalysis {
+    int snippet_index = -1;
+    ErrMsg error;           // resource restriction violations or SPIRVCross exceptions
+    ErrMsg refl_error;      // reflection errors, reported as cross-compilation errors
+    std::shared_ptr<const refl::StageReflection> stage_refl;   // shared by all target language sources instead of copied
+};
+
+} // namespace shdc
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include "errmsg.h"
 #include "reflection/stage_reflection.h"
 
@@ -10,7 +11,7 @@ struct SpirvcrossSource {
     int snippet_index = -1;
     std::string source_code;
     ErrMsg error;
-    refl::StageReflection stage_refl;
+    std::shared_ptr<const refl::StageReflection> stage_refl;   // shared with SpirvcrossAnalysis and ProgramReflection
 };
 
 } // namespace shdc
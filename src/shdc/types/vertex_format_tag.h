@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include "reflection/vertex_format.h"
+
+namespace shdc {
+
+// an @vertex_format tag: [attr] [format] [buffer_index] [per_vertex|per_instance]
+struct VertexFormatTag {
+    std::string attr_name;
+    refl::VertexFormat::Enum format = refl::VertexFormat::INVALID;
+    int buffer_index = 0;
+    bool per_instance = false;
+    int line_index = 0;
+    VertexFormatTag();
+    VertexFormatTag(const std::string& n, refl::VertexFormat::Enum f, int b, bool i, int l);
+};
+
+inline VertexFormatTag::VertexFormatTag() { };
+
+inline VertexFormatTag::VertexFormatTag(const std::string& n, refl::VertexFormat::Enum f, int b, bool i, int l):
+    attr_name(n),
+    format(f),
+    buffer_index(b),
+    per_instance(i),
+    line_index(l)
+{ };
+
+} // namespace shdc
@@ -0,0 +1,32 @@
+@cs cs
+layout(local_size_x=64) in;
+
+struct particle {
+    vec4 pos;
+    vec4 vel;
+};
+
+layout(binding=0) readonly buffer cs_ssbo_in {
+    particle prt_in[];
+};
+
+layout(binding=1) buffer cs_ssbo_out {
+    particle prt_out[];
+};
+
+uniform cs_params {
+    float dt;
+    int num_particles;
+};
+
+void main() {
+    uint idx = gl_GlobalInvocationID.x;
+    if (idx >= uint(num_particles)) {
+        return;
+    }
+    prt_out[idx].pos = prt_in[idx].pos + prt_in[idx].vel * dt;
+    prt_out[idx].vel = prt_in[idx].vel;
+}
+@end
+
+@program compute cs
@@ -0,0 +1,14 @@
+// error: compute shaders are not supported by glsl410 (compile with --slang glsl410)
+@cs cs
+layout(local_size_x=32) in;
+
+layout(binding=0) buffer cs_ssbo {
+    vec4 data[];
+};
+
+void main() {
+    data[gl_GlobalInvocationID.x] *= 2.0;
+}
+@end
+
+@program compute cs
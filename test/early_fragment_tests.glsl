@@ -0,0 +1,40 @@
+@vs vs
+in vec4 position;
+in vec2 texcoord0;
+out vec2 uv;
+
+void main() {
+    gl_Position = position;
+    uv = texcoord0;
+}
+@end
+
+// discards, early fragment tests are disabled
+@fs fs_alpha_test
+uniform texture2D tex;
+uniform sampler smp;
+in vec2 uv;
+out vec4 frag_color;
+
+void main() {
+    frag_color = texture(sampler2D(tex, smp), uv);
+    if (frag_color.a < 0.5) {
+        discard;
+    }
+}
+@end
+
+// writes gl_FragDepth, but early fragment tests are forced
+@fs fs_forced
+@early_fragment_tests
+in vec2 uv;
+out vec4 frag_color;
+
+void main() {
+    frag_color = vec4(uv, 0.0, 1.0);
+    gl_FragDepth = uv.x;
+}
+@end
+
+@program alpha_test vs fs_alpha_test
+@program forced vs fs_forced
@@ -0,0 +1,17 @@
+// error: @early_fragment_tests tag must be inside a @fs block
+@vs vs
+@early_fragment_tests
+in vec4 position;
+void main() {
+    gl_Position = position;
+}
+@end
+
+@fs fs
+out vec4 frag_color;
+void main() {
+    frag_color = vec4(1.0);
+}
+@end
+
+@program prog vs fs
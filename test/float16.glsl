@@ -0,0 +1,36 @@
+// 16-bit float types are only supported by hlsl6, metal, wgsl and spirv
+@vs vs
+uniform vs_params {
+    mat4 mvp;
+    f16vec4 tint;
+    f16vec2 scale;
+    float16_t bias;
+};
+
+struct sb_vertex {
+    vec4 pos;
+    f16vec4 color;
+};
+
+readonly buffer ssbo {
+    sb_vertex vtx[];
+};
+
+out vec4 color;
+
+void main() {
+    vec4 pos = vtx[gl_VertexIndex].pos;
+    gl_Position = mvp * vec4(pos.xy * vec2(scale), pos.zw);
+    color = vec4(vtx[gl_VertexIndex].color * tint) + float(bias);
+}
+@end
+
+@fs fs
+in vec4 color;
+out vec4 frag_color;
+void main() {
+    frag_color = color;
+}
+@end
+
+@program float16 vs fs
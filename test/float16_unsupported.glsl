@@ -0,0 +1,26 @@
+// error: 16-bit types are not supported by the glsl targets, hlsl4 and hlsl5
+// (compile with --slang glsl430, --slang hlsl4 or --slang hlsl5)
+@vs vs
+uniform vs_params {
+    mat4 mvp;
+    f16vec4 tint;
+};
+
+in vec4 position;
+out vec4 color;
+
+void main() {
+    gl_Position = mvp * position;
+    color = vec4(tint);
+}
+@end
+
+@fs fs
+in vec4 color;
+out vec4 frag_color;
+void main() {
+    frag_color = color;
+}
+@end
+
+@program float16 vs fs
@@ -0,0 +1,25 @@
+@include_once include_once_common.glsl
+@include_once include_once_lighting.glsl
+
+@vs vs
+in vec4 position;
+in vec3 normal;
+out vec3 nrm;
+
+void main() {
+    gl_Position = position;
+    nrm = normal;
+}
+@end
+
+@fs fs
+@include_block lighting
+in vec3 nrm;
+out vec4 frag_color;
+
+void main() {
+    frag_color = vec4(light(normalize(nrm), vec3(0.0, 1.0, 0.0)), 1.0);
+}
+@end
+
+@program include_once vs fs
@@ -0,0 +1,6 @@
+// included twice via @include_once, but must only be inserted once
+@block common
+vec3 gamma(vec3 c) {
+    return pow(c, vec3(1.0/2.2));
+}
+@end
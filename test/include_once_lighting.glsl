@@ -0,0 +1,8 @@
+@include_once include_once_common.glsl
+
+@block lighting
+@include_block common
+vec3 light(vec3 nrm, vec3 dir) {
+    return gamma(vec3(max(dot(nrm, dir), 0.0)));
+}
+@end
@@ -0,0 +1,43 @@
+@vs vs
+uniform vs_params {
+    mat4 mvp;
+};
+
+in vec4 position;
+in vec4 color0;
+out vec4 color;
+
+void main() {
+    gl_Position = mvp * position;
+    #if defined(FOG)
+    color = vec4(color0.rgb * 0.5, color0.a);
+    #else
+    color = color0;
+    #endif
+}
+@end
+
+@fs fs
+uniform fs_params {
+    vec4 tint;
+};
+
+in vec4 color;
+out vec4 frag_color;
+
+void main() {
+    #if defined(TINT)
+    frag_color = color * tint;
+    #else
+    frag_color = color;
+    #endif
+    #if defined(ALPHA_TEST)
+    if (frag_color.a < 0.5) {
+        discard;
+    }
+    #endif
+}
+@end
+
+@program mesh vs fs
+@permutation mesh FOG TINT ALPHA_TEST
@@ -0,0 +1,17 @@
+// error: @permutation can have at most 8 features
+@vs vs
+in vec4 position;
+void main() {
+    gl_Position = position;
+}
+@end
+
+@fs fs
+out vec4 frag_color;
+void main() {
+    frag_color = vec4(1.0);
+}
+@end
+
+@program mesh vs fs
+@permutation mesh F0 F1 F2 F3 F4 F5 F6 F7 F8
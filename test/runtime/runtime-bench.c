@@ -0,0 +1,221 @@
+/*
+    runtime-bench.c: headless shader and pipeline creation benchmark over
+    sokol-shdc generated C headers, built and run by runtime-bench.py for
+    each sokol-shdc output mode, the generated programs.h includes the
+    headers and provides the program table.
+
+    Prints one line per created program and iteration to stdout:
+
+    [program index] [iteration] [desc us] [shader us] [pipeline us] [valid]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(SOKOL_GLCORE)
+#include <EGL/egl.h>
+#endif
+#define SOKOL_IMPL
+#include "sokol_gfx.h"
+#include "sokol_log.h"
+#include "sokol_time.h"
+
+typedef struct {
+    int slot;
+    sg_vertex_format format;
+} bench_attr_t;
+
+typedef struct {
+    const char* file;
+    const char* name;
+    const sg_shader_desc* (*shader_desc)(sg_backend backend);
+    bool compute;
+    int num_attrs;
+    bench_attr_t attrs[SG_MAX_VERTEX_ATTRIBUTES];
+    int color_count;
+} bench_program_t;
+
+#include "programs.h"
+
+#define NUM_PROGRAMS ((int)(sizeof(bench_programs) / sizeof(bench_programs[0])))
+
+// headless device or context creation for the host backend
+#if defined(SOKOL_GLCORE)
+static EGLDisplay egl_display = EGL_NO_DISPLAY;
+static EGLSurface egl_surface = EGL_NO_SURFACE;
+static EGLContext egl_context = EGL_NO_CONTEXT;
+
+static bool context_setup(void) {
+    egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if ((egl_display == EGL_NO_DISPLAY) || !eglInitialize(egl_display, 0, 0)) {
+        return false;
+    }
+    const EGLint config_attrs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint num_configs = 0;
+    if (!eglChooseConfig(egl_display, config_attrs, &config, 1, &num_configs) || (num_configs == 0)) {
+        return false;
+    }
+    const EGLint surface_attrs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+    egl_surface = eglCreatePbufferSurface(egl_display, config, surface_attrs);
+    if ((egl_surface == EGL_NO_SURFACE) || !eglBindAPI(EGL_OPENGL_API)) {
+        return false;
+    }
+    const EGLint context_attrs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attrs);
+    if (egl_context == EGL_NO_CONTEXT) {
+        return false;
+    }
+    return eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context);
+}
+
+static sg_environment context_environment(void) {
+    return (sg_environment){
+        .defaults = {
+            .color_format = SG_PIXELFORMAT_RGBA8,
+            .depth_format = SG_PIXELFORMAT_DEPTH_STENCIL,
+            .sample_count = 1,
+        },
+    };
+}
+
+static void context_shutdown(void) {
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(egl_display, egl_context);
+    eglDestroySurface(egl_display, egl_surface);
+    eglTerminate(egl_display);
+}
+#elif defined(SOKOL_METAL)
+static id<MTLDevice> mtl_device;
+
+static bool context_setup(void) {
+    mtl_device = MTLCreateSystemDefaultDevice();
+    return mtl_device != nil;
+}
+
+static sg_environment context_environment(void) {
+    return (sg_environment){
+        .defaults = {
+            .color_format = SG_PIXELFORMAT_BGRA8,
+            .depth_format = SG_PIXELFORMAT_DEPTH_STENCIL,
+            .sample_count = 1,
+        },
+        .metal = {
+            .device = (__bridge const void*) mtl_device,
+        },
+    };
+}
+
+static void context_shutdown(void) {
+    mtl_device = nil;
+}
+#elif defined(SOKOL_D3D11)
+static ID3D11Device* d3d11_device;
+static ID3D11DeviceContext* d3d11_device_context;
+
+static bool context_setup(void) {
+    HRESULT hr = D3D11CreateDevice(0, D3D_DRIVER_TYPE_HARDWARE, 0, D3D11_CREATE_DEVICE_SINGLETHREADED, 0, 0, D3D11_SDK_VERSION, &d3d11_device, 0, &d3d11_device_context);
+    return SUCCEEDED(hr);
+}
+
+static sg_environment context_environment(void) {
+    return (sg_environment){
+        .defaults = {
+            .color_format = SG_PIXELFORMAT_BGRA8,
+            .depth_format = SG_PIXELFORMAT_DEPTH_STENCIL,
+            .sample_count = 1,
+        },
+        .d3d11 = {
+            .device = d3d11_device,
+            .device_context = d3d11_device_context,
+        },
+    };
+}
+
+static void context_shutdown(void) {
+    d3d11_device_context->lpVtbl->Release(d3d11_device_context);
+    d3d11_device->lpVtbl->Release(d3d11_device);
+}
+#else
+#error "runtime-bench.c: define SOKOL_GLCORE, SOKOL_METAL or SOKOL_D3D11"
+#endif
+
+static sg_pipeline_desc pipeline_desc(const bench_program_t* prog, sg_shader shd) {
+    sg_pipeline_desc desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.shader = shd;
+    if (prog->compute) {
+        desc.compute = true;
+    } else {
+        for (int i = 0; i < prog->num_attrs; i++) {
+            desc.layout.attrs[prog->attrs[i].slot].format = prog->attrs[i].format;
+        }
+        desc.color_count = prog->color_count;
+        desc.depth.write_enabled = true;
+        desc.depth.compare = SG_COMPAREFUNC_LESS_EQUAL;
+    }
+    desc.label = prog->name;
+    return desc;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = 5;
+    for (int i = 1; i < argc; i++) {
+        if ((0 == strcmp(argv[i], "-n")) && ((i + 1) < argc)) {
+            iterations = atoi(argv[++i]);
+        }
+    }
+    if (iterations < 1) {
+        fprintf(stderr, "runtime-bench: invalid number of iterations\n");
+        return 10;
+    }
+    if (!context_setup()) {
+        fprintf(stderr, "runtime-bench: failed to create a headless device\n");
+        return 10;
+    }
+    // created shaders and pipelines are kept alive until sg_shutdown(), so that
+    // the timed loop doesn't include deferred resource destruction
+    const int pool_size = NUM_PROGRAMS * iterations + 1;
+    sg_setup(&(sg_desc){
+        .environment = context_environment(),
+        .shader_pool_size = pool_size,
+        .pipeline_pool_size = pool_size,
+        .logger.func = slog_func,
+    });
+    stm_setup();
+    const sg_backend backend = sg_query_backend();
+    for (int iter = 0; iter < iterations; iter++) {
+        for (int i = 0; i < NUM_PROGRAMS; i++) {
+            const bench_program_t* prog = &bench_programs[i];
+            const uint64_t t0 = stm_now();
+            const sg_shader_desc* shd_desc = prog->shader_desc(backend);
+            const uint64_t t1 = stm_now();
+            if (0 == shd_desc) {
+                printf("%d %d %.3f 0 0 0\n", i, iter, stm_us(stm_diff(t1, t0)));
+                continue;
+            }
+            const sg_shader shd = sg_make_shader(shd_desc);
+            const uint64_t t2 = stm_now();
+            const sg_pipeline_desc pip_desc = pipeline_desc(prog, shd);
+            const sg_pipeline pip = sg_make_pipeline(&pip_desc);
+            const uint64_t t3 = stm_now();
+            const bool valid = (sg_query_shader_state(shd) == SG_RESOURCESTATE_VALID) &&
+                               (sg_query_pipeline_state(pip) == SG_RESOURCESTATE_VALID);
+            printf("%d %d %.3f %.3f %.3f %d\n", i, iter,
+                stm_us(stm_diff(t1, t0)), stm_us(stm_diff(t2, t1)), stm_us(stm_diff(t3, t2)), valid ? 1 : 0);
+        }
+    }
+    sg_shutdown();
+    context_shutdown();
+    return 0;
+}
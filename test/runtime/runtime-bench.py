@@ -0,0 +1,291 @@
+'''
+    Runtime shader-creation benchmark for the sokol-shdc output modes.
+
+    Compiles the shader corpus in test/sapp with sokol-shdc once for each
+    output mode (source code vs bytecode, minified, GLSL uniform buffers,
+    SPIRV optimization levels...), builds runtime-bench.c against the
+    generated headers, and creates every shader and pipeline through
+    sokol_gfx.h on a headless device of the host backend (GL 4.3 via
+    EGL on Linux, Metal on macOS, D3D11 on Windows).
+
+    Reports the creation latency per program and output mode, see the
+    'Runtime Shader-Creation Benchmark' section in docs/sokol-shdc.md.
+
+    NOTE: run with python3
+'''
+import argparse
+import glob
+import json
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR = os.path.normpath(os.path.join(SCRIPT_DIR, '..', '..'))
+
+# output modes: name, sokol-shdc options, only for these target languages (None: all)
+MODES = [
+    ('source', [], None),
+    ('minify', ['--minify'], None),
+    ('bytecode', ['--bytecode'], ['metal_macos', 'hlsl5']),
+    ('uniform-buffers', [], ['glsl430']),
+    ('opt-none', ['--opt=none'], None),
+    ('opt-perf', ['--opt=perf'], None),
+    ('compress', ['--compress=lz4'], None),
+    ('const-desc', ['--const-desc'], None),
+]
+
+# the host backend: sokol-shdc target language, sokol_gfx.h backend define, default C compiler
+def host_backend():
+    system = platform.system()
+    if system == 'Darwin':
+        return 'metal_macos', 'SOKOL_METAL', 'clang'
+    elif system == 'Windows':
+        return 'hlsl5', 'SOKOL_D3D11', 'cl'
+    else:
+        return 'glsl430', 'SOKOL_GLCORE', 'cc'
+
+def find_shdc():
+    patterns = [
+        os.path.join(ROOT_DIR, 'zig-out', 'bin', 'sokol-shdc*'),
+        os.path.join(ROOT_DIR, 'fips-deploy', 'sokol-tools', '*', 'sokol-shdc*'),
+        os.path.join(ROOT_DIR, '..', 'fips-deploy', 'sokol-tools', '*', 'sokol-shdc*'),
+    ]
+    for pattern in patterns:
+        for path in sorted(glob.glob(pattern)):
+            if os.path.isfile(path) and os.access(path, os.X_OK):
+                return path
+    return None
+
+# minimal parser for the bare_yaml output of sokol-shdc: nested mappings, and
+# lists of mappings where each item starts with a '-' on its own line
+def parse_yaml(text):
+    lines = [(len(l) - len(l.lstrip(' ')), l.strip()) for l in text.splitlines() if l.strip()]
+    root = {}
+    stack = [(-1, root)]
+    for i, (indent, line) in enumerate(lines):
+        while stack[-1][0] >= indent:
+            stack.pop()
+        parent = stack[-1][1]
+        if line == '-':
+            item = {}
+            parent.append(item)
+            stack.append((indent, item))
+            continue
+        key, _, value = line.partition(':')
+        value = value.strip()
+        if value:
+            parent[key] = value
+        else:
+            is_list = ((i + 1) < len(lines)) and (lines[i + 1][1] == '-')
+            parent[key] = [] if is_list else {}
+            stack.append((indent, parent[key]))
+    return root
+
+VERTEX_FORMATS = {
+    'float': 'FLOAT', 'vec2': 'FLOAT2', 'vec3': 'FLOAT3', 'vec4': 'FLOAT4',
+    'int': 'INT', 'ivec2': 'INT2', 'ivec3': 'INT3', 'ivec4': 'INT4',
+    'uint': 'UINT', 'uvec2': 'UINT2', 'uvec3': 'UINT3', 'uvec4': 'UINT4',
+}
+
+# the program table of a shader file: name, compute, vertex attributes, color attachment count
+def load_programs(yaml_path):
+    with open(yaml_path, 'r') as f:
+        refl = parse_yaml(f.read())
+    progs = []
+    for prog in refl.get('programs', []):
+        item = { 'name': prog['name'], 'compute': 'cs' in prog, 'attrs': [], 'color_count': 1 }
+        if 'vs' in prog:
+            for attr in prog['vs'].get('inputs', []):
+                item['attrs'].append((int(attr['slot']), VERTEX_FORMATS.get(attr['type'], 'FLOAT4')))
+        if 'fs' in prog:
+            item['color_count'] = max(1, len(prog['fs'].get('outputs', [])))
+        progs.append(item)
+    return progs
+
+# the sokol-shdc @module name of a shader file
+def module_name(path):
+    return re.sub(r'[^A-Za-z0-9_]', '_', os.path.splitext(os.path.basename(path))[0])
+
+# inject '@glsl_options uniform_buffers' into each vertex and fragment shader snippet
+def with_uniform_buffers(src):
+    return re.sub(r'^(\s*(#pragma sokol\s+)?@(vs|fs)\s.*)$', r'\1\n@glsl_options uniform_buffers', src, flags=re.MULTILINE)
+
+def run_shdc(shdc, input_path, output_path, slang, fmt, options):
+    cmd = [shdc, f'--input={input_path}', f'--output={output_path}', f'--slang={slang}', f'--format={fmt}', f'--module={module_name(input_path)}'] + options
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    return res.returncode == 0, res.stdout
+
+def write_programs_h(path, files):
+    out = '/* machine generated by runtime-bench.py, don\'t edit! */\n'
+    for file in files:
+        out += f'#include "{module_name(file["path"])}.h"\n'
+    out += 'static const bench_program_t bench_programs[] = {\n'
+    for file in files:
+        mod = module_name(file['path'])
+        for prog in file['programs']:
+            attrs = ', '.join(f'{{ {slot}, SG_VERTEXFORMAT_{fmt} }}' for slot, fmt in prog['attrs']) or '{ 0 }'
+            out += f'    {{ "{os.path.basename(file["path"])}", "{prog["name"]}", {mod}_{prog["name"]}_shader_desc, '
+            out += f'{"true" if prog["compute"] else "false"}, {len(prog["attrs"])}, {{ {attrs} }}, {prog["color_count"]} }},\n'
+    out += '};\n'
+    with open(path, 'w') as f:
+        f.write(out)
+
+def build_harness(cc, backend_define, mode_dir, sokol_dir):
+    src = os.path.join(SCRIPT_DIR, 'runtime-bench.c')
+    exe = os.path.join(mode_dir, 'runtime-bench' + ('.exe' if platform.system() == 'Windows' else ''))
+    if os.path.basename(cc).lower() in ('cl', 'cl.exe', 'clang-cl', 'clang-cl.exe'):
+        cmd = [cc, '/nologo', '/std:c11', '/O2', '/DNDEBUG', f'/D{backend_define}', f'/I{mode_dir}', f'/I{sokol_dir}',
+               src, f'/Fo{mode_dir}\\', f'/Fe{exe}', 'd3d11.lib', 'dxgi.lib']
+    elif backend_define == 'SOKOL_METAL':
+        cmd = [cc, '-x', 'objective-c', '-fobjc-arc', '-O2', '-DNDEBUG', f'-D{backend_define}', f'-I{mode_dir}', f'-I{sokol_dir}',
+               src, '-o', exe, '-framework', 'Metal', '-framework', 'QuartzCore', '-framework', 'Foundation']
+    else:
+        cmd = [cc, '-std=c11', '-O2', '-DNDEBUG', f'-D{backend_define}', f'-I{mode_dir}', f'-I{sokol_dir}',
+               src, '-o', exe, '-lEGL', '-lGL', '-lpthread', '-lm']
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    return exe if res.returncode == 0 else None, res.stdout
+
+# run the harness, returns one list of (desc, shader, pipeline, valid) per program and iteration
+def run_harness(exe, iterations, num_programs, driver_cache):
+    env = dict(os.environ)
+    if not driver_cache:
+        env.update({ 'MESA_SHADER_CACHE_DISABLE': 'true', 'MESA_GLSL_CACHE_DISABLE': 'true', '__GL_SHADER_DISK_CACHE': '0' })
+    res = subprocess.run([exe, '-n', str(iterations)], stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, env=env)
+    if res.returncode != 0:
+        return None, res.stderr
+    samples = [[] for _ in range(num_programs)]
+    for line in res.stdout.splitlines():
+        tokens = line.split()
+        if len(tokens) == 6:
+            samples[int(tokens[0])].append((float(tokens[2]), float(tokens[3]), float(tokens[4]), tokens[5] == '1'))
+    return samples, res.stderr
+
+# cold: the first iteration, warm: median of the following iterations
+def summarize(samples):
+    cold = samples[0]
+    rest = samples[1:] if len(samples) > 1 else samples
+    warm = tuple(statistics.median(s[i] for s in rest) for i in range(3))
+    return {
+        'cold_desc_us': cold[0], 'cold_shader_us': cold[1], 'cold_pipeline_us': cold[2],
+        'warm_desc_us': warm[0], 'warm_shader_us': warm[1], 'warm_pipeline_us': warm[2],
+        'valid': all(s[3] for s in samples),
+    }
+
+def main():
+    slang, backend_define, default_cc = host_backend()
+    parser = argparse.ArgumentParser(description='runtime shader and pipeline creation benchmark for the sokol-shdc output modes')
+    parser.add_argument('--shdc', default=find_shdc(), help='sokol-shdc executable (default: search zig-out and fips-deploy)')
+    parser.add_argument('--sokol-dir', default=os.path.join(ROOT_DIR, '..', 'sokol'), help='directory with sokol_gfx.h, sokol_log.h and sokol_time.h (default: ../sokol)')
+    parser.add_argument('--dir', default=os.path.join(ROOT_DIR, 'test', 'sapp'), help='shader directory (default: test/sapp)')
+    parser.add_argument('--out-dir', default=os.path.join(tempfile.gettempdir(), 'shdc-runtime-bench'), help='directory for generated files (default: system temp dir)')
+    parser.add_argument('--modes', default=None, help='colon-separated output modes (default: all supported by the host backend)')
+    parser.add_argument('--cc', default=default_cc, help=f'C compiler (default: {default_cc})')
+    parser.add_argument('-n', '--iterations', type=int, default=5, help='number of iterations over all programs, the first is reported as cold (default: 5)')
+    parser.add_argument('--driver-cache', action='store_true', help='keep the GL driver shader disk cache enabled')
+    parser.add_argument('--json', default=None, help='also write the results as JSON file for comparison across commits')
+    args = parser.parse_args()
+
+    if not args.shdc:
+        sys.exit('runtime-bench: sokol-shdc executable not found, use --shdc')
+    if not os.path.isfile(os.path.join(args.sokol_dir, 'sokol_gfx.h')):
+        sys.exit(f'runtime-bench: sokol_gfx.h not found in {args.sokol_dir}, use --sokol-dir')
+    modes = [m for m in MODES if (m[2] is None) or (slang in m[2])]
+    if args.modes:
+        names = args.modes.split(':')
+        unknown = [n for n in names if n not in [m[0] for m in MODES]]
+        if unknown:
+            sys.exit(f'runtime-bench: unknown output mode(s): {", ".join(unknown)}')
+        modes = [m for m in modes if m[0] in names]
+    if not modes:
+        sys.exit(f'runtime-bench: none of the output modes is supported for {slang}')
+
+    # compile all shader files for all modes, files which fail in any mode are skipped
+    inputs = sorted(glob.glob(os.path.join(args.dir, '*.glsl')))
+    layout_dir = os.path.join(args.out_dir, 'layout')
+    os.makedirs(layout_dir, exist_ok=True)
+    files = []
+    for path in inputs:
+        ok, log = run_shdc(args.shdc, path, os.path.join(layout_dir, module_name(path)), slang, 'bare_yaml', ['--yaml-schema=2'])
+        yaml_paths = glob.glob(os.path.join(layout_dir, f'{module_name(path)}_*reflection.yaml'))
+        if not ok or not yaml_paths:
+            print(f'skipping {os.path.basename(path)} (failed to compile for {slang})')
+            continue
+        files.append({ 'path': path, 'programs': load_programs(yaml_paths[0]) })
+    for name, options, _ in modes:
+        mode_dir = os.path.join(args.out_dir, name)
+        os.makedirs(mode_dir, exist_ok=True)
+        for file in list(files):
+            input_path = file['path']
+            if name == 'uniform-buffers':
+                with open(input_path, 'r') as f:
+                    src = with_uniform_buffers(f.read())
+                input_path = os.path.join(mode_dir, os.path.basename(file['path']))
+                with open(input_path, 'w') as f:
+                    f.write(src)
+            ok, log = run_shdc(args.shdc, input_path, os.path.join(mode_dir, module_name(file['path']) + '.h'), slang, 'sokol', options)
+            if not ok:
+                print(f'skipping {os.path.basename(file["path"])} (failed to compile in mode {name}):\n{log}')
+                files.remove(file)
+    if not files:
+        sys.exit('runtime-bench: no shader files to benchmark')
+    programs = [(os.path.basename(f['path']), p['name']) for f in files for p in f['programs']]
+
+    # build and run the harness for each mode
+    results = {}
+    for name, _, _ in modes:
+        mode_dir = os.path.join(args.out_dir, name)
+        write_programs_h(os.path.join(mode_dir, 'programs.h'), files)
+        exe, log = build_harness(args.cc, backend_define, mode_dir, args.sokol_dir)
+        if not exe:
+            sys.exit(f'runtime-bench: failed to build the harness for mode {name}:\n{log}')
+        samples, log = run_harness(exe, args.iterations, len(programs), args.driver_cache)
+        if samples is None:
+            sys.exit(f'runtime-bench: harness failed in mode {name}:\n{log}')
+        results[name] = [summarize(s) if s else None for s in samples]
+
+    # per-program cold creation latency (shader desc + shader + pipeline) across modes
+    mode_names = [m[0] for m in modes]
+    width = max(len(f'{f}/{p}') for f, p in programs)
+    print(f'\nsokol-shdc runtime benchmark: {slang} ({backend_define}), {len(programs)} programs, {args.iterations} iterations')
+    print('\ncold creation latency in us (shader desc + shader + pipeline):\n')
+    print(f'{"program":<{width}}' + ''.join(f'{n:>16}' for n in mode_names))
+    for i, (file, prog) in enumerate(programs):
+        row = f'{file + "/" + prog:<{width}}'
+        for name in mode_names:
+            r = results[name][i]
+            if not r or not r['valid']:
+                row += f'{"failed":>16}'
+            else:
+                row += f'{r["cold_desc_us"] + r["cold_shader_us"] + r["cold_pipeline_us"]:>16.1f}'
+        print(row)
+
+    # totals per mode
+    print('\ntotals in ms:\n')
+    print(f'{"mode":<16}{"cold desc":>12}{"cold shader":>14}{"cold pip":>12}{"warm shader":>14}{"warm pip":>12}{"failed":>8}')
+    summary = {}
+    for name in mode_names:
+        valid = [r for r in results[name] if r and r['valid']]
+        totals = { k.replace('_us', '_ms'): sum(r[k] for r in valid) / 1000.0 for k in ('cold_desc_us', 'cold_shader_us', 'cold_pipeline_us', 'warm_shader_us', 'warm_pipeline_us') }
+        summary[name] = dict(totals, failed=len(programs) - len(valid))
+        print(f'{name:<16}{totals["cold_desc_ms"]:>12.2f}{totals["cold_shader_ms"]:>14.2f}{totals["cold_pipeline_ms"]:>12.2f}'
+              f'{totals["warm_shader_ms"]:>14.2f}{totals["warm_pipeline_ms"]:>12.2f}{summary[name]["failed"]:>8}')
+
+    if args.json:
+        out = {
+            'slang': slang,
+            'backend': backend_define,
+            'iterations': args.iterations,
+            'modes': { name: { 'totals_ms': summary[name], 'programs': [
+                dict(results[name][i] or {}, file=file, program=prog) for i, (file, prog) in enumerate(programs)
+            ] } for name in mode_names },
+        }
+        with open(args.json, 'w') as f:
+            json.dump(out, f, indent=2)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,40 @@
+@vs vs
+@vertex_format position float3
+@vertex_format normal ubyte4n
+@vertex_format texcoord0 short2n
+@vertex_format inst_pos float4 1 per_instance
+@vertex_format inst_color ubyte4n 1 per_instance
+uniform vs_params {
+    mat4 mvp;
+};
+
+in vec4 position;
+in vec4 normal;
+in vec2 texcoord0;
+in vec4 inst_pos;
+in vec4 inst_color;
+
+out vec4 color;
+out vec2 uv;
+
+void main() {
+    gl_Position = mvp * (position + inst_pos);
+    color = inst_color * (normal * 0.5 + 0.5);
+    uv = texcoord0;
+}
+@end
+
+@fs fs
+uniform texture2D tex;
+uniform sampler smp;
+
+in vec4 color;
+in vec2 uv;
+out vec4 frag_color;
+
+void main() {
+    frag_color = texture(sampler2D(tex, smp), uv) * color;
+}
+@end
+
+@program instanced vs fs
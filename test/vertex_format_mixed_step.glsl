@@ -0,0 +1,21 @@
+// error: vertex buffer 0 has the per-instance input 'inst_pos' and the
+// per-vertex input 'position' (inputs without @vertex_format go per-vertex
+// into vertex buffer 0)
+@vs vs
+@vertex_format inst_pos float4 0 per_instance
+in vec4 position;
+in vec4 inst_pos;
+
+void main() {
+    gl_Position = position + inst_pos;
+}
+@end
+
+@fs fs
+out vec4 frag_color;
+void main() {
+    frag_color = vec4(1.0);
+}
+@end
+
+@program mixed vs fs